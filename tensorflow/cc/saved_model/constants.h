@@ -24,6 +24,11 @@ inline constexpr char kSavedModelAssetsDirectory[] = "assets";
 // SavedModel assets.extra directory.
 inline constexpr char kSavedModelAssetsExtraDirectory[] = "assets.extra";
 
+// TFRecord file of PredictionLogs in assets.extra that are replayed to warm up
+// a model after loading.
+inline constexpr char kSavedModelWarmupRequestsFilename[] =
+    "tf_serving_warmup_requests";
+
 // SavedModel assets key for graph collection-def.
 inline constexpr char kSavedModelAssetsKey[] = "saved_model_assets";
 
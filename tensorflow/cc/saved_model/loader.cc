@@ -47,6 +47,7 @@ limitations under the License.
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
+#include "tensorflow/core/util/tensor_bundle/shared_tensor_store.h"
 
 namespace tensorflow {
 namespace {
@@ -262,8 +263,14 @@ Status RunRestore(const RunOptions& run_options, const string& export_dir,
   AddAssetsTensorsToInputs(export_dir, asset_file_defs, &inputs);
 
   RunMetadata run_metadata;
-  return RunOnce(run_options, inputs, {}, {string(restore_op_name)},
-                 nullptr /* outputs */, &run_metadata, session);
+  TF_RETURN_IF_ERROR(RunOnce(run_options, inputs, {},
+                             {string(restore_op_name)}, nullptr /* outputs */,
+                             &run_metadata, session));
+  if (SharedTensorStore::IsEnabled()) {
+    // Releases the shared variables of models that were unloaded since.
+    SharedTensorStore::Global()->Sweep();
+  }
+  return OkStatus();
 }
 
 }  // namespace
@@ -0,0 +1,370 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/saved_model/warmup.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "absl/functional/function_ref.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/cc/saved_model/signature_constants.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/threadpool.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+
+namespace tensorflow {
+namespace saved_model {
+namespace {
+
+// Field numbers of the TensorFlow Serving PredictionLog protos. The protos are
+// not part of TensorFlow, so the records are decoded at the wire level.
+constexpr int kPredictionLogPredictLogField = 6;
+constexpr int kPredictLogRequestField = 1;
+constexpr int kPredictRequestModelSpecField = 1;
+constexpr int kPredictRequestInputsField = 2;
+constexpr int kModelSpecSignatureNameField = 3;
+constexpr int kMapEntryKeyField = 1;
+constexpr int kMapEntryValueField = 2;
+
+// Calls `fn` with the field number and payload of every length-delimited field
+// of the serialized message, skipping the fields of other wire types.
+Status ForEachLengthDelimitedField(
+    absl::string_view message,
+    absl::FunctionRef<Status(int, absl::string_view)> fn) {
+  protobuf::io::CodedInputStream input(
+      reinterpret_cast<const uint8_t*>(message.data()), message.size());
+  while (uint32_t tag = input.ReadTag()) {
+    bool ok = false;
+    switch (tag & 0x7) {
+      case 0: {  // Varint.
+        uint64_t value;
+        ok = input.ReadVarint64(&value);
+        break;
+      }
+      case 1:  // 64-bit.
+        ok = input.Skip(8);
+        break;
+      case 5:  // 32-bit.
+        ok = input.Skip(4);
+        break;
+      case 2: {  // Length-delimited.
+        uint32_t length;
+        std::string payload;
+        ok = input.ReadVarint32(&length) && input.ReadString(&payload, length);
+        if (ok) TF_RETURN_IF_ERROR(fn(tag >> 3, payload));
+        break;
+      }
+      default:
+        break;
+    }
+    if (!ok) break;
+  }
+  if (input.CurrentPosition() != static_cast<int>(message.size())) {
+    return errors::DataLoss("Malformed warmup request.");
+  }
+  return absl::OkStatus();
+}
+
+Status ParsePredictRequest(absl::string_view predict_request,
+                           WarmupRequest* request) {
+  return ForEachLengthDelimitedField(
+      predict_request, [&](int field, absl::string_view payload) -> Status {
+        if (field == kPredictRequestModelSpecField) {
+          return ForEachLengthDelimitedField(
+              payload, [&](int field, absl::string_view payload) {
+                if (field == kModelSpecSignatureNameField) {
+                  request->signature_name = std::string(payload);
+                }
+                return absl::OkStatus();
+              });
+        }
+        if (field != kPredictRequestInputsField) return absl::OkStatus();
+
+        std::string key;
+        TensorProto tensor_proto;
+        TF_RETURN_IF_ERROR(ForEachLengthDelimitedField(
+            payload, [&](int field, absl::string_view payload) -> Status {
+              if (field == kMapEntryKeyField) {
+                key = std::string(payload);
+              } else if (field == kMapEntryValueField &&
+                         !tensor_proto.ParseFromArray(payload.data(),
+                                                      payload.size())) {
+                return errors::DataLoss("Malformed warmup request input.");
+              }
+              return absl::OkStatus();
+            }));
+        Tensor tensor;
+        if (!tensor.FromProto(tensor_proto)) {
+          return errors::InvalidArgument("Invalid tensor for warmup input ",
+                                         key);
+        }
+        request->inputs.push_back({std::move(key), std::move(tensor)});
+        return absl::OkStatus();
+      });
+}
+
+// Parses a serialized PredictionLog. Sets `is_predict_log` to false if the log
+// holds a request of another kind, such as a ClassificationRequest.
+Status ParsePredictionLog(absl::string_view prediction_log,
+                          WarmupRequest* request, bool* is_predict_log) {
+  *is_predict_log = false;
+  TF_RETURN_IF_ERROR(ForEachLengthDelimitedField(
+      prediction_log, [&](int field, absl::string_view payload) -> Status {
+        if (field != kPredictionLogPredictLogField) return absl::OkStatus();
+        *is_predict_log = true;
+        return ForEachLengthDelimitedField(
+            payload, [&](int field, absl::string_view payload) {
+              if (field != kPredictLogRequestField) return absl::OkStatus();
+              return ParsePredictRequest(payload, request);
+            });
+      }));
+  if (request->signature_name.empty()) {
+    request->signature_name = kDefaultServingSignatureDefKey;
+  }
+  return absl::OkStatus();
+}
+
+int64_t CpuAllocatorPeakBytesInUse() {
+  const auto stats = cpu_allocator()->GetStats();
+  return stats.has_value() ? stats->peak_bytes_in_use : -1;
+}
+
+// The CPU allocator only collects stats once they are enabled, which they are
+// not by default. They are enabled while any warmup runs, and disabled again
+// after the last one if no one else had enabled them.
+class ScopedCpuAllocatorStats {
+ public:
+  ScopedCpuAllocatorStats() {
+    mutex_lock lock(mu_);
+    if (num_warmups_++ == 0 && !CPUAllocatorStatsEnabled()) {
+      EnableCPUAllocatorStats();
+      enabled_by_warmup_ = true;
+    }
+  }
+
+  ~ScopedCpuAllocatorStats() {
+    mutex_lock lock(mu_);
+    if (--num_warmups_ == 0 && enabled_by_warmup_) {
+      DisableCPUAllocatorStats();
+      enabled_by_warmup_ = false;
+    }
+  }
+
+  ScopedCpuAllocatorStats(const ScopedCpuAllocatorStats&) = delete;
+  ScopedCpuAllocatorStats& operator=(const ScopedCpuAllocatorStats&) = delete;
+
+ private:
+  static mutex mu_;
+  static int num_warmups_ TF_GUARDED_BY(mu_);
+  static bool enabled_by_warmup_ TF_GUARDED_BY(mu_);
+};
+
+mutex ScopedCpuAllocatorStats::mu_(LINKER_INITIALIZED);
+int ScopedCpuAllocatorStats::num_warmups_ = 0;
+bool ScopedCpuAllocatorStats::enabled_by_warmup_ = false;
+
+}  // namespace
+
+std::string GetWarmupRequestsPath(absl::string_view export_dir) {
+  return io::JoinPath(export_dir, kSavedModelAssetsExtraDirectory,
+                      kSavedModelWarmupRequestsFilename);
+}
+
+absl::StatusOr<std::vector<WarmupRequest>> ReadWarmupRequests(
+    absl::string_view export_dir, const WarmupOptions& options,
+    int* num_skipped_requests) {
+  std::vector<WarmupRequest> requests;
+  int num_skipped = 0;
+  const std::string path = GetWarmupRequestsPath(export_dir);
+  Env* env = Env::Default();
+  if (!env->FileExists(path).ok()) return requests;
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(path, &file));
+  io::SequentialRecordReader reader(file.get());
+  while (static_cast<int>(requests.size()) + num_skipped <
+         options.max_num_requests) {
+    tstring record;
+    Status status = reader.ReadRecord(&record);
+    if (errors::IsOutOfRange(status)) break;
+    TF_RETURN_IF_ERROR(status);
+
+    WarmupRequest request;
+    bool is_predict_log;
+    TF_RETURN_IF_ERROR(ParsePredictionLog(record, &request, &is_predict_log));
+    if (is_predict_log) {
+      requests.push_back(std::move(request));
+    } else {
+      ++num_skipped;
+    }
+  }
+  if (num_skipped > 0) {
+    LOG(WARNING) << "Skipped " << num_skipped
+                 << " warmup requests that are not PredictLogs in " << path;
+  }
+  if (num_skipped_requests != nullptr) *num_skipped_requests = num_skipped;
+  return requests;
+}
+
+absl::StatusOr<WarmupReport> RunWarmup(
+    const WarmupOptions& options, const std::vector<WarmupRequest>& requests,
+    const WarmupRunFn& run_fn) {
+  WarmupReport report;
+  report.num_requests = requests.size();
+  if (requests.empty()) return report;
+
+  serving::WarmupStateRegistry::Handle warmup_handle;
+  if (options.model_key.has_value()) {
+    auto per_model_data =
+        std::make_unique<serving::WarmupStateRegistry::PerModelData>();
+    per_model_data->warmup_all_batch_sizes = true;
+    TF_ASSIGN_OR_RETURN(warmup_handle,
+                        serving::GetGlobalWarmupStateRegistry().Register(
+                            *options.model_key, std::move(per_model_data)));
+  }
+
+  const int num_threads = std::max(
+      1, std::min(options.num_threads, static_cast<int>(requests.size())));
+  thread::ThreadPool thread_pool(Env::Default(), "saved_model_warmup",
+                                 num_threads);
+  ScopedCpuAllocatorStats allocator_stats;
+  int64_t peak_bytes_in_use = CpuAllocatorPeakBytesInUse();
+  if (peak_bytes_in_use < 0) {
+    LOG(WARNING) << "The CPU allocator does not collect stats, so warmup "
+                    "reaches steady state based on latency only";
+  }
+  for (int round = 0; round < options.max_rounds; ++round) {
+    const absl::Time start_time = absl::Now();
+    mutex mu;
+    Status status;
+    BlockingCounter pending(requests.size());
+    for (const auto& request : requests) {
+      thread_pool.Schedule([&]() {
+        Status run_status = run_fn(request);
+        if (!run_status.ok()) {
+          mutex_lock lock(mu);
+          status.Update(run_status);
+        }
+        pending.DecrementCount();
+      });
+    }
+    pending.Wait();
+    TF_RETURN_IF_ERROR(status);
+
+    const absl::Duration latency = absl::Now() - start_time;
+    report.round_latencies.push_back(latency);
+    report.num_rounds = round + 1;
+
+    // The allocator has stopped growing once a full round leaves its peak
+    // usage unchanged.
+    const int64_t previous_peak_bytes_in_use = peak_bytes_in_use;
+    peak_bytes_in_use = CpuAllocatorPeakBytesInUse();
+    if (round == 0) continue;
+    const absl::Duration previous_latency = report.round_latencies[round - 1];
+    if (absl::AbsDuration(latency - previous_latency) <=
+            previous_latency * options.steady_state_tolerance &&
+        peak_bytes_in_use == previous_peak_bytes_in_use) {
+      report.reached_steady_state = true;
+      break;
+    }
+  }
+  report.peak_bytes_in_use = peak_bytes_in_use;
+  return report;
+}
+
+absl::StatusOr<WarmupReport> RunSavedModelWarmup(
+    const WarmupOptions& options, absl::string_view export_dir,
+    const SavedModelBundleInterface& bundle) {
+  int num_skipped_requests = 0;
+  TF_ASSIGN_OR_RETURN(
+      auto requests,
+      ReadWarmupRequests(export_dir, options, &num_skipped_requests));
+
+  const auto& signatures = bundle.GetSignatures();
+  auto run_fn = [&](const WarmupRequest& request) -> Status {
+    const auto signature = signatures.find(request.signature_name);
+    if (signature == signatures.end()) {
+      return errors::InvalidArgument("Warmup request for unknown signature ",
+                                     request.signature_name);
+    }
+    std::vector<std::pair<std::string, Tensor>> feeds;
+    feeds.reserve(request.inputs.size());
+    for (const auto& [key, tensor] : request.inputs) {
+      const auto input = signature->second.inputs().find(key);
+      if (input == signature->second.inputs().end()) {
+        return errors::InvalidArgument("Warmup request for signature ",
+                                       request.signature_name,
+                                       " has unknown input ", key);
+      }
+      feeds.push_back({input->second.name(), tensor});
+    }
+    std::vector<std::string> fetches;
+    for (const auto& [key, output] : signature->second.outputs()) {
+      fetches.push_back(output.name());
+    }
+    std::vector<Tensor> outputs;
+    return bundle.GetSession()->Run(feeds, fetches, /*target_node_names=*/{},
+                                    &outputs);
+  };
+
+  TF_ASSIGN_OR_RETURN(auto report, RunWarmup(options, requests, run_fn));
+  report.num_skipped_requests = num_skipped_requests;
+  LOG(INFO) << "Replayed " << report.num_requests
+            << " warmup requests for SavedModel " << export_dir << " in "
+            << report.num_rounds << " rounds; steady state "
+            << (report.reached_steady_state ? "reached." : "not reached.");
+  return report;
+}
+
+absl::StatusOr<WarmupReport> LoadSavedModelWithWarmup(
+    const SessionOptions& session_options, const RunOptions& run_options,
+    const std::string& export_dir, const std::unordered_set<std::string>& tags,
+    const WarmupOptions& warmup_options, SavedModelBundle* bundle) {
+  TF_RETURN_IF_ERROR(
+      LoadSavedModel(session_options, run_options, export_dir, tags, bundle));
+  return RunSavedModelWarmup(warmup_options, export_dir, *bundle);
+}
+
+absl::StatusOr<WarmupReport> LoadSavedModelWithWarmup(
+    const SessionOptions& session_options, const RunOptions& run_options,
+    const std::string& export_dir, const std::unordered_set<std::string>& tags,
+    const WarmupOptions& warmup_options, SavedModelBundleLite* bundle) {
+  TF_RETURN_IF_ERROR(
+      LoadSavedModel(session_options, run_options, export_dir, tags, bundle));
+  return RunSavedModelWarmup(warmup_options, export_dir, *bundle);
+}
+
+}  // namespace saved_model
+}  // namespace tensorflow
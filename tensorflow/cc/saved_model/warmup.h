@@ -0,0 +1,120 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CC_SAVED_MODEL_WARMUP_H_
+#define TENSORFLOW_CC_SAVED_MODEL_WARMUP_H_
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "tensorflow/cc/saved_model/loader.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/batching_util/warmup.h"
+#include "tensorflow/core/platform/status.h"
+
+namespace tensorflow {
+namespace saved_model {
+
+// A recorded request that is replayed to warm up a model.
+struct WarmupRequest {
+  std::string signature_name;
+  // Signature input keys and their values.
+  std::vector<std::pair<std::string, Tensor>> inputs;
+};
+
+struct WarmupOptions {
+  // The number of requests that are replayed concurrently.
+  int num_threads = 4;
+
+  // Warmup stops after the first round whose latency is within
+  // `steady_state_tolerance` of the previous round and during which the peak
+  // usage of the CPU allocator did not grow, or after `max_rounds` rounds. The
+  // allocator's stats are enabled while warming up; if it does not collect
+  // any, only the latency is checked.
+  int max_rounds = 5;
+  double steady_state_tolerance = 0.1;
+
+  // Requests beyond this limit in the warmup file are ignored.
+  int max_num_requests = 1000;
+
+  // If set, the model is registered in the global `WarmupStateRegistry` while
+  // warming up so that batch ops run every request at all of their allowed
+  // batch sizes.
+  std::optional<serving::WarmupStateRegistry::Key> model_key;
+};
+
+struct WarmupReport {
+  int num_requests = 0;
+  // The number of requests in the warmup file that are not PredictLogs and
+  // therefore were not replayed.
+  int num_skipped_requests = 0;
+  int num_rounds = 0;
+  // Wall time of each round, in order.
+  std::vector<absl::Duration> round_latencies;
+  // Peak bytes in use of the CPU allocator after warmup, or -1 if the
+  // allocator does not collect stats.
+  int64_t peak_bytes_in_use = -1;
+  bool reached_steady_state = false;
+};
+
+// Runs one warmup request against the model and discards the outputs.
+using WarmupRunFn = std::function<Status(const WarmupRequest&)>;
+
+// Returns the path of the warmup requests file of the SavedModel in
+// `export_dir`.
+std::string GetWarmupRequestsPath(absl::string_view export_dir);
+
+// Reads the PredictLogs recorded in the warmup requests file of the SavedModel
+// in `export_dir`. Returns no requests if the model has no such file.
+absl::StatusOr<std::vector<WarmupRequest>> ReadWarmupRequests(
+    absl::string_view export_dir, const WarmupOptions& options,
+    int* num_skipped_requests = nullptr);
+
+// Replays `requests` concurrently with `run_fn` until the model reaches steady
+// state. Returns the first error returned by `run_fn`, if any.
+absl::StatusOr<WarmupReport> RunWarmup(
+    const WarmupOptions& options, const std::vector<WarmupRequest>& requests,
+    const WarmupRunFn& run_fn);
+
+// Reads the warmup requests of the SavedModel in `export_dir` and replays them
+// against `bundle`, which must have been loaded from `export_dir`.
+absl::StatusOr<WarmupReport> RunSavedModelWarmup(
+    const WarmupOptions& options, absl::string_view export_dir,
+    const SavedModelBundleInterface& bundle);
+
+// Loads the SavedModel in `export_dir` with LoadSavedModel() and replays its
+// warmup requests against `bundle` before returning. This is the session-based
+// counterpart of the TFRT SavedModel's `Options::enable_warmup`.
+absl::StatusOr<WarmupReport> LoadSavedModelWithWarmup(
+    const SessionOptions& session_options, const RunOptions& run_options,
+    const std::string& export_dir, const std::unordered_set<std::string>& tags,
+    const WarmupOptions& warmup_options, SavedModelBundle* bundle);
+absl::StatusOr<WarmupReport> LoadSavedModelWithWarmup(
+    const SessionOptions& session_options, const RunOptions& run_options,
+    const std::string& export_dir, const std::unordered_set<std::string>& tags,
+    const WarmupOptions& warmup_options, SavedModelBundleLite* bundle);
+
+}  // namespace saved_model
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CC_SAVED_MODEL_WARMUP_H_
@@ -0,0 +1,256 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/saved_model/warmup.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/cc/saved_model/loader.h"
+#include "tensorflow/cc/saved_model/signature_constants.h"
+#include "tensorflow/cc/saved_model/tag_constants.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/batching_util/warmup.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace saved_model {
+namespace {
+
+constexpr char kTestDataSharded[] =
+    "cc/saved_model/testdata/half_plus_two/00000123";
+
+// Encodes a length-delimited protobuf field.
+std::string Field(int field, absl::string_view payload) {
+  std::string result;
+  {
+    protobuf::io::StringOutputStream stream(&result);
+    protobuf::io::CodedOutputStream output(&stream);
+    output.WriteTag((field << 3) | 2);
+    output.WriteVarint32(payload.size());
+    output.WriteRaw(payload.data(), payload.size());
+  }
+  return result;
+}
+
+// Returns a serialized PredictionLog with a PredictLog for `signature_name`.
+std::string PredictionLog(absl::string_view signature_name,
+                          absl::string_view input_key, const Tensor& input) {
+  TensorProto tensor_proto;
+  input.AsProtoTensorContent(&tensor_proto);
+  const std::string model_spec = Field(3, signature_name);
+  const std::string inputs_entry = absl::StrCat(
+      Field(1, input_key), Field(2, tensor_proto.SerializeAsString()));
+  const std::string predict_request =
+      absl::StrCat(Field(1, model_spec), Field(2, inputs_entry));
+  return Field(6, Field(1, predict_request));
+}
+
+std::string WriteWarmupRequests(absl::string_view test_name,
+                                const std::vector<std::string>& records) {
+  const std::string export_dir = io::JoinPath(testing::TmpDir(), test_name);
+  Env* env = Env::Default();
+  TF_CHECK_OK(env->RecursivelyCreateDir(
+      io::JoinPath(export_dir, kSavedModelAssetsExtraDirectory)));
+  std::unique_ptr<WritableFile> file;
+  TF_CHECK_OK(env->NewWritableFile(GetWarmupRequestsPath(export_dir), &file));
+  io::RecordWriter writer(file.get());
+  for (const auto& record : records) TF_CHECK_OK(writer.WriteRecord(record));
+  TF_CHECK_OK(writer.Close());
+  TF_CHECK_OK(file->Close());
+  return export_dir;
+}
+
+// Copies the half_plus_two SavedModel to a directory that warmup requests can
+// be written to.
+std::string CopyHalfPlusTwo(absl::string_view test_name) {
+  const std::string src_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+  const std::string export_dir = io::JoinPath(testing::TmpDir(), test_name);
+  Env* env = Env::Default();
+  for (const char* file :
+       {"saved_model.pb", "assets/foo.txt", "variables/variables.index",
+        "variables/variables.data-00000-of-00001"}) {
+    const std::string target = io::JoinPath(export_dir, file);
+    TF_CHECK_OK(env->RecursivelyCreateDir(std::string(io::Dirname(target))));
+    TF_CHECK_OK(env->CopyFile(io::JoinPath(src_dir, file), target));
+  }
+  return export_dir;
+}
+
+TEST(WarmupTest, ReadWarmupRequests) {
+  const std::string export_dir = WriteWarmupRequests(
+      "read_warmup_requests",
+      {PredictionLog("sig", "x", test::AsTensor<float>({1, 2})),
+       PredictionLog("", "y", test::AsScalar<int32>(3)),
+       // A PredictionLog holding a ClassifyLog.
+       Field(1, "")});
+
+  int num_skipped_requests = 0;
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto requests,
+      ReadWarmupRequests(export_dir, WarmupOptions(), &num_skipped_requests));
+  EXPECT_EQ(num_skipped_requests, 1);
+  ASSERT_EQ(requests.size(), 2);
+
+  EXPECT_EQ(requests[0].signature_name, "sig");
+  ASSERT_EQ(requests[0].inputs.size(), 1);
+  EXPECT_EQ(requests[0].inputs[0].first, "x");
+  test::ExpectTensorEqual<float>(requests[0].inputs[0].second,
+                                 test::AsTensor<float>({1, 2}));
+
+  EXPECT_EQ(requests[1].signature_name, "serving_default");
+  ASSERT_EQ(requests[1].inputs.size(), 1);
+  test::ExpectTensorEqual<int32>(requests[1].inputs[0].second,
+                                 test::AsScalar<int32>(3));
+}
+
+TEST(WarmupTest, NoWarmupFile) {
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto requests,
+      ReadWarmupRequests(io::JoinPath(testing::TmpDir(), "no_warmup_file"),
+                         WarmupOptions()));
+  EXPECT_TRUE(requests.empty());
+}
+
+TEST(WarmupTest, MalformedRecord) {
+  const std::string export_dir =
+      WriteWarmupRequests("malformed_record", {"\x32\x10truncated"});
+  EXPECT_FALSE(ReadWarmupRequests(export_dir, WarmupOptions()).ok());
+}
+
+TEST(WarmupTest, ReplaysAllRequestsUntilSteadyState) {
+  std::vector<WarmupRequest> requests(3);
+  std::atomic<int> num_runs = 0;
+  WarmupOptions options;
+  options.max_rounds = 10;
+  // Any two rounds are close enough for this test.
+  options.steady_state_tolerance = 1e6;
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto report, RunWarmup(options, requests, [&](const WarmupRequest&) {
+        ++num_runs;
+        return absl::OkStatus();
+      }));
+  EXPECT_EQ(report.num_requests, 3);
+  EXPECT_EQ(report.num_rounds, 2);
+  EXPECT_EQ(report.round_latencies.size(), 2);
+  EXPECT_TRUE(report.reached_steady_state);
+  EXPECT_EQ(num_runs, 6);
+}
+
+TEST(WarmupTest, StopsAfterMaxRounds) {
+  std::vector<WarmupRequest> requests(1);
+  WarmupOptions options;
+  options.max_rounds = 1;
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto report, RunWarmup(options, requests, [](const WarmupRequest&) {
+        return absl::OkStatus();
+      }));
+  EXPECT_EQ(report.num_rounds, 1);
+  EXPECT_FALSE(report.reached_steady_state);
+}
+
+TEST(WarmupTest, NoSteadyStateWhileCpuAllocatorGrows) {
+  ASSERT_FALSE(CPUAllocatorStatsEnabled());
+  std::vector<WarmupRequest> requests(1);
+  WarmupOptions options;
+  options.max_rounds = 3;
+  options.steady_state_tolerance = 1e6;
+  size_t num_bytes = 1 << 20;
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto report, RunWarmup(options, requests, [&](const WarmupRequest&) {
+        // Each round needs twice as much memory as the previous one.
+        num_bytes *= 2;
+        void* buffer = cpu_allocator()->AllocateRaw(
+            Allocator::kAllocatorAlignment, num_bytes);
+        cpu_allocator()->DeallocateRaw(buffer);
+        return absl::OkStatus();
+      }));
+  EXPECT_EQ(report.num_rounds, 3);
+  EXPECT_FALSE(report.reached_steady_state);
+  EXPECT_GT(report.peak_bytes_in_use, 0);
+  // The stats are only collected while warming up.
+  EXPECT_FALSE(CPUAllocatorStatsEnabled());
+}
+
+TEST(WarmupTest, RegistersModelForAllBatchSizes) {
+  const serving::WarmupStateRegistry::Key key("model", 1);
+  WarmupOptions options;
+  options.max_rounds = 1;
+  options.model_key = key;
+  std::vector<WarmupRequest> requests(1);
+
+  TF_ASSERT_OK(RunWarmup(options, requests, [&](const WarmupRequest&) {
+                 const auto* data =
+                     serving::GetGlobalWarmupStateRegistry().Lookup(key);
+                 EXPECT_NE(data, nullptr);
+                 EXPECT_TRUE(data != nullptr && data->warmup_all_batch_sizes);
+                 return absl::OkStatus();
+               }).status());
+  EXPECT_EQ(serving::GetGlobalWarmupStateRegistry().Lookup(key), nullptr);
+}
+
+TEST(WarmupTest, LoadSavedModelWithWarmup) {
+  const std::string export_dir = CopyHalfPlusTwo("load_with_warmup");
+  Example example;
+  (*example.mutable_features()->mutable_feature())["x"]
+      .mutable_float_list()
+      ->add_value(1);
+  WriteWarmupRequests(
+      "load_with_warmup",
+      {PredictionLog("regress_x_to_y", kRegressInputs,
+                     test::AsTensor<tstring>({example.SerializeAsString()}))});
+
+  WarmupOptions options;
+  options.max_rounds = 2;
+  SavedModelBundle bundle;
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto report,
+      LoadSavedModelWithWarmup(SessionOptions(), RunOptions(), export_dir,
+                               {kSavedModelTagServe}, options, &bundle));
+  EXPECT_EQ(report.num_requests, 1);
+  EXPECT_GE(report.num_rounds, 1);
+  EXPECT_NE(bundle.GetSession(), nullptr);
+}
+
+TEST(WarmupTest, PropagatesErrors) {
+  std::vector<WarmupRequest> requests(2);
+  EXPECT_TRUE(errors::IsInternal(
+      RunWarmup(WarmupOptions(), requests, [](const WarmupRequest&) {
+        return errors::Internal("failed");
+      }).status()));
+}
+
+}  // namespace
+}  // namespace saved_model
+}  // namespace tensorflow
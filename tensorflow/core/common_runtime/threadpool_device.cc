@@ -46,6 +46,7 @@ info. It does not have any negative impact on performance. */
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/util/port.h"
 #include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 #ifdef INTEL_MKL
 #include "tensorflow/core/common_runtime/mkl_cpu_allocator.h"
@@ -182,7 +183,15 @@ void ThreadPoolDevice::Compute(OpKernel* op_kernel, OpKernelContext* context) {
     LogInputs(op_kernel, context);
   }
 
-  op_kernel->Compute(context);
+  if (op_kernel->max_intra_op_parallelism() > 0) {
+    // Limits the threads used by Shard() and by the Eigen device of the
+    // kernel to its thread budget.
+    ScopedPerThreadMaxParallelism max_parallelism(
+        op_kernel->max_intra_op_parallelism());
+    op_kernel->Compute(context);
+  } else {
+    op_kernel->Compute(context);
+  }
 
   if (context->status().ok() && node_file_writer_) {
     Status s = node_file_writer_->RecordNodeExecution(op_kernel, context);
@@ -211,7 +220,13 @@ void ThreadPoolDevice::ComputeAsync(AsyncOpKernel* op_kernel,
     };
   }
 
-  op_kernel->ComputeAsync(context, done);
+  if (op_kernel->max_intra_op_parallelism() > 0) {
+    ScopedPerThreadMaxParallelism max_parallelism(
+        op_kernel->max_intra_op_parallelism());
+    op_kernel->ComputeAsync(context, std::move(done));
+  } else {
+    op_kernel->ComputeAsync(context, std::move(done));
+  }
 }
 
 void ThreadPoolDevice::LogInputs(OpKernel* op_kernel,
@@ -368,6 +368,17 @@ auto* graph_optimization_cache_load_count = tsl::monitoring::Counter<1>::New(
     "source"  // graph optimization source
 );
 
+auto* grappler_graph_cache_lookups = tsl::monitoring::Counter<1>::New(
+    "/tensorflow/core/grappler/optimized_graph_cache_lookups",
+    "The number of lookups in the Grappler optimized graph cache. The result "
+    "can be memory_hit, disk_hit or miss.",
+    "result");
+
+auto* grappler_graph_cache_saving_time_usecs = tsl::monitoring::Counter<0>::New(
+    "/tensorflow/core/grappler/optimized_graph_cache_saving_time_usecs",
+    "The total time saved by reusing graphs of the Grappler optimized graph "
+    "cache in microseconds.");
+
 auto* xla_compilations = tsl::monitoring::Counter<0>::New(
     "/tensorflow/core/xla_compilations",
     "The number of XLA compilations used to collect "
@@ -812,6 +823,19 @@ int64_t GetFunctionGraphOptimizationCacheLoadCount(
   return graph_optimization_cache_load_count->GetCell(mapped_source)->value();
 }
 
+void RecordGrapplerGraphCacheLookup(const string& result,
+                                    uint64 saving_time_usecs) {
+  grappler_graph_cache_lookups->GetCell(result)->IncrementBy(1);
+  if (saving_time_usecs > 0) {
+    grappler_graph_cache_saving_time_usecs->GetCell()->IncrementBy(
+        saving_time_usecs);
+  }
+}
+
+int64_t GetGrapplerGraphCacheLookupCount(const string& result) {
+  return grappler_graph_cache_lookups->GetCell(result)->value();
+}
+
 void UpdateTpuVariableDistributionTime(const uint64 distribution_time_usecs) {
   if (distribution_time_usecs > 0) {
     tpu_variable_distribution_time_usecs->GetCell()->IncrementBy(
@@ -304,6 +304,15 @@ void IncrementFunctionGraphOptimizationCacheLoadCount(
 int64_t GetFunctionGraphOptimizationCacheLoadCount(
     GraphOptimizationSource source);
 
+// Records a lookup in the Grappler optimized graph cache. `result` is one of
+// "memory_hit", "disk_hit" or "miss". `saving_time_usecs` is the optimization
+// time that a hit saved.
+void RecordGrapplerGraphCacheLookup(const string& result,
+                                    uint64 saving_time_usecs = 0);
+
+// Gets the number of Grappler optimized graph cache lookups with `result`.
+int64_t GetGrapplerGraphCacheLookupCount(const string& result);
+
 // Records the activity of the first phase of the mlir bridge using the
 // tf_metadata.tf_mlir_bridge_first_phase_count metric.
 // device_type: tpu, cpu, gpu, etc.
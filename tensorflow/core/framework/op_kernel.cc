@@ -15,8 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/framework/op_kernel.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
+#include <limits>
 #include <mutex>  // NOLINT
 #include <string>
 #include <unordered_map>
@@ -62,6 +64,7 @@ namespace tensorflow {
 
 const char* kJitKernelLabel = "JITCompiledKernel";
 const char* kDisableJitKernelsEnvVar = "TF_DISABLE_JIT_KERNELS";
+const char* kIntraOpParallelismAttr = "_intra_op_parallelism";
 
 namespace {
 
@@ -122,6 +125,16 @@ bool ShouldLogNodeDef(OpKernel* op_kernel) {
   return ops_to_log_nodedefs.count(op_kernel->type_string());
 }
 
+// Returns the thread budget of the kernel of `node_def`, or 0 if it has none.
+int GetMaxIntraOpParallelism(const NodeDef& node_def) {
+  int64_t max_parallelism = 0;
+  if (!TryGetNodeAttr(node_def, kIntraOpParallelismAttr, &max_parallelism)) {
+    return 0;
+  }
+  return std::max<int64_t>(
+      0, std::min<int64_t>(max_parallelism, std::numeric_limits<int>::max()));
+}
+
 }  // namespace
 
 // OpKernel ------------------------------------------------------------------
@@ -151,6 +164,7 @@ OpKernel::OpKernel(OpKernelConstruction* context, bool is_deferred)
   expensive_ = context->device_type() != DeviceType(DEVICE_GPU) &&
                !DeviceFactory::IsPluggableDevice(
                    DeviceTypeString(context->device_type()));
+  max_intra_op_parallelism_ = GetMaxIntraOpParallelism(props_->node_def);
 
   if (ShouldLogNodeDef(this)) {
     LOG(INFO) << "NodeDef for " << name() << ":\n" << def().ShortDebugString();
@@ -183,6 +197,7 @@ OpKernel::OpKernel(OpKernelConstruction* context, NodeDef&& custom_def,
   expensive_ = context->device_type() != DeviceType(DEVICE_GPU) &&
                !DeviceFactory::IsPluggableDevice(
                    DeviceTypeString(context->device_type()));
+  max_intra_op_parallelism_ = GetMaxIntraOpParallelism(props_->node_def);
 }
 
 OpKernel::~OpKernel() {}
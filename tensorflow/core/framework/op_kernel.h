@@ -101,6 +101,11 @@ class StepStatsCollectorInterface;
 extern const char* kJitKernelLabel;
 extern const char* kDisableJitKernelsEnvVar;
 
+// Name of the integer node attribute bounding the number of threads a kernel
+// uses to parallelize its computation (see
+// OpKernel::max_intra_op_parallelism()).
+extern const char* kIntraOpParallelismAttr;
+
 class OpKernel {
  public:
   // OpKernel won't be instantiated by the scheduler, so you may perform
@@ -198,6 +203,11 @@ class OpKernel {
   // Returns `true` if and only if this kernel uses deferred execution.
   bool is_deferred() const { return is_deferred_; }
 
+  // Returns the maximum number of threads this kernel should use to
+  // parallelize its computation, as set by the kIntraOpParallelismAttr
+  // attribute of its node, or 0 if it may use all the threads of the device.
+  int max_intra_op_parallelism() const { return max_intra_op_parallelism_; }
+
   // Returns a trace string for current computation, op name/type and input
   // tensor shape/dtype are encoded for profiler cost analysis. Most OpKernel
   // should use the default implementation.
@@ -218,6 +228,7 @@ class OpKernel {
   const int graph_def_version_;
   const bool is_deferred_;
   bool expensive_;
+  int max_intra_op_parallelism_ = 0;
 
   OpKernel(const OpKernel&) = delete;
   void operator=(const OpKernel&) = delete;
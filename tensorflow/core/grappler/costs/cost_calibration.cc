@@ -0,0 +1,144 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/cost_calibration.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+
+#include "tensorflow/core/grappler/costs/robust_stats.h"
+#include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// Size bucket of the entries applying to all the sizes of an op.
+constexpr int kAllSizes = -1;
+
+}  // namespace
+
+CostCalibration::CostCalibration(const OpCostCalibration& proto)
+    : proto_(proto) {
+  for (const auto& entry : proto_.entry()) {
+    if (entry.correction() > 0) {
+      corrections_[{entry.op(), entry.size_bucket()}] = entry.correction();
+    }
+  }
+}
+
+int64_t CostCalibration::IoBytes(const OpInfo& op_info) {
+  int64_t io_bytes = 0;
+  for (const auto& input : op_info.inputs()) {
+    io_bytes += std::max<int64_t>(0, CalculateTensorSize(input));
+  }
+  for (const auto& output : op_info.outputs()) {
+    io_bytes += std::max<int64_t>(0, CalculateTensorSize(output));
+  }
+  return io_bytes;
+}
+
+int CostCalibration::SizeBucket(int64_t io_bytes) {
+  int bucket = 0;
+  while (io_bytes > 1) {
+    io_bytes >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+CostCalibration CostCalibration::Fit(
+    const DeviceProperties& device,
+    const std::vector<CostCalibrationSample>& samples) {
+  // Use ordered maps to emit the entries in a deterministic order.
+  std::map<std::pair<string, int>, std::vector<double>> log_ratios;
+  for (const CostCalibrationSample& sample : samples) {
+    if (sample.predicted_ns <= 0 || sample.measured_ns <= 0) continue;
+    const double log_ratio = std::log(sample.measured_ns / sample.predicted_ns);
+    log_ratios[{sample.op, SizeBucket(sample.io_bytes)}].push_back(log_ratio);
+    log_ratios[{sample.op, kAllSizes}].push_back(log_ratio);
+  }
+
+  OpCostCalibration proto;
+  *proto.mutable_device() = device;
+  for (const auto& key_and_values : log_ratios) {
+    OpCostCalibration::Entry* entry = proto.add_entry();
+    entry->set_op(key_and_values.first.first);
+    entry->set_size_bucket(key_and_values.first.second);
+    // Timings of short kernels are noisy, so use a mean that is robust to
+    // outliers. Averaging log ratios keeps over and under predictions by the
+    // same factor symmetric.
+    entry->set_correction(
+        std::exp(RobustStats(key_and_values.second).mean()));
+    entry->set_num_samples(key_and_values.second.size());
+  }
+  return CostCalibration(proto);
+}
+
+double CostCalibration::Correction(const OpInfo& op_info) const {
+  if (empty()) return 1.0;
+  if (!proto_.device().type().empty() &&
+      op_info.device().type() != proto_.device().type()) {
+    return 1.0;
+  }
+  return Correction(op_info.op(), IoBytes(op_info));
+}
+
+double CostCalibration::Correction(const string& op, int64_t io_bytes) const {
+  auto it = corrections_.find({op, SizeBucket(io_bytes)});
+  if (it != corrections_.end()) return it->second;
+  it = corrections_.find({op, kAllSizes});
+  if (it != corrections_.end()) return it->second;
+  return 1.0;
+}
+
+Status CostCalibration::Save(const string& path) const {
+  return WriteBinaryProto(Env::Default(), path, proto_);
+}
+
+Status CostCalibration::Load(const string& path,
+                             CostCalibration* calibration) {
+  OpCostCalibration proto;
+  TF_RETURN_IF_ERROR(ReadTextOrBinaryProto(Env::Default(), path, &proto));
+  *calibration = CostCalibration(proto);
+  return OkStatus();
+}
+
+const CostCalibration* CostCalibration::Global() {
+  static const CostCalibration* calibration = []() -> CostCalibration* {
+    const char* path = std::getenv(kCostCalibrationFileEnvVar);
+    if (path == nullptr || *path == '\0') return nullptr;
+    auto* calibration = new CostCalibration();
+    const Status status = Load(path, calibration);
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to load the cost model calibration from " << path
+                   << ": " << status;
+      delete calibration;
+      return nullptr;
+    }
+    VLOG(1) << "Loaded " << calibration->proto().entry_size()
+            << " cost model corrections from " << path;
+    return calibration;
+  }();
+  return calibration;
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
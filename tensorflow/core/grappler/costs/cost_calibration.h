@@ -0,0 +1,93 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_COST_CALIBRATION_H_
+#define TENSORFLOW_CORE_GRAPPLER_COSTS_COST_CALIBRATION_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Name of the environment variable pointing to the calibration used by all
+// the OpLevelCostEstimators of the process.
+constexpr char kCostCalibrationFileEnvVar[] =
+    "TF_GRAPPLER_COST_CALIBRATION_FILE";
+
+// Predicted and measured execution time of a single op.
+struct CostCalibrationSample {
+  string op;
+  // Total size in bytes of the op inputs and outputs.
+  int64_t io_bytes = 0;
+  double predicted_ns = 0;
+  double measured_ns = 0;
+};
+
+// Corrections to the execution times predicted by the OpLevelCostEstimator,
+// keyed by op type and by the size of the op inputs and outputs. The
+// roofline model used by the estimator can be off by an order of magnitude
+// for kernels that reach neither the peak compute rate nor the peak memory
+// bandwidth of the device; the corrections are fitted from kernel timings
+// measured on the target machine (see CostCalibrator).
+class CostCalibration {
+ public:
+  CostCalibration() = default;
+  explicit CostCalibration(const OpCostCalibration& proto);
+
+  // Returns the total size in bytes of the inputs and outputs of the op.
+  static int64_t IoBytes(const OpInfo& op_info);
+
+  // Returns the size bucket of an op reading and writing `io_bytes` bytes.
+  static int SizeBucket(int64_t io_bytes);
+
+  // Fits the corrections of every op type and size bucket in `samples`, as
+  // the robust mean of the log ratio of the measured to the predicted time.
+  static CostCalibration Fit(const DeviceProperties& device,
+                             const std::vector<CostCalibrationSample>& samples);
+
+  // Returns the factor by which the predicted execution time of the op should
+  // be multiplied. Uses the correction of the size bucket of the op if there
+  // is one, falls back to the correction of the op type, and returns 1 for
+  // unknown ops and ops placed on a different type of device.
+  double Correction(const OpInfo& op_info) const;
+  double Correction(const string& op, int64_t io_bytes) const;
+
+  bool empty() const { return corrections_.empty(); }
+  const OpCostCalibration& proto() const { return proto_; }
+
+  Status Save(const string& path) const;
+  static Status Load(const string& path, CostCalibration* calibration);
+
+  // Returns the calibration loaded from the file named by
+  // TF_GRAPPLER_COST_CALIBRATION_FILE, or nullptr if it is not set or the file
+  // can't be loaded.
+  static const CostCalibration* Global();
+
+ private:
+  OpCostCalibration proto_;
+  absl::flat_hash_map<std::pair<string, int>, double> corrections_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_COSTS_COST_CALIBRATION_H_
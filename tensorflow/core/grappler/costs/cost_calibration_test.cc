@@ -0,0 +1,137 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/cost_calibration.h"
+
+#include <cmath>
+
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+CostCalibrationSample Sample(const string& op, int64_t io_bytes,
+                             double predicted_ns, double measured_ns) {
+  CostCalibrationSample sample;
+  sample.op = op;
+  sample.io_bytes = io_bytes;
+  sample.predicted_ns = predicted_ns;
+  sample.measured_ns = measured_ns;
+  return sample;
+}
+
+DeviceProperties CpuDevice() {
+  DeviceProperties device;
+  device.set_type("CPU");
+  device.set_frequency(1000);
+  device.set_num_cores(1);
+  device.set_bandwidth(32);
+  return device;
+}
+
+OpContext ReluContext(int64_t size) {
+  OpContext op_context;
+  op_context.name = "relu";
+  op_context.op_info.set_op("Relu");
+  OpInfo::TensorProperties tensor;
+  tensor.set_dtype(DT_FLOAT);
+  tensor.mutable_shape()->add_dim()->set_size(size);
+  *op_context.op_info.add_inputs() = tensor;
+  *op_context.op_info.add_outputs() = tensor;
+  *op_context.op_info.mutable_device() = CpuDevice();
+  return op_context;
+}
+
+TEST(CostCalibrationTest, SizeBucket) {
+  EXPECT_EQ(CostCalibration::SizeBucket(0), 0);
+  EXPECT_EQ(CostCalibration::SizeBucket(1), 0);
+  EXPECT_EQ(CostCalibration::SizeBucket(2), 1);
+  EXPECT_EQ(CostCalibration::SizeBucket(1023), 9);
+  EXPECT_EQ(CostCalibration::SizeBucket(1024), 10);
+}
+
+TEST(CostCalibrationTest, FitsCorrectionsPerSizeBucket) {
+  const CostCalibration calibration = CostCalibration::Fit(
+      CpuDevice(),
+      {Sample("Relu", 1024, 100, 400), Sample("Relu", 1 << 20, 1000, 500)});
+
+  EXPECT_NEAR(calibration.Correction("Relu", 1024), 4.0, 1e-6);
+  EXPECT_NEAR(calibration.Correction("Relu", 1 << 20), 0.5, 1e-6);
+  // Sizes that were not measured use the correction of the op type, which is
+  // the geometric mean of all the measured ratios.
+  EXPECT_NEAR(calibration.Correction("Relu", 1 << 14), std::sqrt(2.0), 1e-6);
+  // Other ops are not corrected.
+  EXPECT_EQ(calibration.Correction("Tanh", 1024), 1.0);
+}
+
+TEST(CostCalibrationTest, IgnoresOpsOnOtherDevices) {
+  const CostCalibration calibration =
+      CostCalibration::Fit(CpuDevice(), {Sample("Relu", 4096, 100, 300)});
+  OpContext op_context = ReluContext(512);
+  EXPECT_NEAR(calibration.Correction(op_context.op_info), 3.0, 1e-6);
+
+  op_context.op_info.mutable_device()->set_type("GPU");
+  EXPECT_EQ(calibration.Correction(op_context.op_info), 1.0);
+}
+
+TEST(CostCalibrationTest, SaveAndLoad) {
+  const CostCalibration calibration = CostCalibration::Fit(
+      CpuDevice(),
+      {Sample("Relu", 4096, 100, 300), Sample("MatMul", 1 << 20, 100, 50)});
+  const string path =
+      io::JoinPath(testing::TmpDir(), "cost_calibration_test.pb");
+  TF_ASSERT_OK(calibration.Save(path));
+
+  CostCalibration loaded;
+  TF_ASSERT_OK(CostCalibration::Load(path, &loaded));
+  EXPECT_EQ(loaded.proto().entry_size(), calibration.proto().entry_size());
+  EXPECT_NEAR(loaded.Correction("Relu", 4096), 3.0, 1e-6);
+  EXPECT_NEAR(loaded.Correction("MatMul", 1 << 20), 0.5, 1e-6);
+
+  EXPECT_FALSE(
+      CostCalibration::Load(io::JoinPath(testing::TmpDir(), "missing.pb"),
+                            &loaded)
+          .ok());
+}
+
+TEST(CostCalibrationTest, CorrectsOpLevelCostEstimates) {
+  OpLevelCostEstimator estimator;
+  estimator.set_calibration(nullptr);
+  const OpContext op_context = ReluContext(1 << 16);
+  const Costs uncalibrated = estimator.PredictCosts(op_context);
+  ASSERT_GT(uncalibrated.execution_time.count(), 0);
+
+  const CostCalibration calibration = CostCalibration::Fit(
+      CpuDevice(),
+      {Sample("Relu", CostCalibration::IoBytes(op_context.op_info), 100, 250)});
+  estimator.set_calibration(&calibration);
+  const Costs calibrated = estimator.PredictCosts(op_context);
+  EXPECT_NEAR(calibrated.execution_time.count(),
+              uncalibrated.execution_time.count() * 2.5, 1);
+  EXPECT_NEAR(calibrated.compute_time.count(),
+              uncalibrated.compute_time.count() * 2.5, 1);
+  EXPECT_NEAR(calibrated.memory_time.count(),
+              uncalibrated.memory_time.count() * 2.5, 1);
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
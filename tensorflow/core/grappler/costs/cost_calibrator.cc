@@ -0,0 +1,320 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/cost_calibrator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/costs/analytical_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/measuring_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/robust_stats.h"
+#include "tensorflow/core/grappler/costs/virtual_scheduler.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+constexpr char kBenchmarkNodeName[] = "calibration_op";
+
+OpInfo::TensorProperties FloatTensor(const std::vector<int64_t>& dims) {
+  OpInfo::TensorProperties tensor;
+  tensor.set_dtype(DT_FLOAT);
+  for (int64_t dim : dims) {
+    tensor.mutable_shape()->add_dim()->set_size(dim);
+  }
+  return tensor;
+}
+
+OpInfo Benchmark(const string& op, const DeviceProperties& device,
+                 const std::vector<OpInfo::TensorProperties>& inputs,
+                 const OpInfo::TensorProperties& output) {
+  OpInfo op_info;
+  op_info.set_op(op);
+  (*op_info.mutable_attr())["T"].set_type(DT_FLOAT);
+  for (const auto& input : inputs) *op_info.add_inputs() = input;
+  *op_info.add_outputs() = output;
+  *op_info.mutable_device() = device;
+  return op_info;
+}
+
+// Returns the mean absolute log2 ratio of the predicted to the measured time,
+// i.e. 1 if the predictions are off by a factor of 2 on average.
+double MeanLog2Error(const std::vector<double>& predicted_ns,
+                     const std::vector<double>& measured_ns) {
+  double error = 0;
+  for (int i = 0; i < predicted_ns.size(); ++i) {
+    error += std::abs(std::log2(predicted_ns[i] / measured_ns[i]));
+  }
+  return predicted_ns.empty() ? 0 : error / predicted_ns.size();
+}
+
+}  // namespace
+
+CostCalibrator::CostCalibrator(Cluster* cluster, int measurement_steps)
+    : cluster_(cluster), measurement_steps_(measurement_steps) {
+  CHECK_GE(measurement_steps, 1);
+}
+
+std::vector<OpInfo> CostCalibrator::DefaultBenchmarks(
+    const DeviceProperties& device) {
+  std::vector<OpInfo> benchmarks;
+
+  // Elementwise ops, from cache resident to memory bound sizes.
+  for (int64_t size : {1 << 10, 1 << 14, 1 << 18, 1 << 22}) {
+    const OpInfo::TensorProperties tensor = FloatTensor({size});
+    for (const char* op : {"Relu", "Tanh", "Sigmoid", "Exp", "Rsqrt"}) {
+      benchmarks.push_back(Benchmark(op, device, {tensor}, tensor));
+    }
+    for (const char* op : {"AddV2", "Mul", "RealDiv", "Maximum"}) {
+      benchmarks.push_back(Benchmark(op, device, {tensor, tensor}, tensor));
+    }
+  }
+
+  // Matrix multiplications.
+  for (int64_t size : {32, 128, 512, 1024}) {
+    const OpInfo::TensorProperties matrix = FloatTensor({size, size});
+    OpInfo matmul = Benchmark("MatMul", device, {matrix, matrix}, matrix);
+    (*matmul.mutable_attr())["transpose_a"].set_b(false);
+    (*matmul.mutable_attr())["transpose_b"].set_b(false);
+    benchmarks.push_back(std::move(matmul));
+  }
+
+  // Convolutions of typical image models.
+  for (const auto& shape : std::vector<std::vector<int64_t>>{
+           {8, 56, 56, 64}, {8, 28, 28, 128}, {8, 14, 14, 256}}) {
+    const int64_t depth = shape[3];
+    const OpInfo::TensorProperties filter = FloatTensor({3, 3, depth, depth});
+    OpInfo conv = Benchmark("Conv2D", device, {FloatTensor(shape), filter},
+                            FloatTensor(shape));
+    auto* strides = (*conv.mutable_attr())["strides"].mutable_list();
+    for (int i = 0; i < 4; ++i) strides->add_i(1);
+    (*conv.mutable_attr())["padding"].set_s("SAME");
+    (*conv.mutable_attr())["data_format"].set_s("NHWC");
+    benchmarks.push_back(std::move(conv));
+  }
+
+  return benchmarks;
+}
+
+Status CostCalibrator::MeasureOp(const OpInfo& op_info,
+                                 double* measured_ns) const {
+  GrapplerItem item;
+  item.id = absl::StrCat("calibration_", op_info.op());
+  NodeDef* op_node = item.graph.add_node();
+  op_node->set_name(kBenchmarkNodeName);
+  op_node->set_op(op_info.op());
+  op_node->mutable_attr()->insert(op_info.attr().begin(),
+                                  op_info.attr().end());
+  for (int i = 0; i < op_info.inputs_size(); ++i) {
+    const OpInfo::TensorProperties& input = op_info.inputs(i);
+    // Feed the inputs rather than using constants, which could be folded.
+    NodeDef* placeholder = item.graph.add_node();
+    placeholder->set_name(absl::StrCat("input_", i));
+    placeholder->set_op("Placeholder");
+    (*placeholder->mutable_attr())["dtype"].set_type(input.dtype());
+    op_node->add_input(placeholder->name());
+
+    TensorProto value = input.value();
+    if (!input.has_value()) {
+      if (!TensorShape::IsValid(input.shape())) {
+        return errors::InvalidArgument("Input ", i, " of ", op_info.op(),
+                                       " has an unknown shape");
+      }
+      // A tensor proto without any value is parsed as a tensor of zeros.
+      value.set_dtype(input.dtype());
+      *value.mutable_tensor_shape() = input.shape();
+    }
+    Tensor tensor;
+    if (!tensor.FromProto(value)) {
+      return errors::InvalidArgument("Invalid value of input ", i, " of ",
+                                     op_info.op());
+    }
+    item.feed.emplace_back(placeholder->name(), std::move(tensor));
+  }
+  item.fetch.push_back(kBenchmarkNodeName);
+  TF_RETURN_IF_ERROR(cluster_->Initialize(item));
+
+  std::vector<double> times;
+  // The first run is a warmup, that also creates the kernel.
+  for (int step = -1; step < measurement_steps_; ++step) {
+    RunMetadata metadata;
+    TF_RETURN_IF_ERROR(
+        cluster_->Run(item.graph, item.feed, item.fetch, &metadata));
+    if (step < 0) continue;
+    for (const DeviceStepStats& dev_stats : metadata.step_stats().dev_stats()) {
+      for (const NodeExecStats& node_stats : dev_stats.node_stats()) {
+        if (node_stats.node_name() != kBenchmarkNodeName) continue;
+        if (node_stats.op_end_rel_nanos() > 0) {
+          times.push_back(node_stats.op_end_rel_nanos() -
+                          node_stats.op_start_rel_nanos());
+        } else {
+          times.push_back(1e3 * (node_stats.op_end_rel_micros() -
+                                 node_stats.op_start_rel_micros()));
+        }
+      }
+    }
+  }
+  if (times.empty()) {
+    return errors::Unavailable("No timings were collected for ",
+                               op_info.op(),
+                               ", detailed stats might be disabled");
+  }
+  *measured_ns = RobustStats(times).mean();
+  return OkStatus();
+}
+
+Status CostCalibrator::Calibrate(const std::vector<OpInfo>& benchmarks,
+                                 std::vector<CostCalibrationSample>* samples,
+                                 CostCalibration* calibration) const {
+  OpLevelCostEstimator estimator;
+  // Fit the corrections to the uncorrected predictions.
+  estimator.set_calibration(nullptr);
+
+  for (const OpInfo& op_info : benchmarks) {
+    CostCalibrationSample sample;
+    sample.op = op_info.op();
+    sample.io_bytes = CostCalibration::IoBytes(op_info);
+
+    OpContext op_context;
+    op_context.name = kBenchmarkNodeName;
+    op_context.op_info = op_info;
+    const Costs costs = estimator.PredictCosts(op_context);
+    if (costs.inaccurate) {
+      VLOG(1) << "Skipping calibration of " << op_info.op()
+              << ", its cost can't be predicted accurately";
+      continue;
+    }
+    sample.predicted_ns = costs.execution_time.count();
+
+    const Status status = MeasureOp(op_info, &sample.measured_ns);
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to measure " << op_info.ShortDebugString()
+                   << ": " << status;
+      continue;
+    }
+    VLOG(1) << op_info.op() << " with " << sample.io_bytes
+            << " bytes of inputs and outputs: predicted "
+            << sample.predicted_ns << " ns, measured " << sample.measured_ns
+            << " ns";
+    samples->push_back(std::move(sample));
+  }
+
+  if (samples->empty()) {
+    return errors::Unavailable("None of the calibration benchmarks ran");
+  }
+  *calibration = CostCalibration::Fit(
+      benchmarks.empty() ? DeviceProperties() : benchmarks.front().device(),
+      *samples);
+  return OkStatus();
+}
+
+string CostCalibrator::AccuracyReport(
+    const std::vector<CostCalibrationSample>& samples,
+    const CostCalibration& calibration) {
+  struct OpErrors {
+    std::vector<double> predicted_ns;
+    std::vector<double> calibrated_ns;
+    std::vector<double> measured_ns;
+  };
+  std::map<string, OpErrors> errors_per_op;
+  OpErrors all_errors;
+  for (const CostCalibrationSample& sample : samples) {
+    if (sample.predicted_ns <= 0 || sample.measured_ns <= 0) continue;
+    const double calibrated_ns =
+        sample.predicted_ns *
+        calibration.Correction(sample.op, sample.io_bytes);
+    for (OpErrors* errors : {&errors_per_op[sample.op], &all_errors}) {
+      errors->predicted_ns.push_back(sample.predicted_ns);
+      errors->calibrated_ns.push_back(calibrated_ns);
+      errors->measured_ns.push_back(sample.measured_ns);
+    }
+  }
+
+  // Errors are reported as the mean absolute log2 ratio of the predicted to
+  // the measured times.
+  string report = absl::StrFormat("%-24s %8s %12s %12s\n", "Op", "Samples",
+                                  "Error", "Calibrated");
+  auto add_row = [&report](const string& name, const OpErrors& errors) {
+    absl::StrAppendFormat(
+        &report, "%-24s %8d %12.3f %12.3f\n", name, errors.measured_ns.size(),
+        MeanLog2Error(errors.predicted_ns, errors.measured_ns),
+        MeanLog2Error(errors.calibrated_ns, errors.measured_ns));
+  };
+  for (const auto& op_and_errors : errors_per_op) {
+    add_row(op_and_errors.first, op_and_errors.second);
+  }
+  add_row("All", all_errors);
+  return report;
+}
+
+Status CostCalibrator::CompareStepTimes(const GrapplerItem& item,
+                                        const CostCalibration& calibration,
+                                        StepTimeComparison* comparison) const {
+  MeasuringCostEstimator measuring_estimator(cluster_, measurement_steps_,
+                                             /*measurement_threads=*/0);
+  TF_RETURN_IF_ERROR(measuring_estimator.Initialize(item));
+  Costs measured_costs;
+  TF_RETURN_IF_ERROR(
+      measuring_estimator.PredictCosts(item.graph, nullptr, &measured_costs));
+  comparison->measured = measured_costs.execution_time;
+
+  auto predict = [&](const CostCalibration* node_calibration,
+                     Costs::Duration* step_time) -> Status {
+    auto node_estimator = std::make_unique<OpLevelCostEstimator>();
+    node_estimator->set_calibration(node_calibration);
+    AnalyticalCostEstimator estimator(
+        cluster_, std::move(node_estimator),
+        ReadyNodeManagerFactory("FirstReady"),
+        /*use_static_shapes=*/true, /*use_aggressive_shape_inference=*/true);
+    TF_RETURN_IF_ERROR(estimator.Initialize(item));
+    Costs costs;
+    TF_RETURN_IF_ERROR(estimator.PredictCosts(item.graph, nullptr, &costs));
+    *step_time = costs.execution_time;
+    return OkStatus();
+  };
+  TF_RETURN_IF_ERROR(predict(nullptr, &comparison->predicted));
+  TF_RETURN_IF_ERROR(predict(&calibration, &comparison->calibrated));
+
+  VLOG(1) << "Step time of " << item.id << ": measured "
+          << comparison->measured.count() << " ns, predicted "
+          << comparison->predicted.count() << " ns, calibrated "
+          << comparison->calibrated.count() << " ns";
+  return OkStatus();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,100 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_COST_CALIBRATOR_H_
+#define TENSORFLOW_CORE_GRAPPLER_COSTS_COST_CALIBRATOR_H_
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/grappler/costs/cost_calibration.h"
+#include "tensorflow/core/grappler/costs/cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+namespace grappler {
+
+class Cluster;
+struct GrapplerItem;
+
+// Step time of a graph as measured, and as predicted by the analytical cost
+// model with and without calibration.
+struct StepTimeComparison {
+  Costs::Duration measured;
+  Costs::Duration predicted;
+  Costs::Duration calibrated;
+};
+
+// Fits a CostCalibration for the OpLevelCostEstimator by running single op
+// microbenchmarks on the machine of a cluster. Typical use:
+//
+//   SingleMachine cluster(...);
+//   TF_RETURN_IF_ERROR(cluster.Provision());
+//   CostCalibrator calibrator(&cluster, /*measurement_steps=*/10);
+//   std::vector<CostCalibrationSample> samples;
+//   CostCalibration calibration;
+//   TF_RETURN_IF_ERROR(calibrator.Calibrate(
+//       CostCalibrator::DefaultBenchmarks(GetLocalCPUInfo()), &samples,
+//       &calibration));
+//   LOG(INFO) << CostCalibrator::AccuracyReport(samples, calibration);
+//   TF_RETURN_IF_ERROR(calibration.Save(path));
+//
+// The saved calibration is then used by every OpLevelCostEstimator of the
+// processes started with TF_GRAPPLER_COST_CALIBRATION_FILE=path.
+class CostCalibrator {
+ public:
+  // Runs every benchmark `measurement_steps` times, after one warmup run.
+  // Does not take ownership of the cluster, which must be provisioned.
+  CostCalibrator(Cluster* cluster, int measurement_steps);
+
+  // Returns benchmarks of common op types over a range of sizes, placed on
+  // `device`.
+  static std::vector<OpInfo> DefaultBenchmarks(const DeviceProperties& device);
+
+  // Measures the execution time of the kernel of the op described by
+  // `op_info`. The inputs of the op are fed with their value if it is known,
+  // and with zeros otherwise, so their shapes must be fully defined.
+  Status MeasureOp(const OpInfo& op_info, double* measured_ns) const;
+
+  // Measures and predicts the execution time of every benchmark, appends the
+  // results to `samples` and fits `calibration` from all the samples. All the
+  // benchmarks must be placed on the same device. Benchmarks that fail to run
+  // are skipped.
+  Status Calibrate(const std::vector<OpInfo>& benchmarks,
+                   std::vector<CostCalibrationSample>* samples,
+                   CostCalibration* calibration) const;
+
+  // Returns a table of the prediction error of every op type in `samples`,
+  // before and after applying `calibration`.
+  static string AccuracyReport(
+      const std::vector<CostCalibrationSample>& samples,
+      const CostCalibration& calibration);
+
+  // Measures the step time of `item`, and predicts it with the analytical cost
+  // estimator with and without `calibration`.
+  Status CompareStepTimes(const GrapplerItem& item,
+                          const CostCalibration& calibration,
+                          StepTimeComparison* comparison) const;
+
+ private:
+  Cluster* cluster_;  // Not owned.
+  const int measurement_steps_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_COSTS_COST_CALIBRATOR_H_
@@ -0,0 +1,115 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/cost_calibrator.h"
+
+#include <memory>
+
+#include "absl/strings/match.h"
+#include "tensorflow/core/grappler/clusters/single_machine.h"
+#include "tensorflow/core/grappler/clusters/utils.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/inputs/trivial_test_graph_input_yielder.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class CostCalibratorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    cluster_ = std::make_unique<SingleMachine>(/*timeout_s=*/60,
+                                               /*num_cpu_cores=*/1,
+                                               /*num_gpus=*/0);
+    TF_CHECK_OK(cluster_->Provision());
+  }
+
+  void TearDown() override { TF_CHECK_OK(cluster_->Shutdown()); }
+
+  std::unique_ptr<SingleMachine> cluster_;
+};
+
+TEST_F(CostCalibratorTest, MeasuresOps) {
+  CostCalibrator calibrator(cluster_.get(), /*measurement_steps=*/3);
+  for (const OpInfo& op_info :
+       CostCalibrator::DefaultBenchmarks(GetLocalCPUInfo())) {
+    if (op_info.op() != "Relu" && op_info.op() != "MatMul") continue;
+    double measured_ns = 0;
+    TF_ASSERT_OK(calibrator.MeasureOp(op_info, &measured_ns));
+    EXPECT_GT(measured_ns, 0) << op_info.ShortDebugString();
+  }
+}
+
+TEST_F(CostCalibratorTest, RejectsUnknownShapes) {
+  CostCalibrator calibrator(cluster_.get(), /*measurement_steps=*/1);
+  OpInfo op_info;
+  op_info.set_op("Relu");
+  (*op_info.mutable_attr())["T"].set_type(DT_FLOAT);
+  OpInfo::TensorProperties* input = op_info.add_inputs();
+  input->set_dtype(DT_FLOAT);
+  input->mutable_shape()->add_dim()->set_size(-1);
+  double measured_ns = 0;
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(calibrator.MeasureOp(op_info, &measured_ns)));
+}
+
+TEST_F(CostCalibratorTest, CalibratesAndReports) {
+  CostCalibrator calibrator(cluster_.get(), /*measurement_steps=*/3);
+  std::vector<OpInfo> benchmarks;
+  for (const OpInfo& op_info :
+       CostCalibrator::DefaultBenchmarks(GetLocalCPUInfo())) {
+    if (op_info.op() == "AddV2" || op_info.op() == "Tanh") {
+      benchmarks.push_back(op_info);
+    }
+  }
+  std::vector<CostCalibrationSample> samples;
+  CostCalibration calibration;
+  TF_ASSERT_OK(calibrator.Calibrate(benchmarks, &samples, &calibration));
+  EXPECT_EQ(samples.size(), benchmarks.size());
+  EXPECT_FALSE(calibration.empty());
+  EXPECT_EQ(calibration.proto().device().type(), "CPU");
+  for (const CostCalibrationSample& sample : samples) {
+    EXPECT_GT(calibration.Correction(sample.op, sample.io_bytes), 0);
+  }
+
+  const string report = CostCalibrator::AccuracyReport(samples, calibration);
+  EXPECT_TRUE(absl::StrContains(report, "AddV2")) << report;
+  EXPECT_TRUE(absl::StrContains(report, "Tanh")) << report;
+  EXPECT_TRUE(absl::StrContains(report, "All")) << report;
+}
+
+TEST_F(CostCalibratorTest, ComparesStepTimes) {
+  TrivialTestGraphInputYielder fake_input(/*num_stages=*/4, /*width=*/1,
+                                          /*tensor_size=*/10,
+                                          /*insert_queue=*/false,
+                                          {"/CPU:0"});
+  GrapplerItem item;
+  ASSERT_TRUE(fake_input.NextItem(&item));
+
+  CostCalibrator calibrator(cluster_.get(), /*measurement_steps=*/3);
+  StepTimeComparison comparison;
+  TF_ASSERT_OK(
+      calibrator.CompareStepTimes(item, CostCalibration(), &comparison));
+  EXPECT_GT(comparison.measured.count(), 0);
+  EXPECT_GT(comparison.predicted.count(), 0);
+  // An empty calibration doesn't change the prediction.
+  EXPECT_EQ(comparison.calibrated, comparison.predicted);
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -15,8 +15,13 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 
+#include <list>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
 #include "absl/hash/hash.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/graph_constructor.h"
 #include "tensorflow/core/framework/common_shape_fns.h"
@@ -37,7 +42,10 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/gtl/flatset.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -491,6 +499,77 @@ uint64 NumElementsFromTensorProto(const TensorProto& tensor_proto) {
   return num_elements;
 }
 
+// Caches the output properties of function bodies across GraphProperties
+// instances. A function is typically inferred with the same input shapes and
+// values at every call site, and again every time an optimizer rebuilds the
+// properties of the graph. Entries are keyed by the function, the library it
+// was instantiated from and the nodes its inputs were bound to, which hold the
+// input shapes and values.
+class FunctionPropertiesCache {
+ public:
+  static FunctionPropertiesCache* Global() {
+    static FunctionPropertiesCache* cache = new FunctionPropertiesCache();
+    return cache;
+  }
+
+  static Fprint128 Key(const string& function_name, uint64 library_fingerprint,
+                       int graph_def_version,
+                       absl::Span<const NodeDef* const> bound_inputs,
+                       bool aggressive_shape_inference) {
+    Fprint128 key = tsl::FingerprintCat128(Fingerprint128(function_name),
+                                           library_fingerprint);
+    key = tsl::FingerprintCat128(key, graph_def_version);
+    key = tsl::FingerprintCat128(key, aggressive_shape_inference ? 1 : 0);
+    std::string serialized;
+    for (const NodeDef* input : bound_inputs) {
+      SerializeToStringDeterministic(*input, &serialized);
+      key = tsl::FingerprintCat128(key, Fingerprint128(serialized));
+    }
+    return key;
+  }
+
+  bool Lookup(const Fprint128& key,
+              std::vector<OpInfo::TensorProperties>* output_properties) {
+    mutex_lock lock(mu_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return false;
+    // Move the entry to the front of the LRU list.
+    lru_.splice(lru_.begin(), lru_, it->second);
+    *output_properties = it->second->second;
+    return true;
+  }
+
+  void Insert(const Fprint128& key,
+              std::vector<OpInfo::TensorProperties> output_properties) {
+    mutex_lock lock(mu_);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      lru_.splice(lru_.begin(), lru_, it->second);
+      it->second->second = std::move(output_properties);
+      return;
+    }
+    // Bounds the memory of the cache by evicting the least recently used
+    // entry, so the functions of the graphs being optimized stay cached.
+    if (entries_.size() >= kMaxEntries) {
+      entries_.erase(lru_.back().first);
+      lru_.pop_back();
+    }
+    lru_.emplace_front(key, std::move(output_properties));
+    entries_.emplace(key, lru_.begin());
+  }
+
+ private:
+  using Entry = std::pair<Fprint128, std::vector<OpInfo::TensorProperties>>;
+
+  static constexpr int kMaxEntries = 10000;
+
+  mutex mu_;
+  // Most recently used entries first.
+  std::list<Entry> lru_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<Fprint128, std::list<Entry>::iterator, Fprint128Hasher>
+      entries_ TF_GUARDED_BY(mu_);
+};
+
 }  // namespace
 
 // Note that tensor_as_shape input should not include kUnknownDimFromConst.
@@ -648,8 +727,9 @@ class SymbolicShapeRefiner {
   explicit SymbolicShapeRefiner(
       const GraphView& graph,
       const absl::flat_hash_map<string, absl::flat_hash_set<int>>& fed_ports,
-      const bool aggressive_shape_inference)
+      const bool aggressive_shape_inference, GraphProperties* graph_properties)
       : graph_(graph),
+        graph_properties_(graph_properties),
         function_library_(OpRegistry::Global(), graph.graph()->library()),
         fed_ports_(fed_ports),
         aggressive_shape_inference_(aggressive_shape_inference) {
@@ -885,6 +965,14 @@ class SymbolicShapeRefiner {
       }
     }
 
+    // The input nodes keep their names when they are replaced with constants
+    // below. Together they describe how the function is specialized.
+    std::vector<string> input_node_names;
+    input_node_names.reserve(grappler_function_item.inputs().size());
+    for (const auto& fun_input : grappler_function_item.inputs()) {
+      input_node_names.push_back(fun_input.node_name);
+    }
+
     // ReplaceInputWithConst() may break GraphView's internal node mapping
     // structure; hence, we separately build node name to NodeDef* map, for the
     // output nodes (before GraphView becomes invalid). Note that we use string,
@@ -936,38 +1024,71 @@ class SymbolicShapeRefiner {
       output_node->mutable_attr()->erase("index");
     }
 
-    // Perform inference on function body.
-    GraphProperties gp(grappler_function_item);
-    TF_RETURN_IF_ERROR(gp.InferStatically(
-        /*assume_valid_feeds=*/true,
-        /*aggressive_shape_inference=*/aggressive_shape_inference_,
-        /*include_tensor_values=*/true));
+    // Perform inference on function body, unless the same function was
+    // inferred before with the same input shapes and values.
+    absl::flat_hash_map<absl::string_view, const NodeDef*> body_nodes;
+    for (const NodeDef& node : grappler_function_item.graph.node()) {
+      body_nodes.emplace(node.name(), &node);
+    }
+    std::vector<const NodeDef*> bound_inputs;
+    bound_inputs.reserve(input_node_names.size());
+    for (const string& input_node_name : input_node_names) {
+      auto input_node = body_nodes.find(input_node_name);
+      if (input_node == body_nodes.end()) {
+        return errors::FailedPrecondition("Unable to find function input ",
+                                          input_node_name, " for ",
+                                          function_node->name());
+      }
+      bound_inputs.push_back(input_node->second);
+    }
+    const Fprint128 cache_key = FunctionPropertiesCache::Key(
+        function.name(), LibraryFingerprint(), graph_def_version_,
+        bound_inputs, aggressive_shape_inference_);
+    std::vector<OpInfo::TensorProperties> function_outputs;
+    if (!FunctionPropertiesCache::Global()->Lookup(cache_key,
+                                                   &function_outputs)) {
+      GraphProperties gp(grappler_function_item);
+      // The body library is the subset of our library reachable from the
+      // function, so its fingerprint follows from ours without serializing it.
+      gp.function_library_fingerprint_ = tsl::FingerprintCat64(
+          LibraryFingerprint(), Fingerprint64(function.name()));
+      TF_RETURN_IF_ERROR(gp.InferStatically(
+          /*assume_valid_feeds=*/true,
+          /*aggressive_shape_inference=*/aggressive_shape_inference_,
+          /*include_tensor_values=*/true));
+
+      for (auto const& out_arg : grappler_function_item.outputs()) {
+        // It is guaranteed that output_tensors does not contain any control
+        // inputs, so port_id >= 0.
+        TensorId out_tensor = ParseTensorName(out_arg.node_name);
+
+        if (output_nodes.count(out_tensor.node()) <= 0) {
+          return errors::FailedPrecondition(
+              "Unable to find return function_node ", out_tensor.node(),
+              " for ", function_node->name());
+        }
+        const NodeDef* retnode = output_nodes[out_tensor.node()];
+
+        const auto& output_properties =
+            gp.GetOutputProperties(retnode->name());
+        int output_properties_size = output_properties.size();
+        if (out_tensor.index() >= output_properties_size) {
+          return errors::InvalidArgument(
+              out_tensor.ToString(), " has invalid position ",
+              out_tensor.index(),
+              " (output_properties.size() = ", output_properties.size(), ").");
+        }
+        function_outputs.push_back(output_properties[out_tensor.index()]);
+      }
+      FunctionPropertiesCache::Global()->Insert(cache_key, function_outputs);
+    }
 
     // Add return nodes for output shapes.
     int output = 0;
     ctx->output_tensors_as_shapes.resize(grappler_function_item.output_size());
     ctx->output_tensor_protos.resize(grappler_function_item.output_size(),
                                      nullptr);
-    for (auto const& out_arg : grappler_function_item.outputs()) {
-      // It is guaranteed that output_tensors does not contain any control
-      // inputs, so port_id >= 0.
-      TensorId out_tensor = ParseTensorName(out_arg.node_name);
-
-      if (output_nodes.count(out_tensor.node()) <= 0) {
-        return errors::FailedPrecondition(
-            "Unable to find return function_node ", out_tensor.node(), " for ",
-            function_node->name());
-      }
-      const NodeDef* retnode = output_nodes[out_tensor.node()];
-
-      auto output_properties = gp.GetOutputProperties(retnode->name());
-      int output_properties_size = output_properties.size();
-      if (out_tensor.index() >= output_properties_size) {
-        return errors::InvalidArgument(
-            out_tensor.ToString(), " has invalid position ", out_tensor.index(),
-            " (output_properties.size() = ", output_properties.size(), ").");
-      }
-      auto& outprop = output_properties[out_tensor.index()];
+    for (const auto& outprop : function_outputs) {
       TensorShapeProto shape = outprop.shape();
       NormalizeShapeForOutput(&shape);
       ShapeHandle out;
@@ -1388,6 +1509,10 @@ class SymbolicShapeRefiner {
   }
 
  private:
+  uint64 LibraryFingerprint() {
+    return graph_properties_->FunctionLibraryFingerprint();
+  }
+
   // Return the one ShapeHandle used to denote a fully unknown shape for a node
   // output.
   ShapeHandle GetUnknownOutputShape(const NodeDef* node, int index) {
@@ -2043,6 +2168,7 @@ class SymbolicShapeRefiner {
   }
 
   const GraphView& graph_;
+  GraphProperties* graph_properties_;
   int graph_def_version_;
   absl::flat_hash_map<const NodeDef*, NodeContext> node_to_context_;
   absl::flat_hash_map<ShapeId, ShapeHandle> unknown_shapes_;
@@ -2052,6 +2178,7 @@ class SymbolicShapeRefiner {
   absl::flat_hash_map<string, absl::optional<GrapplerFunctionItem>>
       fun_to_grappler_function_item_;
   FunctionLibraryDefinition function_library_;
+  // Fingerprint of the function library of the graph, computed on first use.
   const absl::flat_hash_map<string, absl::flat_hash_set<int>>& fed_ports_;
   // Store TensorProtos for tensor value propagation. Note that we use deque,
   // not vector, as we use pointers to the TensorProtos in this container.
@@ -2514,6 +2641,15 @@ Status GraphProperties::UpdateEnqueue(
   return OkStatus();
 }
 
+uint64 GraphProperties::FunctionLibraryFingerprint() {
+  if (!function_library_fingerprint_.has_value()) {
+    std::string serialized;
+    SerializeToStringDeterministic(item_.graph.library(), &serialized);
+    function_library_fingerprint_ = Fingerprint64(serialized);
+  }
+  return *function_library_fingerprint_;
+}
+
 Status GraphProperties::InferStatically(bool assume_valid_feeds,
                                         bool aggressive_shape_inference,
                                         bool include_input_tensor_values,
@@ -2605,7 +2741,7 @@ Status GraphProperties::InferStatically(bool assume_valid_feeds,
   // Heap-allocate SymbolicShapeRefiner in order to not consume a large amount
   // of stack space.
   auto refiner = std::make_unique<SymbolicShapeRefiner>(
-      graph_view, fed_ports, aggressive_shape_inference);
+      graph_view, fed_ports, aggressive_shape_inference, this);
 
   TopoQueue new_shapes(topo_order);
   // Also seed the propagation of shapes in the fanout of primary inputs.
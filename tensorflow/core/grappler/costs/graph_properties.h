@@ -21,6 +21,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/types/optional.h"
 #include "tensorflow/core/framework/shape_inference.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
 #include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
@@ -159,6 +160,13 @@ class GraphProperties {
   }
 
  private:
+  friend class SymbolicShapeRefiner;
+
+  // Returns the fingerprint of the function library of the item, which keys
+  // the cache of inferred function outputs. Computed on first use, so graphs
+  // without function calls never serialize their library.
+  uint64 FunctionLibraryFingerprint();
+
   // Relaxes shapes <shapes_and_types>, determined from an EnqueueV2 node, into
   // <*queue_shapes_and_types>.
   static Status RelaxEnqueueShapesAndMergeTypes(
@@ -207,6 +215,9 @@ class GraphProperties {
   absl::flat_hash_map<string, std::vector<OpInfo::TensorProperties>>
       output_properties_;
   const std::vector<OpInfo::TensorProperties> missing_properties_;
+  // Set by FunctionLibraryFingerprint(), or by the parent GraphProperties when
+  // inferring the body of a function call.
+  absl::optional<uint64> function_library_fingerprint_;
 
   // Nodes with output shape incompatible between shape inference and
   // annotation.
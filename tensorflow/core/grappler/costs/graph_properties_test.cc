@@ -1554,6 +1554,49 @@ TEST_F(GraphPropertiesTest, FunctionReturnTensorValue) {
                      properties.GetInputProperties("MyFunc")[0].value());
 }
 
+TEST_F(GraphPropertiesTest, FunctionCallsWithDifferentInputs) {
+  FunctionDefLibrary library;
+  *library.add_function() = FunctionDefHelper::Create(
+      "MyFunc",                                                   // Name
+      {"x: int32"},                                               // Inputs
+      {"out: int32"},                                             // Outputs
+      {},                                                         // Attrs
+      {{{"a"}, "Identity", {"x"}, {{"T", DataType::DT_INT32}}}},  // Nodes
+      {{"out", "a:output:0"}});                                   // Returns
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  TF_ASSERT_OK(s.graph()->AddFunctionLibrary(library));
+
+  // The output properties of function bodies are cached across call sites and
+  // GraphProperties instances, but only for the same input shapes and values.
+  Output short_input = ops::Const(s.WithOpName("short"), {5, 7}, {2});
+  Output long_input = ops::Const(s.WithOpName("long"), {1, 2, 3}, {3});
+  for (const auto& [name, input] :
+       {std::make_pair("MyFuncShort", short_input),
+        std::make_pair("MyFuncLong", long_input)}) {
+    tensorflow::Node* func_op;
+    TF_ASSERT_OK(
+        tensorflow::NodeBuilder(name, "MyFunc", s.graph()->op_registry())
+            .Input(tensorflow::ops::AsNodeOut(s, input))
+            .Finalize(s.graph(), &func_op));
+  }
+
+  GrapplerItem item;
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  for (int i = 0; i < 2; ++i) {
+    GraphProperties properties(item);
+    TF_ASSERT_OK(properties.InferStatically(true));
+    const OpInfo::TensorProperties short_prop =
+        properties.GetOutputProperties("MyFuncShort")[0];
+    EXPECT_EQ("int32: [2]", PropToString(short_prop));
+    ExpectTensorValues({5, 7}, short_prop.value());
+    const OpInfo::TensorProperties long_prop =
+        properties.GetOutputProperties("MyFuncLong")[0];
+    EXPECT_EQ("int32: [3]", PropToString(long_prop));
+    ExpectTensorValues({1, 2, 3}, long_prop.value());
+  }
+}
+
 TEST_F(GraphPropertiesTest, ArithmeticFunctionReturnTensorValue) {
   FunctionDefLibrary library;
   // Function that adds two input values.
@@ -655,6 +655,9 @@ OpLevelCostEstimator::OpLevelCostEstimator() {
 
   // By default, use sum of memory_time and compute_time for execution_time.
   compute_memory_overlap_ = false;
+
+  // Use the machine specific corrections of the process, if any.
+  calibration_ = CostCalibration::Global();
 }
 
 Costs OpLevelCostEstimator::PredictCosts(const OpContext& op_context) const {
@@ -662,7 +665,9 @@ Costs OpLevelCostEstimator::PredictCosts(const OpContext& op_context) const {
   NodeCosts node_costs;
   if (PredictNodeCosts(op_context, &node_costs).ok()) {
     if (node_costs.has_costs) {
-      return node_costs.costs;
+      costs = node_costs.costs;
+      ApplyCalibration(op_context.op_info, &costs);
+      return costs;
     }
     // Convert NodeCosts to Costs.
     if (node_costs.minimum_cost_op) {
@@ -682,6 +687,7 @@ Costs OpLevelCostEstimator::PredictCosts(const OpContext& op_context) const {
       costs = PredictOpCountBasedCost(
           node_costs.num_compute_ops, node_costs.num_total_read_bytes(),
           node_costs.num_total_write_bytes(), op_context.op_info);
+      ApplyCalibration(op_context.op_info, &costs);
     }
     VLOG(1) << "Operation " << op_context.op_info.op() << " takes "
             << costs.execution_time.count() << " ns.";
@@ -703,6 +709,23 @@ Costs OpLevelCostEstimator::PredictCosts(const OpContext& op_context) const {
   return costs;
 }
 
+void OpLevelCostEstimator::ApplyCalibration(const OpInfo& op_info,
+                                            Costs* costs) const {
+  if (calibration_ == nullptr) return;
+  const double correction = calibration_->Correction(op_info);
+  if (correction == 1.0) return;
+  auto scale = [correction](Costs::Duration* time) {
+    if (*time >= Costs::Duration::infinity()) return;
+    *time = Costs::Duration(time->count() * correction);
+  };
+  scale(&costs->execution_time);
+  scale(&costs->compute_time);
+  scale(&costs->memory_time);
+  scale(&costs->intermediate_memory_time);
+  scale(&costs->intermediate_memory_read_time);
+  scale(&costs->intermediate_memory_write_time);
+}
+
 absl::Status OpLevelCostEstimator::PredictNodeCosts(
     const OpContext& op_context, NodeCosts* node_costs) const {
   const auto& op_info = op_context.op_info;
@@ -25,6 +25,7 @@ limitations under the License.
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "tensorflow/core/grappler/costs/cost_calibration.h"
 #include "tensorflow/core/grappler/costs/cost_estimator.h"
 #include "tensorflow/core/grappler/costs/op_context.h"
 #include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
@@ -106,6 +107,13 @@ class OpLevelCostEstimator {
   // Returns basic device performance info.
   virtual DeviceInfo GetDeviceInfo(const DeviceProperties& device) const;
 
+  // Sets the corrections applied to the predicted execution times. Defaults to
+  // CostCalibration::Global(); nullptr disables the corrections.
+  void set_calibration(const CostCalibration* calibration) {
+    calibration_ = calibration;
+  }
+  const CostCalibration* calibration() const { return calibration_; }
+
  protected:
   // TODO(dyoon): Consider to remove PredictOpCountBasedCosts() with OpInfo.
   // Naive cost estimate based on the given operations count and total
@@ -335,8 +343,13 @@ class OpLevelCostEstimator {
   // compute_time and memory_time, instead of sum of those two.
   bool compute_memory_overlap_;
   std::set<string> persistent_ops_;
+  // Not owned, may be null.
+  const CostCalibration* calibration_;
 
  private:
+  // Scales the predicted times by the calibrated correction of the op.
+  void ApplyCalibration(const OpInfo& op_info, Costs* costs) const;
+
   friend class OpLevelCostEstimatorTest;
 };
 
@@ -25,12 +25,17 @@ limitations under the License.
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/bfloat16.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/utils.h"
 #include "tensorflow/core/grappler/costs/virtual_placer.h"
 #include "tensorflow/core/grappler/devices.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -43,6 +48,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/statusor.h"
@@ -1068,6 +1074,7 @@ class AutoMixedPrecisionImpl {
         return std::make_unique<AutoMixedPrecisionListsCuda>(cuda_version_,
                                                              cudnn_version_);
       case AutoMixedPrecisionMode::BF16:
+      case AutoMixedPrecisionMode::NATIVE_BF16:
         return std::make_unique<AutoMixedPrecisionListsMkl>();
       case AutoMixedPrecisionMode::CPU:
         // Note: this is not a typo here. AutoMixedPrecisionListsCuda is used
@@ -1098,6 +1105,14 @@ class AutoMixedPrecisionImpl {
       const absl::flat_hash_set<const NodeDef*>& tensor_list_nodes,
       std::vector<NodeTypeIdEdge>* implicit_fp32_edges) const;
   void AddAllowlistOps(absl::flat_hash_set<int>* allow_set) const;
+  bool IsAvailableInF16(const MutableGraphView::OutputPort& src,
+                        const absl::flat_hash_set<int>& allow_set,
+                        int max_depth) const;
+  bool IsOnlyUsedInF16(const MutableGraphView::OutputPort& src,
+                       const absl::flat_hash_set<int>& allow_set,
+                       int max_depth) const;
+  Status RemoveUnprofitableAllowlistOps(
+      absl::flat_hash_set<int>* allow_set) const;
   void RemoveAllowsetWithFp32(absl::flat_hash_set<int>* allow_set) const;
   void PropagateDenyFwdThroughClearAndInfer(
       absl::flat_hash_set<int>* deny_set) const;
@@ -1118,6 +1133,8 @@ class AutoMixedPrecisionImpl {
       absl::flat_hash_set<int>* allow_set) const;
   NodeDef BuildCastNode(const MutableGraphView::OutputPort& src, bool to_f16,
                         const string& device) const;
+  bool BuildPreCastConstNode(const MutableGraphView::OutputPort& src,
+                             NodeDef* node) const;
   StatusOr<NodeDef*> InsertCastNodeAtFanout(
       const absl::flat_hash_set<int>& allow_set, const bool src_is_allow,
       const CastType& cast_type, MutableGraphView::OutputPort& src);
@@ -1180,6 +1197,42 @@ NodeDef AutoMixedPrecisionImpl::BuildCastNode(
   return node;
 }
 
+// Builds a Const node holding the value of the float constant `src` converted
+// to bfloat16, to be used in place of a Cast of `src`. This keeps weights
+// pre-cast even when constant folding is disabled or skips large constants.
+// Returns false if the value of `src` can't be converted.
+bool AutoMixedPrecisionImpl::BuildPreCastConstNode(
+    const MutableGraphView::OutputPort& src, NodeDef* node) const {
+  if (target_dtype_ != DT_BFLOAT16 || !IsConstant(*src.node) ||
+      src.port_id != 0) {
+    return false;
+  }
+  const AttrValue* value = AttrSlice(*src.node).Find("value");
+  Tensor fp32_value;
+  if (value == nullptr || !fp32_value.FromProto(value->tensor()) ||
+      fp32_value.dtype() != DT_FLOAT) {
+    return false;
+  }
+  Tensor bf16_value(DT_BFLOAT16, fp32_value.shape());
+  RoundFloatToBFloat16(fp32_value.flat<float>().data(),
+                       bf16_value.flat<bfloat16>().data(),
+                       fp32_value.NumElements());
+
+  // Reuse the name and device of the Cast node this replaces.
+  *node = BuildCastNode(src, /*to_f16=*/true, src.node->device());
+  node->set_op("Const");
+  node->clear_input();
+  node->clear_attr();
+  // Keep the control inputs of the constant, e.g. to stay in its frame.
+  for (const string& input : src.node->input()) {
+    if (IsControlInput(input)) node->add_input(input);
+  }
+  (*node->mutable_attr())["dtype"].set_type(DT_BFLOAT16);
+  bf16_value.AsProtoTensorContent(
+      (*node->mutable_attr())["value"].mutable_tensor());
+  return true;
+}
+
 bool AutoMixedPrecisionImpl::NodeHasF16KernelForTypeAttr(
     const NodeDef& node, TypeAttrId taid) const {
   NodeDef node_copy(node);
@@ -1380,13 +1433,37 @@ bool ShouldIgnorePerformance() {
   return is_enabled;
 }
 
+// Returns the expected speedup of compute bound ops in bfloat16 over float32
+// on this CPU, or 1 if it has no native bfloat16 instructions. It can be
+// overridden with TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_BF16_SPEEDUP.
+double GetNativeBf16Speedup() {
+  string speedup_str;
+  TF_CHECK_OK(ReadStringFromEnvVar(
+      "TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_BF16_SPEEDUP", "", &speedup_str));
+  double speedup;
+  if (!speedup_str.empty() && strings::safe_strtod(speedup_str, &speedup)) {
+    return speedup;
+  }
+  // AMX multiplies bfloat16 tiles at a much higher rate than AVX512 FMAs,
+  // while AVX512-BF16 dot products process twice as many elements.
+  if (port::TestCPUFeature(port::CPUFeature::AMX_TILE) &&
+      port::TestCPUFeature(port::CPUFeature::AMX_BF16)) {
+    return 8.0;
+  }
+  if (port::TestCPUFeature(port::CPUFeature::AVX512_BF16)) {
+    return 2.0;
+  }
+  return 1.0;
+}
+
 Status AutoMixedPrecisionImpl::Optimize() {
   string optimization_level;
   TF_RETURN_IF_ERROR(ReadStringFromEnvVar(
       "TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_LEVEL", "", &optimization_level));
   optimization_level = absl::AsciiStrToUpper(optimization_level);
   force_all_fp16_ = optimization_level == "UNSAFE_FORCE_ALL";
-  if (force_all_fp16_ && mode_ == AutoMixedPrecisionMode::BF16) {
+  if (force_all_fp16_ && (mode_ == AutoMixedPrecisionMode::BF16 ||
+                          mode_ == AutoMixedPrecisionMode::NATIVE_BF16)) {
     // Many ops do not support bfloat16 on the CPU so we disallowing forcing to
     // bfloat16.
     return errors::InvalidArgument(
@@ -1430,6 +1507,7 @@ Status AutoMixedPrecisionImpl::Optimize() {
         break;
       case AutoMixedPrecisionMode::BF16:
       case AutoMixedPrecisionMode::CPU:
+      case AutoMixedPrecisionMode::NATIVE_BF16:
         device_type = DEVICE_CPU;
         should_process = !MustPreserve(node) && IsOnDevice(node, device_type);
         break;
@@ -1500,6 +1578,12 @@ Status AutoMixedPrecisionImpl::Optimize() {
   AddAllowlistOps(&allow_set);
   VLOG(2) << "Finished pass 1";
 
+  if (mode_ == AutoMixedPrecisionMode::NATIVE_BF16 &&
+      !ShouldIgnorePerformance()) {
+    VLOG(2) << "Removing allowlist ops which are too cheap to convert";
+    TF_RETURN_IF_ERROR(RemoveUnprofitableAllowlistOps(&allow_set));
+  }
+
   if (allow_set.empty()) {
     LOG(INFO) << "No allowlist ops found, nothing to do";
     return OkStatus();
@@ -1704,6 +1788,143 @@ void AutoMixedPrecisionImpl::AddAllowlistOps(
   }
 }
 
+// Returns true if the tensor `src` will be available in f16 without a Cast at
+// runtime: it's produced by an allow node, possibly through clearlist ops,
+// or by a constant whose Cast is folded.
+bool AutoMixedPrecisionImpl::IsAvailableInF16(
+    const MutableGraphView::OutputPort& src,
+    const absl::flat_hash_set<int>& allow_set, int max_depth) const {
+  if (IsConstant(*src.node)) return true;
+  const absl::optional<int> src_idx = graph_type_view_.GetNodeIndex(
+      src.node->name(), node_type_map_.GetOutputTypeAttr(*src.node,
+                                                         src.port_id));
+  if (!src_idx.has_value()) return false;
+  if (allow_set.count(*src_idx)) return true;
+  if (max_depth == 0 || !f16_clearlist_.count(src.node->op())) return false;
+  for (int port_id : node_type_map_.GetInputPorts(
+           *src.node, graph_type_view_.GetNode(*src_idx)->type_attr)) {
+    const MutableGraphView::InputPort dst(src.node, port_id);
+    if (!IsAvailableInF16(graph_view_.GetRegularFanin(dst), allow_set,
+                          max_depth - 1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns true if all the consumers of the tensor `src` are allow nodes,
+// possibly through clearlist ops.
+bool AutoMixedPrecisionImpl::IsOnlyUsedInF16(
+    const MutableGraphView::OutputPort& src,
+    const absl::flat_hash_set<int>& allow_set, int max_depth) const {
+  for (const MutableGraphView::InputPort& dst : graph_view_.GetFanout(src)) {
+    const TypeAttrId dst_type_attr =
+        node_type_map_.GetInputTypeAttr(*dst.node, dst.port_id);
+    const absl::optional<int> dst_idx =
+        graph_type_view_.GetNodeIndex(dst.node->name(), dst_type_attr);
+    if (!dst_idx.has_value()) return false;
+    if (allow_set.count(*dst_idx)) continue;
+    if (max_depth == 0 || !f16_clearlist_.count(dst.node->op())) return false;
+    for (int port_id :
+         node_type_map_.GetOutputPorts(*dst.node, dst_type_attr)) {
+      if (!IsOnlyUsedInF16({dst.node, port_id}, allow_set, max_depth - 1)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Removes the allowlist ops whose estimated speedup in bfloat16 doesn't pay for
+// the casts they need at their inputs and outputs. The costs are estimated
+// with the analytical cost model for the device of each node.
+Status AutoMixedPrecisionImpl::RemoveUnprofitableAllowlistOps(
+    absl::flat_hash_set<int>* allow_set) const {
+  // Per op overhead of a Cast at runtime, on top of its memory traffic.
+  constexpr Costs::NanoSeconds kCastOverhead(1000);
+  // How far to look through clearlist ops for the producers and consumers of
+  // an allowlist op, since casts are moved past them later on.
+  constexpr int kMaxClearlistDepth = 4;
+
+  const double speedup = GetNativeBf16Speedup();
+  GrapplerItem item;
+  item.graph = *graph_;
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically(
+      /*assume_valid_feeds=*/false, /*aggressive_shape_inference=*/false,
+      /*include_tensor_values=*/false));
+  OpLevelCostEstimator estimator;
+
+  // Decide for all nodes before removing any, so that neighbouring allowlist
+  // ops are assumed to share their casts.
+  std::vector<int> to_remove;
+  for (int idx : *allow_set) {
+    const NodeTypeId& root = *graph_type_view_.GetNode(idx);
+    const NodeDef& node = *root.node;
+    if (!f16_allowlist_.count(node.op()) ||
+        !properties.HasInputProperties(node.name()) ||
+        !properties.HasOutputProperties(node.name())) {
+      continue;
+    }
+    OpContext op_context;
+    op_context.op_info.set_op(node.op());
+    *op_context.op_info.mutable_attr() = node.attr();
+    for (const auto& input : properties.GetInputProperties(node.name())) {
+      *op_context.op_info.add_inputs() = input;
+    }
+    for (const auto& output : properties.GetOutputProperties(node.name())) {
+      *op_context.op_info.add_outputs() = output;
+    }
+    *op_context.op_info.mutable_device() = virtual_placer_.get_device(node);
+    const Costs costs = estimator.PredictCosts(op_context);
+    if (costs.inaccurate) {
+      // Unknown shapes; keep the decision of the lists.
+      continue;
+    }
+    // bfloat16 speeds up the arithmetic and halves the memory traffic.
+    const double savings_ns =
+        costs.compute_time.count() * (1.0 - 1.0 / speedup) +
+        costs.memory_time.count() / 2.0;
+
+    const double gb_per_sec =
+        estimator.GetDeviceInfo(op_context.op_info.device()).gb_per_sec;
+    double casts_ns = 0;
+    auto add_cast = [&](const OpInfo::TensorProperties& tensor) {
+      // A Cast reads float32 and writes bfloat16 values.
+      const int64_t bytes = CalculateTensorSize(tensor);
+      casts_ns += kCastOverhead.count() + 1.5 * std::max<int64_t>(bytes, 0) /
+                                              gb_per_sec;
+    };
+    NodeDef* mutable_node = graph_view_.GetNode(node.name());
+    for (int port_id : node_type_map_.GetInputPorts(node, root.type_attr)) {
+      const MutableGraphView::InputPort dst(mutable_node, port_id);
+      if (port_id < op_context.op_info.inputs_size() &&
+          !IsAvailableInF16(graph_view_.GetRegularFanin(dst), *allow_set,
+                            kMaxClearlistDepth)) {
+        add_cast(op_context.op_info.inputs(port_id));
+      }
+    }
+    for (int port_id : node_type_map_.GetOutputPorts(node, root.type_attr)) {
+      if (port_id < op_context.op_info.outputs_size() &&
+          !IsOnlyUsedInF16({mutable_node, port_id}, *allow_set,
+                           kMaxClearlistDepth)) {
+        add_cast(op_context.op_info.outputs(port_id));
+      }
+    }
+
+    if (savings_ns <= casts_ns) {
+      VLOG(2) << "Not painting node " << node.name() << " ALLOW: estimated "
+              << savings_ns << "ns saved in " << DataTypeString(target_dtype_)
+              << " but " << casts_ns << "ns spent in casts";
+      to_remove.push_back(idx);
+    }
+  }
+  for (int idx : to_remove) {
+    allow_set->erase(idx);
+  }
+  return OkStatus();
+}
+
 // Adds nodes to deny_set iff they are on the denylist or they are on a
 // forward path from a denylist node to a deny/infer node (including the node
 // at the end of the path) through clear and infer nodes.
@@ -1859,7 +2080,8 @@ void AutoMixedPrecisionImpl::AddInferToAllowIfFollowAllow(
     const absl::flat_hash_set<int>& deny_set,
     absl::flat_hash_set<int>* allow_set) const {
   // Currently only target for oneDNN
-  if (mode_ != AutoMixedPrecisionMode::BF16) {
+  if (mode_ != AutoMixedPrecisionMode::BF16 &&
+      mode_ != AutoMixedPrecisionMode::NATIVE_BF16) {
     return;
   }
   for (int item_idx = 0; item_idx < graph_type_view_.num_nodes(); ++item_idx) {
@@ -2126,8 +2348,14 @@ StatusOr<NodeDef*> AutoMixedPrecisionImpl::InsertCastNodeAtFanout(
               << (to_f16 ? DataTypeString(target_dtype_) : "DT_FLOAT") << " at "
               << src.node->op() << " " << src.node->name() << ":"
               << src.port_id;
-      added_cast_node =
-          graph_view_.AddNode(BuildCastNode(src, to_f16, src.node->device()));
+      NodeDef pre_cast_const;
+      if (to_f16 && mode_ == AutoMixedPrecisionMode::NATIVE_BF16 &&
+          BuildPreCastConstNode(src, &pre_cast_const)) {
+        added_cast_node = graph_view_.AddNode(std::move(pre_cast_const));
+      } else {
+        added_cast_node = graph_view_.AddNode(
+            BuildCastNode(src, to_f16, src.node->device()));
+      }
       if (to_f16 && !IsConstant(*src.node) && !IsVariable(*src.node) &&
           !NodeImplicitlyReadsNonResourceVariable(*src.node)) {
         ++num_nonvar_casts_to_f16_;
@@ -2285,11 +2513,12 @@ Status AutoMixedPrecision::Optimize(Cluster* cluster, const GrapplerItem& item,
   }
 
 #if !defined(INTEL_MKL)
-  if (mode_ == AutoMixedPrecisionMode::BF16) {
+  if (mode_ == AutoMixedPrecisionMode::BF16 ||
+      mode_ == AutoMixedPrecisionMode::NATIVE_BF16) {
     return errors::Unimplemented(
-        "The auto_mixed_precision_onednn_bfloat16 optimizer cannot be used "
-        "since this build of TensorFlow is not compiled with oneDNN support "
-        "for bfloat16. "
+        "The ", name(),
+        " optimizer cannot be used since this build of TensorFlow is not "
+        "compiled with oneDNN support for bfloat16. "
         "For information on oneDNN builds, see: "
         "https://software.intel.com/en-us/articles/intel-optimization-for-"
         "tensorflow-installation-guide");
@@ -2307,11 +2536,22 @@ Status AutoMixedPrecision::Optimize(Cluster* cluster, const GrapplerItem& item,
     return OkStatus();
   }
 
-  if (num_gpus >= 1 && mode_ == AutoMixedPrecisionMode::BF16) {
+  if (num_gpus >= 1 && (mode_ == AutoMixedPrecisionMode::BF16 ||
+                        mode_ == AutoMixedPrecisionMode::NATIVE_BF16)) {
     LOG(WARNING) << "Note: GPUs detected. Using " << name()
                  << " graph optimizer configured for BFloat16 on CPUs";
   }
 
+  if (mode_ == AutoMixedPrecisionMode::NATIVE_BF16 &&
+      !ShouldIgnorePerformance() && GetNativeBf16Speedup() <= 1.0) {
+    // Without native instructions bfloat16 is emulated, which is slower than
+    // float32.
+    LOG(WARNING) << "No native bfloat16 support (AMX or AVX512-BF16) "
+                    "detected, skipping "
+                 << name() << " graph optimizer";
+    return OkStatus();
+  }
+
   // Optimize the output graph in-place.
   AutoMixedPrecisionImpl optimizer(cluster, item.NodesToPreserve(), output,
                                    item.id, mode_);
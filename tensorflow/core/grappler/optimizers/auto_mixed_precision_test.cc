@@ -1719,6 +1719,83 @@ TEST_F(AutoMixedPrecisionMklTest, InferFollowUpStreamDeny) {
     test::ExpectClose(tensors_expected[i], tensors[i]);
   }
 }
+
+TEST_F(AutoMixedPrecisionMklTest, NativeBf16KeepsProfitableOps) {
+  if (!IsMKLEnabled())
+    GTEST_SKIP() << "Test only applicable to MKL auto-mixed precision.";
+  setenv("TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_BF16_SPEEDUP", "8",
+         1 /* replace */);
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(
+      "/job:localhost/replica:0/task:0/device:CPU:0");
+  Output input = ops::Const(s.WithOpName("input"), 1.f / 256, {256, 256});
+  Output weight = ops::Const(s.WithOpName("weight"), 0.5f, {256, 256});
+  Output allow1 = ops::MatMul(s.WithOpName("allow1"), input, weight);
+  Output deny1 = ops::Exp(s.WithOpName("deny1"), allow1);
+  Output fetch1 = ops::Identity(s.WithOpName("fetch1"), deny1);
+  // Too small for bfloat16 to pay for the casts around it.
+  Output small = ops::Const(s.WithOpName("small"), 0.5f, {4, 4});
+  Output deny2 = ops::Exp(s.WithOpName("deny2"), small);
+  Output allow2 = ops::MatMul(s.WithOpName("allow2"), deny2, deny2);
+  Output deny3 = ops::Log(s.WithOpName("deny3"), allow2);
+  Output fetch2 = ops::Identity(s.WithOpName("fetch2"), deny3);
+
+  GrapplerItem item;
+  item.fetch = {"fetch1", "fetch2"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+
+  AutoMixedPrecision optimizer{AutoMixedPrecisionMode::NATIVE_BF16};
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(virtual_cluster_.get(), item, &output));
+  unsetenv("TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_BF16_SPEEDUP");
+
+  VLOG(1) << output.DebugString();
+
+  GraphView output_view(&output);
+  // The weights are converted ahead of time instead of being cast at runtime.
+  EXPECT_EQ(output.node_size(), item.graph.node_size() + 3);
+  EXPECT_EQ(output_view.GetNode("allow1")->attr().at("T").type(), DT_BFLOAT16);
+  for (int port = 0; port < 2; ++port) {
+    const NodeDef* fanin =
+        output_view.GetRegularFanin({output_view.GetNode("allow1"), port})
+            .node;
+    EXPECT_EQ(fanin->op(), "Const");
+    EXPECT_EQ(fanin->attr().at("dtype").type(), DT_BFLOAT16);
+  }
+  EXPECT_EQ(output_view.GetNode("input")->attr().at("dtype").type(), DT_FLOAT);
+  EXPECT_EQ(output_view.GetNode("deny1")->attr().at("T").type(), DT_FLOAT);
+  EXPECT_EQ(output_view.GetNode("allow2")->attr().at("T").type(), DT_FLOAT);
+
+  auto tensors = EvaluateNodes(output, item.fetch);
+  EXPECT_EQ(tensors.size(), tensors_expected.size());
+  EXPECT_EQ(tensors.size(), item.fetch.size());
+  for (int i = 0; i < item.fetch.size(); ++i) {
+    test::ExpectClose(tensors_expected[i], tensors[i], -1, 1e-2);
+  }
+}
+
+TEST_F(AutoMixedPrecisionMklTest, NativeBf16RequiresNativeSupport) {
+  if (!IsMKLEnabled())
+    GTEST_SKIP() << "Test only applicable to MKL auto-mixed precision.";
+  setenv("TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_BF16_SPEEDUP", "1",
+         1 /* replace */);
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(
+      "/job:localhost/replica:0/task:0/device:CPU:0");
+  Output input = ops::Const(s.WithOpName("input"), 1.f / 256, {256, 256});
+  Output allow = ops::MatMul(s.WithOpName("allow"), input, input);
+  Output fetch = ops::Identity(s.WithOpName("fetch"), allow);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  AutoMixedPrecision optimizer{AutoMixedPrecisionMode::NATIVE_BF16};
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(virtual_cluster_.get(), item, &output));
+  unsetenv("TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_BF16_SPEEDUP");
+
+  CompareGraphs(item.graph, output);
+}
 #endif  // INTEL_MKL
 
 }  // namespace
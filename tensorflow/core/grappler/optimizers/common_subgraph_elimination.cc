@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/common_subgraph_elimination.h"
 
+#include <algorithm>
+#include <functional>
 #include <set>
 #include <string>
 #include <unordered_set>
@@ -23,9 +25,15 @@ limitations under the License.
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/match.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/graph/tensor_id.h"
 #include "tensorflow/core/grappler/graph_topology_view.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -36,6 +44,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/grappler/utils/traversal.h"
 #include "tensorflow/core/lib/gtl/flatset.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/hash.h"
 #include "tensorflow/core/platform/status.h"
@@ -54,6 +63,158 @@ using tensorflow::strings::StrCat;
 namespace tensorflow {
 namespace grappler {
 
+namespace {
+
+// Appends the names of the functions referenced by `attr` to `names`.
+void CollectFunctionNames(const AttrValue& attr, std::vector<string>* names) {
+  const auto collect = [names](const NameAttrList& func) {
+    names->push_back(func.name());
+    for (const auto& nested : func.attr()) {
+      CollectFunctionNames(nested.second, names);
+    }
+  };
+  if (attr.has_func()) collect(attr.func());
+  if (attr.has_list()) {
+    for (const NameAttrList& func : attr.list().func()) collect(func);
+  }
+}
+
+// Renames the functions referenced by `attr` according to `renames`.
+void RenameFunctions(const absl::flat_hash_map<string, string>& renames,
+                     AttrValue* attr) {
+  const auto rename = [&renames](NameAttrList* func) {
+    auto it = renames.find(func->name());
+    if (it != renames.end()) func->set_name(it->second);
+    for (auto& nested : *func->mutable_attr()) {
+      RenameFunctions(renames, &nested.second);
+    }
+  };
+  if (attr->has_func()) rename(attr->mutable_func());
+  if (attr->has_list()) {
+    for (NameAttrList& func : *attr->mutable_list()->mutable_func()) {
+      rename(&func);
+    }
+  }
+}
+
+// Renames the functions called by `node`, either directly or through a
+// function attribute, according to `renames`.
+void RenameFunctions(const absl::flat_hash_map<string, string>& renames,
+                     NodeDef* node) {
+  auto it = renames.find(node->op());
+  if (it != renames.end()) node->set_op(it->second);
+  for (auto& attr : *node->mutable_attr()) {
+    RenameFunctions(renames, &attr.second);
+  }
+}
+
+// Splits an input of a function body node into the name of the node or
+// argument it refers to, and the rest of the input, e.g. ":y:0". Returns
+// whether the input is a control input.
+bool SplitFunctionInput(absl::string_view input, absl::string_view* name,
+                        absl::string_view* rest) {
+  const bool is_control = absl::ConsumePrefix(&input, "^");
+  const size_t colon = input.find(':');
+  *name = input.substr(0, colon);
+  *rest = colon == absl::string_view::npos ? absl::string_view()
+                                            : input.substr(colon);
+  return is_control;
+}
+
+// Renames the nodes of the body of `function` to "n0", "n1", ... and sorts
+// them in a topological order that only depends on what the nodes compute, so
+// that functions that differ only in the names and order of their nodes become
+// identical. The ready node whose renamed NodeDef serializes first is named
+// next; ready nodes that serialize the same are interchangeable. Returns false,
+// leaving `function` unchanged, if the body has a cycle or colocates nodes by
+// name, which would have to be renamed as well.
+bool CanonicalizeFunctionBody(FunctionDef* function) {
+  const int num_nodes = function->node_def_size();
+  absl::flat_hash_map<absl::string_view, int> node_index;
+  for (int i = 0; i < num_nodes; ++i) {
+    const NodeDef& node = function->node_def(i);
+    if (node.attr().count(kColocationAttrName) > 0) return false;
+    node_index.emplace(node.name(), i);
+  }
+
+  std::vector<int> num_pending_inputs(num_nodes, 0);
+  std::vector<std::vector<int>> fanouts(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    for (const string& input : function->node_def(i).input()) {
+      absl::string_view name, rest;
+      SplitFunctionInput(input, &name, &rest);
+      auto it = node_index.find(name);
+      if (it == node_index.end()) continue;
+      ++num_pending_inputs[i];
+      fanouts[it->second].push_back(i);
+    }
+  }
+
+  std::vector<string> new_names(num_nodes);
+  const auto rename = [&](const string& input) -> string {
+    absl::string_view name, rest;
+    const bool is_control = SplitFunctionInput(input, &name, &rest);
+    auto it = node_index.find(name);
+    if (it == node_index.end()) return input;
+    return StrCat(is_control ? "^" : "", new_names[it->second], rest);
+  };
+  // Returns the node with its inputs renamed, which requires all of them to
+  // be named already.
+  const auto renamed_node = [&](int i) {
+    NodeDef node = function->node_def(i);
+    node.clear_name();
+    node.clear_experimental_debug_info();
+    int num_data_inputs = 0;
+    for (string& input : *node.mutable_input()) {
+      if (!absl::StartsWith(input, "^")) ++num_data_inputs;
+      input = rename(input);
+    }
+    std::sort(node.mutable_input()->begin() + num_data_inputs,
+              node.mutable_input()->end());
+    return node;
+  };
+
+  // Ready nodes, ordered by their serialized renamed NodeDef.
+  std::set<std::pair<string, int>> ready;
+  const auto add_ready = [&](int i) {
+    string serialized;
+    SerializeToStringDeterministic(renamed_node(i), &serialized);
+    ready.emplace(std::move(serialized), i);
+  };
+  for (int i = 0; i < num_nodes; ++i) {
+    if (num_pending_inputs[i] == 0) add_ready(i);
+  }
+  std::vector<int> order;
+  order.reserve(num_nodes);
+  while (!ready.empty()) {
+    const int i = ready.begin()->second;
+    ready.erase(ready.begin());
+    new_names[i] = StrCat("n", order.size());
+    order.push_back(i);
+    for (int fanout : fanouts[i]) {
+      if (--num_pending_inputs[fanout] == 0) add_ready(fanout);
+    }
+  }
+  if (static_cast<int>(order.size()) != num_nodes) return false;
+
+  protobuf::RepeatedPtrField<NodeDef> nodes;
+  for (int i : order) {
+    NodeDef* node = nodes.Add();
+    *node = renamed_node(i);
+    node->set_name(new_names[i]);
+  }
+  for (auto& ret : *function->mutable_ret()) {
+    ret.second = rename(ret.second);
+  }
+  for (auto& control_ret : *function->mutable_control_ret()) {
+    control_ret.second = rename(control_ret.second);
+  }
+  function->mutable_node_def()->Swap(&nodes);
+  return true;
+}
+
+}  // namespace
+
 class UniqueNodes {
  public:
   // Warning: This is conservative and may fail to find an identical node in
@@ -168,9 +329,126 @@ bool CommonSubgraphElimination::CanDedup(const NodeDef& node) const {
   if (IsAssert(node) || IsPrint(node)) {
     return true;
   }
+  // Calls to functions without side effects are pure, even if they go through
+  // StatefulPartitionedCall.
+  if (!pure_functions_.empty()) {
+    const string* callee = &node.op();
+    if (IsPartitionedCall(node) || IsStatefulPartitionedCall(node)) {
+      auto it = node.attr().find("f");
+      if (it == node.attr().end()) return false;
+      callee = &it->second.func().name();
+    }
+    if (pure_functions_.contains(*callee)) {
+      return true;
+    }
+  }
   return IsFreeOfSideEffect(node);
 }
 
+int CommonSubgraphElimination::DedupFunctions(GraphDef* optimized_graph) {
+  FunctionDefLibrary* library = optimized_graph->mutable_library();
+  // A function with a registered gradient can't be replaced by a function
+  // that may be differentiated differently.
+  absl::flat_hash_set<string> has_gradient;
+  for (const GradientDef& gradient : library->gradient()) {
+    has_gradient.insert(gradient.function_name());
+    has_gradient.insert(gradient.gradient_func());
+  }
+  std::vector<FunctionDef*> functions;
+  functions.reserve(library->function_size());
+  for (FunctionDef& function : *library->mutable_function()) {
+    functions.push_back(&function);
+  }
+  std::sort(functions.begin(), functions.end(),
+            [](const FunctionDef* a, const FunctionDef* b) {
+              return a->signature().name() < b->signature().name();
+            });
+
+  absl::flat_hash_set<string> merged;
+  // Merging functions can make the functions that call them identical, so
+  // iterate until no more functions are merged.
+  while (true) {
+    // Maps the canonical form of a function, which is the function without
+    // its name and with its body nodes renamed, to the name of the first
+    // function with that form.
+    absl::flat_hash_map<string, string> representatives;
+    absl::flat_hash_map<string, string> renames;
+    for (const FunctionDef* function : functions) {
+      const string& name = function->signature().name();
+      if (has_gradient.contains(name) || merged.contains(name)) continue;
+      FunctionDef canonical = *function;
+      canonical.mutable_signature()->clear_name();
+      // Functions whose body can't be canonicalized are compared as they are.
+      CanonicalizeFunctionBody(&canonical);
+      string key;
+      if (!SerializeToStringDeterministic(canonical, &key)) continue;
+      auto it = representatives.emplace(std::move(key), name);
+      if (!it.second) {
+        renames.emplace(name, it.first->second);
+      }
+    }
+    if (renames.empty()) break;
+
+    for (NodeDef& node : *optimized_graph->mutable_node()) {
+      RenameFunctions(renames, &node);
+    }
+    for (FunctionDef* function : functions) {
+      for (NodeDef& node : *function->mutable_node_def()) {
+        RenameFunctions(renames, &node);
+      }
+    }
+    for (const auto& rename : renames) {
+      VLOG(2) << "Merged function " << rename.first << " into "
+              << rename.second;
+      merged.insert(rename.first);
+    }
+  }
+  return merged.size();
+}
+
+void CommonSubgraphElimination::FindPureFunctions(
+    const FunctionDefLibrary& library) {
+  pure_functions_.clear();
+  absl::flat_hash_map<string, const FunctionDef*> functions;
+  for (const FunctionDef& function : library.function()) {
+    functions.emplace(function.signature().name(), &function);
+  }
+
+  absl::flat_hash_map<string, bool> is_pure;
+  std::function<bool(const string&)> visit =
+      [&](const string& name) -> bool {
+    auto it = is_pure.find(name);
+    if (it != is_pure.end()) return it->second;
+    auto function = functions.find(name);
+    if (function == functions.end()) return false;
+    // Recursive functions are conservatively considered impure.
+    is_pure[name] = false;
+
+    bool pure = !function->second->signature().is_stateful();
+    std::vector<string> callees;
+    for (const NodeDef& node : function->second->node_def()) {
+      if (!pure) break;
+      if (functions.contains(node.op())) {
+        pure = visit(node.op());
+        continue;
+      }
+      pure = IsFreeOfSideEffect(node);
+      callees.clear();
+      for (const auto& attr : node.attr()) {
+        CollectFunctionNames(attr.second, &callees);
+      }
+      for (const string& callee : callees) {
+        pure = pure && visit(callee);
+      }
+    }
+    is_pure[name] = pure;
+    return pure;
+  };
+  for (const auto& function : functions) {
+    if (visit(function.first)) pure_functions_.insert(function.first);
+  }
+}
+
 Status CommonSubgraphElimination::DedupComputations(GraphDef* optimized_graph) {
   CanonicalizeGraph(optimized_graph);
 
@@ -281,6 +559,12 @@ Status CommonSubgraphElimination::Optimize(Cluster* /*cluster*/,
   fetch_nodes_known_ = !item.fetch.empty();
   *optimized_graph = item.graph;
 
+  if (dedup_functions_) {
+    const int num_merged = DedupFunctions(optimized_graph);
+    VLOG(1) << "Merged " << num_merged << " duplicate functions";
+    FindPureFunctions(optimized_graph->library());
+  }
+
   // Perform topological sort on the graph in order to help DedupComputations
   // optimize larger subgraphs starting from the roots with more inputs.
   TF_RETURN_IF_ERROR(TopologicalSort(optimized_graph));
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <unordered_set>
 
+#include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
@@ -37,14 +38,18 @@ class CommonSubgraphElimination : public GraphOptimizer {
  public:
   CommonSubgraphElimination() {}
 
-  explicit CommonSubgraphElimination(RewriterConfig::Toggle opt_level)
-      : opt_level_(opt_level) {}
+  // If `dedup_functions` is true, identical functions of the library are
+  // merged as well, and calls to side effect free functions are deduped like
+  // any other side effect free op.
+  explicit CommonSubgraphElimination(RewriterConfig::Toggle opt_level,
+                                     bool dedup_functions = false)
+      : opt_level_(opt_level), dedup_functions_(dedup_functions) {}
 
   ~CommonSubgraphElimination() override {}
 
   string name() const override { return "common_subgraph_elimination"; };
 
-  bool UsesFunctionLibrary() const override { return false; }
+  bool UsesFunctionLibrary() const override { return dedup_functions_; }
 
   Status Optimize(Cluster* cluster, const GrapplerItem& item,
                   GraphDef* optimized_graph) override;
@@ -58,10 +63,24 @@ class CommonSubgraphElimination : public GraphOptimizer {
   // Dedup redundant nodes in the graph.
   Status DedupComputations(GraphDef* optimized_graph);
 
+  // Redirects all the references to a function of the library to the first
+  // function, in name order, with the same signature and the same body up to
+  // the names and order of its nodes. The merged functions are left in the
+  // library; the meta optimizer drops them when it rewrites the library to the
+  // functions reachable from the graph after optimizing function bodies.
+  // Returns the number of functions merged.
+  int DedupFunctions(GraphDef* optimized_graph);
+
+  // Fills pure_functions_ with the functions of the library whose body,
+  // including the functions it calls, is free of side effects.
+  void FindPureFunctions(const FunctionDefLibrary& library);
+
   RewriterConfig::Toggle opt_level_;
+  bool dedup_functions_ = false;
 
   bool fetch_nodes_known_ = false;
   std::unordered_set<string> nodes_to_preserve_;
+  absl::flat_hash_set<string> pure_functions_;
 };
 
 }  // end namespace grappler
@@ -19,6 +19,8 @@ limitations under the License.
 #include "tensorflow/cc/ops/array_ops.h"
 #include "tensorflow/cc/ops/math_ops.h"
 #include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/function_testlib.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -174,5 +176,178 @@ TEST_F(CommonSubgraphEliminationTest, OpDedupCommutative) {
   test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
 }
 
+TEST_F(CommonSubgraphEliminationTest, DedupIdenticalFunctions) {
+  using test::function::NDef;
+  using FDH = FunctionDefHelper;
+
+  FunctionDef x_times_two = test::function::XTimesTwo();
+  FunctionDef x_times_two_copy = x_times_two;
+  x_times_two_copy.mutable_signature()->set_name("XTimesTwoCopy");
+  // Calls the copy, so it becomes identical to CallXTimesTwo once the copy
+  // is merged.
+  FunctionDef call_copy = FDH::Create(
+      "CallXTimesTwoCopy", {"x: float"}, {"y: float"}, {},
+      {{{"call"}, "XTimesTwoCopy", {"x"}, {{"T", DT_FLOAT}}}},
+      {{"y", "call:y:0"}});
+  FunctionDef call = call_copy;
+  call.mutable_signature()->set_name("CallXTimesTwo");
+  (*call.mutable_node_def())[0].set_op("XTimesTwo");
+
+  const auto call_node = [](const string& name, const string& function) {
+    return NDef(name, "StatefulPartitionedCall", {"x"},
+                {{"Tin", DataTypeSlice{DT_FLOAT}},
+                 {"Tout", DataTypeSlice{DT_FLOAT}},
+                 {"f", FDH::FunctionRef(function, {})}});
+  };
+  GrapplerItem item;
+  item.fetch = {"z"};
+  item.graph = test::function::GDef(
+      {NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}),
+       call_node("y1", "CallXTimesTwo"), call_node("y2", "CallXTimesTwoCopy"),
+       NDef("z", "AddV2", {"y1", "y2"}, {{"T", DT_FLOAT}})},
+      {x_times_two, x_times_two_copy, call, call_copy});
+
+  // Without function deduplication, the stateful calls are kept as is.
+  CommonSubgraphElimination optimizer(RewriterConfig::ON);
+  EXPECT_FALSE(optimizer.UsesFunctionLibrary());
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(output.node_size(), 4);
+
+  CommonSubgraphElimination function_optimizer(RewriterConfig::ON,
+                                               /*dedup_functions=*/true);
+  EXPECT_TRUE(function_optimizer.UsesFunctionLibrary());
+  TF_EXPECT_OK(function_optimizer.Optimize(nullptr, item, &output));
+  NodeMap node_map(&output);
+  EXPECT_EQ(output.node_size(), 3);
+  EXPECT_EQ(node_map.GetNode("y2"), nullptr);
+  const NodeDef* y1 = node_map.GetNode("y1");
+  ASSERT_NE(y1, nullptr);
+  EXPECT_EQ(y1->attr().at("f").func().name(), "CallXTimesTwo");
+  const NodeDef* z = node_map.GetNode("z");
+  ASSERT_NE(z, nullptr);
+  ASSERT_EQ(z->input_size(), 2);
+  EXPECT_EQ(z->input(0), "y1");
+  EXPECT_EQ(z->input(1), "y1");
+  for (const FunctionDef& function : output.library().function()) {
+    for (const NodeDef& node : function.node_def()) {
+      EXPECT_NE(node.op(), "XTimesTwoCopy");
+    }
+  }
+
+  const Tensor x_t = test::AsTensor<float>({1.0f, 2.0f});
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, {{"x", x_t}});
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, {{"x", x_t}});
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorEqual<float>(tensors[0], tensors_expected[0]);
+}
+
+TEST_F(CommonSubgraphEliminationTest, DedupFunctionsWithRenamedNodes) {
+  using test::function::NDef;
+  using FDH = FunctionDefHelper;
+
+  FunctionDef square_minus_neg = FDH::Create(
+      "SquareMinusNeg", {"x: float"}, {"y: float"}, {},
+      {{{"square"}, "Square", {"x"}, {{"T", DT_FLOAT}}},
+       {{"neg"}, "Neg", {"x"}, {{"T", DT_FLOAT}}},
+       {{"sub"}, "Sub", {"square:y:0", "neg:y:0"}, {{"T", DT_FLOAT}}}},
+      {{"y", "sub:z:0"}});
+  // The same body with other node names, in another order.
+  FunctionDef renamed = FDH::Create(
+      "SquareMinusNegRenamed", {"x: float"}, {"y: float"}, {},
+      {{{"diff"}, "Sub", {"sq:y:0", "n:y:0"}, {{"T", DT_FLOAT}}},
+       {{"n"}, "Neg", {"x"}, {{"T", DT_FLOAT}}},
+       {{"sq"}, "Square", {"x"}, {{"T", DT_FLOAT}}}},
+      {{"y", "diff:z:0"}});
+  // Only differs in the order of the operands of the Sub.
+  FunctionDef neg_minus_square = FDH::Create(
+      "NegMinusSquare", {"x: float"}, {"y: float"}, {},
+      {{{"square"}, "Square", {"x"}, {{"T", DT_FLOAT}}},
+       {{"neg"}, "Neg", {"x"}, {{"T", DT_FLOAT}}},
+       {{"sub"}, "Sub", {"neg:y:0", "square:y:0"}, {{"T", DT_FLOAT}}}},
+      {{"y", "sub:z:0"}});
+
+  const auto call_node = [](const string& name, const string& function) {
+    return NDef(name, "StatefulPartitionedCall", {"x"},
+                {{"Tin", DataTypeSlice{DT_FLOAT}},
+                 {"Tout", DataTypeSlice{DT_FLOAT}},
+                 {"f", FDH::FunctionRef(function, {})}});
+  };
+  GrapplerItem item;
+  item.fetch = {"y1", "y2", "y3"};
+  item.graph = test::function::GDef(
+      {NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}),
+       call_node("y1", "SquareMinusNeg"),
+       call_node("y2", "SquareMinusNegRenamed"),
+       call_node("y3", "NegMinusSquare")},
+      {square_minus_neg, renamed, neg_minus_square});
+
+  CommonSubgraphElimination optimizer(RewriterConfig::ON,
+                                      /*dedup_functions=*/true);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  NodeMap node_map(&output);
+  const NodeDef* y2 = node_map.GetNode("y2");
+  ASSERT_NE(y2, nullptr);
+  EXPECT_EQ(y2->attr().at("f").func().name(), "SquareMinusNeg");
+  const NodeDef* y3 = node_map.GetNode("y3");
+  ASSERT_NE(y3, nullptr);
+  EXPECT_EQ(y3->attr().at("f").func().name(), "NegMinusSquare");
+
+  const Tensor x_t = test::AsTensor<float>({1.0f, 2.0f});
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, {{"x", x_t}});
+  ASSERT_EQ(tensors_expected.size(), 3);
+  auto tensors = EvaluateNodes(output, item.fetch, {{"x", x_t}});
+  ASSERT_EQ(tensors.size(), 3);
+  for (int i = 0; i < 3; ++i) {
+    test::ExpectTensorEqual<float>(tensors[i], tensors_expected[i]);
+  }
+}
+
+TEST_F(CommonSubgraphEliminationTest, KeepCallsToStatefulFunctions) {
+  using test::function::NDef;
+  using FDH = FunctionDefHelper;
+
+  FunctionDef random = FDH::Create(
+      "Random", {"x: int32"}, {"y: float"}, {},
+      {{{"random"},
+        "RandomUniform",
+        {"x"},
+        {{"T", DT_INT32}, {"dtype", DT_FLOAT}}}},
+      {{"y", "random:output:0"}});
+  FunctionDef random_copy = random;
+  random_copy.mutable_signature()->set_name("RandomCopy");
+
+  const auto call_node = [](const string& name, const string& function) {
+    return NDef(name, "StatefulPartitionedCall", {"shape"},
+                {{"Tin", DataTypeSlice{DT_INT32}},
+                 {"Tout", DataTypeSlice{DT_FLOAT}},
+                 {"f", FDH::FunctionRef(function, {})}});
+  };
+  GrapplerItem item;
+  item.fetch = {"z"};
+  item.graph = test::function::GDef(
+      {NDef("shape", "Const", {},
+            {{"dtype", DT_INT32}, {"value", test::AsTensor<int32>({2})}}),
+       call_node("r1", "Random"), call_node("r2", "RandomCopy"),
+       NDef("z", "Sub", {"r1", "r2"}, {{"T", DT_FLOAT}})},
+      {random, random_copy});
+
+  CommonSubgraphElimination optimizer(RewriterConfig::ON,
+                                      /*dedup_functions=*/true);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  NodeMap node_map(&output);
+  // Both calls now use the same function, but must still run separately.
+  EXPECT_EQ(output.node_size(), 4);
+  const NodeDef* r1 = node_map.GetNode("r1");
+  ASSERT_NE(r1, nullptr);
+  const NodeDef* r2 = node_map.GetNode("r2");
+  ASSERT_NE(r2, nullptr);
+  EXPECT_EQ(r1->attr().at("f").func().name(), "Random");
+  EXPECT_EQ(r2->attr().at("f").func().name(), "Random");
+}
+
 }  // namespace grappler
 }  // namespace tensorflow
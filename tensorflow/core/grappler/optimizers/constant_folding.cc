@@ -56,6 +56,7 @@ limitations under the License.
 #include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/public/version.h"
 #include "tensorflow/core/util/bcast.h"
+#include "tensorflow/core/util/device_name_utils.h"
 #include "tensorflow/core/util/overflow.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
 
@@ -193,21 +194,30 @@ float QuantizedTypeMaxAsFloat(DataType data_type) {
 ConstantFolding::ConstantFolding(RewriterConfig::Toggle opt_level,
                                  DeviceBase* cpu_device,
                                  bool disable_compressed_tensor_optimization,
-                                 bool fold_quantization_emulation)
+                                 bool fold_quantization_emulation,
+                                 const string& large_constant_dir,
+                                 int64_t large_constant_max_bytes)
     : opt_level_(opt_level),
       cpu_device_(cpu_device),
       disable_compressed_tensor_optimization_(
           disable_compressed_tensor_optimization),
       fold_quantization_emulation_(fold_quantization_emulation) {
   resource_mgr_.reset(new ResourceMgr());
+  if (!large_constant_dir.empty()) {
+    large_constant_store_ = std::make_unique<LargeConstantStore>(
+        large_constant_dir, large_constant_max_bytes);
+  }
 }
 
 ConstantFolding::ConstantFolding(DeviceBase* cpu_device,
                                  bool disable_compressed_tensor_optimization,
-                                 bool fold_quantization_ops)
+                                 bool fold_quantization_ops,
+                                 const string& large_constant_dir,
+                                 int64_t large_constant_max_bytes)
     : ConstantFolding(RewriterConfig::ON, cpu_device,
                       disable_compressed_tensor_optimization,
-                      fold_quantization_ops) {}
+                      fold_quantization_ops, large_constant_dir,
+                      large_constant_max_bytes) {}
 
 // static
 string ConstantFolding::AddControlDependency(const string& input_name,
@@ -384,6 +394,26 @@ bool ConstantFolding::IsReallyConstant(const NodeDef& node) const {
   return feed_nodes_.find(node.name()) == feed_nodes_.end();
 }
 
+bool ConstantFolding::IsStoredConstant(const NodeDef& node) const {
+  return large_constant_store_ != nullptr &&
+         large_constant_store_->IsStoredConstant(node) &&
+         feed_nodes_.find(node.name()) == feed_nodes_.end();
+}
+
+bool ConstantFolding::CanStoreLargeConstant(const NodeDef& node,
+                                            DataType dtype,
+                                            int64_t num_bytes) const {
+  if (large_constant_store_ == nullptr ||
+      !large_constant_store_->CanStore(dtype, num_bytes)) {
+    return false;
+  }
+  // ImmutableConst is only implemented on CPU.
+  if (node.device().empty()) return true;
+  DeviceNameUtils::ParsedName parsed_name;
+  return DeviceNameUtils::ParseFullName(node.device(), &parsed_name) &&
+         (!parsed_name.has_type || parsed_name.type == DEVICE_CPU);
+}
+
 // TODO(rmlarsen): Refactor to shared util.
 bool ConstantFolding::GetTensorFromConstNode(const string& node_name_or_input,
                                              Tensor* tensor) {
@@ -984,7 +1014,8 @@ bool ConstantFolding::IsFoldableUncached(
     if (!input_node) {
       return false;
     }
-    bool is_const = IsReallyConstant(*input_node);
+    bool is_const =
+        IsReallyConstant(*input_node) || IsStoredConstant(*input_node);
     if (is_const) {
       // Don't fold strings constants for now since this causes problems with
       // checkpointing.
@@ -1037,7 +1068,8 @@ bool ConstantFolding::IsFoldableUncached(
         if (num_bytes < 0) {  // Overflown
           return false;
         }
-        if (num_bytes > input_size_bytes && num_bytes > kMaxConstantSize) {
+        if (num_bytes > input_size_bytes && num_bytes > kMaxConstantSize &&
+            !CanStoreLargeConstant(node, output_prop.dtype(), num_bytes)) {
           // Do not fold nodes if the in-memory size of output is too large.
           // Notice that this is not exactly the same check used in
           // CreateNodeDef() where the actual encoded size is checked.
@@ -1365,6 +1397,17 @@ Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
       break;
     }
     const NodeDef* input_node = node_map_->GetNode(input);
+    if (IsStoredConstant(*input_node)) {
+      Tensor* value = new Tensor;
+      Status s = LargeConstantStore::ReadTensor(*input_node, value);
+      if (!s.ok()) {
+        delete value;
+        return s;
+      }
+      inputs.emplace_back(value);
+      total_inputs_size += value->TotalBytes();
+      continue;
+    }
     if (!IsReallyConstant(*input_node)) {
       return Status(absl::StatusCode::kInvalidArgument,
                     strings::StrCat("Can't fold ", node.name(), ", its ", input,
@@ -1410,6 +1453,14 @@ Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
     if (output_tensors[i].tensor) {
       Status s = CreateNodeDef(node_name, output_tensors[i], &outputs->at(i),
                                total_inputs_size);
+      const Tensor& tensor = *output_tensors[i].tensor;
+      if (!s.ok() &&
+          CanStoreLargeConstant(node, tensor.dtype(), tensor.TotalBytes())) {
+        // Too large to be embedded in the graph: reference a copy of the
+        // tensor in the large constant store instead.
+        s = large_constant_store_->CreateNodeDef(node_name, tensor,
+                                                 &outputs->at(i));
+      }
       if (!s.ok()) {
         *result_too_large = true;
         return s;
@@ -1568,7 +1619,7 @@ Status ConstantFolding::FoldNode(NodeDef* node, GraphDef* output_graph,
     // We rewrite the existing node if it only has a single output, and
     // create new nodes otherwise.
     if (const_nodes.size() == 1) {
-      node->set_op("Const");
+      node->set_op(const_node->op());
       // Note we need to clear the inputs in NodeMap before we clear the inputs
       // in the node, otherwise NodeMap would see empty inputs and effectively
       // does nothing.
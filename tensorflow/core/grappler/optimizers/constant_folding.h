@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/large_constant_store.h"
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
 
@@ -45,12 +46,19 @@ class ConstantFolding : public GraphOptimizer {
   static string AddControlDependency(const string& input_name, GraphDef* graph,
                                      NodeMap* node_map);
 
+  // If `large_constant_dir` is not empty, folded tensors that are too large
+  // to be embedded in the graph are written to files in that directory and
+  // replaced by ImmutableConst nodes, up to `large_constant_max_bytes` bytes.
   explicit ConstantFolding(DeviceBase* cpu_device,
                            bool disable_compressed_tensor_optimization = false,
-                           bool fold_quantization_emulation = true);
+                           bool fold_quantization_emulation = true,
+                           const string& large_constant_dir = "",
+                           int64_t large_constant_max_bytes = 0);
   ConstantFolding(RewriterConfig::Toggle opt_level, DeviceBase* cpu_device,
                   bool disable_compressed_tensor_optimization = false,
-                  bool fold_quantization_emulation = true);
+                  bool fold_quantization_emulation = true,
+                  const string& large_constant_dir = "",
+                  int64_t large_constant_max_bytes = 0);
 
   ~ConstantFolding() override {}
 
@@ -67,6 +75,12 @@ class ConstantFolding : public GraphOptimizer {
   bool OptimizedNodeExists(const NodeDef& node, StringPiece suffix) const;
 
   bool IsReallyConstant(const NodeDef& node) const;
+  // Returns true if `node` reads a tensor from the large constant store.
+  bool IsStoredConstant(const NodeDef& node) const;
+  // Returns true if an output of `node` of the given type and size can be
+  // folded into the large constant store.
+  bool CanStoreLargeConstant(const NodeDef& node, DataType dtype,
+                             int64_t num_bytes) const;
 
   bool GetTensorFromConstNode(const string& node_name_or_input, Tensor* tensor);
 
@@ -340,6 +354,8 @@ class ConstantFolding : public GraphOptimizer {
   bool graph_contains_assign_or_inplace_op_;
   bool disable_compressed_tensor_optimization_;
   bool fold_quantization_emulation_;
+  // Holds the folded tensors that exceed kMaxConstantSize, if enabled.
+  std::unique_ptr<LargeConstantStore> large_constant_store_;
 };
 
 }  // end namespace grappler
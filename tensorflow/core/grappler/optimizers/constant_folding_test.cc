@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <string>
 
+#include "absl/strings/match.h"
 #include "tensorflow/cc/ops/array_ops.h"
 #include "tensorflow/cc/ops/array_ops_internal.h"
 #include "tensorflow/cc/ops/const_op.h"
@@ -31,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/grappler/utils/grappler_test.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/tensor_coding.h"
@@ -3240,6 +3242,59 @@ TEST_F(ConstantFoldingTest, LargeConstant) {
   test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
 }
 
+TEST_F(ConstantFoldingTest, LargeConstantStore) {
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  Output mat_diag =
+      ops::Const(scope.WithOpName("mat_diag"), 3.14f, TensorShape({1024 * 4}));
+  Output mat = ops::Diag(scope.WithOpName("mat"), mat_diag);
+  Output out = ops::Identity(scope.WithOpName("out"), mat);
+
+  GrapplerItem item;
+  TF_CHECK_OK(scope.ToGraphDef(&item.graph));
+  item.fetch.push_back("out");
+
+  const string store_dir =
+      io::JoinPath(testing::TmpDir(), "constant_folding_large_constants");
+  ConstantFolding optimizer(/*cpu_device=*/nullptr,
+                            /*disable_compressed_tensor_optimization=*/false,
+                            /*fold_quantization_emulation=*/true, store_dir);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(/*cluster=*/nullptr, item, &output));
+
+  // The diag node is folded into a memory mapped constant, which keeps the
+  // graph small.
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "mat") {
+      EXPECT_EQ(node.op(), "ImmutableConst");
+      EXPECT_EQ(node.input_size(), 0);
+      EXPECT_TRUE(absl::StartsWith(
+          node.attr().at("memory_region_name").s(), store_dir));
+      ++found;
+    }
+  }
+  EXPECT_EQ(found, 1);
+  EXPECT_LT(output.ByteSizeLong(), 1000);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
+
+  // The node is left as is if it exceeds the budget of the store.
+  ConstantFolding small_store_optimizer(
+      /*cpu_device=*/nullptr,
+      /*disable_compressed_tensor_optimization=*/false,
+      /*fold_quantization_emulation=*/true, store_dir,
+      /*large_constant_max_bytes=*/1024);
+  TF_EXPECT_OK(
+      small_store_optimizer.Optimize(/*cluster=*/nullptr, item, &output));
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "mat") EXPECT_EQ(node.op(), "Diag");
+  }
+}
+
 TEST_F(ConstantFoldingTest, SwitchIdenticalInputs) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
   Output x = ops::Placeholder(s.WithOpName("x"), DT_BOOL,
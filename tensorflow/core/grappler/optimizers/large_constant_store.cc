@@ -0,0 +1,151 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/large_constant_store.h"
+
+#include <cstring>
+#include <memory>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/fingerprint.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// Attributes of the ImmutableConst op.
+constexpr char kImmutableConstOp[] = "ImmutableConst";
+constexpr char kDTypeAttr[] = "dtype";
+constexpr char kShapeAttr[] = "shape";
+constexpr char kMemoryRegionNameAttr[] = "memory_region_name";
+
+constexpr char kTensorFileSuffix[] = ".tensor";
+
+}  // namespace
+
+LargeConstantStore::LargeConstantStore(const string& directory,
+                                       int64_t max_bytes)
+    : directory_(directory),
+      max_bytes_(max_bytes > 0 ? max_bytes
+                               : kDefaultLargeConstantStoreMaxBytes) {}
+
+bool LargeConstantStore::CanStore(DataType dtype, int64_t num_bytes) const {
+  // ImmutableConst outputs the memory mapped buffer as is, which only works
+  // for types with a trivial in-memory representation.
+  return DataTypeCanUseMemcpy(dtype) && dtype != DT_STRING &&
+         num_bytes >= 0 && bytes_written_ + num_bytes <= max_bytes_;
+}
+
+Status LargeConstantStore::CreateNodeDef(const string& name,
+                                         const Tensor& tensor,
+                                         NodeDef* node) {
+  const int64_t num_bytes = tensor.TotalBytes();
+  if (!CanStore(tensor.dtype(), num_bytes)) {
+    return errors::ResourceExhausted(
+        "Can't store a tensor of ", num_bytes, " bytes of type ",
+        DataTypeString(tensor.dtype()), " in ", directory_, " (",
+        bytes_written_, " of ", max_bytes_, " bytes already written)");
+  }
+
+  const uint64 fingerprint = FingerprintCat64(
+      Fingerprint64(tensor.tensor_data()),
+      Fingerprint64(absl::StrCat(DataTypeString(tensor.dtype()),
+                                 tensor.shape().DebugString())));
+  const string path = io::JoinPath(
+      directory_, absl::StrCat(absl::Hex(fingerprint, absl::kZeroPad16),
+                               kTensorFileSuffix));
+
+  Env* env = Env::Default();
+  uint64 file_size = 0;
+  if (!env->GetFileSize(path, &file_size).ok() || file_size != num_bytes) {
+    TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(directory_));
+    // Write to a temporary file first, so that a concurrently loaded graph
+    // never maps a partially written file.
+    const string tmp_path = absl::StrCat(path, ".tmp", random::New64());
+    std::unique_ptr<WritableFile> file;
+    TF_RETURN_IF_ERROR(env->NewWritableFile(tmp_path, &file));
+    TF_RETURN_IF_ERROR(file->Append(tensor.tensor_data()));
+    TF_RETURN_IF_ERROR(file->Close());
+    TF_RETURN_IF_ERROR(env->RenameFile(tmp_path, path));
+    bytes_written_ += num_bytes;
+  }
+
+  node->Clear();
+  node->set_name(name);
+  node->set_op(kImmutableConstOp);
+  auto* attr = node->mutable_attr();
+  (*attr)[kDTypeAttr].set_type(tensor.dtype());
+  tensor.shape().AsProto((*attr)[kShapeAttr].mutable_shape());
+  (*attr)[kMemoryRegionNameAttr].set_s(path);
+  return OkStatus();
+}
+
+bool LargeConstantStore::IsStoredConstant(const NodeDef& node) const {
+  if (node.op() != kImmutableConstOp) return false;
+  auto it = node.attr().find(kMemoryRegionNameAttr);
+  return it != node.attr().end() &&
+         absl::StartsWith(it->second.s(), directory_) &&
+         absl::EndsWith(it->second.s(), kTensorFileSuffix);
+}
+
+// static
+Status LargeConstantStore::ReadTensor(const NodeDef& node, Tensor* tensor) {
+  if (node.op() != kImmutableConstOp) {
+    return errors::InvalidArgument(node.name(), " is not an ",
+                                   kImmutableConstOp, " node");
+  }
+  const auto& attr = node.attr();
+  if (!attr.count(kDTypeAttr) || !attr.count(kShapeAttr) ||
+      !attr.count(kMemoryRegionNameAttr)) {
+    return errors::InvalidArgument("Incomplete ", kImmutableConstOp,
+                                   " node ", node.name());
+  }
+  const DataType dtype = attr.at(kDTypeAttr).type();
+  TensorShape shape;
+  TF_RETURN_IF_ERROR(
+      TensorShape::BuildTensorShape(attr.at(kShapeAttr).shape(), &shape));
+  if (!DataTypeCanUseMemcpy(dtype)) {
+    return errors::Unimplemented("Can't read tensors of type ",
+                                 DataTypeString(dtype), " from ",
+                                 node.name());
+  }
+
+  std::unique_ptr<ReadOnlyMemoryRegion> region;
+  TF_RETURN_IF_ERROR(Env::Default()->NewReadOnlyMemoryRegionFromFile(
+      attr.at(kMemoryRegionNameAttr).s(), &region));
+  Tensor result(dtype, shape);
+  if (region->length() < result.TotalBytes()) {
+    return errors::DataLoss("File ", attr.at(kMemoryRegionNameAttr).s(),
+                            " of ", node.name(), " has ", region->length(),
+                            " bytes, expected ", result.TotalBytes());
+  }
+  std::memcpy(const_cast<char*>(result.tensor_data().data()), region->data(),
+              result.TotalBytes());
+  *tensor = std::move(result);
+  return OkStatus();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
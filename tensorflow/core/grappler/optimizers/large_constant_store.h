@@ -0,0 +1,75 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_LARGE_CONSTANT_STORE_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_LARGE_CONSTANT_STORE_H_
+
+#include <cstdint>
+#include <string>
+
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Default limit of the number of bytes written to a store while optimizing a
+// single graph.
+constexpr int64_t kDefaultLargeConstantStoreMaxBytes = 4LL << 30;
+
+// Stores constant tensors that are too large to be embedded in a GraphDef in
+// files of a directory, one raw tensor buffer per file. The tensors are
+// referenced from ImmutableConst nodes, which memory map the files when the
+// graph is loaded instead of parsing them from the GraphDef.
+//
+// Files are named after a fingerprint of the tensor, so identical tensors
+// share a file and rewriting the same graph produces the same GraphDef.
+class LargeConstantStore {
+ public:
+  // Writes at most `max_bytes` bytes of new files to `directory`. Uses
+  // kDefaultLargeConstantStoreMaxBytes if `max_bytes` isn't positive.
+  LargeConstantStore(const string& directory, int64_t max_bytes);
+
+  const string& directory() const { return directory_; }
+  int64_t bytes_written() const { return bytes_written_; }
+
+  // Returns true if a tensor of the given type and size can be added to the
+  // store without exceeding its budget.
+  bool CanStore(DataType dtype, int64_t num_bytes) const;
+
+  // Writes `tensor` to the store and sets `node` to an ImmutableConst node
+  // named `name` that produces it.
+  Status CreateNodeDef(const string& name, const Tensor& tensor,
+                       NodeDef* node);
+
+  // Returns true if `node` is an ImmutableConst node reading a file of this
+  // store.
+  bool IsStoredConstant(const NodeDef& node) const;
+
+  // Reads the tensor produced by the ImmutableConst `node`.
+  static Status ReadTensor(const NodeDef& node, Tensor* tensor);
+
+ private:
+  const string directory_;
+  const int64_t max_bytes_;
+  int64_t bytes_written_ = 0;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_LARGE_CONSTANT_STORE_H_
@@ -0,0 +1,92 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/large_constant_store.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+string StoreDir(const string& name) {
+  return io::JoinPath(testing::TmpDir(), "large_constant_store_test", name);
+}
+
+Tensor Iota(int64_t size) {
+  Tensor tensor(DT_FLOAT, TensorShape({size}));
+  auto flat = tensor.flat<float>();
+  for (int64_t i = 0; i < size; ++i) flat(i) = i;
+  return tensor;
+}
+
+TEST(LargeConstantStoreTest, WritesAndReadsTensors) {
+  LargeConstantStore store(StoreDir("round_trip"), /*max_bytes=*/0);
+  const Tensor tensor = Iota(1000);
+  NodeDef node;
+  TF_ASSERT_OK(store.CreateNodeDef("c", tensor, &node));
+  EXPECT_EQ(node.name(), "c");
+  EXPECT_EQ(node.op(), "ImmutableConst");
+  EXPECT_EQ(node.attr().at("dtype").type(), DT_FLOAT);
+  EXPECT_TRUE(store.IsStoredConstant(node));
+  EXPECT_EQ(store.bytes_written(), tensor.TotalBytes());
+
+  Tensor read;
+  TF_ASSERT_OK(LargeConstantStore::ReadTensor(node, &read));
+  test::ExpectTensorEqual<float>(tensor, read);
+}
+
+TEST(LargeConstantStoreTest, SharesFilesOfIdenticalTensors) {
+  LargeConstantStore store(StoreDir("dedup"), /*max_bytes=*/0);
+  NodeDef node1, node2, node3;
+  TF_ASSERT_OK(store.CreateNodeDef("c1", Iota(100), &node1));
+  TF_ASSERT_OK(store.CreateNodeDef("c2", Iota(100), &node2));
+  TF_ASSERT_OK(store.CreateNodeDef("c3", Iota(101), &node3));
+  EXPECT_EQ(node1.attr().at("memory_region_name").s(),
+            node2.attr().at("memory_region_name").s());
+  EXPECT_NE(node1.attr().at("memory_region_name").s(),
+            node3.attr().at("memory_region_name").s());
+  EXPECT_EQ(store.bytes_written(), 201 * sizeof(float));
+}
+
+TEST(LargeConstantStoreTest, EnforcesBudget) {
+  LargeConstantStore store(StoreDir("budget"), /*max_bytes=*/1000);
+  EXPECT_TRUE(store.CanStore(DT_FLOAT, 1000));
+  EXPECT_FALSE(store.CanStore(DT_FLOAT, 1001));
+  EXPECT_FALSE(store.CanStore(DT_STRING, 10));
+
+  NodeDef node;
+  TF_ASSERT_OK(store.CreateNodeDef("small", Iota(200), &node));
+  EXPECT_TRUE(
+      errors::IsResourceExhausted(store.CreateNodeDef("big", Iota(51), &node)));
+}
+
+TEST(LargeConstantStoreTest, IgnoresOtherNodes) {
+  LargeConstantStore store(StoreDir("other"), /*max_bytes=*/0);
+  NodeDef node;
+  node.set_op("ImmutableConst");
+  (*node.mutable_attr())["memory_region_name"].set_s("/some/other/file");
+  EXPECT_FALSE(store.IsStoredConstant(node));
+  node.set_op("Const");
+  EXPECT_FALSE(store.IsStoredConstant(node));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -52,6 +52,8 @@ namespace {
 // Prefix added to nodes which are recomputed.
 const char* kRecomputedNodePrefix = "Recomputed";
 const char* kRecomputeTriggerNodePrefix = "RecomputeTrigger";
+// Prefix added to nodes which are recomputed to reduce the peak memory usage.
+const char* kRematerializedNodePrefix = "Rematerialized";
 // Attribute which may be added to nodes to manually allow them to be
 // recomputed.
 const char* kRecomputeHint = "_recompute_hint";
@@ -977,6 +979,40 @@ struct MemInfo {
   bool operator<(const MemInfo& other) const { return fitness < other.fitness; }
 };
 
+// Simulates the execution of the item on the devices of the cluster, and
+// records the start and completion time of every op. Either map may be null.
+static Status EstimateOpTimes(
+    Cluster* cluster, const GrapplerItem& item,
+    std::unordered_map<string, Costs::NanoSeconds>* op_start_times,
+    std::unordered_map<string, Costs::NanoSeconds>* op_completion_times) {
+  VirtualCluster vcluster(cluster->GetDevices());
+  TF_RETURN_IF_ERROR(vcluster.Provision());
+  TF_RETURN_IF_ERROR(vcluster.Initialize(item));
+  RunMetadata metadata;
+  Status s = vcluster.Run(item.graph, item.feed, item.fetch, &metadata);
+  if (!s.ok() && s.code() != error::RESOURCE_EXHAUSTED) {
+    return s;
+  }
+
+  for (const auto& dev_stats : metadata.step_stats().dev_stats()) {
+    for (const auto& node_stats : dev_stats.node_stats()) {
+      if (op_start_times != nullptr) {
+        op_start_times->emplace(
+            node_stats.node_name(),
+            Costs::MicroSeconds(node_stats.all_start_micros()));
+      }
+      if (op_completion_times != nullptr) {
+        Costs::NanoSeconds exec_time =
+            Costs::NanoSeconds(1) +
+            Costs::MicroSeconds(node_stats.all_start_micros() +
+                                node_stats.op_end_rel_micros());
+        op_completion_times->emplace(node_stats.node_name(), exec_time);
+      }
+    }
+  }
+  return OkStatus();
+}
+
 static bool IdentifySwappingCandidates(
     Cluster* cluster, GrapplerItem* item,
     std::unique_ptr<GraphMemory>* memory_ptr,
@@ -1012,29 +1048,10 @@ static bool IdentifySwappingCandidates(
     int64_t required_savings = mem_usage.used_memory - prop.memory_size();
 
     std::unordered_map<string, Costs::NanoSeconds> op_completion_times;
-    {
-      VirtualCluster vcluster(cluster->GetDevices());
-      if (!vcluster.Provision().ok()) {
-        return false;
-      }
-      if (!vcluster.Initialize(*item).ok()) {
-        return false;
-      }
-      RunMetadata metadata;
-      Status s = vcluster.Run(item->graph, item->feed, item->fetch, &metadata);
-      if (!s.ok() && s.code() != error::RESOURCE_EXHAUSTED) {
-        return false;
-      }
-
-      for (const auto& dev_stats : metadata.step_stats().dev_stats()) {
-        for (const auto& node_stats : dev_stats.node_stats()) {
-          Costs::NanoSeconds exec_time =
-              Costs::NanoSeconds(1) +
-              Costs::MicroSeconds(node_stats.all_start_micros() +
-                                  node_stats.op_end_rel_micros());
-          op_completion_times.emplace(node_stats.node_name(), exec_time);
-        }
-      }
+    if (!EstimateOpTimes(cluster, *item, /*op_start_times=*/nullptr,
+                         &op_completion_times)
+             .ok()) {
+      return false;
     }
 
     Costs::Duration peak_time = -1;
@@ -1270,6 +1287,274 @@ bool SwappingPass(RewriterConfig::MemOptType optimization_level,
   return updated_graph;
 }
 
+// Returns true if `to` is in the transitive fanout of `from`.
+static bool IsInTransitiveFanout(const MutableGraphView& graph,
+                                 const NodeDef* from, const NodeDef* to) {
+  std::unordered_set<const NodeDef*> visited;
+  std::vector<const NodeDef*> queue = {from};
+  while (!queue.empty()) {
+    const NodeDef* node = queue.back();
+    queue.pop_back();
+    if (node == to) {
+      return true;
+    }
+    for (const auto& fanout :
+         graph.GetFanouts(*node, /*include_controlled_nodes=*/true)) {
+      if (visited.insert(fanout.node).second) {
+        queue.push_back(fanout.node);
+      }
+    }
+  }
+  return false;
+}
+
+// Returns true if a copy of the node computes the same outputs as the node
+// itself, so the copy can be run at a later time.
+static bool IsRematerializable(const NodeDef& node,
+                               const std::unordered_set<string>& feeds) {
+  if (feeds.find(node.name()) != feeds.end()) {
+    return false;
+  }
+  // Persistent tensors aren't freed after their last use anyway.
+  if (IsPersistent(node)) {
+    return false;
+  }
+  // Don't duplicate or move ops across frames or branches.
+  if (ModifiesFrameInfo(node) || IsSwitch(node) || IsMerge(node)) {
+    return false;
+  }
+  if (IsStateful(node) || HasRefInput(node)) {
+    return false;
+  }
+  return true;
+}
+
+// Reduces the peak memory usage of the CPU devices to `peak_memory_target`
+// bytes. The activations which are live at the peak and used again later on
+// are either recomputed right before their first use after the peak if they
+// are cheap to compute, or, if they aren't used before the peak, computed
+// right before their first use instead.
+bool RematerializationPass(Cluster* cluster, int64_t peak_memory_target,
+                           std::unique_ptr<GraphMemory>* memory_ptr,
+                           GrapplerItem* item,
+                           std::unordered_set<string>* skip_list) {
+  if ((*memory_ptr) == nullptr) {
+    memory_ptr->reset(new GraphMemory(*item));
+    Status s = (*memory_ptr)->InferStatically(cluster->GetDevices());
+    if (!s.ok()) {
+      memory_ptr->reset();
+      VLOG(1) << "Failed to infer memory usage: " << s.message();
+      return false;
+    }
+  }
+  const GraphMemory& memory = **memory_ptr;
+
+  const std::unordered_set<string> cheap_to_recompute_ops =
+      GetCheapToRecomputeOps();
+  const std::unordered_set<string> nodes_to_preserve = item->NodesToPreserve();
+  std::unordered_set<string> feeds;
+  for (const auto& feed : item->feed) {
+    feeds.insert(NodeName(feed.first));
+  }
+
+  std::unordered_map<string, Costs::NanoSeconds> op_start_times;
+  std::unordered_map<const NodeDef*, Costs::NanoSeconds> execution_times;
+  std::unordered_map<string, const NodeDef*> name_map;
+  MutableGraphView graph(&item->graph);
+
+  bool updated_graph = false;
+  for (const auto& device : cluster->GetDevices()) {
+    const string& name = device.first;
+    const DeviceProperties& prop = device.second;
+    if (prop.type() != "CPU") {
+      continue;
+    }
+    const GraphMemory::MemoryUsage& mem_usage = memory.GetPeakMemoryUsage(name);
+    if (mem_usage.used_memory <= peak_memory_target) {
+      continue;
+    }
+    int64_t required_savings = mem_usage.used_memory - peak_memory_target;
+
+    if (op_start_times.empty()) {
+      if (!EstimateOpTimes(cluster, *item, &op_start_times,
+                           /*op_completion_times=*/nullptr)
+               .ok() ||
+          !EstimateEarliestExecutionTimes(*item, cluster, &execution_times)
+               .ok()) {
+        return updated_graph;
+      }
+      for (const auto& node : item->graph.node()) {
+        name_map[node.name()] = &node;
+      }
+    }
+
+    Costs::Duration peak_time = -1;
+    std::unordered_map<string, Costs::Duration> deallocation_times;
+    for (const auto& live_tensor : mem_usage.live_tensors) {
+      peak_time = std::max(peak_time, live_tensor.allocation_time);
+      deallocation_times[strings::StrCat(live_tensor.node, ":",
+                                         live_tensor.output_id)] =
+          live_tensor.deallocation_time;
+    }
+
+    std::vector<MemInfo> mem_state;
+    for (const auto& live_tensor : mem_usage.live_tensors) {
+      if (live_tensor.memory_used <= 1024) {
+        // Don't bother with small tensors.
+        continue;
+      }
+      if (skip_list->find(live_tensor.node) != skip_list->end()) {
+        continue;
+      }
+      NodeDef* node = graph.GetNode(live_tensor.node);
+      if (node == nullptr || !IsRematerializable(*node, feeds)) {
+        continue;
+      }
+
+      MemInfo mem_info;
+      mem_info.port = graph.GetOutputPort(node->name(), live_tensor.output_id);
+      mem_info.memory_used = live_tensor.memory_used;
+      Costs::Duration earliest_use(Costs::Duration::infinity());
+      bool used_before_peak = false;
+      bool valid = true;
+      for (const MutableGraphView::InputPort& input :
+           graph.GetFanout(mem_info.port)) {
+        auto it = op_start_times.find(input.node->name());
+        if (it == op_start_times.end() ||
+            skip_list->find(input.node->name()) != skip_list->end()) {
+          valid = false;
+          break;
+        }
+        if (it->second <= peak_time) {
+          used_before_peak = true;
+          continue;
+        }
+        // Keep the first use after the peak in front.
+        mem_info.uses_left.push_back(input);
+        if (it->second < earliest_use) {
+          earliest_use = it->second;
+          std::swap(mem_info.uses_left.front(), mem_info.uses_left.back());
+        }
+      }
+      if (!valid || mem_info.uses_left.empty()) {
+        continue;
+      }
+      if (used_before_peak) {
+        // The tensor is needed before the peak, so it has to be computed
+        // twice: only do this for ops which are cheap to recompute.
+        if (cheap_to_recompute_ops.find(node->op()) ==
+                cheap_to_recompute_ops.end() &&
+            node->attr().count(kRecomputeHint) == 0) {
+          continue;
+        }
+      } else if (live_tensor.allocation_time >= peak_time ||
+                 nodes_to_preserve.find(node->name()) !=
+                     nodes_to_preserve.end()) {
+        continue;
+      }
+
+      // The inputs must still be available when the op runs again, without
+      // extending their lifetime.
+      for (const string& input : node->input()) {
+        const TensorId input_id = ParseTensorName(input);
+        if (input_id.index() < 0) {
+          continue;
+        }
+        const NodeDef* input_node = graph.GetNode(input_id.node());
+        if (input_node != nullptr && IsPersistent(*input_node)) {
+          continue;
+        }
+        auto it = deallocation_times.find(strings::StrCat(
+            input_id.node(), ":", input_id.index()));
+        if (it == deallocation_times.end() || it->second < earliest_use) {
+          valid = false;
+          break;
+        }
+      }
+      if (!valid) {
+        continue;
+      }
+
+      // Prefer large tensors which won't be needed for a long time after the
+      // peak. The arithmetic is done as "double" since the product doesn't fit
+      // into any integral type.
+      mem_info.fitness = -static_cast<double>(mem_info.memory_used) *
+                         (earliest_use - peak_time).count();
+      mem_state.push_back(mem_info);
+    }
+
+    // Sort by fitness
+    std::sort(mem_state.begin(), mem_state.end());
+
+    for (const MemInfo& mem_info : mem_state) {
+      NodeDef* node = mem_info.port.node;
+      if (skip_list->find(node->name()) != skip_list->end()) {
+        continue;
+      }
+      // Don't attempt to reprocess this node in a subsequent pass.
+      skip_list->insert(node->name());
+
+      // Compute the tensor after the node that runs right before its first use
+      // after the peak.
+      SwapInfo trigger_info;
+      const MutableGraphView::InputPort& first_use = mem_info.uses_left[0];
+      trigger_info.inputs_to_swap.push_back(first_use.port_id);
+      const NodeDef* trigger = FindSwapInTrigger(first_use.node, trigger_info,
+                                                 name_map, execution_times);
+      if (trigger == nullptr) {
+        continue;
+      }
+      const TensorId control_dependency(trigger->name(), Graph::kControlSlot);
+
+      bool used_before_peak = graph.GetFanout(mem_info.port).size() >
+                              mem_info.uses_left.size();
+      if (used_before_peak) {
+        const string copy_name =
+            AddPrefixToNodeName(node->name(), kRematerializedNodePrefix);
+        if (graph.GetNode(copy_name) != nullptr) {
+          continue;
+        }
+        NodeDef copy = *node;
+        copy.set_name(copy_name);
+        graph.AddNode(std::move(copy));
+        if (!graph.AddControllingFanin(copy_name, control_dependency).ok()) {
+          continue;
+        }
+        for (const MutableGraphView::InputPort& use : mem_info.uses_left) {
+          Status s = graph.UpdateRegularFaninByPort(
+              use.node->name(), use.port_id,
+              {copy_name, mem_info.port.port_id});
+          if (!s.ok()) {
+            VLOG(1) << "Failed to rematerialize input " << use.port_id
+                    << " of " << use.node->name() << ": " << s.message();
+          }
+        }
+        skip_list->insert(copy_name);
+        VLOG(1) << "Rematerialized " << node->name() << ":"
+                << mem_info.port.port_id << " of size "
+                << mem_info.memory_used << " after " << trigger->name();
+      } else {
+        // Delaying the node until after the trigger would create a cycle if
+        // the trigger depends on the node.
+        if (IsInTransitiveFanout(graph, node, trigger) ||
+            !graph.AddControllingFanin(node->name(), control_dependency)
+                 .ok()) {
+          continue;
+        }
+        VLOG(1) << "Delayed " << node->name() << ":" << mem_info.port.port_id
+                << " of size " << mem_info.memory_used << " after "
+                << trigger->name();
+      }
+      updated_graph = true;
+      required_savings -= mem_info.memory_used;
+      if (required_savings < 0) {
+        break;
+      }
+    }
+  }
+  return updated_graph;
+}
+
 bool CrossesTaskOrCpuGpuBoundary(const NodeDef& node1, const NodeDef& node2) {
   string task1;
   string device1;
@@ -1435,6 +1720,19 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
           updated_graph = true;
         }
       }
+
+      GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+      if (peak_memory_target_bytes_ > 0 &&
+          (optimization_level_ == RewriterConfig::DEFAULT_MEM_OPT ||
+           optimization_level_ == RewriterConfig::RECOMPUTATION_HEURISTICS ||
+           optimization_level_ == RewriterConfig::HEURISTICS)) {
+        if (RematerializationPass(cluster, peak_memory_target_bytes_, &memory,
+                                  &optimized_item, &skip_list)) {
+          // Reset the inferred memory usage since the graph changed.
+          memory.reset();
+          updated_graph = true;
+        }
+      }
     }
   }
 
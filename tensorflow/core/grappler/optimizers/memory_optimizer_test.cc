@@ -448,6 +448,109 @@ TEST_F(MemoryOptimizerTest, AccumulationRewrites) {
   }
 }
 
+TEST_F(MemoryOptimizerTest, RematerializesCheapActivations) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice("/cpu:0");
+  Output v = ops::Variable(s.WithOpName("v"), {128, 128, 8}, DT_FLOAT);
+  // "a" is needed at the beginning and at the end of the chain, and is cheap
+  // to recompute from "v".
+  Output a = ops::Square(s.WithOpName("a"), v);
+  Output b = ops::Sqrt(s.WithOpName("b"), a);
+  Output c = ops::Exp(s.WithOpName("c"), b);
+  Output d = ops::Log(s.WithOpName("d"), c);
+  Output e = ops::Tanh(s.WithOpName("e"), d);
+  Output f = ops::Add(s.WithOpName("f"), e, a);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"f"};
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+  MemoryOptimizer optimizer(RewriterConfig::RECOMPUTATION_HEURISTICS,
+                            "gradients/",
+                            /*peak_memory_target_bytes=*/1024 * 1024);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* rematerialized = node_map.GetNode("Rematerialized/a");
+  ASSERT_NE(rematerialized, nullptr);
+  EXPECT_EQ("Square", rematerialized->op());
+  ASSERT_EQ(2, rematerialized->input_size());
+  EXPECT_EQ("v", rematerialized->input(0));
+  EXPECT_EQ("^d", rematerialized->input(1));
+
+  // The early use keeps the original tensor, the late one uses the copy.
+  const NodeDef* new_b = node_map.GetNode("b");
+  ASSERT_NE(new_b, nullptr);
+  EXPECT_EQ("a", new_b->input(0));
+  const NodeDef* new_f = node_map.GetNode("f");
+  ASSERT_NE(new_f, nullptr);
+  EXPECT_EQ("Rematerialized/a", new_f->input(1));
+}
+
+TEST_F(MemoryOptimizerTest, DelaysActivationsOnlyUsedAfterPeak) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice("/cpu:0");
+  Output v = ops::Variable(s.WithOpName("v"), {128, 128, 8}, DT_FLOAT);
+  // "a" is computed at the beginning but only used at the end of the chain,
+  // so it can be computed later instead of being copied.
+  Output a = ops::Square(s.WithOpName("a"), v);
+  Output b = ops::Exp(s.WithOpName("b"), v);
+  Output c = ops::Log(s.WithOpName("c"), b);
+  Output d = ops::Tanh(s.WithOpName("d"), c);
+  Output e = ops::Sum(s.WithOpName("e"), d, {0, 1, 2});
+  Output f = ops::Mul(s.WithOpName("f"), a, e);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"f"};
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+  MemoryOptimizer optimizer(RewriterConfig::RECOMPUTATION_HEURISTICS,
+                            "gradients/",
+                            /*peak_memory_target_bytes=*/1024 * 1024);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+
+  // "a" now runs after "d", without a copy.
+  NodeMap node_map(&output);
+  EXPECT_EQ(node_map.GetNode("Rematerialized/a"), nullptr);
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+  const NodeDef* new_a = node_map.GetNode("a");
+  ASSERT_NE(new_a, nullptr);
+  ASSERT_EQ(2, new_a->input_size());
+  EXPECT_EQ("v", new_a->input(0));
+  EXPECT_EQ("^d", new_a->input(1));
+
+  // The other nodes, and so all the data edges, are unchanged.
+  NodeMap original_node_map(&item.graph);
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "a") continue;
+    const NodeDef* original = original_node_map.GetNode(node.name());
+    ASSERT_NE(original, nullptr) << node.name();
+    EXPECT_THAT(node.input(), ::testing::ElementsAreArray(original->input()))
+        << node.name();
+  }
+}
+
+TEST_F(MemoryOptimizerTest, NoRematerializationWithoutTarget) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice("/cpu:0");
+  Output v = ops::Variable(s.WithOpName("v"), {128, 128, 8}, DT_FLOAT);
+  Output a = ops::Square(s.WithOpName("a"), v);
+  Output b = ops::Sqrt(s.WithOpName("b"), a);
+  Output c = ops::Exp(s.WithOpName("c"), b);
+  Output f = ops::Add(s.WithOpName("f"), c, a);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"f"};
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+  MemoryOptimizer optimizer(RewriterConfig::RECOMPUTATION_HEURISTICS);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+  CompareGraphs(item.graph, output);
+}
+
 class RelaxAllocatorConstraintsTest : public GrapplerTest {};
 
 TEST_F(RelaxAllocatorConstraintsTest, SameDevice) {
@@ -17,15 +17,20 @@ limitations under the License.
 
 #include <algorithm>
 #include <functional>
+#include <memory>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/substitute.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/graph_constructor.h"
 #include "tensorflow/core/common_runtime/local_device.h"
@@ -50,10 +55,12 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/model_pruner.h"
+#include "tensorflow/core/grappler/optimizers/optimized_graph_cache.h"
 #include "tensorflow/core/grappler/optimizers/pin_to_host_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 #include "tensorflow/core/grappler/optimizers/scoped_allocator_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/shape_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/thread_budget_optimizer.h"
 #include "tensorflow/core/grappler/utils/canonicalizer.h"
 #include "tensorflow/core/grappler/utils/colocation.h"
 #include "tensorflow/core/grappler/utils/functions.h"
@@ -62,7 +69,9 @@ limitations under the License.
 #include "tensorflow/core/grappler/verifiers/structure_verifier.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/util/dump_graph.h"
 #include "tensorflow/core/util/util.h"
 #include "tensorflow/core/util/xla_config_registry.h"
@@ -218,7 +227,9 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
          new ConstantFolding(
              cpu_device_,
              cfg_.experimental_disable_compressed_tensor_optimization(),
-             !cfg_.experimental_disable_folding_quantization_emulation()));
+             !cfg_.experimental_disable_folding_quantization_emulation(),
+             cfg_.constant_folding_large_constant_dir(),
+             cfg_.constant_folding_large_constant_max_bytes()));
   MK_OPT("shape", "shape_optimization", new ShapeOptimizer());
   MK_OPT("remap", "remapping",
          new Remapper(cfg_.remapping(), cfg_.cpu_layout_conversion(),
@@ -236,6 +247,9 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
     MK_OPT("auto_mixed_precision_onednn_bfloat16",
            "auto_mixed_precision_onednn_bfloat16",
            new AutoMixedPrecision(AutoMixedPrecisionMode::BF16));
+    MK_OPT("auto_mixed_precision_native_bfloat16",
+           "auto_mixed_precision_native_bfloat16",
+           new AutoMixedPrecision(AutoMixedPrecisionMode::NATIVE_BF16));
   }
 #endif
   MK_OPT("auto_mixed_precision_cpu", "auto_mixed_precision_cpu",
@@ -243,7 +257,10 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
   MK_OPT("memory", "memory_optimization",
          new MemoryOptimizer(RewriterConfig::MANUAL));
   MK_OPT("common_subgraph_elimination", "common_subgraph_elimination",
-         new CommonSubgraphElimination(cfg_.common_subgraph_elimination()));
+         new CommonSubgraphElimination(
+             cfg_.common_subgraph_elimination(),
+             cfg_.common_subgraph_elimination_across_functions() ==
+                 RewriterConfig::ON));
   MK_OPT("arithmetic", "arithmetic_optimization",
          new ArithmeticOptimizer(cfg_.arithmetic_optimization()));
   MK_OPT("autoparallel", "auto_parallel",
@@ -258,6 +275,10 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
                                       cfg_.scoped_allocator_opts()));
   MK_OPT("pin_to_host", "pin_to_host_optimization",
          new PinToHostOptimizer(cfg_.pin_to_host_optimization()));
+  MK_OPT("thread_budget", "thread_budget_optimization",
+         new ThreadBudgetOptimizer(
+             cfg_.thread_budget_optimization(),
+             config_proto_.intra_op_parallelism_threads()));
 
   return std::unique_ptr<GraphOptimizer>();
 }
@@ -345,7 +366,9 @@ Status MetaOptimizer::InitializeOptimizers(
       VLOG(2) << "common_subgraph_elimination is not implemented in TFG yet";
     } else {
       optimizers->push_back(std::make_unique<CommonSubgraphElimination>(
-          cfg_.common_subgraph_elimination()));
+          cfg_.common_subgraph_elimination(),
+          cfg_.common_subgraph_elimination_across_functions() ==
+              RewriterConfig::ON));
     }
   }
   if (BOTH_ARE_ON(debug_stripper))
@@ -396,6 +419,14 @@ Status MetaOptimizer::InitializeOptimizers(
     optimizers->push_back(
         std::make_unique<AutoMixedPrecision>(AutoMixedPrecisionMode::BF16));
   }
+  if (AutoMixedPrecisionEnabled(cfg_.auto_mixed_precision_native_bfloat16()) &&
+      AutoMixedPrecisionEnabled(
+          plugin_configs
+              .toggle_config["auto_mixed_precision_native_bfloat16"]) &&
+      IsMKLEnabled()) {
+    optimizers->push_back(std::make_unique<AutoMixedPrecision>(
+        AutoMixedPrecisionMode::NATIVE_BF16));
+  }
 #endif
   if (AutoMixedPrecisionEnabled(cfg_.auto_mixed_precision_cpu()) &&
       AutoMixedPrecisionEnabled(
@@ -468,15 +499,12 @@ Status MetaOptimizer::InitializeOptimizers(
   if (MemoryOptimizerEnabled(cfg_.memory_optimization(),
                              xla_auto_clustering_on_) &&
       PLUGIN_NOT_OFF(memory_optimization)) {
-    if (cfg_.memory_optimizer_target_node_name_scope().empty()) {
-      optimizers->push_back(
-          // Use the default target node name prefix "gradients/"
-          std::make_unique<MemoryOptimizer>(cfg_.memory_optimization()));
-    } else {
-      optimizers->push_back(std::make_unique<MemoryOptimizer>(
-          cfg_.memory_optimization(),
-          cfg_.memory_optimizer_target_node_name_scope()));
-    }
+    const string& name_scope = cfg_.memory_optimizer_target_node_name_scope();
+    optimizers->push_back(std::make_unique<MemoryOptimizer>(
+        cfg_.memory_optimization(),
+        // Use the default target node name prefix "gradients/"
+        name_scope.empty() ? "gradients/" : name_scope,
+        cfg_.memory_optimizer_peak_memory_target_bytes()));
   }
   if (cfg_.auto_parallel().enable() && PLUGIN_IS_ON(auto_parallel)) {
     optimizers->push_back(
@@ -492,6 +520,13 @@ Status MetaOptimizer::InitializeOptimizers(
     VLOG(2) << "scoped_allocator_optimization is not implemented in TFG yet";
   }
 #endif
+  // Thread budgets depend on the final shape of the graph, so they are
+  // computed last.
+  if (BOTH_ARE_ON(thread_budget_optimization)) {
+    optimizers->push_back(std::make_unique<ThreadBudgetOptimizer>(
+        cfg_.thread_budget_optimization(),
+        config_proto_.intra_op_parallelism_threads()));
+  }
 
 #undef USER_IS_ON
 #undef USER_IS_EXPERIMENTAL_MLIR
@@ -636,6 +671,7 @@ void MetaOptimizer::PrintUserAndPluginConfigs(
     PRINT_CFG(loop_optimization)
     PRINT_CFG(dependency_optimization)
     PRINT_CFG(scoped_allocator_optimization)
+    PRINT_CFG(thread_budget_optimization)
 #undef PRINT_CFG
     user_cfg.toggle_config["auto_mixed_precision"] =
         AutoMixedPrecisionEnabled(cfg_.auto_mixed_precision())
@@ -653,6 +689,10 @@ void MetaOptimizer::PrintUserAndPluginConfigs(
         AutoMixedPrecisionEnabled(cfg_.auto_mixed_precision_cpu())
             ? RewriterConfig::ON
             : RewriterConfig::OFF;
+    user_cfg.toggle_config["auto_mixed_precision_native_bfloat16"] =
+        AutoMixedPrecisionEnabled(cfg_.auto_mixed_precision_native_bfloat16())
+            ? RewriterConfig::ON
+            : RewriterConfig::OFF;
     user_cfg.toggle_config["memory_optimization"] =
         MemoryOptimizerEnabled(cfg_.memory_optimization(),
                                config_proto_.graph_options()
@@ -683,6 +723,8 @@ void MetaOptimizer::PrintUserAndPluginConfigs(
                 "auto_mixed_precision_onednn_bfloat16")
       PRINT_CFG("auto_mixed_precision_mkl", "auto_mixed_precision_mkl")
       PRINT_CFG("auto_mixed_precision_cpu", "auto_mixed_precision_cpu")
+      PRINT_CFG("auto_mixed_precision_native_bfloat16",
+                "auto_mixed_precision_native_bfloat16")
       PRINT_CFG("pin_to_host", "pin_to_host_optimization")
       PRINT_CFG("layout", "layout_optimizer")
       PRINT_CFG("remap", "remapping")
@@ -691,6 +733,7 @@ void MetaOptimizer::PrintUserAndPluginConfigs(
       PRINT_CFG("memory", "memory_optimization")
       PRINT_CFG("autoparallel", "auto_parallel")
       PRINT_CFG("scoped_allocator", "scoped_allocator_optimization")
+      PRINT_CFG("thread_budget", "thread_budget_optimization")
 #undef PRINT_CFG
     }
   }
@@ -724,6 +767,7 @@ void MetaOptimizer::PrintUserAndPluginConfigs(
         pair.first == "auto_mixed_precision_onednn_bfloat16" ||
         pair.first == "auto_mixed_precision_mkl" ||
         pair.first == "auto_mixed_precision_cpu" ||
+        pair.first == "auto_mixed_precision_native_bfloat16" ||
         pair.first == "pin_to_host_optimization" ||
         pair.first == "scoped_allocator_optimization") {
       // These optimizers are turned off by default.
@@ -882,8 +926,12 @@ Status MetaOptimizer::OptimizeGraph(
                                      return result.status.ok();
                                    }) != optimization_result.results.end();
 
-  // Record graph optimization result.
-  optimization_results_.push_back(optimization_result);
+  // Record graph optimization result. Function bodies might be optimized
+  // concurrently.
+  {
+    mutex_lock lock(optimization_results_mu_);
+    optimization_results_.push_back(optimization_result);
+  }
 
   if (is_optimized) {
     TF_RETURN_IF_ERROR(TopologicalSort(optimized_graph));
@@ -1074,6 +1122,24 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
       "Deleted $0 unreachable functions from the graph (library size = $1)",
       old_library_size - new_library_size, new_library_size);
 
+  // Reuse the result of an earlier optimization of an identical graph, e.g. of
+  // an identical function instantiation or of the same model in an earlier
+  // process.
+  const bool use_graph_cache =
+      cfg_.experimental_optimized_graph_cache() == RewriterConfig::ON;
+  std::string graph_cache_key;
+  if (use_graph_cache) {
+    graph_cache_key =
+        OptimizedGraphCache::ComputeKey(item, cluster, config_proto_);
+    if (OptimizedGraphCache::Global()->Lookup(
+            graph_cache_key, cfg_.experimental_optimized_graph_cache_dir(),
+            optimized_graph)) {
+      VLOG(1) << "Reused cached optimized graph for grappler item: " << item.id;
+      return OkStatus();
+    }
+  }
+  const absl::Time optimization_start_time = absl::Now();
+
   // Save a few small fields from item before we move it.
   bool optimize_function_library =
       item.optimization_options().optimize_function_library;
@@ -1159,11 +1225,83 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
   // True if this is a TPU graph using the old bridge.
   bool is_tpu_graph = IsLegacyTPUBridgeGraphDef(*optimized_graph);
 
+  // If more than one thread is configured, the bodies of the functions found
+  // in a single pass over the library are optimized in parallel, and merged
+  // back into the library in library order. Otherwise each function is merged
+  // right after it is optimized, so the functions that follow it in the pass
+  // see the specializations it added to the library.
+  const int num_function_threads =
+      std::max(1, cfg_.meta_optimizer_function_library_threads());
+  std::unique_ptr<thread::ThreadPool> function_thread_pool;
+
   // Optimize each function only once.
   absl::flat_hash_set<string> optimized_funcs;
   while (optimize_function_library) {
     optimize_function_library = false;
 
+    // Functions collected in this pass, and their optimized body graphs.
+    std::vector<string> func_names;
+    std::vector<GrapplerFunctionItem> func_items;
+    std::vector<GraphDef> optimized_func_graphs;
+    std::vector<Status> func_statuses;
+
+    // Optimizes the body graph of the i-th collected function.
+    const auto optimize_function = [&](int i) {
+      if (is_tpu_graph) {
+        // Skip optimizing functions if this is a TPU graph. Currently, Grappler
+        // passes do not handle TPU functions correctly in a variety of ways
+        // (Note that due to the pre-placement TPU graph rewriting passes, the
+        // TPU-related ops are encapsulated away into functions). For example,
+        // TPU graphs contain TPUReplicateMetadata node that carries relevant
+        // TPU metadata and Grappler passes could prune that away. Grappler
+        // passes could also cause issues around shape inference. Since the
+        // desired and existing behavior is to not optimize TPU functions with
+        // Grappler, this check preserves that. The only exception is
+        // implementation selector what is required to swap in some TPU specific
+        // lowering code and is verified the work correctly on TPUs.
+        ImplementationSelector implementation_selector;
+
+        // Implementation selector needs to have access to valid function
+        // signature and attributes, and it doesn't need actual function body.
+        GrapplerFunctionItem func_item = func_items[i];
+        std::unique_ptr<FunctionDefLibrary> func_item_function_library(
+            func_item.graph.release_library());
+        *func_item.graph.mutable_library() =
+            GetFunctionDefLibraryStub(*func_item_function_library);
+
+        func_statuses[i] = implementation_selector.Optimize(
+            cluster, func_item, &optimized_func_graphs[i]);
+      } else {
+        GrapplerFunctionItem func_item_copy = func_items[i];
+        func_statuses[i] = OptimizeGraph(cluster, std::move(func_item_copy),
+                                         &optimized_func_graphs[i]);
+      }
+    };
+
+    // Merges the optimized body of the i-th collected function back into the
+    // library.
+    const auto merge_function = [&](int i) -> Status {
+      TF_RETURN_IF_ERROR(func_statuses[i]);
+      GraphDef& optimized_func_graph = optimized_func_graphs[i];
+
+      // Function body optimization might have created new specialized
+      // functions for each instantiation context. Add them to the library.
+      for (const FunctionDef& func_def :
+           optimized_func_graph.library().function()) {
+        if (flib.Find(func_def.signature().name()) == nullptr) {
+          TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
+        }
+      }
+
+      // Convert optimized graph back to FunctionDef.
+      FunctionDef optimized_func;
+      func_items[i].SwapFunctionBody(std::move(optimized_func_graph));
+      TF_RETURN_IF_ERROR(MakeFunctionDef(func_items[i], flib, &optimized_func));
+
+      // Replace optimized function with a new FunctionDef.
+      return flib.ReplaceFunction(func_names[i], optimized_func);
+    };
+
     int function_idx = 0;
     for (const FunctionDef& func : optimized_graph->library().function()) {
       GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
@@ -1221,59 +1359,59 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
       func_item.optimization_options().allow_pruning_stateful_and_dataset_ops =
           false;
 
-      // Optimize function body graph.
-      GraphDef optimized_func_graph;
-      if (is_tpu_graph) {
-        // Skip optimizing functions if this is a TPU graph. Currently, Grappler
-        // passes do not handle TPU functions correctly in a variety of ways
-        // (Note that due to the pre-placement TPU graph rewriting passes, the
-        // TPU-related ops are encapsulated away into functions). For example,
-        // TPU graphs contain TPUReplicateMetadata node that carries relevant
-        // TPU metadata and Grappler passes could prune that away. Grappler
-        // passes could also cause issues around shape inference. Since the
-        // desired and existing behavior is to not optimize TPU functions with
-        // Grappler, this check preserves that. The only exception is
-        // implementation selector what is required to swap in some TPU specific
-        // lowering code and is verified the work correctly on TPUs.
-        ImplementationSelector implementation_selector;
-
-        // Implementation selector needs to have access to valid function
-        // signature and attributes, and it doesn't need actual function body.
-        std::unique_ptr<FunctionDefLibrary> func_item_function_library(
-            func_item.graph.release_library());
-        *func_item.graph.mutable_library() =
-            GetFunctionDefLibraryStub(*func_item_function_library);
-
-        TF_RETURN_IF_ERROR(implementation_selector.Optimize(
-            cluster, func_item, &optimized_func_graph));
-      } else {
-        GrapplerFunctionItem func_item_copy = func_item;
-        TF_RETURN_IF_ERROR(OptimizeGraph(cluster, std::move(func_item_copy),
-                                         &optimized_func_graph));
+      func_names.push_back(func_name);
+      func_items.push_back(std::move(func_item));
+      if (num_function_threads == 1) {
+        const int i = func_items.size() - 1;
+        optimized_func_graphs.emplace_back();
+        func_statuses.emplace_back();
+        optimize_function(i);
+        TF_RETURN_IF_ERROR(merge_function(i));
       }
+    }
 
-      // Function body optimization might have created new specialized
-      // functions for each instantiation context. Add them to the library.
-      for (const FunctionDef& func_def :
-           optimized_func_graph.library().function()) {
-        if (flib.Find(func_def.signature().name()) == nullptr) {
-          TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
-        }
+    // Optimize the collected functions in parallel.
+    if (num_function_threads > 1 && !func_items.empty()) {
+      optimized_func_graphs.resize(func_items.size());
+      func_statuses.resize(func_items.size());
+      const size_t first_func_result = optimization_results_.size();
+      if (function_thread_pool == nullptr) {
+        function_thread_pool = std::make_unique<thread::ThreadPool>(
+            Env::Default(), "meta_optimizer_functions", num_function_threads);
       }
+      VLOG(2) << "Optimize " << func_items.size() << " functions using "
+              << num_function_threads << " threads";
+      BlockingCounter counter(func_items.size());
+      for (int i = 0; i < func_items.size(); ++i) {
+        function_thread_pool->Schedule([&, i]() {
+          optimize_function(i);
+          counter.DecrementCount();
+        });
+      }
+      counter.Wait();
 
-      // Convert optimized graph back to FunctionDef.
-      FunctionDef optimized_func;
-      func_item.SwapFunctionBody(std::move(optimized_func_graph));
-      TF_RETURN_IF_ERROR(MakeFunctionDef(func_item, flib, &optimized_func));
-
-      // Replace optimized function with a new FunctionDef.
-      TF_RETURN_IF_ERROR(flib.ReplaceFunction(func_name, optimized_func));
+      // Keep optimization results in library order, independent of the order
+      // in which the functions finished.
+      absl::flat_hash_map<string, int> func_index;
+      for (int i = 0; i < func_names.size(); ++i) {
+        func_index.emplace(func_names[i], i);
+      }
+      std::stable_sort(
+          optimization_results_.begin() + first_func_result,
+          optimization_results_.end(),
+          [&](const GraphOptimizationResult& a,
+              const GraphOptimizationResult& b) {
+            return func_index[a.id] < func_index[b.id];
+          });
+
+      // Merge optimized functions back into the library in library order.
+      for (int i = 0; i < func_items.size(); ++i) {
+        TF_RETURN_IF_ERROR(merge_function(i));
+      }
     }
 
     // If optimized at least one function, update the graph library.
-    if (optimize_function_library) {
-      *optimized_graph->mutable_library() = flib.ToProto();
-    }
+    *optimized_graph->mutable_library() = flib.ToProto();
   }
 
   // Run module-level TFG optimizations at the end of the meta-optimizer.
@@ -1311,6 +1449,11 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
         *optimized_graph);
   }
 
+  if (use_graph_cache) {
+    OptimizedGraphCache::Global()->Insert(
+        graph_cache_key, cfg_.experimental_optimized_graph_cache_dir(),
+        *optimized_graph, absl::Now() - optimization_start_time);
+  }
   return OkStatus();
 }
 
@@ -1352,11 +1495,14 @@ bool MetaOptimizerEnabled(const ConfigProto& cfg) {
          rewrite_cfg.scoped_allocator_optimization() == RewriterConfig::ON ||
 #endif
          rewrite_cfg.pin_to_host_optimization() == RewriterConfig::ON ||
+         rewrite_cfg.thread_budget_optimization() == RewriterConfig::ON ||
          AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision()) ||
          AutoMixedPrecisionEnabled(
              rewrite_cfg.auto_mixed_precision_onednn_bfloat16()) ||
          AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision_mkl()) ||
          AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision_cpu()) ||
+         AutoMixedPrecisionEnabled(
+             rewrite_cfg.auto_mixed_precision_native_bfloat16()) ||
          !rewrite_cfg.optimizers().empty() ||
          !rewrite_cfg.custom_optimizers().empty();
 }
@@ -18,11 +18,13 @@ limitations under the License.
 #include <atomic>
 
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/substitute.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/function_testlib.h"
 #include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/inputs/trivial_test_graph_input_yielder.h"
@@ -32,8 +34,10 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/grappler_test.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 
 namespace tensorflow {
@@ -113,6 +117,8 @@ class GrapplerItemPropertiesAccumulator : public CustomGraphOptimizer {
   Status Optimize(Cluster* cluster, const GrapplerItem& item,
                   GraphDef* optimized_graph) override {
     *optimized_graph = item.graph;
+    // Function bodies are optimized concurrently.
+    mutex_lock lock(mu_);
     if (optimization_options_) {
       optimization_options_->insert({item.id, item.optimization_options()});
     }
@@ -120,10 +126,13 @@ class GrapplerItemPropertiesAccumulator : public CustomGraphOptimizer {
   }
 
  private:
+  static mutex mu_;
   static gtl::FlatMap<string, GrapplerItem::OptimizationOptions>*
       optimization_options_;
 };
 
+mutex GrapplerItemPropertiesAccumulator::mu_(LINKER_INITIALIZED);
+
 gtl::FlatMap<string, GrapplerItem::OptimizationOptions>*
     GrapplerItemPropertiesAccumulator::optimization_options_;
 
@@ -150,6 +159,42 @@ TEST_F(MetaOptimizerTest, RunsCustomOptimizer) {
   EXPECT_TRUE(TestOptimizer::IsOptimized());
 }
 
+TEST_F(MetaOptimizerTest, ReusesCachedOptimizedGraph) {
+  TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {kDevice});
+  GrapplerItem item;
+  ASSERT_TRUE(fake_input.NextItem(&item));
+
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.add_optimizers("TestOptimizer");
+  rewriter_config.set_min_graph_nodes(-1);
+  rewriter_config.set_experimental_optimized_graph_cache(RewriterConfig::ON);
+
+  TestOptimizer::SetOptimized(false);
+  GraphDef output;
+  {
+    MetaOptimizer optimizer(nullptr, config_proto);
+    TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  }
+  EXPECT_TRUE(TestOptimizer::IsOptimized());
+
+  // An identical graph with another id is not optimized again.
+  TestOptimizer::SetOptimized(false);
+  item.id = "another_id";
+  const int64_t num_hits =
+      metrics::GetGrapplerGraphCacheLookupCount("memory_hit");
+  GraphDef cached_output;
+  {
+    MetaOptimizer optimizer(nullptr, config_proto);
+    TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &cached_output));
+  }
+  EXPECT_FALSE(TestOptimizer::IsOptimized());
+  EXPECT_EQ(metrics::GetGrapplerGraphCacheLookupCount("memory_hit"),
+            num_hits + 1);
+  CompareGraphs(output, cached_output);
+}
+
 TEST_F(MetaOptimizerTest, RunsCustomOptimizerWithParams) {
   TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {kDevice});
   GrapplerItem item;
@@ -703,6 +748,91 @@ TEST_F(MetaOptimizerTest, OptimizeFunctionLibraryWithRestrictions) {
       optimization_options_my_mul_2->allow_non_differentiable_rewrites);
 }
 
+// Returns a graph calling `num_functions` non-inlinable functions, each with a
+// chain of `function_size` multiplications.
+GrapplerItem FunctionLibraryItem(int num_functions, int function_size) {
+  using test::function::NDef;
+
+  std::vector<FunctionDef> functions;
+  std::vector<NodeDef> nodes = {
+      NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice)};
+  std::vector<string> fetch;
+  for (int i = 0; i < num_functions; ++i) {
+    const string func_name = absl::StrCat("MyFunc", i);
+    std::vector<FunctionDefHelper::Node> body;
+    string prev = "x";
+    for (int j = 0; j < function_size; ++j) {
+      const string mul = absl::StrCat("mul", j);
+      const string add = absl::StrCat("add", j);
+      body.push_back({{mul}, "Mul", {prev, "x"}, {{"T", DT_FLOAT}}});
+      body.push_back(
+          {{add}, "AddV2", {absl::StrCat(mul, ":z:0"), "x"},
+           {{"T", DT_FLOAT}}});
+      prev = absl::StrCat(add, ":z:0");
+    }
+    FunctionDef func = FunctionDefHelper::Create(
+        func_name, {"x:float"}, {"z:float"}, {}, body,
+        /*ret_def=*/{{"z", prev}});
+    (*func.mutable_attr())["_noinline"].set_b(true);
+    functions.push_back(func);
+
+    const string call = absl::StrCat("call", i);
+    nodes.push_back(NDef(call, func_name, {"x"}, {}, kDevice));
+    fetch.push_back(call);
+  }
+
+  GrapplerItem item;
+  item.id = "tf_graph";
+  item.graph = test::function::GDef(nodes, functions);
+  item.fetch = fetch;
+  return item;
+}
+
+ConfigProto FunctionLibraryConfig(int num_threads) {
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.set_meta_optimizer_iterations(RewriterConfig::TWO);
+  rewriter_config.add_optimizers("function");
+  rewriter_config.add_optimizers("arithmetic");
+  rewriter_config.add_optimizers("dependency");
+  rewriter_config.set_min_graph_nodes(-1);
+  rewriter_config.set_meta_optimizer_function_library_threads(num_threads);
+  return config_proto;
+}
+
+TEST_F(MetaOptimizerTest, OptimizeFunctionLibraryInParallel) {
+  const GrapplerItem item = FunctionLibraryItem(/*num_functions=*/16,
+                                                /*function_size=*/8);
+
+  MetaOptimizer sequential_optimizer(nullptr, FunctionLibraryConfig(1));
+  GraphDef sequential_output;
+  TF_ASSERT_OK(sequential_optimizer.Optimize(nullptr, item,
+                                             &sequential_output));
+
+  // Functions optimized in parallel must end up in the same library, and
+  // optimization results must be reported in the same order.
+  for (int attempt = 0; attempt < 3; ++attempt) {
+    MetaOptimizer parallel_optimizer(nullptr, FunctionLibraryConfig(4));
+    GraphDef parallel_output;
+    TF_ASSERT_OK(
+        parallel_optimizer.Optimize(nullptr, item, &parallel_output));
+    CompareGraphs(sequential_output, parallel_output);
+    FunctionLibraryDefinition parallel_flib(OpRegistry::Global(),
+                                            parallel_output.library());
+    ASSERT_EQ(sequential_output.library().function_size(),
+              parallel_output.library().function_size());
+    for (const FunctionDef& func : sequential_output.library().function()) {
+      const FunctionDef* parallel_func =
+          parallel_flib.Find(func.signature().name());
+      ASSERT_NE(parallel_func, nullptr);
+      CompareFunctions(func, *parallel_func);
+    }
+    EXPECT_EQ(sequential_optimizer.GetResultString(),
+              parallel_optimizer.GetResultString());
+  }
+}
+
 class SleepingOptimizer : public CustomGraphOptimizer {
  public:
   SleepingOptimizer() {}
@@ -1412,6 +1542,29 @@ INSTANTIATE_TEST_SUITE_P(
       return test_name;
     });
 
+// Reports the wall time of optimizing a large function library with the given
+// number of threads.
+void BM_OptimizeFunctionLibrary(::testing::benchmark::State& state) {
+  const int num_threads = state.range(0);
+  const GrapplerItem item = FunctionLibraryItem(/*num_functions=*/64,
+                                                /*function_size=*/64);
+  const ConfigProto config_proto = FunctionLibraryConfig(num_threads);
+  for (auto s : state) {
+    MetaOptimizer optimizer(nullptr, config_proto);
+    GraphDef output;
+    TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          item.graph.library().function_size());
+}
+BENCHMARK(BM_OptimizeFunctionLibrary)
+    ->UseRealTime()
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->Arg(16);
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
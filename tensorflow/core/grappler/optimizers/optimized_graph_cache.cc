@@ -0,0 +1,339 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/optimized_graph_cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+#include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr int64_t kDefaultMaxMemoryBytes = 256 << 20;
+
+// Incrementally fingerprints the components of a cache key.
+class KeyBuilder {
+ public:
+  KeyBuilder() : fingerprint_(Fingerprint128(TF_VERSION_STRING)) {
+    Add(static_cast<int64_t>(TF_GRAPH_DEF_VERSION));
+  }
+
+  void Add(absl::string_view value) { Add(Fingerprint128(value)); }
+  void Add(int64_t value) {
+    fingerprint_ = tsl::FingerprintCat128(fingerprint_, value);
+  }
+  void Add(const Fprint128& fingerprint) {
+    fingerprint_ = tsl::FingerprintCat128(fingerprint_, fingerprint);
+  }
+  void Add(const protobuf::MessageLite& proto) {
+    std::string serialized;
+    SerializeToStringDeterministic(proto, &serialized);
+    Add(serialized);
+  }
+
+  // Adds the fingerprints of named components in the order of their names, so
+  // that the key does not depend on the order of nodes or functions.
+  void AddSorted(std::vector<std::pair<std::string, Fprint128>> components) {
+    std::sort(components.begin(), components.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    Add(static_cast<int64_t>(components.size()));
+    for (const auto& [name, fingerprint] : components) {
+      Add(name);
+      Add(fingerprint);
+    }
+  }
+
+  void AddStrings(const std::vector<std::string>& values) {
+    Add(static_cast<int64_t>(values.size()));
+    for (const auto& value : values) Add(value);
+  }
+
+  std::string Finish() const {
+    return absl::StrCat(absl::Hex(fingerprint_.high64, absl::kZeroPad16),
+                        absl::Hex(fingerprint_.low64, absl::kZeroPad16));
+  }
+
+ private:
+  Fprint128 fingerprint_;
+};
+
+Fprint128 ProtoFingerprint(const protobuf::MessageLite& proto) {
+  std::string serialized;
+  SerializeToStringDeterministic(proto, &serialized);
+  return Fingerprint128(serialized);
+}
+
+std::string CacheFilePath(absl::string_view directory,
+                          const std::string& key) {
+  return io::JoinPath(directory, absl::StrCat(key, ".pb"));
+}
+
+Status WriteToDirectory(absl::string_view directory, const std::string& key,
+                        const GraphDef& optimized_graph) {
+  Env* env = Env::Default();
+  const std::string dir(directory);
+  if (!env->FileExists(dir).ok()) {
+    TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(dir));
+  }
+  // Writes to a temporary file first, so that concurrent readers in other
+  // processes never see a partially written graph.
+  const std::string file_path = CacheFilePath(directory, key);
+  std::string temp_file_path = file_path;
+  if (!env->CreateUniqueFileName(&temp_file_path, ".pb.tmp")) {
+    return errors::Unavailable("Could not create a unique file inside ", dir);
+  }
+  TF_RETURN_IF_ERROR(WriteBinaryProto(env, temp_file_path, optimized_graph));
+  return env->RenameFile(temp_file_path, file_path);
+}
+
+}  // namespace
+
+OptimizedGraphCache* OptimizedGraphCache::Global() {
+  static OptimizedGraphCache* cache =
+      new OptimizedGraphCache(kDefaultMaxMemoryBytes);
+  return cache;
+}
+
+std::string OptimizedGraphCache::ComputeKey(const GrapplerItem& item,
+                                            const Cluster* cluster,
+                                            const ConfigProto& config) {
+  KeyBuilder key;
+
+  std::vector<std::pair<std::string, Fprint128>> nodes;
+  nodes.reserve(item.graph.node_size());
+  for (const NodeDef& node : item.graph.node()) {
+    nodes.push_back({node.name(), ProtoFingerprint(node)});
+  }
+  key.AddSorted(std::move(nodes));
+  key.Add(item.graph.versions());
+
+  const FunctionDefLibrary& library = item.graph.library();
+  std::vector<std::pair<std::string, Fprint128>> functions;
+  functions.reserve(library.function_size());
+  for (const FunctionDef& function : library.function()) {
+    functions.push_back(
+        {function.signature().name(), ProtoFingerprint(function)});
+  }
+  key.AddSorted(std::move(functions));
+  std::vector<std::pair<std::string, Fprint128>> gradients;
+  for (const GradientDef& gradient : library.gradient()) {
+    gradients.push_back(
+        {gradient.function_name(), Fingerprint128(gradient.gradient_func())});
+  }
+  for (const RegisteredGradient& gradient : library.registered_gradients()) {
+    gradients.push_back({gradient.gradient_func(),
+                         Fingerprint128(gradient.registered_op_type())});
+  }
+  key.AddSorted(std::move(gradients));
+
+  key.AddStrings(item.fetch);
+  key.Add(static_cast<int64_t>(item.feed.size()));
+  for (const auto& [name, tensor] : item.feed) {
+    key.Add(name);
+    TensorProto tensor_proto;
+    tensor.AsProtoTensorContent(&tensor_proto);
+    key.Add(tensor_proto);
+  }
+  key.AddStrings(item.init_ops);
+  key.Add(item.expected_init_time);
+  key.Add(item.save_op);
+  key.Add(item.restore_op);
+  key.Add(item.save_restore_loc_tensor);
+  key.Add(static_cast<int64_t>(item.queue_runners.size()));
+  for (const QueueRunnerDef& queue_runner : item.queue_runners) {
+    key.Add(queue_runner);
+  }
+  key.AddStrings(item.keep_ops);
+
+  const GrapplerItem::OptimizationOptions& options =
+      item.optimization_options();
+  key.Add(static_cast<int64_t>(options.allow_non_differentiable_rewrites));
+  key.Add(
+      static_cast<int64_t>(options.allow_pruning_stateful_and_dataset_ops));
+  key.Add(static_cast<int64_t>(options.optimize_function_library));
+  key.Add(static_cast<int64_t>(options.is_eager_mode));
+  key.Add(static_cast<int64_t>(options.intra_op_parallelism_threads));
+
+  std::vector<std::pair<std::string, Fprint128>> devices;
+  for (const std::string& device : item.devices()) {
+    devices.push_back({device, Fprint128{0, 0}});
+  }
+  key.AddSorted(std::move(devices));
+  std::vector<std::pair<std::string, Fprint128>> cluster_devices;
+  if (cluster != nullptr) {
+    for (const auto& [name, properties] : cluster->GetDevices()) {
+      cluster_devices.push_back({name, ProtoFingerprint(properties)});
+    }
+  }
+  key.AddSorted(std::move(cluster_devices));
+
+  // Besides the rewriter config, the optimizers read other parts of the
+  // session config, e.g. the executor type, and the thread budget optimizer
+  // writes the intra-op parallelism into the graph. The cache settings
+  // themselves do not affect the optimized graph.
+  ConfigProto key_config = config;
+  RewriterConfig* rewriter_config =
+      key_config.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config->clear_experimental_optimized_graph_cache();
+  rewriter_config->clear_experimental_optimized_graph_cache_dir();
+  key.Add(key_config);
+
+  // Plugin optimizers, and the optimizers they turn off, depend on the device
+  // types of the graph and on the plugins registered in this process.
+  std::set<std::string> device_types;
+  for (const NodeDef& node : item.graph.node()) {
+    DeviceNameUtils::ParsedName parsed_name;
+    if (DeviceNameUtils::ParseFullName(node.device(), &parsed_name)) {
+      device_types.insert(parsed_name.type);
+    }
+  }
+  const bool use_plugin_optimizers =
+      rewriter_config->use_plugin_optimizers() != RewriterConfig::OFF;
+  const ConfigList plugin_configs =
+      PluginGraphOptimizerRegistry::GetPluginConfigs(use_plugin_optimizers,
+                                                     device_types);
+  key.Add(static_cast<int64_t>(plugin_configs.disable_model_pruning));
+  std::vector<std::pair<std::string, Fprint128>> plugin_toggles;
+  for (const auto& [name, toggle] : plugin_configs.toggle_config) {
+    plugin_toggles.push_back({name, Fprint128{static_cast<uint64_t>(toggle),
+                                              0}});
+  }
+  key.AddSorted(std::move(plugin_toggles));
+  std::vector<std::string> plugin_optimizers;
+  if (use_plugin_optimizers) {
+    for (const auto& optimizer :
+         PluginGraphOptimizerRegistry::CreateOptimizers(device_types)) {
+      plugin_optimizers.push_back(optimizer->name());
+    }
+  }
+  key.AddStrings(plugin_optimizers);
+  return key.Finish();
+}
+
+bool OptimizedGraphCache::Lookup(const std::string& key,
+                                 absl::string_view directory,
+                                 GraphDef* optimized_graph) {
+  std::shared_ptr<const GraphDef> graph;
+  absl::Duration optimization_time;
+  {
+    mutex_lock lock(mu_);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+      graph = it->second.graph;
+      optimization_time = it->second.optimization_time;
+    }
+  }
+  if (graph != nullptr) {
+    *optimized_graph = *graph;
+    metrics::RecordGrapplerGraphCacheLookup(
+        "memory_hit", absl::ToInt64Microseconds(optimization_time));
+    return true;
+  }
+
+  if (!directory.empty()) {
+    Env* env = Env::Default();
+    const std::string file_path = CacheFilePath(directory, key);
+    if (env->FileExists(file_path).ok()) {
+      auto graph_from_disk = std::make_shared<GraphDef>();
+      Status status = ReadBinaryProto(env, file_path, graph_from_disk.get());
+      if (status.ok()) {
+        *optimized_graph = *graph_from_disk;
+        InsertInMemory(key, std::move(graph_from_disk), absl::ZeroDuration());
+        metrics::RecordGrapplerGraphCacheLookup("disk_hit");
+        VLOG(1) << "Read optimized graph from cache file " << file_path;
+        return true;
+      }
+      LOG(WARNING) << "Failed to read optimized graph from cache file "
+                   << file_path << ": " << status;
+    }
+  }
+  metrics::RecordGrapplerGraphCacheLookup("miss");
+  return false;
+}
+
+void OptimizedGraphCache::Insert(const std::string& key,
+                                 absl::string_view directory,
+                                 const GraphDef& optimized_graph,
+                                 absl::Duration optimization_time) {
+  if (!directory.empty() &&
+      optimization_time >= kMinPersistedOptimizationTime) {
+    Status status = WriteToDirectory(directory, key, optimized_graph);
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to write optimized graph to cache directory "
+                   << directory << ": " << status;
+    }
+  }
+  InsertInMemory(key, std::make_shared<const GraphDef>(optimized_graph),
+                 optimization_time);
+}
+
+void OptimizedGraphCache::InsertInMemory(
+    const std::string& key, std::shared_ptr<const GraphDef> graph,
+    absl::Duration optimization_time) {
+  const int64_t size_bytes = graph->ByteSizeLong();
+  if (size_bytes > max_memory_bytes_) return;
+
+  mutex_lock lock(mu_);
+  if (entries_.contains(key)) return;
+  while (size_bytes_ + size_bytes > max_memory_bytes_) {
+    auto it = entries_.find(lru_.back());
+    size_bytes_ -= it->second.size_bytes;
+    entries_.erase(it);
+    lru_.pop_back();
+  }
+  lru_.push_front(key);
+  entries_[key] = {std::move(graph), size_bytes, optimization_time,
+                   lru_.begin()};
+  size_bytes_ += size_bytes;
+}
+
+int64_t OptimizedGraphCache::num_entries() const {
+  mutex_lock lock(mu_);
+  return entries_.size();
+}
+
+int64_t OptimizedGraphCache::size_bytes() const {
+  mutex_lock lock(mu_);
+  return size_bytes_;
+}
+
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,113 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZED_GRAPH_CACHE_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZED_GRAPH_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// A content-addressed cache of graphs optimized by the MetaOptimizer. Graphs
+// are kept in memory up to a byte budget, and optionally persisted in a
+// directory so that later processes can skip the optimization of graphs that
+// were slow to optimize.
+//
+// Thread-safe.
+class OptimizedGraphCache {
+ public:
+  // Graphs that took less than this to optimize are not written to disk.
+  static constexpr absl::Duration kMinPersistedOptimizationTime =
+      absl::Seconds(1);
+
+  explicit OptimizedGraphCache(int64_t max_memory_bytes)
+      : max_memory_bytes_(max_memory_bytes) {}
+
+  OptimizedGraphCache(const OptimizedGraphCache&) = delete;
+  OptimizedGraphCache& operator=(const OptimizedGraphCache&) = delete;
+
+  // Returns the process-wide cache.
+  static OptimizedGraphCache* Global();
+
+  // Returns the cache key of optimizing `item` on `cluster`, which may be
+  // null, with the MetaOptimizer configured by `config`. The key covers the
+  // graph and its function library independently of the order of their nodes
+  // and functions, the fetch, feed and other properties of the item, the
+  // session config except for the cache settings, the plugin optimizers, the
+  // devices and the TensorFlow version. The item id is not part of the key, so
+  // that identical function instantiations share it.
+  static std::string ComputeKey(const GrapplerItem& item,
+                                const Cluster* cluster,
+                                const ConfigProto& config);
+
+  // Looks up the graph cached for `key`, first in memory and then in
+  // `directory` if it is non-empty. A graph read from disk is kept in memory.
+  // Returns false on a miss.
+  bool Lookup(const std::string& key, absl::string_view directory,
+              GraphDef* optimized_graph) TF_LOCKS_EXCLUDED(mu_);
+
+  // Caches `optimized_graph` for `key`. The graph is also written to
+  // `directory` if it is non-empty and the optimization took at least
+  // `kMinPersistedOptimizationTime`. Failures to write are logged and
+  // otherwise ignored.
+  void Insert(const std::string& key, absl::string_view directory,
+              const GraphDef& optimized_graph,
+              absl::Duration optimization_time) TF_LOCKS_EXCLUDED(mu_);
+
+  int64_t num_entries() const TF_LOCKS_EXCLUDED(mu_);
+  int64_t size_bytes() const TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Entry {
+    std::shared_ptr<const GraphDef> graph;
+    int64_t size_bytes = 0;
+    absl::Duration optimization_time;
+    // Position in `lru_`.
+    std::list<std::string>::iterator lru_position;
+  };
+
+  void InsertInMemory(const std::string& key,
+                      std::shared_ptr<const GraphDef> graph,
+                      absl::Duration optimization_time) TF_LOCKS_EXCLUDED(mu_);
+
+  const int64_t max_memory_bytes_;
+
+  mutable mutex mu_;
+  absl::flat_hash_map<std::string, Entry> entries_ TF_GUARDED_BY(mu_);
+  // Keys from the most to the least recently used.
+  std::list<std::string> lru_ TF_GUARDED_BY(mu_);
+  int64_t size_bytes_ TF_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace grappler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZED_GRAPH_CACHE_H_
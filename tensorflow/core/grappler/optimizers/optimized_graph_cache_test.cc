@@ -0,0 +1,171 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/optimized_graph_cache.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include <gtest/gtest.h>
+#include "absl/time/time.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+GraphDef MakeGraph(bool reversed) {
+  GraphDef graph;
+  for (const char* name : {"a", "b", "c"}) {
+    NodeDef* node = graph.add_node();
+    node->set_name(name);
+    node->set_op("NoOp");
+  }
+  if (reversed) {
+    std::swap(*graph.mutable_node(0), *graph.mutable_node(2));
+  }
+  return graph;
+}
+
+GrapplerItem MakeItem(bool reversed = false) {
+  GrapplerItem item;
+  item.id = reversed ? "reversed" : "item";
+  item.graph = MakeGraph(reversed);
+  item.fetch = {"c"};
+  return item;
+}
+
+TEST(OptimizedGraphCacheTest, KeyIgnoresNodeOrderAndItemId) {
+  ConfigProto config;
+  EXPECT_EQ(OptimizedGraphCache::ComputeKey(MakeItem(), nullptr, config),
+            OptimizedGraphCache::ComputeKey(MakeItem(/*reversed=*/true),
+                                            nullptr, config));
+}
+
+TEST(OptimizedGraphCacheTest, KeyDependsOnItemAndConfig) {
+  ConfigProto config;
+  const std::string key =
+      OptimizedGraphCache::ComputeKey(MakeItem(), nullptr, config);
+
+  GrapplerItem item = MakeItem();
+  item.fetch = {"b"};
+  EXPECT_NE(OptimizedGraphCache::ComputeKey(item, nullptr, config), key);
+
+  item = MakeItem();
+  item.optimization_options().allow_non_differentiable_rewrites = false;
+  EXPECT_NE(OptimizedGraphCache::ComputeKey(item, nullptr, config), key);
+
+  ConfigProto other_config;
+  other_config.mutable_graph_options()
+      ->mutable_rewrite_options()
+      ->set_constant_folding(RewriterConfig::OFF);
+  EXPECT_NE(OptimizedGraphCache::ComputeKey(MakeItem(), nullptr, other_config),
+            key);
+
+  // The cache settings are not part of the key.
+  ConfigProto cache_config;
+  cache_config.mutable_graph_options()
+      ->mutable_rewrite_options()
+      ->set_experimental_optimized_graph_cache(RewriterConfig::ON);
+  EXPECT_EQ(OptimizedGraphCache::ComputeKey(MakeItem(), nullptr, cache_config),
+            key);
+}
+
+TEST(OptimizedGraphCacheTest, KeyDependsOnSessionConfig) {
+  ConfigProto config;
+  const std::string key =
+      OptimizedGraphCache::ComputeKey(MakeItem(), nullptr, config);
+
+  // TFRT sessions keep functional control flow, so they must not reuse graphs
+  // optimized for the default executor.
+  ConfigProto tfrt_config;
+  tfrt_config.mutable_experimental()->set_use_tfrt(true);
+  EXPECT_NE(OptimizedGraphCache::ComputeKey(MakeItem(), nullptr, tfrt_config),
+            key);
+
+  ConfigProto executor_config;
+  executor_config.mutable_experimental()->set_executor_type(
+      "SINGLE_THREADED_EXECUTOR");
+  EXPECT_NE(
+      OptimizedGraphCache::ComputeKey(MakeItem(), nullptr, executor_config),
+      key);
+}
+
+TEST(OptimizedGraphCacheTest, KeyDependsOnIntraOpParallelism) {
+  // The thread budget optimizer writes the session's intra-op parallelism into
+  // the _intra_op_parallelism attrs of the optimized graph.
+  ConfigProto config;
+  config.set_intra_op_parallelism_threads(4);
+  ConfigProto other_config;
+  other_config.set_intra_op_parallelism_threads(8);
+  EXPECT_NE(OptimizedGraphCache::ComputeKey(MakeItem(), nullptr, config),
+            OptimizedGraphCache::ComputeKey(MakeItem(), nullptr, other_config));
+}
+
+TEST(OptimizedGraphCacheTest, LookupInMemory) {
+  OptimizedGraphCache cache(/*max_memory_bytes=*/1 << 20);
+  GraphDef graph;
+  EXPECT_FALSE(cache.Lookup("key", /*directory=*/"", &graph));
+
+  cache.Insert("key", /*directory=*/"", MakeGraph(false), absl::Seconds(2));
+  ASSERT_TRUE(cache.Lookup("key", /*directory=*/"", &graph));
+  EXPECT_EQ(graph.node_size(), 3);
+  EXPECT_EQ(cache.num_entries(), 1);
+}
+
+TEST(OptimizedGraphCacheTest, EvictsLeastRecentlyUsed) {
+  const int64_t graph_size = MakeGraph(false).ByteSizeLong();
+  OptimizedGraphCache cache(/*max_memory_bytes=*/2 * graph_size);
+  cache.Insert("a", "", MakeGraph(false), absl::ZeroDuration());
+  cache.Insert("b", "", MakeGraph(false), absl::ZeroDuration());
+  GraphDef graph;
+  ASSERT_TRUE(cache.Lookup("a", "", &graph));
+
+  cache.Insert("c", "", MakeGraph(false), absl::ZeroDuration());
+  EXPECT_EQ(cache.num_entries(), 2);
+  EXPECT_EQ(cache.size_bytes(), 2 * graph_size);
+  EXPECT_TRUE(cache.Lookup("a", "", &graph));
+  EXPECT_FALSE(cache.Lookup("b", "", &graph));
+  EXPECT_TRUE(cache.Lookup("c", "", &graph));
+}
+
+TEST(OptimizedGraphCacheTest, PersistsSlowOptimizations) {
+  const std::string directory =
+      io::JoinPath(testing::TmpDir(), "optimized_graph_cache_test");
+  {
+    OptimizedGraphCache cache(/*max_memory_bytes=*/1 << 20);
+    cache.Insert("slow", directory, MakeGraph(false),
+                 OptimizedGraphCache::kMinPersistedOptimizationTime);
+    cache.Insert("fast", directory, MakeGraph(false), absl::Milliseconds(1));
+  }
+
+  // A new cache, as in another process, only finds the slow graph on disk.
+  OptimizedGraphCache cache(/*max_memory_bytes=*/1 << 20);
+  GraphDef graph;
+  ASSERT_TRUE(cache.Lookup("slow", directory, &graph));
+  EXPECT_EQ(graph.node_size(), 3);
+  EXPECT_FALSE(cache.Lookup("fast", directory, &graph));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
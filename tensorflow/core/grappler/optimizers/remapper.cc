@@ -1576,11 +1576,6 @@ bool FindMatMulBiasAddAndGelu(RemapperContext* ctx, int node_index,
                               std::map<string, int>* matched_nodes_map,
                               std::set<int>* remove_node_indices,
                               bool* is_gelu_approximate) {
-  // Gelu fusion is enabled with oneDNN or cublasLt or cuDNN library.
-  if (!IsMKLEnabled() && !BlasLtMatmulEnabled() &&
-      !RuntimeFusionEnabled(cluster))
-    return false;
-
   using utils::MatchingDirection;
   using utils::NodeStatus;
 
@@ -1695,11 +1690,13 @@ bool FindMatMulBiasAddAndGelu(RemapperContext* ctx, int node_index,
         ctx->graph_view.GetNode(matched_nodes_map->at("matmul"))->node();
     DataType matmul_dtype = GetDataTypeFromAttr(*matmul_node, "T");
 
-    bool cpu_ok = IsMKLEnabled() && IsCpuCompatibleMatMul(*ctx, matmul_node);
-    // Currently, the fusion is not supported on CPU for transpose_a in the
+    bool cpu_ok = IsCpuCompatibleMatMul(*ctx, matmul_node);
+    // Currently, the oneDNN fusion is not supported for transpose_a in the
     // MatMul op.
-    cpu_ok = cpu_ok && matmul_node->attr().contains("transpose_a") &&
-             !matmul_node->attr().at("transpose_a").b();
+    if (IsMKLEnabled()) {
+      cpu_ok = cpu_ok && matmul_node->attr().contains("transpose_a") &&
+               !matmul_node->attr().at("transpose_a").b();
+    }
 
     bool gpu_ok = NodeIsOnGpu(matmul_node) && RuntimeFusionEnabled(cluster) &&
                   matmul_dtype == DT_HALF;
@@ -1731,12 +1728,19 @@ bool FindMatMulBiasAddAndGelu(RemapperContext* ctx, int node_index,
         ctx->graph_view.GetNode(matched_nodes_map->at("matmul"))->node();
 
     // matmul_node is already the _FusedMatMul and we don't need to check its
-    // data type again.
-    if (!IsMKLEnabled() && !NodeIsOnGpu(matmul_node)) return false;
+    // data type again. Gelu fusion on GPU is enabled with cublasLt or cuDNN
+    // library.
+    if (NodeIsOnGpu(matmul_node)) {
+      if (!BlasLtMatmulEnabled() && !RuntimeFusionEnabled(cluster)) {
+        return false;
+      }
+    } else if (!NodeIsOnCpu(matmul_node)) {
+      return false;
+    }
 
-    // Currently, the fusion is not supported on CPU for transpose_a in the
+    // Currently, the oneDNN fusion is not supported for transpose_a in the
     // MatMul op.
-    if (NodeIsOnCpu(matmul_node) &&
+    if (IsMKLEnabled() && NodeIsOnCpu(matmul_node) &&
         matmul_node->attr().contains("transpose_a") &&
         matmul_node->attr().at("transpose_a").b()) {
       return false;
@@ -2073,14 +2077,22 @@ bool IsCommonNormPattern(RemapperContext* ctx, int node_index,
 }
 
 // Keras LayerNormalization api uses multiple TensorFlow ops. Current fusion
-// pattern is only for the case, when LayerNormalization uses FusedBatcNormV3.
-// We further restrict it to only 2D or 3D tensor inputs to keras
-// LayerNormalization api.
-bool FindMklLayerNorm(RemapperContext* ctx, int node_index,
-                      std::map<string, int>* matched_nodes_map,
-                      std::set<int>* remove_node_indices,
-                      std::vector<string>* input_node_names, float* epsilon) {
-  if (!IsMKLEnabled()) return false;
+// pattern is only for the case, when LayerNormalization uses FusedBatcNormV3,
+// or when it is spelled out with Mean/SquaredDifference/Rsqrt ops. The fused
+// node is _MklLayerNorm with oneDNN, which is further restricted to 2D or 3D
+// tensor inputs, and _FusedLayerNorm otherwise.
+bool FindLayerNorm(RemapperContext* ctx, int node_index,
+                   std::map<string, int>* matched_nodes_map,
+                   std::set<int>* remove_node_indices,
+                   std::vector<string>* input_node_names, float* epsilon) {
+  const NodeDef* node_def = ctx->graph_view.GetNode(node_index)->node();
+  if (!NodeIsOnCpu(node_def)) return false;
+  if (!IsMKLEnabled()) {
+    const DataType dtype = GetDataTypeFromAttr(*node_def, "T");
+    if (dtype != DT_FLOAT && dtype != DT_BFLOAT16 && dtype != DT_HALF) {
+      return false;
+    }
+  }
 
   // The following pattern will be searched in the graph with additional
   // contraints. Here * means any type of op.
@@ -2208,6 +2220,37 @@ bool FindMklLayerNorm(RemapperContext* ctx, int node_index,
       }
       auto* pre_reshape_node =
           ctx->graph_view.GetNode(matched_nodes_map->at("pre_reshape"))->node();
+      // Keras reshapes the input to [1, rows, depth, 1] and normalizes each
+      // row in NCHW format, where depth is the product of the normalized
+      // axes. The fused ops normalize the last axis only, so depth must be
+      // the last dimension of the input.
+      string data_format;
+      if (!TryGetNodeAttr(*fused_batch_norm_node, "data_format",
+                          &data_format) ||
+          data_format != "NCHW") {
+        return false;
+      }
+      NodeDef* input_node =
+          ctx->graph_view.GetNode(matched_nodes_map->at("input"))->node();
+      const auto& reshaped_props =
+          ctx->graph_properties.GetOutputProperties(pre_reshape_node->name());
+      const auto& input_node_props =
+          ctx->graph_properties.GetOutputProperties(input_node->name());
+      if (reshaped_props.empty() || input_node_props.empty()) return false;
+      const TensorShapeProto& reshaped_shape = reshaped_props[0].shape();
+      const TensorShapeProto& input_shape = input_node_props[0].shape();
+      const int input_rank = Rank(input_shape);
+      if (Rank(reshaped_shape) != 4 || input_rank < 1 ||
+          reshaped_shape.dim(0).size() != 1 ||
+          reshaped_shape.dim(3).size() != 1) {
+        return false;
+      }
+      const int64_t depth = reshaped_shape.dim(2).size();
+      if (depth < 0 || depth != input_shape.dim(input_rank - 1).size()) {
+        VLOG(1) << "Layer norm " << fused_batch_norm_node->name()
+                << " does not normalize the last axis only";
+        return false;
+      }
       auto* scale_node =
           ctx->graph_view.GetNode(matched_nodes_map->at("gamma"))->node();
       auto* beta_node =
@@ -2260,6 +2303,21 @@ bool FindMklLayerNorm(RemapperContext* ctx, int node_index,
         if (static_cast<int64>(rank - 1) != mean_axis_tensor.flat<int64>()(0))
           return false;
       }
+      // Use the epsilon of the custom pattern rather than the Keras default.
+      NodeDef* epsilon_node =
+          ctx->graph_view.GetNode(matched_nodes_map->at("epsilon"))->node();
+      Tensor epsilon_tensor;
+      if (epsilon_node->op() == "Const" &&
+          epsilon_tensor.FromProto(epsilon_node->attr().at("value").tensor()) &&
+          epsilon_tensor.NumElements() == 1) {
+        if (epsilon_tensor.dtype() == DT_FLOAT) {
+          *epsilon = epsilon_tensor.flat<float>()(0);
+        } else if (epsilon_tensor.dtype() == DT_BFLOAT16) {
+          *epsilon = static_cast<float>(epsilon_tensor.flat<bfloat16>()(0));
+        } else if (epsilon_tensor.dtype() == DT_HALF) {
+          *epsilon = static_cast<float>(epsilon_tensor.flat<Eigen::half>()(0));
+        }
+      }
       auto* gamma_node =
           ctx->graph_view.GetNode(matched_nodes_map->at("gamma"))->node();
       auto* beta_node =
@@ -2271,8 +2329,6 @@ bool FindMklLayerNorm(RemapperContext* ctx, int node_index,
       input_node_names->at(2) = beta_node->name();
     }
 
-    // TODO(intel-tf): Relax the restriction of 2D/3D tensor once kernel
-    // supports that.
     NodeDef* input_node_def =
         ctx->graph_view.GetNode(matched_nodes_map->at("input"))->node();
     auto input_props =
@@ -2281,17 +2337,228 @@ bool FindMklLayerNorm(RemapperContext* ctx, int node_index,
         ctx->graph_view.GetNode(matched_nodes_map->at("output"))->node();
     auto output_props =
         ctx->graph_properties.GetOutputProperties(output_node_def->name());
-    if (ShapesSymbolicallyEqual(input_props[0].shape(),
-                                output_props[0].shape())) {
-      int rank = Rank(input_props[0].shape());
+    if (input_props.empty() || output_props.empty()) return false;
+    if (!ShapesSymbolicallyEqual(input_props[0].shape(),
+                                 output_props[0].shape())) {
+      return false;
+    }
+    int rank = Rank(input_props[0].shape());
+    if (IsMKLEnabled()) {
+      // TODO(intel-tf): Relax the restriction of 2D/3D tensor once kernel
+      // supports that.
       if (rank < 2 || rank > 3) return false;
     } else {
-      return false;
+      // _FusedLayerNorm does not broadcast gamma and beta, they must be
+      // vectors over the normalized dimension.
+      if (rank < 1) return false;
+      const auto& depth = input_props[0].shape().dim(rank - 1);
+      for (int i = 1; i < 3; ++i) {
+        const string& name = input_node_names->at(i);
+        if (!ctx->graph_properties.HasOutputProperties(name)) return false;
+        const auto& props = ctx->graph_properties.GetOutputProperties(name);
+        if (props.empty() || Rank(props[0].shape()) != 1) return false;
+        // Unknown dimensions only match if they are symbolically equal.
+        const int64_t dim = props[0].shape().dim(0).size();
+        if (dim != depth.size() || dim == -1) return false;
+      }
     }
   }
   return found_op_type_match;
 }
 
+// Returns the index of the regular input of the matched mask addition that is
+// the attention mask.
+int AttentionMaskInputIndex(const RemapperContext& ctx,
+                            const std::map<string, int>& matched_nodes_map) {
+  const auto* mask_add_view =
+      ctx.graph_view.GetNode(matched_nodes_map.at("mask_add"));
+  return mask_add_view->GetRegularFanin(0).node_index() ==
+                 matched_nodes_map.at("mask")
+             ? 0
+             : 1;
+}
+
+// Scaled dot-product attention, i.e. softmax(Q * K^T * scale + mask) * V,
+// written with BatchMatMul ops. The scaling and the additive mask are
+// optional. The subgraph is fused into _FusedScaledDotProductAttention on CPU,
+// which never materializes the attention logits.
+bool FindScaledDotProductAttention(RemapperContext* ctx, int node_index,
+                                   std::map<string, int>* matched_nodes_map,
+                                   std::set<int>* remove_node_indices,
+                                   float* scale) {
+  using utils::MatchingDirection;
+  using utils::NodeStatus;
+
+  utils::MutableNodeView* node_view = ctx->graph_view.GetNode(node_index);
+  const NodeDef* node_def = node_view->node();
+  if (!IsAnyBatchMatMul(*node_def) || !NodeIsOnCpu(node_def) ||
+      GetDataTypeFromAttr(*node_def, "T") != DT_FLOAT)
+    return false;
+
+  // The following pattern will be searched in the graph with additional
+  // contraints. Here * means any type of op.
+  // clang-format off
+  //              Subgraph for fusion
+  //              -------------------
+  //
+  //     *(query)  *(key)
+  //          \     /
+  //       BatchMatMul(qk)  Const                 FusedOp
+  //               \        /                     -------
+  //           Mul|RealDiv(scale)  *(mask)
+  //                    \          /          *(query) *(key) *(value) *(mask)
+  //                     AddV2|Add                \     |      |     /
+  //                         |           _FusedScaledDotProductAttention
+  //                      Softmax  *(value)
+  //                           \     /
+  //                    BatchMatMul(output)
+  utils::OpTypePattern qk_pattern =
+    {"BatchMatMul|BatchMatMulV2", "qk", NodeStatus::kRemove,
+      {
+        {"*", "query", NodeStatus::kRemain},
+        {"*", "key", NodeStatus::kRemain}
+      }
+    };
+  utils::OpTypePattern scaled_pattern =
+    {"Mul|RealDiv", "scale", NodeStatus::kRemove,
+      {
+        qk_pattern,
+        {"Const", "scale_value", NodeStatus::kRemain}
+      }
+    };
+  auto masked = [](const utils::OpTypePattern& logits) {
+    return utils::OpTypePattern
+      {"AddV2|Add", "mask_add", NodeStatus::kRemove,
+        {
+          logits,
+          {"*", "mask", NodeStatus::kRemain}
+        }
+      };
+  };
+  auto attention = [](const utils::OpTypePattern& logits) {
+    return utils::OpTypePattern
+      {"BatchMatMul|BatchMatMulV2", "output", NodeStatus::kReplace,
+        {
+          {"Softmax", "softmax", NodeStatus::kRemove, {logits}},
+          {"*", "value", NodeStatus::kRemain}
+        }
+      };
+  };
+  // clang-format on
+  const std::vector<utils::OpTypePattern> attention_patterns = {
+      attention(masked(scaled_pattern)), attention(scaled_pattern),
+      attention(masked(qk_pattern)), attention(qk_pattern)};
+
+  utils::SubGraphMatcher<MatchingDirection::kFollowInputs> graph_matcher(
+      &(ctx->graph_view));
+  bool found_op_type_match = false;
+  for (const auto& pattern : attention_patterns) {
+    matched_nodes_map->clear();
+    remove_node_indices->clear();
+    found_op_type_match = graph_matcher.GetMatchedNodes(
+        pattern, ctx->nodes_to_preserve, node_view, matched_nodes_map,
+        remove_node_indices);
+    if (found_op_type_match) break;
+  }
+  if (!found_op_type_match) return false;
+
+  // The logits must be Q * K^T and the output softmax(logits) * V.
+  const NodeDef* qk_node =
+      ctx->graph_view.GetNode(matched_nodes_map->at("qk"))->node();
+  if (GetDataTypeFromAttr(*qk_node, "T") != DT_FLOAT) return false;
+  // Missing adjoint attributes have their default value of false.
+  bool qk_adj_x = false, qk_adj_y = false, adj_x = false, adj_y = false;
+  TryGetNodeAttr(*qk_node, "adj_x", &qk_adj_x);
+  TryGetNodeAttr(*qk_node, "adj_y", &qk_adj_y);
+  TryGetNodeAttr(*node_def, "adj_x", &adj_x);
+  TryGetNodeAttr(*node_def, "adj_y", &adj_y);
+  if (qk_adj_x || !qk_adj_y || adj_x || adj_y) return false;
+
+  *scale = 1.0f;
+  if (matched_nodes_map->count("scale")) {
+    const auto* scale_node_view =
+        ctx->graph_view.GetNode(matched_nodes_map->at("scale"));
+    const NodeDef* scale_value_node =
+        ctx->graph_view.GetNode(matched_nodes_map->at("scale_value"))->node();
+    Tensor scale_tensor;
+    if (!scale_value_node->attr().contains("value") ||
+        !scale_tensor.FromProto(scale_value_node->attr().at("value").tensor()))
+      return false;
+    if (scale_tensor.dtype() != DT_FLOAT || scale_tensor.NumElements() != 1 ||
+        scale_tensor.dims() > 1)
+      return false;
+    const float scale_value = scale_tensor.flat<float>()(0);
+    if (IsRealDiv(*scale_node_view->node())) {
+      // Division is not commutative, the logits must be the dividend.
+      if (scale_node_view->GetRegularFanin(0).node_index() !=
+              matched_nodes_map->at("qk") ||
+          scale_value == 0.0f)
+        return false;
+      *scale = 1.0f / scale_value;
+    } else {
+      *scale = scale_value;
+    }
+  }
+
+  if (!ctx->inferred_graph_properties) {
+    Status s = ctx->graph_properties.InferStatically(
+        /*assume_valid_feeds=*/true,
+        /*aggressive_shape_inference=*/false,
+        /*include_input_tensor_values=*/false,
+        /*include_output_tensor_values=*/true);
+    if (!s.ok()) return false;
+    ctx->inferred_graph_properties = true;
+  }
+  const auto& qk_props =
+      ctx->graph_properties.GetInputProperties(qk_node->name());
+  const auto& output_props =
+      ctx->graph_properties.GetInputProperties(node_def->name());
+  if (qk_props.size() != 2 || output_props.size() != 2) return false;
+  const TensorShapeProto& query_shape = qk_props[0].shape();
+  const TensorShapeProto& key_shape = qk_props[1].shape();
+  const TensorShapeProto& value_shape = output_props[1].shape();
+  const int rank = Rank(query_shape);
+  if (rank < 3 || Rank(key_shape) != rank || Rank(value_shape) != rank)
+    return false;
+
+  // Unknown dimensions only match if they are symbolically equal.
+  auto same_dim = [](const TensorShapeProto::Dim& a,
+                     const TensorShapeProto::Dim& b) {
+    return a.size() == b.size() && a.size() != -1;
+  };
+  // The fused kernel does not broadcast the batch dimensions.
+  for (int i = 0; i < rank - 2; ++i) {
+    if (!same_dim(query_shape.dim(i), key_shape.dim(i)) ||
+        !same_dim(query_shape.dim(i), value_shape.dim(i)))
+      return false;
+  }
+
+  // The mask must broadcast to the logits, and not the other way around.
+  if (matched_nodes_map->count("mask_add")) {
+    const NodeDef* mask_add_node =
+        ctx->graph_view.GetNode(matched_nodes_map->at("mask_add"))->node();
+    const auto& mask_add_props =
+        ctx->graph_properties.GetInputProperties(mask_add_node->name());
+    const auto& logits_props =
+        ctx->graph_properties.GetOutputProperties(qk_node->name());
+    if (mask_add_props.size() != 2 || logits_props.empty()) return false;
+    const TensorShapeProto& mask_shape =
+        mask_add_props[AttentionMaskInputIndex(*ctx, *matched_nodes_map)]
+            .shape();
+    const TensorShapeProto& logits_shape = logits_props[0].shape();
+    const int mask_rank = Rank(mask_shape);
+    if (Rank(logits_shape) != rank || mask_rank < 0 || mask_rank > rank)
+      return false;
+    for (int i = 0; i < mask_rank; ++i) {
+      const auto& mask_dim = mask_shape.dim(mask_rank - 1 - i);
+      if (mask_dim.size() != 1 &&
+          !same_dim(mask_dim, logits_shape.dim(rank - 1 - i)))
+        return false;
+    }
+  }
+  return true;
+}
+
 bool FindFusedBatchNorm(const RemapperContext& ctx, int node_index,
                         FusedBatchNorm* matched) {
   const auto* node_view = ctx.graph_view.GetNode(node_index);
@@ -3813,19 +4080,18 @@ Status AddFusedMatMulBiasAddAndGelu(
   return OkStatus();
 }
 
-Status AddMklLayerNorm(RemapperContext* ctx,
-                       const std::map<string, int>& matched_nodes_map,
-                       const std::set<int>& remove_node_indices,
-                       const std::vector<string>& input_node_names,
-                       std::vector<bool>* invalidated_nodes,
-                       std::vector<bool>* nodes_to_delete,
-                       const float epsilon) {
+Status AddLayerNorm(RemapperContext* ctx,
+                    const std::map<string, int>& matched_nodes_map,
+                    const std::set<int>& remove_node_indices,
+                    const std::vector<string>& input_node_names,
+                    std::vector<bool>* invalidated_nodes,
+                    std::vector<bool>* nodes_to_delete, const float epsilon) {
   auto* output_node =
       ctx->graph_view.GetNode(matched_nodes_map.at("output"))->node();
 
   NodeDef fused_node;
   fused_node.set_name(output_node->name());
-  fused_node.set_op("_MklLayerNorm");
+  fused_node.set_op(IsMKLEnabled() ? "_MklLayerNorm" : "_FusedLayerNorm");
   fused_node.set_device(output_node->device());
   for (const auto& name : input_node_names) fused_node.add_input(name);
   auto* attr = fused_node.mutable_attr();
@@ -3846,6 +4112,48 @@ Status AddMklLayerNorm(RemapperContext* ctx,
   return OkStatus();
 }
 
+Status AddScaledDotProductAttention(
+    RemapperContext* ctx, const std::map<string, int>& matched_nodes_map,
+    const std::set<int>& remove_node_indices,
+    std::vector<bool>* invalidated_nodes, std::vector<bool>* nodes_to_delete,
+    const float scale) {
+  auto* output_node =
+      ctx->graph_view.GetNode(matched_nodes_map.at("output"))->node();
+  auto* qk_node = ctx->graph_view.GetNode(matched_nodes_map.at("qk"))->node();
+
+  NodeDef fused_node;
+  fused_node.set_name(output_node->name());
+  fused_node.set_op("_FusedScaledDotProductAttention");
+  fused_node.set_device(output_node->device());
+  fused_node.add_input(qk_node->input(0));
+  fused_node.add_input(qk_node->input(1));
+  fused_node.add_input(output_node->input(1));
+  int num_masks = 0;
+  if (matched_nodes_map.count("mask_add")) {
+    auto* mask_add_node =
+        ctx->graph_view.GetNode(matched_nodes_map.at("mask_add"))->node();
+    fused_node.add_input(mask_add_node->input(
+        AttentionMaskInputIndex(*ctx, matched_nodes_map)));
+    num_masks = 1;
+  }
+  auto* attr = fused_node.mutable_attr();
+  (*attr)["T"] = output_node->attr().at("T");
+  SetAttrValue(scale, &(*attr)["scale"]);
+  SetAttrValue(num_masks, &(*attr)["num_masks"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_node), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+  (*invalidated_nodes)[matched_nodes_map.at("output")] = true;
+
+  for (const auto& node_idx : remove_node_indices) {
+    (*nodes_to_delete)[node_idx] = true;
+  }
+  return OkStatus();
+}
+
 Status ReplaceMulMaximumWithLeakyRelu(
     RemapperContext* ctx, const std::map<string, int>& matched_nodes_map,
     const std::set<int>& remove_node_indices,
@@ -4987,9 +5295,9 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       remove_node_indices.clear();
       input_node_names.clear();
       float epsilon = 0.001;
-      if (FindMklLayerNorm(&ctx, i, &matched_nodes_map, &remove_node_indices,
-                           &input_node_names, &epsilon)) {
-        TF_RETURN_IF_ERROR(AddMklLayerNorm(
+      if (FindLayerNorm(&ctx, i, &matched_nodes_map, &remove_node_indices,
+                        &input_node_names, &epsilon)) {
+        TF_RETURN_IF_ERROR(AddLayerNorm(
             &ctx, matched_nodes_map, remove_node_indices, input_node_names,
             &invalidated_nodes, &nodes_to_delete, epsilon));
         continue;
@@ -5018,9 +5326,36 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       }
     }
 
-    // Remap MatMul + BiasAdd + gelu-subgraph
     std::map<string, int> matched_nodes_map;
     std::set<int> remove_node_indices;
+
+    // Remap smaller ops from layernorm python api into _FusedLayerNorm. With
+    // oneDNN they are remapped into _MklLayerNorm above.
+    if (!IsMKLEnabled()) {
+      std::vector<string> input_node_names;
+      float epsilon = 0.001;
+      if (FindLayerNorm(&ctx, i, &matched_nodes_map, &remove_node_indices,
+                        &input_node_names, &epsilon)) {
+        TF_RETURN_IF_ERROR(AddLayerNorm(
+            &ctx, matched_nodes_map, remove_node_indices, input_node_names,
+            &invalidated_nodes, &nodes_to_delete, epsilon));
+        continue;
+      }
+    }
+
+    // Remap BatchMatMul + [Mul] + [AddV2] + Softmax + BatchMatMul into
+    // _FusedScaledDotProductAttention.
+    float attention_scale = 1.0f;
+    if (FindScaledDotProductAttention(&ctx, i, &matched_nodes_map,
+                                      &remove_node_indices,
+                                      &attention_scale)) {
+      TF_RETURN_IF_ERROR(AddScaledDotProductAttention(
+          &ctx, matched_nodes_map, remove_node_indices, &invalidated_nodes,
+          &nodes_to_delete, attention_scale));
+      continue;
+    }
+
+    // Remap MatMul + BiasAdd + gelu-subgraph
     bool is_gelu_approximate = false;
     if (FindMatMulBiasAddAndGelu(&ctx, i, cluster, &matched_nodes_map,
                                  &remove_node_indices, &is_gelu_approximate)) {
@@ -1698,6 +1698,234 @@ class FuseMklLayerNormPattern : public RemapperTest {
 
 TEST_F(FuseMklLayerNormPattern, F32) { RunTest<DT_FLOAT>(); }
 
+TEST_F(RemapperTest, FuseLayerNorm) {
+  if (IsMKLEnabled()) GTEST_SKIP() << "Test not applicable to MKL.";
+  using ::tensorflow::ops::Placeholder;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto input = Placeholder(s.WithOpName("input"), DT_FLOAT,
+                           ops::Placeholder::Shape({2, 3, 8}));
+  auto r_indices = ops::Const(s.WithOpName("r_indices"), {2}, {1});
+  ops::Mean::Attrs attrs;
+  attrs = attrs.KeepDims(true);
+  auto mean = ops::Mean(s.WithOpName("mean"), input, r_indices, attrs);
+  auto s_diff = ops::SquaredDifference(s.WithOpName("s_diff"), input, mean);
+  auto variance = ops::Mean(s.WithOpName("variance"), s_diff, r_indices, attrs);
+  auto e_const = ops::Const(s.WithOpName("e_const"), {0.01f}, {});
+  auto add_1 = ops::AddV2(s.WithOpName("add_1"), variance, e_const);
+  auto rsqrt = ops::Rsqrt(s.WithOpName("rsqrt"), add_1);
+  auto g_const = ops::Const(s.WithOpName("g_const"), 2.0f, {8});
+  auto mul = ops::Mul(s.WithOpName("mul"), rsqrt, g_const);
+  auto mul_1 = ops::Mul(s.WithOpName("mul_1"), input, mul);
+  auto mul_2 = ops::Mul(s.WithOpName("mul_2"), mul, mean);
+  auto b_const = ops::Const(s.WithOpName("b_const"), 0.5f, {8});
+  auto sub = ops::Sub(s.WithOpName("sub"), b_const, mul_2);
+  auto add_2 = ops::AddV2(s.WithOpName("add_2"), mul_1, sub);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), add_2);
+
+  auto input_t = GenerateTensorWithSetRandom<DT_FLOAT>({2, 3, 8});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"input", input_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "add_2") {
+      EXPECT_EQ(node.op(), "_FusedLayerNorm");
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "input");
+      EXPECT_EQ(node.input(1), "g_const");
+      EXPECT_EQ(node.input(2), "b_const");
+      EXPECT_FLOAT_EQ(node.attr().at("epsilon").f(), 0.01f);
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 1);
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-4);
+}
+
+// Builds the Keras LayerNormalization graph, which normalizes with a
+// FusedBatchNormV3 over the input reshaped to [1, rows, depth, 1], on an input
+// of shape [2, 3, 8] with gamma and beta of shape [8]. It is only a layer norm
+// over the last axis if depth is the last dimension of the input.
+class FuseKerasLayerNorm : public RemapperTest {
+ public:
+  void RunTest(bool normalize_last_axis_only) {
+    using ::tensorflow::ops::Placeholder;
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+    const int rows = normalize_last_axis_only ? 6 : 2;
+    const int depth = normalize_last_axis_only ? 8 : 24;
+    auto input = Placeholder(s.WithOpName("input"), DT_FLOAT,
+                             ops::Placeholder::Shape({2, 3, 8}));
+    auto pre_shape =
+        ops::Const(s.WithOpName("pre_shape"), {1, rows, depth, 1}, {4});
+    auto pre_reshape =
+        ops::Reshape(s.WithOpName("pre_reshape"), input, pre_shape);
+    auto fill_dims = ops::Const(s.WithOpName("fill_dims"), {rows}, {1});
+    auto unit_gamma = ops::Const(s.WithOpName("unit_gamma"), 1.0f);
+    auto zero_beta = ops::Const(s.WithOpName("zero_beta"), 0.0f);
+    auto fill_scale =
+        ops::Fill(s.WithOpName("fill_scale"), fill_dims, unit_gamma);
+    auto fill_offset =
+        ops::Fill(s.WithOpName("fill_offset"), fill_dims, zero_beta);
+    Tensor empty_t(DT_FLOAT, TensorShape({0}));
+    auto empty = ops::Const(s.WithOpName("empty"), Input::Initializer(empty_t));
+    auto fbn = ops::FusedBatchNormV3(
+        s.WithOpName("fused_batch_norm"), pre_reshape, fill_scale, fill_offset,
+        empty, empty,
+        ops::FusedBatchNormV3::IsTraining(true).Epsilon(0.01f).DataFormat(
+            "NCHW"));
+    auto post_shape = ops::Const(s.WithOpName("post_shape"), {2, 3, 8}, {3});
+    auto post_reshape =
+        ops::Reshape(s.WithOpName("post_reshape"), fbn.y, post_shape);
+    auto g_const = ops::Const(s.WithOpName("g_const"), 2.0f, {8});
+    auto mul = ops::Mul(s.WithOpName("mul"), post_reshape, g_const);
+    auto b_const = ops::Const(s.WithOpName("b_const"), 0.5f, {8});
+    auto add = ops::AddV2(s.WithOpName("add"), mul, b_const);
+    auto fetch = ops::Identity(s.WithOpName("fetch"), add);
+
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    item.feed = {{"input", GenerateTensorWithSetRandom<DT_FLOAT>({2, 3, 8})}};
+    TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+    // Place all nodes on CPU.
+    for (int i = 0; i < item.graph.node_size(); ++i) {
+      item.graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef output;
+    TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      if (node.name() == "add") {
+        if (normalize_last_axis_only) {
+          EXPECT_EQ(node.op(),
+                    IsMKLEnabled() ? "_MklLayerNorm" : "_FusedLayerNorm");
+          ASSERT_EQ(node.input_size(), 3);
+          EXPECT_EQ(node.input(0), "input");
+          EXPECT_EQ(node.input(1), "g_const");
+          EXPECT_EQ(node.input(2), "b_const");
+          EXPECT_FLOAT_EQ(node.attr().at("epsilon").f(), 0.01f);
+        } else {
+          EXPECT_EQ(node.op(), "AddV2");
+        }
+        found++;
+      }
+    }
+    EXPECT_EQ(found, 1);
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    ASSERT_EQ(tensors_expected.size(), 1);
+    auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+    ASSERT_EQ(tensors.size(), 1);
+    test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-4);
+  }
+};
+
+TEST_F(FuseKerasLayerNorm, LastAxis) { RunTest(true); }
+
+// Normalizing over the last two axes must not be fused into a layer norm over
+// the last axis, although gamma and beta broadcast against the last axis.
+TEST_F(FuseKerasLayerNorm, MultipleAxes) { RunTest(false); }
+
+class FuseScaledDotProductAttention : public RemapperTest {
+ public:
+  void RunTest(bool with_mask, bool divide_by_scale) {
+    using ::tensorflow::ops::Placeholder;
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+    auto query = Placeholder(s.WithOpName("query"), DT_FLOAT,
+                             ops::Placeholder::Shape({2, 4, 40, 16}));
+    auto key = Placeholder(s.WithOpName("key"), DT_FLOAT,
+                           ops::Placeholder::Shape({2, 4, 24, 16}));
+    auto value = Placeholder(s.WithOpName("value"), DT_FLOAT,
+                             ops::Placeholder::Shape({2, 4, 24, 8}));
+    auto mask = Placeholder(s.WithOpName("mask"), DT_FLOAT,
+                            ops::Placeholder::Shape({2, 1, 1, 24}));
+    auto qk = ops::BatchMatMulV2(s.WithOpName("qk"), query, key,
+                                 ops::BatchMatMulV2::AdjY(true));
+    Output logits;
+    if (divide_by_scale) {
+      auto scale = ops::Const(s.WithOpName("scale"), 4.0f, {});
+      logits = ops::RealDiv(s.WithOpName("scaled"), qk, scale);
+    } else {
+      auto scale = ops::Const(s.WithOpName("scale"), 0.25f, {});
+      logits = ops::Mul(s.WithOpName("scaled"), scale, qk);
+    }
+    if (with_mask) {
+      logits = ops::AddV2(s.WithOpName("masked"), mask, logits);
+    }
+    auto softmax = ops::Softmax(s.WithOpName("softmax"), logits);
+    auto attention = ops::BatchMatMulV2(s.WithOpName("attention"), softmax,
+                                        value);
+    auto fetch = ops::Identity(s.WithOpName("fetch"), attention);
+
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    item.feed = {
+        {"query", GenerateTensorWithSetRandom<DT_FLOAT>({2, 4, 40, 16})},
+        {"key", GenerateTensorWithSetRandom<DT_FLOAT>({2, 4, 24, 16})},
+        {"value", GenerateTensorWithSetRandom<DT_FLOAT>({2, 4, 24, 8})}};
+    if (with_mask) {
+      item.feed.push_back(
+          {"mask", GenerateTensorWithSetRandom<DT_FLOAT>({2, 1, 1, 24})});
+    }
+    TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+    // Place all nodes on CPU.
+    for (int i = 0; i < item.graph.node_size(); ++i) {
+      item.graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef output;
+    TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      EXPECT_NE(node.op(), "Softmax");
+      if (node.name() == "attention") {
+        EXPECT_EQ(node.op(), "_FusedScaledDotProductAttention");
+        ASSERT_EQ(node.input_size(), with_mask ? 4 : 3);
+        EXPECT_EQ(node.input(0), "query");
+        EXPECT_EQ(node.input(1), "key");
+        EXPECT_EQ(node.input(2), "value");
+        if (with_mask) EXPECT_EQ(node.input(3), "mask");
+        EXPECT_FLOAT_EQ(node.attr().at("scale").f(), 0.25f);
+        EXPECT_EQ(node.attr().at("num_masks").i(), with_mask ? 1 : 0);
+        found++;
+      }
+    }
+    EXPECT_EQ(found, 1);
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    ASSERT_EQ(tensors_expected.size(), 1);
+    auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+    ASSERT_EQ(tensors.size(), 1);
+    test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-5);
+  }
+};
+
+TEST_F(FuseScaledDotProductAttention, ScaleAndMask) { RunTest(true, false); }
+TEST_F(FuseScaledDotProductAttention, DivideByScale) { RunTest(false, true); }
+
 class RemapperTensorToHashBucketTest : public RemapperTest {
  public:
   template <DataType DTYPE>
@@ -0,0 +1,187 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/thread_budget_optimizer.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/costs/cost_estimator.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/static_schedule.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// Kernels predicted to run for less than this aren't worth parallelizing:
+// they get no budget, and don't take threads away from the others.
+constexpr int64_t kMinParallelWorkNs = 10000;
+
+// Weight of the kernels on the critical path relative to the others.
+constexpr int kCriticalPathWeight = 2;
+
+bool IsOnCpu(const NodeDef& node) {
+  if (node.device().empty()) return true;
+  DeviceNameUtils::ParsedName parsed_name;
+  return DeviceNameUtils::ParseFullName(node.device(), &parsed_name) &&
+         (!parsed_name.has_type || parsed_name.type == DEVICE_CPU);
+}
+
+// Counts the intervals [start, end) that overlap with a given interval.
+class OverlapCounter {
+ public:
+  void Add(int64_t start, int64_t end) {
+    starts_.push_back(start);
+    ends_.push_back(end);
+  }
+
+  void Finalize() {
+    std::sort(starts_.begin(), starts_.end());
+    std::sort(ends_.begin(), ends_.end());
+  }
+
+  // Intervals ending before `start` also start before `end`, so the overlaps
+  // are the intervals starting before `end` minus the ones ending before
+  // `start`.
+  int Count(int64_t start, int64_t end) const {
+    const auto started =
+        std::lower_bound(starts_.begin(), starts_.end(), end) - starts_.begin();
+    const auto ended =
+        std::upper_bound(ends_.begin(), ends_.end(), start) - ends_.begin();
+    return started - ended;
+  }
+
+ private:
+  std::vector<int64_t> starts_;
+  std::vector<int64_t> ends_;
+};
+
+}  // namespace
+
+int ThreadBudgetOptimizer::NumThreads(const Cluster& cluster) const {
+  if (num_threads_ > 0) return num_threads_;
+  int num_cores = 0;
+  for (const auto& device : cluster.GetDevices()) {
+    if (device.second.type() == "CPU") {
+      num_cores = std::max<int>(num_cores, device.second.num_cores());
+    }
+  }
+  return num_cores > 0 ? num_cores : port::MaxParallelism();
+}
+
+Status ThreadBudgetOptimizer::Optimize(Cluster* cluster,
+                                       const GrapplerItem& item,
+                                       GraphDef* optimized_graph) {
+  if (cluster == nullptr) {
+    return errors::Aborted("Thread budgets require a cluster");
+  }
+  const int num_threads = NumThreads(*cluster);
+  if (num_threads <= 1) {
+    return errors::Aborted("Nothing to do: a single intra-op thread");
+  }
+
+  std::unordered_map<const NodeDef*, Costs::NanoSeconds> completion_times;
+  TF_RETURN_IF_ERROR(
+      EstimateEarliestExecutionTimes(item, cluster, &completion_times));
+  std::unordered_map<const NodeDef*, Costs::NanoSeconds> required_times;
+  TF_RETURN_IF_ERROR(EstimateRequiredTimes(item, cluster, completion_times,
+                                           &required_times));
+
+  struct ScheduledNode {
+    int64_t start = 0;
+    int64_t end = 0;
+    bool critical = false;
+    bool parallel_work = false;
+  };
+  const int num_nodes = item.graph.node_size();
+  std::vector<ScheduledNode> schedule(num_nodes);
+  {
+    std::unordered_map<string, const NodeDef*> name_map;
+    for (const NodeDef& node : item.graph.node()) {
+      name_map[node.name()] = &node;
+    }
+    for (int i = 0; i < num_nodes; ++i) {
+      const NodeDef& node = item.graph.node(i);
+      auto completion = completion_times.find(&node);
+      if (completion == completion_times.end() || !IsOnCpu(node)) continue;
+      ScheduledNode& scheduled = schedule[i];
+      // A node starts once all its fanins have completed.
+      for (const string& input : node.input()) {
+        auto fanin = name_map.find(NodeName(input));
+        if (fanin == name_map.end()) continue;
+        auto fanin_completion = completion_times.find(fanin->second);
+        if (fanin_completion != completion_times.end()) {
+          scheduled.start =
+              std::max(scheduled.start, fanin_completion->second.count());
+        }
+      }
+      scheduled.end = completion->second.count();
+      scheduled.parallel_work =
+          scheduled.end - scheduled.start >= kMinParallelWorkNs;
+      auto required = required_times.find(&node);
+      scheduled.critical = required != required_times.end() &&
+                           required->second <= completion->second;
+    }
+  }
+
+  OverlapCounter critical_nodes;
+  OverlapCounter other_nodes;
+  for (const ScheduledNode& scheduled : schedule) {
+    if (!scheduled.parallel_work) continue;
+    (scheduled.critical ? critical_nodes : other_nodes)
+        .Add(scheduled.start, scheduled.end);
+  }
+  critical_nodes.Finalize();
+  other_nodes.Finalize();
+
+  *optimized_graph = item.graph;
+  int num_annotated = 0;
+  for (int i = 0; i < num_nodes; ++i) {
+    NodeDef* node = optimized_graph->mutable_node(i);
+    // Budgets computed by a previous run are recomputed from scratch.
+    node->mutable_attr()->erase(kIntraOpParallelismAttr);
+    const ScheduledNode& scheduled = schedule[i];
+    if (!scheduled.parallel_work) continue;
+
+    const int64_t total_weight =
+        kCriticalPathWeight *
+            critical_nodes.Count(scheduled.start, scheduled.end) +
+        other_nodes.Count(scheduled.start, scheduled.end);
+    const int weight = scheduled.critical ? kCriticalPathWeight : 1;
+    const int64_t budget =
+        std::max<int64_t>(1, num_threads * weight / total_weight);
+    if (budget >= num_threads) continue;
+    (*node->mutable_attr())[kIntraOpParallelismAttr].set_i(budget);
+    ++num_annotated;
+  }
+  VLOG(1) << "Set the thread budget of " << num_annotated << " out of "
+          << num_nodes << " nodes, with " << num_threads << " threads";
+  return OkStatus();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,62 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_THREAD_BUDGET_OPTIMIZER_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_THREAD_BUDGET_OPTIMIZER_H_
+
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Splits the intra-op threads of the CPU between the kernels that the static
+// schedule of the graph (see static_schedule.h) predicts to run concurrently.
+//
+// Every CPU kernel overlapping with other kernels in the schedule is annotated
+// with a thread budget (kIntraOpParallelismAttr), which the CPU device uses to
+// limit the parallelism of the kernel. This keeps parallel branches from
+// oversubscribing the intra-op thread pool. The threads are shared in
+// proportion to a weight, which is twice as large for the kernels on the
+// critical path as for the others, so that the critical path is slowed down
+// the least. Kernels predicted to run alone keep using all the threads.
+class ThreadBudgetOptimizer : public GraphOptimizer {
+ public:
+  ThreadBudgetOptimizer() {}
+  // `num_threads` is the size of the intra-op thread pool. If it isn't
+  // positive, the number of cores of the CPU devices of the cluster is used.
+  explicit ThreadBudgetOptimizer(RewriterConfig::Toggle opt_level,
+                                 int num_threads = 0)
+      : num_threads_(num_threads) {}
+
+  ~ThreadBudgetOptimizer() override {}
+
+  string name() const override { return "thread_budget_optimizer"; };
+
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+ private:
+  int NumThreads(const Cluster& cluster) const;
+
+  int num_threads_ = 0;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_THREAD_BUDGET_OPTIMIZER_H_
@@ -0,0 +1,143 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/thread_budget_optimizer.h"
+
+#include <memory>
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/grappler/clusters/virtual_cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class ThreadBudgetOptimizerTest : public ::testing::Test {
+ public:
+  std::unique_ptr<VirtualCluster> CreateVirtualCluster() const {
+    DeviceProperties cpu_device;
+    cpu_device.set_type("CPU");
+    cpu_device.set_frequency(1000);
+    cpu_device.set_num_cores(8);
+    cpu_device.set_bandwidth(32);
+    std::unordered_map<string, DeviceProperties> devices;
+    devices["/job:localhost/replica:0/task:0/cpu:0"] = cpu_device;
+    return std::make_unique<VirtualCluster>(devices);
+  }
+
+  // Returns the thread budget of `node_name`, or 0 if it has none.
+  int64_t Budget(const GraphDef& graph, const string& node_name) const {
+    for (const NodeDef& node : graph.node()) {
+      if (node.name() != node_name) continue;
+      auto it = node.attr().find(kIntraOpParallelismAttr);
+      return it == node.attr().end() ? 0 : it->second.i();
+    }
+    ADD_FAILURE() << "Missing node " << node_name;
+    return -1;
+  }
+};
+
+TEST_F(ThreadBudgetOptimizerTest, SplitsThreadsBetweenParallelBranches) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                              ops::Placeholder::Shape({512, 512}));
+  std::vector<Output> branches;
+  for (int i = 0; i < 4; ++i) {
+    branches.push_back(
+        ops::MatMul(s.WithOpName(strings::StrCat("branch", i)), x, x));
+  }
+  // A smaller branch, off the critical path.
+  Output y = ops::Placeholder(s.WithOpName("y"), DT_FLOAT,
+                              ops::Placeholder::Shape({256, 512}));
+  Output small = ops::MatMul(s.WithOpName("small"), y, x);
+  Output small_sum = ops::Sum(s.WithOpName("small_sum"), small, {0});
+  Output sum = ops::AddN(s.WithOpName("sum"), branches);
+  Output out = ops::MatMul(s.WithOpName("out"), sum, sum);
+  Output out_plus = ops::Add(s.WithOpName("out_plus"), out, small_sum);
+
+  GrapplerItem item;
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"out_plus"};
+
+  std::unique_ptr<VirtualCluster> cluster = CreateVirtualCluster();
+  ThreadBudgetOptimizer optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(cluster.get(), item, &output));
+  ASSERT_EQ(output.node_size(), item.graph.node_size());
+
+  // The four critical branches and the small branch run concurrently, and
+  // have to share the 8 threads.
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(Budget(output, strings::StrCat("branch", i)), 1);
+  }
+  EXPECT_EQ(Budget(output, "small"), 1);
+  // The final MatMul runs alone, and keeps all the threads.
+  EXPECT_EQ(Budget(output, "out"), 0);
+  EXPECT_EQ(Budget(output, "x"), 0);
+
+  // With more threads, the critical branches get more than the others.
+  ThreadBudgetOptimizer large_optimizer(RewriterConfig::ON,
+                                        /*num_threads=*/64);
+  TF_ASSERT_OK(large_optimizer.Optimize(cluster.get(), item, &output));
+  const int64_t small_budget = Budget(output, "small");
+  EXPECT_GT(small_budget, 1);
+  for (int i = 0; i < 4; ++i) {
+    const int64_t branch_budget =
+        Budget(output, strings::StrCat("branch", i));
+    EXPECT_GT(branch_budget, small_budget);
+    EXPECT_LE(4 * branch_budget + small_budget, 64);
+  }
+  EXPECT_EQ(Budget(output, "out"), 0);
+}
+
+TEST_F(ThreadBudgetOptimizerTest, RecomputesBudgets) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                              ops::Placeholder::Shape({512, 512}));
+  Output out = ops::MatMul(s.WithOpName("out"), x, x);
+
+  GrapplerItem item;
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"out"};
+  for (NodeDef& node : *item.graph.mutable_node()) {
+    if (node.name() == "out") {
+      (*node.mutable_attr())[kIntraOpParallelismAttr].set_i(2);
+    }
+  }
+
+  std::unique_ptr<VirtualCluster> cluster = CreateVirtualCluster();
+  ThreadBudgetOptimizer optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(cluster.get(), item, &output));
+  EXPECT_EQ(Budget(output, "out"), 0);
+}
+
+TEST_F(ThreadBudgetOptimizerTest, NeedsACluster) {
+  GrapplerItem item;
+  ThreadBudgetOptimizer optimizer(RewriterConfig::ON);
+  GraphDef output;
+  EXPECT_TRUE(errors::IsAborted(optimizer.Optimize(nullptr, item, &output)));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
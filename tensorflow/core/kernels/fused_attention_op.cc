@@ -0,0 +1,251 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Scaled dot-product attention, created by the Grappler remapper from the
+// BatchMatMul/Mul/Add/Softmax/BatchMatMul subgraph. The attention logits of a
+// block of query rows are computed, masked, normalized and multiplied by the
+// values while they are still in cache, so the [batch..., query, key] logits
+// tensor of the unfused subgraph is never materialized.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "Eigen/Core"  // from @eigen_archive
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// The number of query rows whose logits are kept in a scratch buffer at once.
+constexpr int64_t kQueryBlockSize = 32;
+
+// Returns the offset of every batch of the attention logits into `mask`, and
+// the mask strides along the query and key dimensions. Broadcast dimensions
+// have a zero stride.
+Status ComputeMaskStrides(const TensorShape& logits_shape,
+                          const TensorShape& mask_shape,
+                          std::vector<int64_t>* batch_offsets,
+                          int64_t* query_stride, int64_t* key_stride) {
+  const int rank = logits_shape.dims();
+  if (mask_shape.dims() > rank) {
+    return errors::InvalidArgument("mask ", mask_shape.DebugString(),
+                                   " is not broadcastable to the logits ",
+                                   logits_shape.DebugString());
+  }
+  std::vector<int64_t> strides(rank, 0);
+  int64_t stride = 1;
+  for (int i = rank - 1, j = mask_shape.dims() - 1; j >= 0; --i, --j) {
+    const int64_t mask_dim = mask_shape.dim_size(j);
+    if (mask_dim == logits_shape.dim_size(i)) {
+      strides[i] = mask_dim == 1 ? 0 : stride;
+    } else if (mask_dim != 1) {
+      return errors::InvalidArgument("mask ", mask_shape.DebugString(),
+                                     " is not broadcastable to the logits ",
+                                     logits_shape.DebugString());
+    }
+    stride *= mask_dim;
+  }
+  *query_stride = strides[rank - 2];
+  *key_stride = strides[rank - 1];
+
+  int64_t num_batches = 1;
+  for (int i = 0; i < rank - 2; ++i) num_batches *= logits_shape.dim_size(i);
+  batch_offsets->assign(num_batches, 0);
+  for (int64_t batch = 0; batch < num_batches; ++batch) {
+    int64_t remaining = batch;
+    for (int i = rank - 3; i >= 0; --i) {
+      const int64_t dim = logits_shape.dim_size(i);
+      (*batch_offsets)[batch] += (remaining % dim) * strides[i];
+      remaining /= dim;
+    }
+  }
+  return OkStatus();
+}
+
+}  // namespace
+
+template <typename Device, typename T>
+class FusedScaledDotProductAttentionOp : public OpKernel {
+ public:
+  explicit FusedScaledDotProductAttentionOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("scale", &scale_));
+    int num_masks;
+    OP_REQUIRES_OK(context, context->GetAttr("num_masks", &num_masks));
+    OP_REQUIRES(context, num_masks <= 1,
+                errors::InvalidArgument("At most one mask is supported, got ",
+                                        num_masks));
+    has_mask_ = num_masks == 1;
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& query = context->input(0);
+    const Tensor& key = context->input(1);
+    const Tensor& value = context->input(2);
+    const int rank = query.dims();
+    OP_REQUIRES(context,
+                rank >= 3 && key.dims() == rank && value.dims() == rank,
+                errors::InvalidArgument(
+                    "query, key and value must have the same rank of at least "
+                    "3, got ",
+                    query.shape().DebugString(), ", ",
+                    key.shape().DebugString(), " and ",
+                    value.shape().DebugString()));
+    for (int i = 0; i < rank - 2; ++i) {
+      OP_REQUIRES(context,
+                  key.dim_size(i) == query.dim_size(i) &&
+                      value.dim_size(i) == query.dim_size(i),
+                  errors::InvalidArgument(
+                      "query, key and value must have the same batch "
+                      "dimensions, got ",
+                      query.shape().DebugString(), ", ",
+                      key.shape().DebugString(), " and ",
+                      value.shape().DebugString()));
+    }
+    const int64_t query_length = query.dim_size(rank - 2);
+    const int64_t depth = query.dim_size(rank - 1);
+    const int64_t key_length = key.dim_size(rank - 2);
+    const int64_t value_depth = value.dim_size(rank - 1);
+    OP_REQUIRES(context,
+                key.dim_size(rank - 1) == depth &&
+                    value.dim_size(rank - 2) == key_length,
+                errors::InvalidArgument(
+                    "Incompatible query, key and value shapes ",
+                    query.shape().DebugString(), ", ",
+                    key.shape().DebugString(), " and ",
+                    value.shape().DebugString()));
+
+    TensorShape output_shape = query.shape();
+    output_shape.set_dim(rank - 1, value_depth);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, output_shape, &output));
+    if (output->NumElements() == 0) return;
+    // Without keys every row of logits is empty, and each output is an empty
+    // sum of weighted values.
+    if (key_length == 0) {
+      output->flat<T>().setZero();
+      return;
+    }
+
+    const T* mask_data = nullptr;
+    std::vector<int64_t> mask_batch_offsets;
+    int64_t mask_query_stride = 0;
+    int64_t mask_key_stride = 0;
+    if (has_mask_) {
+      const Tensor& mask = context->input(3);
+      TensorShape logits_shape = query.shape();
+      logits_shape.set_dim(rank - 1, key_length);
+      OP_REQUIRES_OK(context, ComputeMaskStrides(
+                                  logits_shape, mask.shape(),
+                                  &mask_batch_offsets, &mask_query_stride,
+                                  &mask_key_stride));
+      mask_data = mask.flat<T>().data();
+    }
+
+    using Matrix =
+        Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+    using ConstMatrixMap = Eigen::Map<const Matrix>;
+    using MatrixMap = Eigen::Map<Matrix>;
+    using ConstRowMap = Eigen::Map<const Eigen::Array<T, 1, Eigen::Dynamic>>;
+
+    const int64_t num_batches = output_shape.num_elements() /
+                                (query_length * value_depth);
+    const int64_t blocks_per_batch =
+        (query_length + kQueryBlockSize - 1) / kQueryBlockSize;
+    const T* query_data = query.flat<T>().data();
+    const T* key_data = key.flat<T>().data();
+    const T* value_data = value.flat<T>().data();
+    T* output_data = output->flat<T>().data();
+    const T scale = static_cast<T>(scale_);
+
+    auto compute_blocks = [&](int64_t begin, int64_t end) {
+      Matrix logits(kQueryBlockSize, key_length);
+      for (int64_t block = begin; block < end; ++block) {
+        const int64_t batch = block / blocks_per_batch;
+        const int64_t first_row = (block % blocks_per_batch) * kQueryBlockSize;
+        const int64_t num_rows =
+            std::min(kQueryBlockSize, query_length - first_row);
+
+        const int64_t first_query = batch * query_length + first_row;
+        ConstMatrixMap q(query_data + first_query * depth, num_rows, depth);
+        ConstMatrixMap k(key_data + batch * key_length * depth, key_length,
+                         depth);
+        ConstMatrixMap v(value_data + batch * key_length * value_depth,
+                         key_length, value_depth);
+        auto block_logits = logits.topRows(num_rows);
+        block_logits.noalias() = q * k.transpose();
+        block_logits *= scale;
+
+        for (int64_t row = 0; row < num_rows; ++row) {
+          auto row_logits = block_logits.row(row).array();
+          if (mask_data != nullptr) {
+            const T* mask_row = mask_data + mask_batch_offsets[batch] +
+                                (first_row + row) * mask_query_stride;
+            if (mask_key_stride == 1) {
+              row_logits += ConstRowMap(mask_row, key_length);
+            } else if (mask_key_stride == 0) {
+              row_logits += mask_row[0];
+            } else {
+              for (int64_t j = 0; j < key_length; ++j) {
+                row_logits(j) += mask_row[j * mask_key_stride];
+              }
+            }
+          }
+          row_logits = (row_logits - row_logits.maxCoeff()).exp();
+          row_logits /= row_logits.sum();
+        }
+
+        MatrixMap out(output_data + first_query * value_depth, num_rows,
+                      value_depth);
+        out.noalias() = block_logits * v;
+      }
+    };
+
+    const auto& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    const int64_t cost_per_block =
+        kQueryBlockSize * key_length * (2 * depth + 2 * value_depth + 10);
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          num_batches * blocks_per_batch, cost_per_block, compute_blocks);
+  }
+
+ private:
+  float scale_;
+  bool has_mask_;
+};
+
+#define REGISTER_CPU_KERNEL(T)                                          \
+  REGISTER_KERNEL_BUILDER(Name("_FusedScaledDotProductAttention")       \
+                              .Device(DEVICE_CPU)                       \
+                              .TypeConstraint<T>("T"),                  \
+                          FusedScaledDotProductAttentionOp<CPUDevice, T>);
+
+TF_CALL_float(REGISTER_CPU_KERNEL);
+
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace tensorflow
@@ -0,0 +1,240 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+class FusedScaledDotProductAttentionOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(float scale, int num_masks) {
+    TF_ASSERT_OK(NodeDefBuilder("attention", "_FusedScaledDotProductAttention")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(num_masks, DT_FLOAT))
+                     .Attr("T", DT_FLOAT)
+                     .Attr("scale", scale)
+                     .Attr("num_masks", num_masks)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Computes softmax(q * k^T * scale + mask) * v for a single batch, with the
+  // mask given per [query, key] position.
+  static std::vector<float> Reference(const std::vector<float>& q,
+                                      const std::vector<float>& k,
+                                      const std::vector<float>& v,
+                                      const std::vector<float>& mask,
+                                      int query_length, int key_length,
+                                      int depth, int value_depth,
+                                      float scale) {
+    std::vector<float> output;
+    for (int i = 0; i < query_length; ++i) {
+      std::vector<float> logits(key_length);
+      for (int j = 0; j < key_length; ++j) {
+        float dot = 0;
+        for (int d = 0; d < depth; ++d) {
+          dot += q[i * depth + d] * k[j * depth + d];
+        }
+        logits[j] = dot * scale + (mask.empty() ? 0 : mask[i * key_length + j]);
+      }
+      const float max = *std::max_element(logits.begin(), logits.end());
+      float sum = 0;
+      for (float& logit : logits) sum += (logit = std::exp(logit - max));
+      for (int d = 0; d < value_depth; ++d) {
+        float out = 0;
+        for (int j = 0; j < key_length; ++j) {
+          out += logits[j] / sum * v[j * value_depth + d];
+        }
+        output.push_back(out);
+      }
+    }
+    return output;
+  }
+};
+
+TEST_F(FusedScaledDotProductAttentionOpTest, WithoutMask) {
+  MakeOp(0.5f, 0);
+  const std::vector<float> q = {1, 0, 0, 1, 1, 1};
+  const std::vector<float> k = {1, 2, -1, 0.5};
+  const std::vector<float> v = {1, 2, 3, -1, 0, 4};
+  AddInputFromArray<float>(TensorShape({1, 3, 2}), q);
+  AddInputFromArray<float>(TensorShape({1, 2, 2}), k);
+  AddInputFromArray<float>(TensorShape({1, 2, 3}), v);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(DT_FLOAT, TensorShape({1, 3, 3}));
+  test::FillValues<float>(&expected, Reference(q, k, v, {}, 3, 2, 2, 3, 0.5f));
+  test::ExpectClose(expected, *GetOutput(0), /*atol=*/1e-5);
+}
+
+TEST_F(FusedScaledDotProductAttentionOpTest, BroadcastsMask) {
+  MakeOp(1.0f, 1);
+  // Two batches of two heads with 40 queries, to cover more than one block of
+  // query rows, attending to 3 keys. The mask is shared by the heads.
+  const int kBatch = 2, kHeads = 2, kQueries = 40, kKeys = 3, kDepth = 4;
+  Tensor q(DT_FLOAT, TensorShape({kBatch, kHeads, kQueries, kDepth}));
+  Tensor k(DT_FLOAT, TensorShape({kBatch, kHeads, kKeys, kDepth}));
+  Tensor v(DT_FLOAT, TensorShape({kBatch, kHeads, kKeys, kDepth}));
+  Tensor mask(DT_FLOAT, TensorShape({kBatch, 1, 1, kKeys}));
+  q.flat<float>().setRandom();
+  k.flat<float>().setRandom();
+  v.flat<float>().setRandom();
+  test::FillValues<float>(&mask, {0, -1e9, 0, 0, 0, -1e9});
+  for (const Tensor* input : {&q, &k, &v, &mask}) {
+    AddInputFromArray<float>(
+        input->shape(), absl::Span<const float>(input->flat<float>().data(),
+                                                input->NumElements()));
+  }
+  TF_ASSERT_OK(RunOpKernel());
+
+  std::vector<float> expected;
+  for (int b = 0; b < kBatch; ++b) {
+    std::vector<float> batch_mask;
+    for (int i = 0; i < kQueries; ++i) {
+      for (int j = 0; j < kKeys; ++j) {
+        batch_mask.push_back(mask.flat<float>()(b * kKeys + j));
+      }
+    }
+    for (int h = 0; h < kHeads; ++h) {
+      const int batch = b * kHeads + h;
+      auto slice = [](const Tensor& t, int batch, int size) {
+        const float* data = t.flat<float>().data() + batch * size;
+        return std::vector<float>(data, data + size);
+      };
+      const std::vector<float> out = Reference(
+          slice(q, batch, kQueries * kDepth), slice(k, batch, kKeys * kDepth),
+          slice(v, batch, kKeys * kDepth), batch_mask, kQueries, kKeys, kDepth,
+          kDepth, 1.0f);
+      expected.insert(expected.end(), out.begin(), out.end());
+    }
+  }
+  Tensor expected_tensor(DT_FLOAT, q.shape());
+  test::FillValues<float>(&expected_tensor, expected);
+  test::ExpectClose(expected_tensor, *GetOutput(0), /*atol=*/1e-5);
+}
+
+TEST_F(FusedScaledDotProductAttentionOpTest, WithoutKeys) {
+  MakeOp(1.0f, 1);
+  AddInputFromArray<float>(TensorShape({1, 2, 2}), {1, 2, 3, 4});
+  AddInputFromArray<float>(TensorShape({1, 0, 2}), {});
+  AddInputFromArray<float>(TensorShape({1, 0, 3}), {});
+  AddInputFromArray<float>(TensorShape({1, 1, 0}), {});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(DT_FLOAT, TensorShape({1, 2, 3}));
+  test::FillValues<float>(&expected, {0, 0, 0, 0, 0, 0});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(FusedScaledDotProductAttentionOpTest, RejectsIncompatibleMask) {
+  MakeOp(1.0f, 1);
+  AddInputFromArray<float>(TensorShape({1, 2, 2}), {1, 2, 3, 4});
+  AddInputFromArray<float>(TensorShape({1, 2, 2}), {1, 2, 3, 4});
+  AddInputFromArray<float>(TensorShape({1, 2, 2}), {1, 2, 3, 4});
+  AddInputFromArray<float>(TensorShape({3}), {0, 0, 0});
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
+// Performance benchmarks below.
+
+static Tensor RandomTensor(const TensorShape& shape) {
+  Tensor t(DT_FLOAT, shape);
+  t.flat<float>().setRandom();
+  return t;
+}
+
+// Attention as emitted by Keras MultiHeadAttention, one node per operation.
+static Graph* AttentionChain(int batch, int heads, int length, int depth) {
+  Graph* g = new Graph(OpRegistry::Global());
+  const TensorShape shape({batch, heads, length, depth});
+  Node* q = test::graph::Constant(g, RandomTensor(shape));
+  Node* k = test::graph::Constant(g, RandomTensor(shape));
+  Node* v = test::graph::Constant(g, RandomTensor(shape));
+  Node* mask = test::graph::Constant(
+      g, RandomTensor(TensorShape({batch, 1, 1, length})));
+  Node* scale = test::graph::Constant(
+      g, test::AsScalar<float>(1.0f / std::sqrt(static_cast<float>(depth))));
+
+  Node* logits = test::graph::BatchMatmul(g, q, k, /*adj_x=*/false,
+                                          /*adj_y=*/true);
+  logits = test::graph::Binary(g, "Mul", logits, scale);
+  logits = test::graph::Binary(g, "AddV2", logits, mask);
+  Node* softmax = test::graph::Unary(g, "Softmax", logits);
+  test::graph::BatchMatmul(g, softmax, v, /*adj_x=*/false, /*adj_y=*/false);
+  return g;
+}
+
+static Graph* FusedAttention(int batch, int heads, int length, int depth) {
+  Graph* g = new Graph(OpRegistry::Global());
+  const TensorShape shape({batch, heads, length, depth});
+  Node* q = test::graph::Constant(g, RandomTensor(shape));
+  Node* k = test::graph::Constant(g, RandomTensor(shape));
+  Node* v = test::graph::Constant(g, RandomTensor(shape));
+  Node* mask = test::graph::Constant(
+      g, RandomTensor(TensorShape({batch, 1, 1, length})));
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "_FusedScaledDotProductAttention")
+                  .Input(q)
+                  .Input(k)
+                  .Input(v)
+                  .Input(std::vector<NodeBuilder::NodeOut>{mask})
+                  .Attr("T", DT_FLOAT)
+                  .Attr("scale", 1.0f / std::sqrt(static_cast<float>(depth)))
+                  .Attr("num_masks", 1)
+                  .Finalize(g, &ret));
+  return g;
+}
+
+#define BM_Attention(B, H, L, D, kind)                                        \
+  static void BM_Attention##_##kind##_##B##_##H##_##L##_##D(                  \
+      ::testing::benchmark::State& state) {                                   \
+    test::Benchmark("cpu", kind(B, H, L, D), /*old_benchmark_api*/ false)     \
+        .Run(state);                                                          \
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * B * H * \
+                            L * L * D * 4);                                   \
+  }                                                                           \
+  BENCHMARK(BM_Attention##_##kind##_##B##_##H##_##L##_##D)->UseRealTime();
+
+// BenchmarkName(batch, heads, sequence_length, depth, kind)
+
+BM_Attention(1, 12, 128, 64, AttentionChain);
+BM_Attention(1, 12, 128, 64, FusedAttention);
+
+BM_Attention(8, 12, 128, 64, AttentionChain);
+BM_Attention(8, 12, 128, 64, FusedAttention);
+
+BM_Attention(8, 12, 512, 64, AttentionChain);
+BM_Attention(8, 12, 512, 64, FusedAttention);
+
+}  // namespace
+}  // namespace tensorflow
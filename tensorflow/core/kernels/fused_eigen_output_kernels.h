@@ -151,6 +151,29 @@ struct LeakyRelu {
   };
 };
 
+// Applies the tanh approximation of `Gelu` to the passed input expression.
+struct GeluApproximate {
+  template <typename XprType>
+  static auto apply(XprType expr) {
+    using Scalar = typename XprType::Scalar;
+    const auto inner = (expr + expr.cube() * expr.constant(Scalar(0.044715))) *
+                       expr.constant(Scalar(0.7978845608028654));
+    return expr * expr.constant(Scalar(0.5)) *
+           (inner.tanh() + expr.constant(Scalar(1)));
+  };
+};
+
+// Applies the erf based `Gelu` to the passed input expression.
+struct GeluExact {
+  template <typename XprType>
+  static auto apply(XprType expr) {
+    using Scalar = typename XprType::Scalar;
+    return expr * expr.constant(Scalar(0.5)) *
+           ((expr * expr.constant(Scalar(0.7071067811865476))).erf() +
+            expr.constant(Scalar(1)));
+  };
+};
+
 template <typename T>
 struct BiasAddArgs {
   const T* bias_add_data = nullptr;
@@ -163,7 +186,9 @@ struct BiasAddArgs {
            fusion == FusedComputationType::kBiasAddWithTanh ||
            fusion == FusedComputationType::kBiasAddWithSigmoid ||
            fusion == FusedComputationType::kBiasAddWithElu ||
-           fusion == FusedComputationType::kBiasAddWithLeakyRelu;
+           fusion == FusedComputationType::kBiasAddWithLeakyRelu ||
+           fusion == FusedComputationType::kBiasAddWithGeluApproximate ||
+           fusion == FusedComputationType::kBiasAddWithGeluExact;
   }
 };
 
@@ -398,6 +423,10 @@ using WithBiasAddAndElu = BiasAddOutputKernel<T, Elu>;
 template <typename T>
 using WithBiasAddAndLeakyRelu = BiasAddOutputKernel<T, LeakyRelu>;
 template <typename T>
+using WithBiasAddAndGeluApproximate = BiasAddOutputKernel<T, GeluApproximate>;
+template <typename T>
+using WithBiasAddAndGeluExact = BiasAddOutputKernel<T, GeluExact>;
+template <typename T>
 using WithFusedBatchNorm = FusedBatchNormOutputKernel<T>;
 template <typename T>
 using WithFusedBatchNormAndRelu = FusedBatchNormOutputKernel<T, Relu>;
@@ -0,0 +1,116 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Layer normalization over the innermost dimension, created by the Grappler
+// remapper from the Mean/SquaredDifference/Rsqrt subgraph. Every row is
+// normalized in a single pass over cache resident data, without materializing
+// the mean, variance and centered tensors of the unfused subgraph.
+
+#define EIGEN_USE_THREADS
+
+#include <cmath>
+#include <cstdint>
+
+#include "Eigen/Core"  // from @eigen_archive
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+template <typename Device, typename T>
+class FusedLayerNormOp : public OpKernel {
+ public:
+  explicit FusedLayerNormOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("epsilon", &epsilon_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& x = context->input(0);
+    const Tensor& scale = context->input(1);
+    const Tensor& offset = context->input(2);
+    OP_REQUIRES(context, x.dims() >= 1,
+                errors::InvalidArgument("x must be at least 1-dimensional: ",
+                                        x.shape().DebugString()));
+    const int64_t depth = x.dim_size(x.dims() - 1);
+    OP_REQUIRES(context,
+                scale.dims() == 1 && scale.dim_size(0) == depth &&
+                    offset.dims() == 1 && offset.dim_size(0) == depth,
+                errors::InvalidArgument(
+                    "scale and offset must be vectors of size ", depth,
+                    ", got ", scale.shape().DebugString(), " and ",
+                    offset.shape().DebugString()));
+
+    Tensor* y = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, x.shape(), &y));
+    if (x.NumElements() == 0) return;
+
+    using Array = Eigen::Array<float, Eigen::Dynamic, 1>;
+    using ConstRow = Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>>;
+    using Row = Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>>;
+    const Array scale_values = ConstRow(scale.flat<T>().data(), depth)
+                                   .template cast<float>();
+    const Array offset_values = ConstRow(offset.flat<T>().data(), depth)
+                                    .template cast<float>();
+    const T* x_data = x.flat<T>().data();
+    T* y_data = y->flat<T>().data();
+    const float epsilon = epsilon_;
+
+    auto normalize_rows = [&](int64_t begin, int64_t end) {
+      Array values(depth);
+      for (int64_t row = begin; row < end; ++row) {
+        // `x` and `y` may alias, so the input row is fully read before the
+        // output row is written.
+        values = ConstRow(x_data + row * depth, depth).template cast<float>();
+        const float mean = values.mean();
+        const float variance = (values - mean).square().mean();
+        const float inv_stddev = 1.0f / std::sqrt(variance + epsilon);
+        Row(y_data + row * depth, depth) =
+            ((values - mean) * (inv_stddev * scale_values) + offset_values)
+                .template cast<T>();
+      }
+    };
+
+    const auto& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    // Each row is read twice and written once.
+    const int64_t cost_per_row = 8 * depth;
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          x.NumElements() / depth, cost_per_row, normalize_rows);
+  }
+
+ private:
+  float epsilon_;
+};
+
+#define REGISTER_CPU_KERNEL(T)                                          \
+  REGISTER_KERNEL_BUILDER(                                              \
+      Name("_FusedLayerNorm").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      FusedLayerNormOp<CPUDevice, T>);
+
+TF_CALL_float(REGISTER_CPU_KERNEL);
+TF_CALL_bfloat16(REGISTER_CPU_KERNEL);
+TF_CALL_half(REGISTER_CPU_KERNEL);
+
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace tensorflow
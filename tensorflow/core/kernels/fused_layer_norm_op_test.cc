@@ -0,0 +1,167 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+class FusedLayerNormOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(DataType dtype, float epsilon) {
+    TF_ASSERT_OK(NodeDefBuilder("layer_norm", "_FusedLayerNorm")
+                     .Input(FakeInput(dtype))
+                     .Input(FakeInput(dtype))
+                     .Input(FakeInput(dtype))
+                     .Attr("T", dtype)
+                     .Attr("epsilon", epsilon)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(FusedLayerNormOpTest, Float) {
+  const float epsilon = 0.001f;
+  MakeOp(DT_FLOAT, epsilon);
+  const std::vector<float> x = {1, 2, 3, 4, -1, 0, 5, 8};
+  const std::vector<float> scale = {1, 2, 0.5, -1};
+  const std::vector<float> offset = {0, 1, -1, 0.5};
+  AddInputFromArray<float>(TensorShape({2, 4}), x);
+  AddInputFromArray<float>(TensorShape({4}), scale);
+  AddInputFromArray<float>(TensorShape({4}), offset);
+  TF_ASSERT_OK(RunOpKernel());
+
+  std::vector<float> expected;
+  for (int row = 0; row < 2; ++row) {
+    float mean = 0;
+    for (int i = 0; i < 4; ++i) mean += x[row * 4 + i] / 4;
+    float variance = 0;
+    for (int i = 0; i < 4; ++i) {
+      variance += (x[row * 4 + i] - mean) * (x[row * 4 + i] - mean) / 4;
+    }
+    for (int i = 0; i < 4; ++i) {
+      const float normalized =
+          (x[row * 4 + i] - mean) / std::sqrt(variance + epsilon);
+      expected.push_back(normalized * scale[i] + offset[i]);
+    }
+  }
+  Tensor expected_tensor(DT_FLOAT, TensorShape({2, 4}));
+  test::FillValues<float>(&expected_tensor, expected);
+  test::ExpectClose(expected_tensor, *GetOutput(0), /*atol=*/1e-5);
+}
+
+TEST_F(FusedLayerNormOpTest, ConstantRowsAreNormalizedToOffset) {
+  MakeOp(DT_FLOAT, 0.001f);
+  AddInputFromArray<float>(TensorShape({1, 2, 3}), {3, 3, 3, -2, -2, -2});
+  AddInputFromArray<float>(TensorShape({3}), {1, 1, 1});
+  AddInputFromArray<float>(TensorShape({3}), {0.5, 1, 1.5});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(DT_FLOAT, TensorShape({1, 2, 3}));
+  test::FillValues<float>(&expected, {0.5, 1, 1.5, 0.5, 1, 1.5});
+  test::ExpectClose(expected, *GetOutput(0));
+}
+
+TEST_F(FusedLayerNormOpTest, RejectsMismatchedScale) {
+  MakeOp(DT_FLOAT, 0.001f);
+  AddInputFromArray<float>(TensorShape({2, 2}), {1, 2, 3, 4});
+  AddInputFromArray<float>(TensorShape({3}), {1, 1, 1});
+  AddInputFromArray<float>(TensorShape({2}), {0, 0});
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
+// Performance benchmarks below.
+
+static Tensor RandomTensor(const TensorShape& shape) {
+  Tensor t(DT_FLOAT, shape);
+  t.flat<float>().setRandom();
+  return t;
+}
+
+// Layer normalization as emitted by Keras, one node per operation.
+static Graph* LayerNormChain(int rows, int depth) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* x = test::graph::Constant(g, RandomTensor(TensorShape({rows, depth})));
+  Node* scale = test::graph::Constant(g, RandomTensor(TensorShape({depth})));
+  Node* offset = test::graph::Constant(g, RandomTensor(TensorShape({depth})));
+  Node* axes = test::graph::Constant(g, test::AsScalar<int32>(1));
+  Node* epsilon = test::graph::Constant(g, test::AsScalar<float>(0.001f));
+
+  Node* mean = test::graph::Reduce(g, "Mean", x, axes, /*keep_dims=*/true);
+  Node* squared_difference =
+      test::graph::Binary(g, "SquaredDifference", x, mean);
+  Node* variance = test::graph::Reduce(g, "Mean", squared_difference, axes,
+                                       /*keep_dims=*/true);
+  Node* rsqrt = test::graph::Unary(
+      g, "Rsqrt", test::graph::Binary(g, "AddV2", variance, epsilon));
+  Node* multiplier = test::graph::Binary(g, "Mul", rsqrt, scale);
+  Node* centered = test::graph::Binary(g, "Mul", x, multiplier);
+  Node* shift = test::graph::Binary(
+      g, "Sub", offset, test::graph::Binary(g, "Mul", mean, multiplier));
+  test::graph::Binary(g, "AddV2", centered, shift);
+  return g;
+}
+
+static Graph* FusedLayerNorm(int rows, int depth) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* x = test::graph::Constant(g, RandomTensor(TensorShape({rows, depth})));
+  Node* scale = test::graph::Constant(g, RandomTensor(TensorShape({depth})));
+  Node* offset = test::graph::Constant(g, RandomTensor(TensorShape({depth})));
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "_FusedLayerNorm")
+                  .Input(x)
+                  .Input(scale)
+                  .Input(offset)
+                  .Attr("T", DT_FLOAT)
+                  .Attr("epsilon", 0.001f)
+                  .Finalize(g, &ret));
+  return g;
+}
+
+#define BM_LayerNorm(R, D, kind)                                              \
+  static void BM_LayerNorm##_##kind##_##R##_##D(                              \
+      ::testing::benchmark::State& state) {                                   \
+    test::Benchmark("cpu", kind(R, D), /*old_benchmark_api*/ false)           \
+        .Run(state);                                                          \
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * R * D); \
+  }                                                                           \
+  BENCHMARK(BM_LayerNorm##_##kind##_##R##_##D)->UseRealTime();
+
+// BenchmarkName(rows, depth, kind)
+
+BM_LayerNorm(128, 768, LayerNormChain);
+BM_LayerNorm(128, 768, FusedLayerNorm);
+
+BM_LayerNorm(4096, 768, LayerNormChain);
+BM_LayerNorm(4096, 768, FusedLayerNorm);
+
+BM_LayerNorm(4096, 1024, LayerNormChain);
+BM_LayerNorm(4096, 1024, FusedLayerNorm);
+
+}  // namespace
+}  // namespace tensorflow
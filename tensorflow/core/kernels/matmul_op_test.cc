@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <cmath>
 #include <functional>
 #include <string>
 
@@ -420,6 +421,54 @@ using FusedBiasAddDataTypes = ::testing::Types<float, Eigen::half>;
 INSTANTIATE_TYPED_TEST_SUITE_P(Test, FusedMatMulWithBiasOpTest,
                                FusedBiasAddDataTypes);
 
+// Gelu is not a TensorFlow op, so the fused CPU kernel is compared against
+// MatMul+BiasAdd with Gelu applied on the host.
+class FusedMatMulWithGeluOpTest : public FusedMatMulOpTest<float> {
+ protected:
+  void VerifyMatMulWithGelu(int m, int k, int n, bool transpose_a,
+                            bool approximate) {
+    Tensor lhs(DT_FLOAT, {transpose_a ? k : m, transpose_a ? m : k});
+    lhs.flat<float>().setRandom();
+    Tensor rhs(DT_FLOAT, {k, n});
+    rhs.flat<float>().setRandom();
+    rhs.flat<float>() -= rhs.flat<float>().constant(0.5f);
+    Tensor bias(DT_FLOAT, {n});
+    bias.flat<float>().setRandom();
+    bias.flat<float>() -= bias.flat<float>().constant(0.5f);
+
+    Tensor with_bias;
+    RunMatMulWithBias(lhs, rhs, bias, transpose_a, /*transpose_b=*/false,
+                      &with_bias);
+    Tensor expected(DT_FLOAT, with_bias.shape());
+    const auto gelu = [approximate](float x) {
+      if (approximate) {
+        return 0.5f * x *
+               (1.0f + std::tanh(0.7978846f * (x + 0.044715f * x * x * x)));
+      }
+      return 0.5f * x * (1.0f + std::erf(x * 0.7071068f));
+    };
+    expected.flat<float>() = with_bias.flat<float>().unaryExpr(gelu);
+
+    Tensor fused;
+    RunFusedMatMulOp(lhs, rhs, {bias},
+                     {"BiasAdd", approximate ? "GeluApproximate" : "GeluExact"},
+                     transpose_a, /*transpose_b=*/false, &fused);
+    test::ExpectClose(expected, fused, /*atol=*/1e-5);
+  }
+};
+
+TEST_F(FusedMatMulWithGeluOpTest, GeluApproximate) {
+  VerifyMatMulWithGelu(256, 128, 64, false, /*approximate=*/true);
+  VerifyMatMulWithGelu(256, 128, 64, true, /*approximate=*/true);
+  VerifyMatMulWithGelu(1, 256, 256, false, /*approximate=*/true);
+}
+
+TEST_F(FusedMatMulWithGeluOpTest, GeluExact) {
+  VerifyMatMulWithGelu(256, 128, 64, false, /*approximate=*/false);
+  VerifyMatMulWithGelu(256, 128, 64, true, /*approximate=*/false);
+  VerifyMatMulWithGelu(1, 256, 256, false, /*approximate=*/false);
+}
+
 //----------------------------------------------------------------------------//
 // Performance benchmarks are below.                                          //
 //----------------------------------------------------------------------------//
@@ -33,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/tensor_bundle/shared_tensor_store.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
@@ -303,9 +304,14 @@ struct RestoreOp {
     Tensor* restored_tensor;
     if (shape_and_slice.empty()) {
       // Lookup the full tensor.
-      TF_RETURN_IF_ERROR(
-          context->allocate_output(idx, restored_full_shape, &restored_tensor));
-      TF_RETURN_IF_ERROR(reader->Lookup(tensor_name, restored_tensor));
+      if (SharedTensorStore::IsEnabled()) {
+        TF_RETURN_IF_ERROR(restore_shared(reader, restored_full_shape));
+        restored_tensor = context->mutable_output(idx);
+      } else {
+        TF_RETURN_IF_ERROR(context->allocate_output(idx, restored_full_shape,
+                                                    &restored_tensor));
+        TF_RETURN_IF_ERROR(reader->Lookup(tensor_name, restored_tensor));
+      }
     } else {
       // Lookup the slice.
       TensorShape parsed_full_shape;
@@ -349,6 +355,23 @@ struct RestoreOp {
     return OkStatus();
   }
 
+  // Restores the full tensor and outputs an identical tensor restored earlier
+  // in this process, e.g. by another model, in its place if there is one.
+  Status restore_shared(BundleReader* reader, const TensorShape& shape) {
+    Tensor restored_tensor;
+    TF_RETURN_IF_ERROR(context->allocate_temp(dtype, shape, &restored_tensor));
+    TF_RETURN_IF_ERROR(reader->Lookup(tensor_name, &restored_tensor));
+    SharedTensorStore* store = SharedTensorStore::Global();
+    uint32 masked_crc32c;
+    if (reader->LookupChecksum(tensor_name, &masked_crc32c).ok()) {
+      context->set_output(idx,
+                          store->Canonicalize(restored_tensor, masked_crc32c));
+    } else {
+      context->set_output(idx, store->Canonicalize(restored_tensor));
+    }
+    return OkStatus();
+  }
+
   OpKernelContext* context;
   int idx;
   string tensor_name;
@@ -260,6 +260,72 @@ Do not invoke this operator directly in Python. A fusion optimization is
 expected to create these operators.
 )doc");
 
+REGISTER_OP("_FusedLayerNorm")
+    .Input("x: T")
+    .Input("scale: T")
+    .Input("offset: T")
+    .Output("y: T")
+    .Attr("T: {float, bfloat16, half}")
+    .Attr("epsilon: float = 0.001")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle x;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &x));
+      DimensionHandle depth = c->Dim(x, -1);
+      for (int i = 1; i <= 2; ++i) {
+        ShapeHandle vec;
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 1, &vec));
+        TF_RETURN_IF_ERROR(c->Merge(depth, c->Dim(vec, 0), &depth));
+      }
+      c->set_output(0, x);
+      return OkStatus();
+    })
+    .Doc(R"doc(
+Internal layer normalization over the innermost dimension of `x`: reserved for
+internal use.
+
+Do not invoke this operator directly in Python. A fusion optimization is
+expected to create these operators.
+)doc");
+
+REGISTER_OP("_FusedScaledDotProductAttention")
+    .Input("query: T")
+    .Input("key: T")
+    .Input("value: T")
+    .Input("mask: num_masks * T")
+    .Output("output: T")
+    .Attr("T: {float}")
+    .Attr("scale: float = 1.0")
+    .Attr("num_masks: int >= 0 = 0")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle query;
+      ShapeHandle key;
+      ShapeHandle value;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 3, &query));
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(1), 3, &key));
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(2), 3, &value));
+      // Query and key share the depth, key and value the sequence length.
+      DimensionHandle unused;
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(query, -1), c->Dim(key, -1), &unused));
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(key, -2), c->Dim(value, -2), &unused));
+      ShapeHandle batch_and_rows;
+      TF_RETURN_IF_ERROR(c->Subshape(query, 0, -1, &batch_and_rows));
+      ShapeHandle output;
+      TF_RETURN_IF_ERROR(c->Concatenate(
+          batch_and_rows, c->Vector(c->Dim(value, -1)), &output));
+      c->set_output(0, output);
+      return OkStatus();
+    })
+    .Doc(R"doc(
+Internal Softmax(scale * query * key^T + mask) * value: reserved for internal
+use. The batch dimensions of `query`, `key` and `value` must be equal, and the
+mask, if any, must be broadcastable to the shape of the attention logits.
+
+Do not invoke this operator directly in Python. A fusion optimization is
+expected to create these operators.
+)doc");
+
 REGISTER_OP("FusedBatchNormGrad")
     .Input("y_backprop: T")
     .Input("x: T")
@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/platform/threadpool_interface.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/tfrt/fallback/cost_recorder.h"
+#include "tensorflow/core/tfrt/fallback/op_dispatch_policy.h"
 #include "tensorflow/core/tfrt/fallback/op_kernel_runner.h"
 #include "tensorflow/core/tfrt/graph_executor/config.h"
 #include "tensorflow/core/tfrt/utils/fallback_tensor.h"
@@ -163,6 +164,16 @@ class KernelFallbackCompatRequestState {
     cost_recorder_ = cost_recorder;
   }
 
+  // Nullable. If set, synchronous kernels selected by the policy are run on
+  // the inter-op thread pool.
+  const tensorflow::tfrt_stub::OpDispatchPolicy* op_dispatch_policy() const {
+    return op_dispatch_policy_;
+  }
+  void set_op_dispatch_policy(
+      const tensorflow::tfrt_stub::OpDispatchPolicy* op_dispatch_policy) {
+    op_dispatch_policy_ = op_dispatch_policy;
+  }
+
   // Nullable.
   tfrt::ResourceContext* client_graph_resource_context() const {
     return client_graph_resource_context_;
@@ -220,6 +231,8 @@ class KernelFallbackCompatRequestState {
   // Records the cost per op.
   tensorflow::tfrt_stub::CostRecorder* cost_recorder_ = nullptr;
 
+  const tensorflow::tfrt_stub::OpDispatchPolicy* op_dispatch_policy_ = nullptr;
+
   tfrt::ResourceContext* client_graph_resource_context_ = nullptr;
 
   const tensorflow::tfrt_stub::RuntimeConfig* runtime_config_ = nullptr;
@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/types.h"
@@ -75,6 +76,12 @@ using ::tfrt::Chain;
 using ::tfrt::RCReference;
 using ::tfrt::string_view;
 
+auto* dispatched_ops = tensorflow::monitoring::Counter<1>::New(
+    "/tensorflow/tfrt/fallback/dispatched_ops",
+    "The number of synchronous fallback kernels dispatched to the inter-op "
+    "thread pool by speculative dispatch.",
+    "model_name");
+
 void KernelFallbackEmitError(
     const tfrt::ExecutionContext& exec_ctx,
     const KernelFallbackCompatRequestState* fallback_request_state,
@@ -254,6 +261,69 @@ static void KernelFallbackExecuteCompatSyncInternal(
   if (op_chain) *op_chain = tfrt::MakeAvailableAsyncValueRef<tfrt::Chain>();
 }
 
+// Execute a synchronous tensorflow::OpKernel on the inter-op thread pool so
+// that the caller thread can proceed to independent kernels. `kernel_runner` is
+// expected to be alive until the execution finishes. The results are set on
+// the worker thread, so cheap kernels that only depend on them run there inline
+// instead of being dispatched separately.
+template <typename TensorType>
+static void KernelFallbackExecuteCompatDispatchInternal(
+    const tfrt::ExecutionContext& exec_ctx, OpKernelRunState* run_state,
+    const OpKernelRunner& kernel_runner,
+    tfrt::AsyncValueRef<tfrt::Chain>* op_chain,
+    llvm::MutableArrayRef<tfrt::RCReference<tfrt::AsyncValue>> results) {
+  auto chain = tfrt::MakeUnconstructedAsyncValueRef<tfrt::Chain>();
+  if (op_chain) *op_chain = chain.CopyRef();
+
+  struct DispatchState {
+    explicit DispatchState(const OpKernelRunState& rs)
+        : run_state(rs.input_tf_tensor_values, rs.params) {}
+
+    OpKernelRunState run_state;
+    tfrt::AsyncValueRef<tfrt::Chain> chain;
+    llvm::SmallVector<tfrt::AsyncValueRef<TensorType>, 4> result_refs;
+  };
+
+  DCHECK_EQ(results.size(), kernel_runner.op_kernel()->num_outputs());
+  // Copy the inputs as the thread local run state is reused by the next kernel
+  // on this thread.
+  auto dispatch_state = std::make_shared<DispatchState>(*run_state);
+  dispatch_state->chain = std::move(chain);
+  dispatch_state->result_refs.reserve(results.size());
+  for (auto& result : results) {
+    dispatch_state->result_refs.emplace_back(
+        tfrt::MakeUnconstructedAsyncValueRef<TensorType>());
+    result = dispatch_state->result_refs.back().CopyRef();
+  }
+
+  tfrt::EnqueueWork(exec_ctx, [dispatch_state = std::move(dispatch_state),
+                               exec_ctx, &kernel_runner]() {
+    OpKernelContext context(&dispatch_state->run_state.params,
+                            dispatch_state->result_refs.size());
+    kernel_runner.Run(&context);
+
+    if (!context.status().ok()) {
+      auto diag = tfrt::EmitError(
+          exec_ctx,
+          absl::Status(context.status().code(),
+                       tfrt::StrCat("error running kernel fallback kernel ",
+                                    kernel_runner.op_kernel()->name(), ": ",
+                                    context.status().message())));
+      for (auto& result : dispatch_state->result_refs) {
+        result.SetError(diag.status);
+      }
+      dispatch_state->chain.SetError(diag.status);
+      return;
+    }
+
+    for (int i = 0; i < context.num_outputs(); ++i) {
+      dispatch_state->result_refs[i].emplace(
+          std::move(*context.mutable_output(i)));
+    }
+    dispatch_state->chain.emplace();
+  });
+}
+
 tfrt::AsyncValueRef<tfrt::Chain> KernelFallbackExecuteCompatCoreRuntimeDispatch(
     const tfrt::ExecutionContext& exec_ctx, tfrt::string_view op_name,
     tfrt::string_view device_name, llvm::ArrayRef<tfrt::Tensor*> arguments,
@@ -412,7 +482,7 @@ TF_ATTRIBUTE_ALWAYS_INLINE static void KernelFallbackExecuteOpInternal(
     const FallbackKernelAttributeFrame& frame,
     const tfrt::ExecutionContext& exec_ctx,
     const KernelFallbackCompatRequestState& fallback_request_state,
-    const OpKernelRunner& kernel_runner, bool is_async,
+    const OpKernelRunner& kernel_runner, bool is_async, bool dispatch,
     tensorflow::Device* device) {
   tensorflow::profiler::TraceMe trace_me([&]() -> std::string {
     if (kernel_runner.op_kernel()) {
@@ -464,6 +534,10 @@ TF_ATTRIBUTE_ALWAYS_INLINE static void KernelFallbackExecuteOpInternal(
     KernelFallbackExecuteCompatAsyncInternal<
         tensorflow::tfrt_stub::FallbackTensor>(
         exec_ctx, &run_state, kernel_runner, op_chain, results);
+  } else if (dispatch) {
+    KernelFallbackExecuteCompatDispatchInternal<
+        tensorflow::tfrt_stub::FallbackTensor>(
+        exec_ctx, &run_state, kernel_runner, op_chain, results);
   } else {
     KernelFallbackExecuteCompatSyncInternal<
         tensorflow::tfrt_stub::FallbackTensor>(
@@ -510,9 +584,24 @@ TF_ATTRIBUTE_ALWAYS_INLINE static void KernelFallbackExecuteOp(
   auto* device =
       GetDeviceFromFallbackState(*fallback_request_state, *kernel_runner);
 
+  // Expensive synchronous kernels are dispatched to the inter-op thread pool
+  // based on the measured op costs. This is skipped while costs are being
+  // recorded, so that the recorded costs do not include queuing delays.
+  const auto* op_dispatch_policy = fallback_request_state->op_dispatch_policy();
+  const bool dispatch = !kernel_runner->IsAsync() &&
+                        cost_recorder == nullptr &&
+                        op_dispatch_policy != nullptr &&
+                        op_dispatch_policy->ShouldDispatch(
+                            frame.op_key().GetValue());
+  if (dispatch) {
+    dispatched_ops
+        ->GetCell(fallback_request_state->session_metadata().name())
+        ->IncrementBy(1);
+  }
+
   KernelFallbackExecuteOpInternal(args, results, op_chain, frame, exec_ctx,
                                   *fallback_request_state, *kernel_runner,
-                                  kernel_runner->IsAsync(), device);
+                                  kernel_runner->IsAsync(), dispatch, device);
 
   // Finish recording the op execution time, given a non-null
   // cost recorder.
@@ -714,7 +803,7 @@ void KernelFallbackExecuteOpCustomAllocatorInternal(
     KernelFallbackExecuteOpInternal(args, results,
                                     /*op_chain=*/op_chain, attr_frame, exec_ctx,
                                     *fallback_request_state, *kernel_runner,
-                                    /*is_async=*/false,
+                                    /*is_async=*/false, /*dispatch=*/false,
                                     &device_with_custom_allocator);
   } else {
     auto device_with_custom_allocator =
@@ -729,7 +818,7 @@ void KernelFallbackExecuteOpCustomAllocatorInternal(
     KernelFallbackExecuteOpInternal(args, results,
                                     /*op_chain=*/op_chain, attr_frame, exec_ctx,
                                     *fallback_request_state, *kernel_runner,
-                                    /*is_async=*/true,
+                                    /*is_async=*/true, /*dispatch=*/false,
                                     device_with_custom_allocator.get());
 
     DCHECK(op_chain);
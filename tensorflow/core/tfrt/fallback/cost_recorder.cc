@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/tfrt/fallback/cost_recorder.h"
 
+#include <algorithm>
 #include <limits>
 #include <string>
 
@@ -51,6 +52,18 @@ uint64_t CostRecorder::GetCost(int64_t op_key) const {
   return r;
 }
 
+absl::flat_hash_map<int64_t, uint64_t> CostRecorder::GetCosts() const {
+  tf_shared_lock l(op_cost_map_mutex_);
+  absl::flat_hash_map<int64_t, uint64_t> costs;
+  costs.reserve(op_cost_map_.size());
+  for (const auto& [op_key, op_cost] : op_cost_map_) {
+    costs[op_key] = std::max(static_cast<uint64_t>(1),
+                             static_cast<uint64_t>(op_cost.first /
+                                                   op_cost.second));
+  }
+  return costs;
+}
+
 Status CostRecorder::WriteToFile() const {
   OpCostMapProto op_cost_map_proto;
   {
@@ -42,6 +42,10 @@ class CostRecorder {
   // otherwise adding op costs would cause overflow.
   uint64_t GetCost(int64_t op_key) const;
 
+  // Returns the normalized average execution durations of all recorded ops,
+  // keyed by `op_key`.
+  absl::flat_hash_map<int64_t, uint64_t> GetCosts() const;
+
   // Writes the op cost map (in format of `OpCostMapProto`) to a file specified
   // by the env var name `MesuredCostPathEnvVarName()`.
   // TODO(b/263837451): Fix the op_key unstableness during serialization.
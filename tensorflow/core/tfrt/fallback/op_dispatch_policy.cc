@@ -0,0 +1,36 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/tfrt/fallback/op_dispatch_policy.h"
+
+#include <cstdint>
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/tfrt/fallback/cost_recorder.h"
+
+namespace tensorflow {
+namespace tfrt_stub {
+
+OpDispatchPolicy::OpDispatchPolicy(const CostRecorder& cost_recorder,
+                                   uint64_t min_dispatch_cost) {
+  for (const auto& [op_key, cost] : cost_recorder.GetCosts()) {
+    if (cost >= min_dispatch_cost) dispatched_op_keys_.insert(op_key);
+  }
+  VLOG(1) << "Dispatching " << dispatched_op_keys_.size() << " of "
+          << cost_recorder.size()
+          << " fallback ops to the inter-op thread pool.";
+}
+
+}  // namespace tfrt_stub
+}  // namespace tensorflow
@@ -0,0 +1,54 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_TFRT_FALLBACK_OP_DISPATCH_POLICY_H_
+#define TENSORFLOW_CORE_TFRT_FALLBACK_OP_DISPATCH_POLICY_H_
+
+#include <cstdint>
+
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/core/tfrt/fallback/cost_recorder.h"
+
+namespace tensorflow {
+namespace tfrt_stub {
+
+// Decides at run time which synchronous fallback kernels are dispatched to the
+// inter-op thread pool instead of running inline on the caller thread, so that
+// expensive ops on independent branches of a graph run concurrently. Ops whose
+// measured cost does not amortize a dispatch stay inline, and so do ops without
+// a recorded cost.
+//
+// Thread-safe, as it is immutable after construction.
+class OpDispatchPolicy {
+ public:
+  // Dispatches the ops whose average cost in `cost_recorder` is at least
+  // `min_dispatch_cost`. Costs are in the same unit as recorded, i.e. CPU clock
+  // cycles for fallback kernels.
+  OpDispatchPolicy(const CostRecorder& cost_recorder,
+                   uint64_t min_dispatch_cost);
+
+  bool ShouldDispatch(int64_t op_key) const {
+    return dispatched_op_keys_.contains(op_key);
+  }
+
+  size_t num_dispatched_ops() const { return dispatched_op_keys_.size(); }
+
+ private:
+  absl::flat_hash_set<int64_t> dispatched_op_keys_;
+};
+
+}  // namespace tfrt_stub
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_TFRT_FALLBACK_OP_DISPATCH_POLICY_H_
@@ -0,0 +1,48 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/tfrt/fallback/op_dispatch_policy.h"
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/tfrt/fallback/cost_recorder.h"
+
+namespace tensorflow {
+namespace tfrt_stub {
+namespace {
+
+TEST(OpDispatchPolicyTest, DispatchesOnlyExpensiveOps) {
+  CostRecorder recorder;
+  recorder.RecordCost(/*op_key=*/1, 100);
+  recorder.RecordCost(/*op_key=*/2, 5000);
+  // The average cost of op 3 is exactly the threshold.
+  recorder.RecordCost(/*op_key=*/3, 500);
+  recorder.RecordCost(/*op_key=*/3, 1500);
+
+  OpDispatchPolicy policy(recorder, /*min_dispatch_cost=*/1000);
+  EXPECT_EQ(policy.num_dispatched_ops(), 2);
+  EXPECT_FALSE(policy.ShouldDispatch(1));
+  EXPECT_TRUE(policy.ShouldDispatch(2));
+  EXPECT_TRUE(policy.ShouldDispatch(3));
+}
+
+TEST(OpDispatchPolicyTest, OpsWithoutCostStayInline) {
+  CostRecorder recorder;
+  OpDispatchPolicy policy(recorder, /*min_dispatch_cost=*/0);
+  EXPECT_EQ(policy.num_dispatched_ops(), 0);
+  EXPECT_FALSE(policy.ShouldDispatch(1));
+}
+
+}  // namespace
+}  // namespace tfrt_stub
+}  // namespace tensorflow
@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_TFRT_GRAPH_EXECUTOR_GRAPH_EXECUTION_OPTIONS_H_
 #define TENSORFLOW_CORE_TFRT_GRAPH_EXECUTOR_GRAPH_EXECUTION_OPTIONS_H_
 
+#include <cstdint>
 #include <functional>
 #include <optional>
 #include <ostream>
@@ -100,6 +101,41 @@ struct GraphExecutionOptions {
 
   CostAnalysisOptions cost_analysis_options;
 
+  // Options for dispatching expensive synchronous fallback kernels to the
+  // inter-op thread pool at run time, so that independent branches of a graph
+  // run concurrently instead of one after another on the caller thread. The
+  // op costs come from online cost analysis, so this only takes effect after
+  // the first cost update when `cost_analysis_options` is enabled. Only the
+  // BEF executor is supported.
+  struct SpeculativeDispatchOptions {
+    bool enable = false;
+
+    // Ops whose average measured cost, in CPU clock cycles, is below this
+    // threshold run inline as the dispatch overhead would outweigh the gain.
+    uint64_t min_dispatch_cost = 100000;
+  };
+
+  SpeculativeDispatchOptions speculative_dispatch_options;
+
+  // Options for memoizing the outputs of client graphs. The cache is only
+  // created for graphs that are idempotent, i.e. graphs without stateful ops
+  // other than read-only ones such as variable reads and table lookups.
+  struct ResultCacheOptions {
+    // If true, each eligible client graph gets its own result cache keyed by a
+    // fingerprint of its input tensors. Requests with resource or variant
+    // inputs always bypass the cache. Outputs served from the cache share
+    // their buffers with it and must not be modified in place.
+    bool enable = false;
+
+    // The maximum total size of the cached output tensors per client graph.
+    int64_t capacity_bytes = 64 << 20;
+
+    // Cached outputs older than this are recomputed.
+    absl::Duration ttl = absl::InfiniteDuration();
+  };
+
+  ResultCacheOptions result_cache_options;
+
   // If true, the MLRT interpreter will be used instead of the BEF executor.
   // This option is experimental.
   bool enable_mlrt = false;
@@ -134,6 +170,10 @@ struct GraphExecutionRunOptions {
   // specified graph is not compiled, the execution will return an error.
   bool disable_compilation = false;
 
+  // If true, the result cache (if enabled in `GraphExecutionOptions`) is
+  // neither consulted nor populated for this run.
+  bool bypass_result_cache = false;
+
   std::function<void(absl::flat_hash_map<std::string, tensorflow::Tensor>)>
       streamed_output_callback;
 };
@@ -71,6 +71,7 @@ limitations under the License.
 #include "tensorflow/core/tfrt/graph_executor/executable_context.h"
 #include "tensorflow/core/tfrt/graph_executor/export_mlir.h"
 #include "tensorflow/core/tfrt/graph_executor/graph_execution_options.h"
+#include "tensorflow/core/tfrt/graph_executor/result_cache.h"
 #include "tensorflow/core/tfrt/graph_executor/sync_resource_state.h"
 #include "tensorflow/core/tfrt/mlrt/bytecode/bytecode.h"
 #include "tensorflow/core/tfrt/mlrt/bytecode/executable.h"
@@ -85,6 +86,7 @@ limitations under the License.
 #include "tensorflow/core/tfrt/utils/fallback_tensor.h"
 #include "tensorflow/core/tfrt/utils/utils.h"
 #include "tsl/platform/errors.h"
+#include "tsl/platform/fingerprint.h"
 #include "tsl/platform/refcount.h"
 #include "tsl/platform/statusor.h"
 #include "tsl/profiler/lib/traceme.h"
@@ -202,7 +204,7 @@ StatusOr<std::unique_ptr<RequestInfo>> CreateRequestInfo(
     tensorflow::tfrt_stub::FallbackState& fallback_state,
     const tensorflow::ProcessFunctionLibraryRuntime&
         process_function_library_runtime,
-    CostRecorder* cost_recorder) {
+    CostRecorder* cost_recorder, const OpDispatchPolicy* op_dispatch_policy) {
   auto request_info = std::make_unique<RequestInfo>();
 
   DCHECK(options.runtime);
@@ -250,6 +252,7 @@ StatusOr<std::unique_ptr<RequestInfo>> CreateRequestInfo(
               &process_function_library_runtime);
 
   fallback_request_state.set_cost_recorder(cost_recorder);
+  fallback_request_state.set_op_dispatch_policy(op_dispatch_policy);
   fallback_request_state.set_client_graph_resource_context(
       client_graph_resource_context);
   fallback_request_state.set_runtime_config(&options.runtime_config);
@@ -287,13 +290,14 @@ tensorflow::Status GraphExecutionRunOnFunction(
         process_function_library_runtime,
     tfrt::RequestDeadlineTracker* req_deadline_tracker,
     std::optional<StreamCallbackId> stream_callback_id,
-    CostRecorder* cost_recorder) {
+    CostRecorder* cost_recorder, const OpDispatchPolicy* op_dispatch_policy) {
   TF_ASSIGN_OR_RETURN(
       auto request_info,
       CreateRequestInfo(options, run_options, run_options.work_queue,
                         resource_context, client_graph_resource_context,
                         runner_table, resource_array, fallback_state,
-                        process_function_library_runtime, cost_recorder));
+                        process_function_library_runtime, cost_recorder,
+                        op_dispatch_policy));
 
   int64_t request_id = request_info->tfrt_request_context->id();
   // The top level traceme root for this request. The thread pool used later
@@ -598,33 +602,58 @@ tensorflow::Status GraphExecutor::Run(
     }
   }
 
-  // Possibly record costs, depending on the particular setting of
-  // `CostAnalysisOptions`.
-  auto now = absl::Now() + simulated_duration_;
-  bool do_recompilation;
-  CostRecorder* cost_recorder =
-      loaded_client_graph.MaybeGetCostRecorder(now, &do_recompilation);
-
   std::vector<tensorflow::Tensor> flat_outputs;
-  TF_RETURN_IF_ERROR(GraphExecutionRunOnFunction(
-      options_, run_options, loaded_client_graph.name(),
-      loaded_client_graph.symbol_uids(), func, loaded_executable, flat_inputs,
-      &flat_outputs, resource_context_.get(),
-      &executable_context->resource_context,
-      &loaded_client_graph.runner_table(),
-      &loaded_client_graph.resource_array(), runtime(), fallback_state(),
-      loaded_client_graph.process_function_library_runtime(),
-      &req_deadline_tracker_, loaded_client_graph.stream_callback_id(),
-      cost_recorder));
-
-  if (do_recompilation) {
-    TF_RETURN_IF_ERROR(
-        loaded_client_graph.UpdateCost(*cost_recorder, runtime()));
-    tensorflow::mutex_lock l(num_recompilations_mu_);
-    num_recompilations_ += 1;
+
+  // Serve the request from the result cache if the same inputs were seen
+  // before. Resource and variant inputs cannot be fingerprinted by value, so
+  // such requests are always executed.
+  ResultCache* result_cache = run_options.bypass_result_cache ||
+                                      !AreInputTensorsCacheable(flat_inputs)
+                                  ? nullptr
+                                  : loaded_client_graph.result_cache();
+  tsl::Fprint128 result_cache_key = {0, 0};
+  bool is_result_cache_hit = false;
+  if (result_cache != nullptr) {
+    result_cache_key = FingerprintInputTensors(flat_inputs);
+    if (auto cached_outputs =
+            result_cache->Lookup(result_cache_key, absl::Now())) {
+      flat_outputs = *std::move(cached_outputs);
+      is_result_cache_hit = true;
+    }
   }
-  if (cost_recorder != nullptr) {
-    loaded_client_graph.UpdateCostAnalysisData(now, do_recompilation);
+
+  if (!is_result_cache_hit) {
+    // Possibly record costs, depending on the particular setting of
+    // `CostAnalysisOptions`.
+    auto now = absl::Now() + simulated_duration_;
+    bool do_recompilation;
+    CostRecorder* cost_recorder =
+        loaded_client_graph.MaybeGetCostRecorder(now, &do_recompilation);
+    const auto op_dispatch_policy = loaded_client_graph.op_dispatch_policy();
+
+    TF_RETURN_IF_ERROR(GraphExecutionRunOnFunction(
+        options_, run_options, loaded_client_graph.name(),
+        loaded_client_graph.symbol_uids(), func, loaded_executable,
+        flat_inputs, &flat_outputs, resource_context_.get(),
+        &executable_context->resource_context,
+        &loaded_client_graph.runner_table(),
+        &loaded_client_graph.resource_array(), runtime(), fallback_state(),
+        loaded_client_graph.process_function_library_runtime(),
+        &req_deadline_tracker_, loaded_client_graph.stream_callback_id(),
+        cost_recorder, op_dispatch_policy.get()));
+
+    if (do_recompilation) {
+      TF_RETURN_IF_ERROR(
+          loaded_client_graph.UpdateCost(*cost_recorder, runtime()));
+      tensorflow::mutex_lock l(num_recompilations_mu_);
+      num_recompilations_ += 1;
+    }
+    if (cost_recorder != nullptr) {
+      loaded_client_graph.UpdateCostAnalysisData(now, do_recompilation);
+    }
+    if (result_cache != nullptr) {
+      result_cache->Insert(result_cache_key, flat_outputs, absl::Now());
+    }
   }
   // Create the outputs from the actual function results, which are sorted
   // according to the output tensor names.
@@ -657,9 +686,11 @@ GraphExecutor::ImportAndCompileClientGraph(
   // compilation.
   auto context = std::make_unique<mlir::MLIRContext>(
       registry, mlir::MLIRContext::Threading::DISABLED);
+  bool is_idempotent = false;
   ASSIGN_OR_RETURN_IN_IMPORT(
       auto flib_def_and_module,
-      ImportClientGraphToMlirModule(client_graph, context.get()));
+      ImportClientGraphToMlirModule(client_graph, context.get(),
+                                    &is_idempotent));
   auto& [flib_def, module] = flib_def_and_module;
 
   // If the module contains a Restore op, then there should be one input,
@@ -749,11 +780,23 @@ GraphExecutor::ImportAndCompileClientGraph(
             << "). Took " << absl::ToInt64Milliseconds(compile_duration)
             << " ms. Client graph name: " << client_graph.name;
 
+  // Streamed outputs are side effects, so graphs that stream are not cached.
+  std::unique_ptr<ResultCache> result_cache;
+  const auto& result_cache_options = options_.result_cache_options;
+  if (result_cache_options.enable && is_idempotent &&
+      checkpoint_path.empty() && !stream_callback_id.has_value()) {
+    result_cache = std::make_unique<ResultCache>(
+        options_.model_metadata.name(), client_graph.name,
+        result_cache_options.capacity_bytes, result_cache_options.ttl);
+    LOG(INFO) << "TFRT enabled result cache for client graph ("
+              << &client_graph << "). Client graph name: " << client_graph.name;
+  }
+
   return std::make_unique<LoadedClientGraph>(
       client_graph.name, std::move(symbol_uids), this, std::move(context),
       std::move(module_with_op_keys), std::move(module),
       std::move(executable_context), stream_callback_id,
-      !checkpoint_path.empty(), std::move(flib_def));
+      !checkpoint_path.empty(), std::move(flib_def), std::move(result_cache));
 }
 
 StatusOr<std::unique_ptr<GraphExecutor::LoadedClientGraph>>
@@ -783,8 +826,8 @@ GraphExecutor::LoadClientGraph(
 tensorflow::StatusOr<
     std::pair<FunctionLibraryDefinition, mlir::OwningOpRef<mlir::ModuleOp>>>
 GraphExecutor::ImportClientGraphToMlirModule(
-    const GraphExecutor::ClientGraph& client_graph,
-    mlir::MLIRContext* context) const {
+    const GraphExecutor::ClientGraph& client_graph, mlir::MLIRContext* context,
+    bool* is_idempotent) const {
   tensorflow::GraphImportConfig graph_import_config;
   graph_import_config.graph_func_name = client_graph.name;
   graph_import_config.prune_unused_nodes = true;
@@ -809,6 +852,11 @@ GraphExecutor::ImportClientGraphToMlirModule(
             << absl::ToInt64Milliseconds(optimized_graph.grappler_duration)
             << " ms. Client graph name: " << client_graph.name;
 
+  if (is_idempotent != nullptr && options_.result_cache_options.enable) {
+    *is_idempotent = IsGraphIdempotent(*optimized_graph.graph,
+                                       optimized_graph.graph->flib_def());
+  }
+
   // Convert the optimized graph to an MLIR module.
   TF_ASSIGN_OR_RETURN(
       auto module,
@@ -1055,12 +1103,21 @@ Status GraphExecutor::LoadedClientGraph::UpdateCost(
     new_executable_context = std::make_shared<ExecutableContext>(
         std::move(bef), std::move(bef_file));
   }
+  std::shared_ptr<const OpDispatchPolicy> new_op_dispatch_policy = nullptr;
+  const auto& speculative_dispatch_options =
+      graph_executor_->options().speculative_dispatch_options;
+  if (speculative_dispatch_options.enable &&
+      !new_executable_context->IsForMlrt()) {
+    new_op_dispatch_policy = std::make_shared<const OpDispatchPolicy>(
+        cost_recorder, speculative_dispatch_options.min_dispatch_cost);
+  }
   {
     // Swap in the new `ExecutableContext`.
     tensorflow::mutex_lock lock(executable_context_mu_);
     // TODO(b/259602527): Add test cases that fail when code is changed. E.g.,
     // add a test kernel that examines the cost.
     executable_context_ = std::move(new_executable_context);
+    op_dispatch_policy_ = std::move(new_op_dispatch_policy);
   }
   return OkStatus();
 }
@@ -1072,7 +1129,8 @@ GraphExecutor::LoadedClientGraph::LoadedClientGraph(
     mlir::OwningOpRef<mlir::ModuleOp> tfrt_mlir,
     std::shared_ptr<ExecutableContext> executable_context,
     std::optional<StreamCallbackId> stream_callback_id, bool is_restore,
-    FunctionLibraryDefinition flib_def)
+    FunctionLibraryDefinition flib_def,
+    std::unique_ptr<ResultCache> result_cache)
     : name_(std::move(name)),
       symbol_uids_(std::move(symbol_uids)),
       graph_executor_(graph_executor),
@@ -1080,6 +1138,7 @@ GraphExecutor::LoadedClientGraph::LoadedClientGraph(
       executable_context_(std::move(executable_context)),
       stream_callback_id_(stream_callback_id),
       is_restore_(is_restore),
+      result_cache_(std::move(result_cache)),
       flib_def_(std::move(flib_def)),
       pflr_(&graph_executor->fallback_state().device_manager(),
             graph_executor->fallback_state().session_options().env,
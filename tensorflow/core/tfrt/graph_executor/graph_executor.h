@@ -43,10 +43,12 @@ limitations under the License.
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/runtime_fallback/kernel/kernel_fallback_compat_request_state.h"
 #include "tensorflow/core/tfrt/fallback/cost_recorder.h"
+#include "tensorflow/core/tfrt/fallback/op_dispatch_policy.h"
 #include "tensorflow/core/tfrt/fallback/fallback_state.h"
 #include "tensorflow/core/tfrt/fallback/op_kernel_runner.h"
 #include "tensorflow/core/tfrt/graph_executor/executable_context.h"
 #include "tensorflow/core/tfrt/graph_executor/graph_execution_options.h"
+#include "tensorflow/core/tfrt/graph_executor/result_cache.h"
 #include "tensorflow/core/tfrt/graph_executor/sync_resource_state.h"
 #include "tensorflow/core/tfrt/mlrt/bytecode/function.h"
 #include "tensorflow/core/tfrt/mlrt/interpreter/context.h"
@@ -103,7 +105,8 @@ StatusOr<std::unique_ptr<RequestInfo>> CreateRequestInfo(
     OpKernelRunnerTable* runner_table,
     tfd::FallbackResourceArray* resource_array, FallbackState& fallback_state,
     const ProcessFunctionLibraryRuntime& process_function_library_runtime,
-    CostRecorder* cost_recorder = nullptr);
+    CostRecorder* cost_recorder = nullptr,
+    const OpDispatchPolicy* op_dispatch_policy = nullptr);
 
 // Runs on a function given input/output and other info.
 // Note: `resource_context` is per-graph-executor and
@@ -128,7 +131,8 @@ tensorflow::Status GraphExecutionRunOnFunction(
         process_function_library_runtime,
     tfrt::RequestDeadlineTracker* req_deadline_tracker,
     std::optional<StreamCallbackId> stream_callback_id,
-    CostRecorder* cost_recorder = nullptr);
+    CostRecorder* cost_recorder = nullptr,
+    const OpDispatchPolicy* op_dispatch_policy = nullptr);
 
 // Runs a MLRT function for executing tensorflow graphs.
 tensorflow::Status RunMlrtFunction(
@@ -156,7 +160,8 @@ class GraphExecutor {
                       mlir::OwningOpRef<mlir::ModuleOp> tfrt_mlir,
                       std::shared_ptr<ExecutableContext> executable_context,
                       std::optional<StreamCallbackId> stream_callback_id,
-                      bool is_restore, FunctionLibraryDefinition flib_def);
+                      bool is_restore, FunctionLibraryDefinition flib_def,
+                      std::unique_ptr<ResultCache> result_cache = nullptr);
 
     // Returns this instance's CostRecorder if it is time to update costs,
     // else returns nullptr. Only allows one non-null return value at a time
@@ -175,6 +180,12 @@ class GraphExecutor {
       tensorflow::mutex_lock lock(executable_context_mu_);
       return executable_context_;
     }
+    // Returns the policy for dispatching expensive fallback kernels, or nullptr
+    // if speculative dispatch is disabled or no costs were recorded yet.
+    std::shared_ptr<const OpDispatchPolicy> op_dispatch_policy() const {
+      tensorflow::mutex_lock lock(executable_context_mu_);
+      return op_dispatch_policy_;
+    }
     absl::string_view name() const { return name_; }
     const SymbolUids& symbol_uids() const { return symbol_uids_; }
 
@@ -188,6 +199,10 @@ class GraphExecutor {
 
     bool is_restore() const { return is_restore_; }
 
+    // Returns the result cache of this graph, or nullptr if result caching is
+    // disabled or the graph is not idempotent.
+    ResultCache* result_cache() const { return result_cache_.get(); }
+
     const ProcessFunctionLibraryRuntime& process_function_library_runtime()
         const {
       return pflr_;
@@ -224,10 +239,14 @@ class GraphExecutor {
     // Can be updated if online cost analysis is enabled.
     std::shared_ptr<ExecutableContext> executable_context_
         TF_GUARDED_BY(executable_context_mu_);
+    // Updated along with `executable_context_` from the recorded costs.
+    std::shared_ptr<const OpDispatchPolicy> op_dispatch_policy_
+        TF_GUARDED_BY(executable_context_mu_);
     SyncResourceState sync_resource_state_;
 
     std::optional<StreamCallbackId> stream_callback_id_;
     bool is_restore_;
+    std::unique_ptr<ResultCache> result_cache_;
     FunctionLibraryDefinition flib_def_;
     ProcessFunctionLibraryRuntime pflr_;
   };
@@ -326,7 +345,8 @@ class GraphExecutor {
   tensorflow::StatusOr<
       std::pair<FunctionLibraryDefinition, mlir::OwningOpRef<mlir::ModuleOp>>>
   ImportClientGraphToMlirModule(const GraphExecutor::ClientGraph& client_graph,
-                                mlir::MLIRContext* context) const;
+                                mlir::MLIRContext* context,
+                                bool* is_idempotent = nullptr) const;
   StatusOr<tfrt::BefBuffer> CompileMlirModuleToBef(mlir::ModuleOp module) const;
 
   tensorflow::Status InitBef(
@@ -31,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
 #include "tensorflow/core/grappler/utils/grappler_test.h"
+#include "tensorflow/core/lib/monitoring/cell_reader.h"
 #include "tensorflow/core/platform/statusor.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
 #include "tensorflow/core/tfrt/mlrt/interpreter/context.h"
@@ -368,6 +369,109 @@ class TestIsCancelledKernel : public OpKernel {
 REGISTER_KERNEL_BUILDER(Name("TestIsCancelled").Device(DEVICE_CPU),
                         TestIsCancelledKernel);
 
+TEST_P(GraphExecutorTest, ResultCache) {
+  GraphDef graph_def;
+  TF_ASSERT_OK(GetSimpleGraphDef(graph_def));
+
+  auto runtime = DefaultTfrtRuntime(/*num_threads=*/1);
+  GraphExecutor::Options options(runtime.get());
+  options.result_cache_options.enable = true;
+  options.enable_mlrt = GetParam();
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto fallback_state,
+      tensorflow::tfrt_stub::FallbackState::Create(
+          CreateDefaultSessionOptions(options), graph_def.library()));
+  auto resource_context = std::make_unique<tfrt::ResourceContext>();
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto graph_executor,
+      GraphExecutor::Create(std::move(options), std::move(fallback_state),
+                            std::move(resource_context), graph_def,
+                            GetKernelRegistry()));
+
+  std::vector<std::pair<std::string, tensorflow::Tensor>> inputs;
+  inputs.push_back({"input", CreateTfTensor<int32_t>(
+                                 /*shape=*/{1, 3}, /*data=*/{1, 1, 1})});
+
+  // The second run with identical inputs is served from the cache and must
+  // produce the same result.
+  for (int i = 0; i < 2; ++i) {
+    std::vector<tensorflow::Tensor> outputs;
+    TF_ASSERT_OK(graph_executor->Run(/*run_options=*/{}, inputs,
+                                     /*output_tensor_names=*/{"rank"},
+                                     /*target_tensor_names=*/{}, &outputs));
+    ASSERT_EQ(outputs.size(), 1);
+    EXPECT_THAT(GetTfTensorData<int32_t>(outputs[0]),
+                ::testing::ElementsAreArray({2}));
+  }
+
+  // A different input shape must not hit the cached entry.
+  inputs[0].second = CreateTfTensor<int32_t>(/*shape=*/{3}, /*data=*/{1, 1, 1});
+  std::vector<tensorflow::Tensor> outputs;
+  TF_ASSERT_OK(graph_executor->Run(/*run_options=*/{}, inputs,
+                                   /*output_tensor_names=*/{"rank"},
+                                   /*target_tensor_names=*/{}, &outputs));
+  ASSERT_EQ(outputs.size(), 1);
+  EXPECT_THAT(GetTfTensorData<int32_t>(outputs[0]),
+              ::testing::ElementsAreArray({1}));
+}
+
+TEST_P(GraphExecutorTest, SpeculativeDispatch) {
+  // Speculative dispatch is only implemented by the BEF executor.
+  if (GetParam()) {
+    GTEST_SKIP() << "Speculative dispatch is not supported by MLRT.";
+  }
+
+  GraphDef graph_def;
+  TF_ASSERT_OK(GetSimpleGraphDef(graph_def));
+
+  auto runtime = DefaultTfrtRuntime(/*num_threads=*/2);
+  GraphExecutor::Options options(runtime.get());
+  options.model_metadata.set_name("speculative_dispatch_test");
+  options.cost_analysis_options.version =
+      GraphExecutionOptions::CostAnalysisOptions::kOnce;
+  options.speculative_dispatch_options.enable = true;
+  // Dispatch every op with a recorded cost.
+  options.speculative_dispatch_options.min_dispatch_cost = 0;
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto fallback_state,
+      tensorflow::tfrt_stub::FallbackState::Create(
+          CreateDefaultSessionOptions(options), graph_def.library()));
+  auto resource_context = std::make_unique<tfrt::ResourceContext>();
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto graph_executor,
+      GraphExecutor::Create(std::move(options), std::move(fallback_state),
+                            std::move(resource_context), graph_def,
+                            GetKernelRegistry()));
+
+  std::vector<std::pair<std::string, tensorflow::Tensor>> inputs;
+  inputs.push_back({"input", CreateTfTensor<int32_t>(
+                                 /*shape=*/{1, 3}, /*data=*/{1, 1, 1})});
+
+  auto run = [&]() {
+    std::vector<tensorflow::Tensor> outputs;
+    TF_ASSERT_OK(graph_executor->Run(/*run_options=*/{}, inputs,
+                                     /*output_tensor_names=*/{"rank"},
+                                     /*target_tensor_names=*/{}, &outputs));
+    ASSERT_EQ(outputs.size(), 1);
+    EXPECT_THAT(GetTfTensorData<int32_t>(outputs[0]),
+                ::testing::ElementsAreArray({2}));
+  };
+
+  // The first run records the costs and doesn't dispatch anything.
+  monitoring::testing::CellReader<int64_t> dispatched_ops(
+      "/tensorflow/tfrt/fallback/dispatched_ops");
+  run();
+  EXPECT_EQ(dispatched_ops.Delta("speculative_dispatch_test"), 0);
+
+  // The later runs dispatch the ops with a recorded cost.
+  for (int i = 0; i < 2; ++i) {
+    run();
+    EXPECT_GT(dispatched_ops.Delta("speculative_dispatch_test"), 0);
+  }
+}
+
 TEST_P(GraphExecutorTest, Cancellation) {
   GraphDef graph_def;
 
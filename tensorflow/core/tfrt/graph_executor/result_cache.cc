@@ -0,0 +1,209 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/tfrt/graph_executor/result_cache.h"
+
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/log/log.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/op_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tsl/platform/fingerprint.h"
+
+namespace tensorflow {
+namespace tfrt_stub {
+namespace {
+
+auto* result_cache_hits = tensorflow::monitoring::Counter<2>::New(
+    "/tensorflow/tfrt/graph_executor/result_cache_hits",
+    "The number of requests served from the result cache.", "model_name",
+    "graph_name");
+
+auto* result_cache_misses = tensorflow::monitoring::Counter<2>::New(
+    "/tensorflow/tfrt/graph_executor/result_cache_misses",
+    "The number of requests that missed the result cache.", "model_name",
+    "graph_name");
+
+auto* result_cache_evictions = tensorflow::monitoring::Counter<2>::New(
+    "/tensorflow/tfrt/graph_executor/result_cache_evictions",
+    "The number of result cache entries evicted due to size or TTL.",
+    "model_name", "graph_name");
+
+// Stateful ops whose outputs do not change across requests in a serving
+// setting, so they do not prevent memoization.
+bool IsReadOnlyStatefulOp(absl::string_view op) {
+  static const auto* const kReadOnlyStatefulOps =
+      new absl::flat_hash_set<absl::string_view>({
+          "_Arg",
+          "_Retval",
+          "HashTable",
+          "HashTableV2",
+          "LookupTableFind",
+          "LookupTableFindV2",
+          "LookupTableSize",
+          "LookupTableSizeV2",
+          "PartitionedCall",
+          "ReadVariableOp",
+          "StatefulPartitionedCall",
+          "VarHandleOp",
+          "Variable",
+          "VariableV2",
+      });
+  return kReadOnlyStatefulOps->contains(op);
+}
+
+tsl::Fprint128 FingerprintTensor(const tensorflow::Tensor& tensor) {
+  tsl::Fprint128 fp = tsl::FingerprintCat128(
+      tsl::Fingerprint128(tensor.shape().DebugString()),
+      static_cast<uint64_t>(tensor.dtype()));
+  if (tensor.dtype() == DT_STRING) {
+    for (const auto& str : tensor.flat<tstring>()) {
+      fp = tsl::FingerprintCat128(fp, tsl::Fingerprint128(str));
+    }
+    return fp;
+  }
+  return tsl::FingerprintCat128(fp,
+                                tsl::Fingerprint128(tensor.tensor_data()));
+}
+
+}  // namespace
+
+bool AreInputTensorsCacheable(absl::Span<const tensorflow::Tensor> inputs) {
+  for (const auto& input : inputs) {
+    if (input.dtype() == DT_RESOURCE || input.dtype() == DT_VARIANT) {
+      return false;
+    }
+  }
+  return true;
+}
+
+tsl::Fprint128 FingerprintInputTensors(
+    absl::Span<const tensorflow::Tensor> inputs) {
+  tsl::Fprint128 fp = {static_cast<uint64_t>(inputs.size()), 0};
+  for (const auto& input : inputs) {
+    fp = tsl::FingerprintCat128(fp, FingerprintTensor(input));
+  }
+  return fp;
+}
+
+bool IsGraphIdempotent(const tensorflow::Graph& graph,
+                       const tensorflow::FunctionLibraryDefinition& flib_def) {
+  for (const Node* node : graph.op_nodes()) {
+    if (node->op_def().is_stateful() &&
+        !IsReadOnlyStatefulOp(node->type_string())) {
+      VLOG(1) << "Graph is not idempotent due to stateful op "
+              << node->type_string() << " (" << node->name() << ")";
+      return false;
+    }
+  }
+  for (const auto& function_name : flib_def.ListFunctionNames()) {
+    const FunctionDef* fdef = flib_def.Find(function_name);
+    if (fdef == nullptr) continue;
+    for (const auto& node_def : fdef->node_def()) {
+      const OpDef* op_def = nullptr;
+      if (!flib_def.LookUpOpDef(node_def.op(), &op_def).ok()) return false;
+      // Calls to library functions are covered by checking their bodies.
+      if (flib_def.Find(node_def.op()) != nullptr) continue;
+      if (op_def->is_stateful() && !IsReadOnlyStatefulOp(node_def.op())) {
+        VLOG(1) << "Graph is not idempotent due to stateful op "
+                << node_def.op() << " in function " << function_name;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+ResultCache::ResultCache(std::string model_name, std::string graph_name,
+                         int64_t capacity_bytes, absl::Duration ttl)
+    : model_name_(std::move(model_name)),
+      graph_name_(std::move(graph_name)),
+      capacity_bytes_(capacity_bytes),
+      ttl_(ttl) {}
+
+std::optional<std::vector<tensorflow::Tensor>> ResultCache::Lookup(
+    const tsl::Fprint128& key, absl::Time now) {
+  tensorflow::mutex_lock lock(mu_);
+  auto iter = index_.find(key);
+  if (iter == index_.end()) {
+    result_cache_misses->GetCell(model_name_, graph_name_)->IncrementBy(1);
+    return std::nullopt;
+  }
+  if (now - iter->second->insert_time > ttl_) {
+    EraseLocked(iter->second);
+    result_cache_evictions->GetCell(model_name_, graph_name_)->IncrementBy(1);
+    result_cache_misses->GetCell(model_name_, graph_name_)->IncrementBy(1);
+    return std::nullopt;
+  }
+  entries_.splice(entries_.begin(), entries_, iter->second);
+  result_cache_hits->GetCell(model_name_, graph_name_)->IncrementBy(1);
+  // Tensors are reference counted, so this does not copy the buffers, and the
+  // caller shares them with the cache.
+  return entries_.front().outputs;
+}
+
+void ResultCache::Insert(const tsl::Fprint128& key,
+                         absl::Span<const tensorflow::Tensor> outputs,
+                         absl::Time now) {
+  int64_t size_bytes = 0;
+  for (const auto& output : outputs) size_bytes += output.TotalBytes();
+  if (size_bytes > capacity_bytes_) return;
+
+  tensorflow::mutex_lock lock(mu_);
+  if (auto iter = index_.find(key); iter != index_.end()) {
+    EraseLocked(iter->second);
+  }
+  while (!entries_.empty() && size_bytes_ + size_bytes > capacity_bytes_) {
+    EraseLocked(std::prev(entries_.end()));
+    result_cache_evictions->GetCell(model_name_, graph_name_)->IncrementBy(1);
+  }
+  entries_.push_front(Entry{key,
+                            std::vector<tensorflow::Tensor>(outputs.begin(),
+                                                            outputs.end()),
+                            size_bytes, now});
+  index_[key] = entries_.begin();
+  size_bytes_ += size_bytes;
+}
+
+void ResultCache::EraseLocked(EntryList::iterator it) {
+  size_bytes_ -= it->size_bytes;
+  index_.erase(it->key);
+  entries_.erase(it);
+}
+
+int64_t ResultCache::size_bytes() const {
+  tensorflow::mutex_lock lock(mu_);
+  return size_bytes_;
+}
+
+int64_t ResultCache::num_entries() const {
+  tensorflow::mutex_lock lock(mu_);
+  return entries_.size();
+}
+
+}  // namespace tfrt_stub
+}  // namespace tensorflow
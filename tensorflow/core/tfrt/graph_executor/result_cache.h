@@ -0,0 +1,112 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_TFRT_GRAPH_EXECUTOR_RESULT_CACHE_H_
+#define TENSORFLOW_CORE_TFRT_GRAPH_EXECUTOR_RESULT_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tsl/platform/fingerprint.h"
+#include "tsl/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace tfrt_stub {
+
+// Returns false if any of `inputs` is a DT_RESOURCE or DT_VARIANT tensor. The
+// buffers of those tensors hold handles and pointers rather than values, so
+// equal buffers do not imply equal results and such requests must bypass the
+// cache.
+bool AreInputTensorsCacheable(absl::Span<const tensorflow::Tensor> inputs);
+
+// Computes a fingerprint of `inputs` that covers the dtype, the shape and the
+// content of every tensor. Two input lists with the same fingerprint are
+// treated as identical by `ResultCache`. `inputs` must be cacheable, see
+// `AreInputTensorsCacheable`.
+tsl::Fprint128 FingerprintInputTensors(
+    absl::Span<const tensorflow::Tensor> inputs);
+
+// Returns true if the results of `graph` only depend on its feeds, i.e. the
+// graph and the functions in `flib_def` do not contain stateful ops other than
+// the read-only ones (e.g. variable reads) that are safe to memoize in serving.
+bool IsGraphIdempotent(const tensorflow::Graph& graph,
+                       const tensorflow::FunctionLibraryDefinition& flib_def);
+
+// A thread-safe LRU cache that maps the fingerprint of the inputs of a client
+// graph to its outputs. The total size of the cached output tensors is bounded
+// by `capacity_bytes`, and entries older than `ttl` are never returned.
+class ResultCache {
+ public:
+  ResultCache(std::string model_name, std::string graph_name,
+              int64_t capacity_bytes, absl::Duration ttl);
+
+  ResultCache(const ResultCache&) = delete;
+  ResultCache& operator=(const ResultCache&) = delete;
+
+  // Returns the cached outputs for `key` if there is an unexpired entry. The
+  // returned tensors share their buffers with the cache and with the outputs
+  // returned by other hits on the same entry, so they must not be modified in
+  // place.
+  std::optional<std::vector<tensorflow::Tensor>> Lookup(
+      const tsl::Fprint128& key, absl::Time now) TF_LOCKS_EXCLUDED(mu_);
+
+  // Inserts `outputs` for `key`, evicting the least recently used entries if
+  // the cache is over budget. Outputs larger than the whole budget are not
+  // cached.
+  void Insert(const tsl::Fprint128& key,
+              absl::Span<const tensorflow::Tensor> outputs, absl::Time now)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  int64_t size_bytes() const TF_LOCKS_EXCLUDED(mu_);
+  int64_t num_entries() const TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Entry {
+    tsl::Fprint128 key;
+    std::vector<tensorflow::Tensor> outputs;
+    int64_t size_bytes = 0;
+    absl::Time insert_time;
+  };
+  using EntryList = std::list<Entry>;
+
+  void EraseLocked(EntryList::iterator it) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const std::string model_name_;
+  const std::string graph_name_;
+  const int64_t capacity_bytes_;
+  const absl::Duration ttl_;
+
+  mutable tensorflow::mutex mu_;
+  // Most recently used entries are at the front.
+  EntryList entries_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<tsl::Fprint128, EntryList::iterator, tsl::Fprint128Hasher>
+      index_ TF_GUARDED_BY(mu_);
+  int64_t size_bytes_ TF_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace tfrt_stub
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_TFRT_GRAPH_EXECUTOR_RESULT_CACHE_H_
@@ -0,0 +1,158 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/tfrt/graph_executor/result_cache.h"
+
+#include <cstdint>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/time/time.h"
+#include "tensorflow/cc/framework/scope.h"
+#include "tensorflow/cc/ops/array_ops.h"
+#include "tensorflow/cc/ops/random_ops.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tsl/lib/core/status_test_util.h"
+
+namespace tensorflow {
+namespace tfrt_stub {
+namespace {
+
+Tensor MakeTensor(std::vector<int32_t> values) {
+  return test::AsTensor<int32_t>(values,
+                                 {static_cast<int64_t>(values.size())});
+}
+
+TEST(FingerprintInputTensorsTest, CoversShapeDtypeAndContent) {
+  const auto fp = FingerprintInputTensors({MakeTensor({1, 2, 3})});
+  EXPECT_EQ(fp, FingerprintInputTensors({MakeTensor({1, 2, 3})}));
+  EXPECT_FALSE(fp == FingerprintInputTensors({MakeTensor({1, 2, 4})}));
+  EXPECT_FALSE(fp == FingerprintInputTensors({test::AsTensor<int32_t>(
+                         {1, 2, 3}, {3, 1})}));
+  EXPECT_FALSE(fp == FingerprintInputTensors(
+                         {test::AsTensor<float>({1, 2, 3}, {3})}));
+  EXPECT_FALSE(fp == FingerprintInputTensors(
+                         {MakeTensor({1, 2, 3}), MakeTensor({1, 2, 3})}));
+}
+
+TEST(FingerprintInputTensorsTest, StringTensors) {
+  const auto fp =
+      FingerprintInputTensors({test::AsTensor<tstring>({"ab", "c"}, {2})});
+  EXPECT_EQ(fp, FingerprintInputTensors(
+                    {test::AsTensor<tstring>({"ab", "c"}, {2})}));
+  EXPECT_FALSE(fp == FingerprintInputTensors(
+                         {test::AsTensor<tstring>({"a", "bc"}, {2})}));
+}
+
+TEST(FingerprintInputTensorsTest, ResourceAndVariantInputsAreNotCacheable) {
+  EXPECT_TRUE(AreInputTensorsCacheable(
+      {MakeTensor({1}), test::AsTensor<tstring>({"a"}, {1})}));
+  EXPECT_FALSE(AreInputTensorsCacheable(
+      {MakeTensor({1}), Tensor(DT_RESOURCE, TensorShape({}))}));
+  EXPECT_FALSE(
+      AreInputTensorsCacheable({Tensor(DT_VARIANT, TensorShape({2}))}));
+}
+
+TEST(ResultCacheTest, HitAndMiss) {
+  ResultCache cache("model", "graph", /*capacity_bytes=*/1024,
+                    absl::InfiniteDuration());
+  const auto key = FingerprintInputTensors({MakeTensor({1})});
+  const auto now = absl::Now();
+
+  EXPECT_FALSE(cache.Lookup(key, now).has_value());
+  cache.Insert(key, {MakeTensor({4, 5})}, now);
+
+  auto outputs = cache.Lookup(key, now);
+  ASSERT_TRUE(outputs.has_value());
+  ASSERT_EQ(outputs->size(), 1);
+  test::ExpectTensorEqual<int32_t>((*outputs)[0], MakeTensor({4, 5}));
+  EXPECT_EQ(cache.size_bytes(), 2 * sizeof(int32_t));
+}
+
+TEST(ResultCacheTest, EvictsLeastRecentlyUsed) {
+  ResultCache cache("model", "graph",
+                    /*capacity_bytes=*/2 * 4 * sizeof(int32_t),
+                    absl::InfiniteDuration());
+  const auto now = absl::Now();
+  const auto key_a = FingerprintInputTensors({MakeTensor({1})});
+  const auto key_b = FingerprintInputTensors({MakeTensor({2})});
+  const auto key_c = FingerprintInputTensors({MakeTensor({3})});
+
+  cache.Insert(key_a, {MakeTensor({1, 1, 1, 1})}, now);
+  cache.Insert(key_b, {MakeTensor({2, 2, 2, 2})}, now);
+  // Touch `key_a` so that `key_b` becomes the least recently used entry.
+  EXPECT_TRUE(cache.Lookup(key_a, now).has_value());
+  cache.Insert(key_c, {MakeTensor({3, 3, 3, 3})}, now);
+
+  EXPECT_EQ(cache.num_entries(), 2);
+  EXPECT_TRUE(cache.Lookup(key_a, now).has_value());
+  EXPECT_FALSE(cache.Lookup(key_b, now).has_value());
+  EXPECT_TRUE(cache.Lookup(key_c, now).has_value());
+}
+
+TEST(ResultCacheTest, OversizedOutputsAreNotCached) {
+  ResultCache cache("model", "graph", /*capacity_bytes=*/sizeof(int32_t),
+                    absl::InfiniteDuration());
+  const auto key = FingerprintInputTensors({MakeTensor({1})});
+  const auto now = absl::Now();
+  cache.Insert(key, {MakeTensor({1, 2})}, now);
+  EXPECT_FALSE(cache.Lookup(key, now).has_value());
+  EXPECT_EQ(cache.size_bytes(), 0);
+}
+
+TEST(ResultCacheTest, ExpiresAfterTtl) {
+  ResultCache cache("model", "graph", /*capacity_bytes=*/1024,
+                    absl::Seconds(10));
+  const auto key = FingerprintInputTensors({MakeTensor({1})});
+  const auto now = absl::Now();
+  cache.Insert(key, {MakeTensor({1})}, now);
+
+  EXPECT_TRUE(cache.Lookup(key, now + absl::Seconds(5)).has_value());
+  EXPECT_FALSE(cache.Lookup(key, now + absl::Seconds(11)).has_value());
+  EXPECT_EQ(cache.num_entries(), 0);
+}
+
+TEST(IsGraphIdempotentTest, StatelessGraph) {
+  auto scope = Scope::NewRootScope();
+  auto input = ops::Placeholder(scope.WithOpName("input"), DT_INT32);
+  auto rank = ops::Rank(scope.WithOpName("rank"), input);
+  Graph graph(OpRegistry::Global());
+  TF_ASSERT_OK(scope.ToGraph(&graph));
+
+  FunctionLibraryDefinition flib_def(OpRegistry::Global(),
+                                     FunctionDefLibrary());
+  EXPECT_TRUE(IsGraphIdempotent(graph, flib_def));
+}
+
+TEST(IsGraphIdempotentTest, RandomOpIsNotIdempotent) {
+  auto scope = Scope::NewRootScope();
+  auto shape = ops::Placeholder(scope.WithOpName("shape"), DT_INT32);
+  auto random =
+      ops::RandomUniform(scope.WithOpName("random"), shape, DT_FLOAT);
+  Graph graph(OpRegistry::Global());
+  TF_ASSERT_OK(scope.ToGraph(&graph));
+
+  FunctionLibraryDefinition flib_def(OpRegistry::Global(),
+                                     FunctionDefLibrary());
+  EXPECT_FALSE(IsGraphIdempotent(graph, flib_def));
+}
+
+}  // namespace
+}  // namespace tfrt_stub
+}  // namespace tensorflow
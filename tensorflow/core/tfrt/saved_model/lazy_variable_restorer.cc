@@ -0,0 +1,451 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/tfrt/saved_model/lazy_variable_restorer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/log/log.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/resource_var.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/tensor_id.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/statusor.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow/core/util/tensor_bundle/shared_tensor_store.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+namespace tfrt_stub {
+namespace {
+
+constexpr absl::string_view kSessionInitializerPrefix =
+    "__tf_saved_model_session_initializer_";
+
+using NodeMap = absl::flat_hash_map<absl::string_view, const NodeDef*>;
+
+const NodeDef* FindInputNode(const NodeMap& nodes, absl::string_view input,
+                             int* output_index = nullptr) {
+  const TensorId id = ParseTensorName(input);
+  if (output_index != nullptr) *output_index = id.index();
+  auto iter = nodes.find(id.node());
+  return iter == nodes.end() ? nullptr : iter->second;
+}
+
+// Returns the nodes reachable from `roots` through data and control edges in
+// the reverse direction, including `roots` themselves.
+std::vector<const NodeDef*> CollectAncestors(
+    const NodeMap& nodes, absl::Span<const std::string> roots) {
+  std::vector<const NodeDef*> ancestors;
+  std::vector<const NodeDef*> stack;
+  absl::flat_hash_set<const NodeDef*> visited;
+  for (const auto& root : roots) {
+    const NodeDef* node = FindInputNode(nodes, root);
+    if (node != nullptr && visited.insert(node).second) stack.push_back(node);
+  }
+  while (!stack.empty()) {
+    const NodeDef* node = stack.back();
+    stack.pop_back();
+    ancestors.push_back(node);
+    for (const auto& input : node->input()) {
+      const NodeDef* input_node = FindInputNode(nodes, input);
+      if (input_node != nullptr && visited.insert(input_node).second) {
+        stack.push_back(input_node);
+      }
+    }
+  }
+  return ancestors;
+}
+
+StatusOr<Tensor> GetConstValue(const NodeDef* node) {
+  if (node == nullptr || node->op() != "Const") {
+    return errors::Unimplemented(
+        "Lazy variable restore requires constant restore arguments");
+  }
+  const TensorProto* proto = nullptr;
+  TF_RETURN_IF_ERROR(GetNodeAttr(*node, "value", &proto));
+  Tensor tensor;
+  if (!tensor.FromProto(*proto)) {
+    return errors::InvalidArgument("Failed to parse constant ", node->name());
+  }
+  return tensor;
+}
+
+}  // namespace
+
+LazyVariableRestorer::ScopedAccess::ScopedAccess(ScopedAccess&& other)
+    : restorer_(other.restorer_), variables_(std::move(other.variables_)) {
+  other.restorer_ = nullptr;
+}
+
+LazyVariableRestorer::ScopedAccess&
+LazyVariableRestorer::ScopedAccess::operator=(ScopedAccess&& other) {
+  if (this != &other) {
+    if (restorer_ != nullptr) restorer_->Release(variables_);
+    restorer_ = other.restorer_;
+    variables_ = std::move(other.variables_);
+    other.restorer_ = nullptr;
+  }
+  return *this;
+}
+
+LazyVariableRestorer::ScopedAccess::~ScopedAccess() {
+  if (restorer_ != nullptr) restorer_->Release(variables_);
+}
+
+std::string LazyVariableRestorer::GetRestoreInitializerName(
+    const MetaGraphDef& meta_graph_def) {
+  return absl::StrCat(kSessionInitializerPrefix,
+                      meta_graph_def.saver_def().restore_op_name());
+}
+
+StatusOr<std::unique_ptr<LazyVariableRestorer>> LazyVariableRestorer::Create(
+    const MetaGraphDef& meta_graph_def, absl::string_view saved_model_dir,
+    ResourceMgr* resource_mgr) {
+  const auto& restore_op_name = meta_graph_def.saver_def().restore_op_name();
+  if (restore_op_name.empty()) {
+    return errors::FailedPrecondition("The model does not have a restore op");
+  }
+
+  NodeMap nodes;
+  for (const auto& node : meta_graph_def.graph_def().node()) {
+    nodes[node.name()] = &node;
+  }
+
+  auto restorer = absl::WrapUnique(new LazyVariableRestorer(
+      io::JoinPath(saved_model_dir, kSavedModelVariablesDirectory,
+                   kSavedModelVariablesFilename),
+      resource_mgr));
+
+  // Map each variable handle written by the restore op to the checkpoint key
+  // of its value.
+  absl::flat_hash_map<absl::string_view, int> variable_ids;
+  for (const NodeDef* node : CollectAncestors(nodes, {restore_op_name})) {
+    // Reference variables and legacy checkpoint formats are restored eagerly.
+    if (node->op() == "Assign" || node->op() == "Restore" ||
+        node->op() == "RestoreSlice") {
+      return errors::Unimplemented("Lazy variable restore does not support op ",
+                                   node->op(), " in ", node->name());
+    }
+    if (node->op() != "AssignVariableOp" || node->input_size() < 2) continue;
+
+    const NodeDef* handle = FindInputNode(nodes, node->input(0));
+    if (handle == nullptr || handle->op() != "VarHandleOp") {
+      return errors::Unimplemented(
+          "Lazy variable restore requires VarHandleOp inputs, but got ",
+          node->input(0));
+    }
+
+    // Skip the identities that the saver may insert between the restore and
+    // the assignment.
+    int output_index = 0;
+    const NodeDef* value = FindInputNode(nodes, node->input(1), &output_index);
+    while (value != nullptr && value->op() == "Identity") {
+      value = FindInputNode(nodes, value->input(0), &output_index);
+    }
+    if (value == nullptr || value->op() != "RestoreV2" ||
+        value->input_size() < 3) {
+      return errors::Unimplemented(
+          "Lazy variable restore requires RestoreV2 values for ",
+          node->name());
+    }
+    TF_ASSIGN_OR_RETURN(Tensor tensor_names,
+                        GetConstValue(FindInputNode(nodes, value->input(1))));
+    TF_ASSIGN_OR_RETURN(Tensor shape_and_slices,
+                        GetConstValue(FindInputNode(nodes, value->input(2))));
+    if (output_index < 0 || output_index >= tensor_names.NumElements() ||
+        output_index >= shape_and_slices.NumElements()) {
+      return errors::InvalidArgument("Invalid restore output ", node->input(1));
+    }
+    if (!shape_and_slices.flat<tstring>()(output_index).empty()) {
+      return errors::Unimplemented(
+          "Lazy variable restore does not support partitioned variables");
+    }
+
+    Variable variable;
+    TF_RETURN_IF_ERROR(GetNodeAttr(*handle, "container", &variable.container));
+    TF_RETURN_IF_ERROR(
+        GetNodeAttr(*handle, "shared_name", &variable.shared_name));
+    TF_RETURN_IF_ERROR(GetNodeAttr(*handle, "dtype", &variable.dtype));
+    if (variable.container.empty()) {
+      variable.container = resource_mgr->default_container();
+    }
+    if (variable.shared_name.empty()) variable.shared_name = handle->name();
+    variable.checkpoint_key = tensor_names.flat<tstring>()(output_index);
+
+    variable_ids[handle->name()] = restorer->variables_.size();
+    restorer->variables_.push_back(std::move(variable));
+  }
+
+  // Collect the variables each signature depends on.
+  for (const auto& [signature_name, signature_def] :
+       meta_graph_def.signature_def()) {
+    std::vector<std::string> roots;
+    for (const auto& [key, tensor_info] : signature_def.outputs()) {
+      roots.push_back(tensor_info.name());
+    }
+    auto& ids = restorer->signature_variables_[signature_name];
+    for (const NodeDef* node : CollectAncestors(nodes, roots)) {
+      auto iter = variable_ids.find(node->name());
+      if (iter != variable_ids.end()) ids.push_back(iter->second);
+    }
+    std::sort(ids.begin(), ids.end());
+  }
+
+  LOG(INFO) << "Lazy variable restore planned for "
+            << restorer->variables_.size() << " variables across "
+            << restorer->signature_variables_.size() << " signatures.";
+  return restorer;
+}
+
+LazyVariableRestorer::~LazyVariableRestorer() { WaitForPrefetches(); }
+
+StatusOr<LazyVariableRestorer::ScopedAccess> LazyVariableRestorer::Acquire(
+    absl::Span<const std::string> signature_names) {
+  std::vector<int> variable_ids;
+  for (const auto& name : signature_names) {
+    auto iter = signature_variables_.find(name);
+    if (iter == signature_variables_.end()) {
+      return errors::NotFound("Signature not found: ", name);
+    }
+    variable_ids.insert(variable_ids.end(), iter->second.begin(),
+                        iter->second.end());
+  }
+  std::sort(variable_ids.begin(), variable_ids.end());
+  variable_ids.erase(std::unique(variable_ids.begin(), variable_ids.end()),
+                     variable_ids.end());
+  return AcquireVariables(std::move(variable_ids));
+}
+
+StatusOr<LazyVariableRestorer::ScopedAccess>
+LazyVariableRestorer::AcquireAll() {
+  std::vector<int> variable_ids(variables_.size());
+  for (int i = 0; i < variable_ids.size(); ++i) variable_ids[i] = i;
+  return AcquireVariables(std::move(variable_ids));
+}
+
+StatusOr<LazyVariableRestorer::ScopedAccess>
+LazyVariableRestorer::AcquireVariables(std::vector<int> variable_ids) {
+  const absl::Time now = absl::Now();
+  // Pin the variables first, so that none of them is evicted while the others
+  // are restored.
+  {
+    tensorflow::mutex_lock lock(mu_);
+    for (int id : variable_ids) {
+      ++variables_[id].num_pins;
+      variables_[id].last_access = now;
+    }
+  }
+  ScopedAccess access(this, std::move(variable_ids));
+
+  while (true) {
+    std::vector<int> to_restore;
+    {
+      tensorflow::mutex_lock lock(mu_);
+      while (true) {
+        bool restoring_elsewhere = false;
+        for (int id : access.variables_) {
+          switch (variables_[id].state) {
+            case State::kUnrestored:
+              to_restore.push_back(id);
+              break;
+            case State::kRestoring:
+              restoring_elsewhere = true;
+              break;
+            case State::kRestored:
+              break;
+          }
+        }
+        if (!to_restore.empty()) break;
+        if (!restoring_elsewhere) return access;
+        restore_done_.wait(lock);
+      }
+      for (int id : to_restore) variables_[id].state = State::kRestoring;
+    }
+    TF_RETURN_IF_ERROR(RestoreVariables(to_restore));
+  }
+}
+
+void LazyVariableRestorer::Release(absl::Span<const int> variable_ids) {
+  const absl::Time now = absl::Now();
+  tensorflow::mutex_lock lock(mu_);
+  for (int id : variable_ids) {
+    auto& variable = variables_[id];
+    DCHECK_GT(variable.num_pins, 0);
+    --variable.num_pins;
+    variable.last_access = now;
+  }
+}
+
+Status LazyVariableRestorer::RestoreVariables(
+    absl::Span<const int> variable_ids) {
+  std::unique_ptr<BundleReader> reader;
+  {
+    tensorflow::mutex_lock lock(mu_);
+    if (!idle_readers_.empty()) {
+      reader = std::move(idle_readers_.back());
+      idle_readers_.pop_back();
+    }
+  }
+  if (reader == nullptr) {
+    reader = std::make_unique<BundleReader>(Env::Default(),
+                                            checkpoint_prefix_);
+  }
+
+  Status status = reader->status();
+  std::vector<int64_t> sizes(variable_ids.size(), 0);
+  for (int i = 0; i < variable_ids.size() && status.ok(); ++i) {
+    auto size = RestoreVariable(*reader, variables_[variable_ids[i]]);
+    if (size.ok()) {
+      sizes[i] = *size;
+    } else {
+      status = size.status();
+    }
+  }
+
+  tensorflow::mutex_lock lock(mu_);
+  if (reader->status().ok()) idle_readers_.push_back(std::move(reader));
+  // On failure all of the variables are marked as unrestored, so that the next
+  // request retries them.
+  for (int i = 0; i < variable_ids.size(); ++i) {
+    auto& variable = variables_[variable_ids[i]];
+    if (status.ok()) {
+      variable.state = State::kRestored;
+      variable.size_bytes = sizes[i];
+    } else {
+      variable.state = State::kUnrestored;
+    }
+  }
+  restore_done_.notify_all();
+  return status;
+}
+
+StatusOr<int64_t> LazyVariableRestorer::RestoreVariable(
+    BundleReader& reader, const Variable& variable) {
+  Tensor value;
+  TF_RETURN_IF_ERROR(reader.Lookup(variable.checkpoint_key, &value));
+  if (value.dtype() != variable.dtype) {
+    return errors::InvalidArgument(
+        "Checkpoint entry ", variable.checkpoint_key, " has dtype ",
+        DataTypeString(value.dtype()), " but the variable expects ",
+        DataTypeString(variable.dtype));
+  }
+  uint32 masked_crc32c;
+  if (SharedTensorStore::IsEnabled() &&
+      reader.LookupChecksum(variable.checkpoint_key, &masked_crc32c).ok()) {
+    value = SharedTensorStore::Global()->Canonicalize(value, masked_crc32c);
+  }
+
+  Var* var = nullptr;
+  TF_RETURN_IF_ERROR(resource_mgr_->LookupOrCreate<Var>(
+      variable.container, variable.shared_name, &var,
+      [&variable](Var** ptr) {
+        *ptr = new Var(variable.dtype);
+        return OkStatus();
+      }));
+  core::ScopedUnref unref(var);
+  const int64_t size_bytes = value.TotalBytes();
+  {
+    tensorflow::mutex_lock var_lock(*var->mu());
+    *var->tensor() = std::move(value);
+    var->is_initialized = true;
+  }
+  VLOG(1) << "Lazily restored variable " << variable.shared_name << " from "
+          << variable.checkpoint_key;
+  return size_bytes;
+}
+
+void LazyVariableRestorer::PrefetchAsync(
+    std::vector<std::string> signature_names) {
+  {
+    tensorflow::mutex_lock lock(mu_);
+    ++num_pending_prefetches_;
+  }
+  Env::Default()->SchedClosure(
+      [this, signature_names = std::move(signature_names)]() {
+        auto access = Acquire(signature_names);
+        if (!access.ok()) {
+          LOG(WARNING) << "Failed to prefetch variables: " << access.status();
+        }
+        // Release the pins before signaling the destructor.
+        access = ScopedAccess();
+        tensorflow::mutex_lock lock(mu_);
+        if (--num_pending_prefetches_ == 0) prefetch_done_.notify_all();
+      });
+}
+
+void LazyVariableRestorer::WaitForPrefetches() {
+  tensorflow::mutex_lock lock(mu_);
+  while (num_pending_prefetches_ > 0) prefetch_done_.wait(lock);
+}
+
+int64_t LazyVariableRestorer::EvictIdleVariables(absl::Duration max_idle,
+                                                 absl::Time now) {
+  int64_t released_bytes = 0;
+  tensorflow::mutex_lock lock(mu_);
+  for (auto& variable : variables_) {
+    if (variable.state != State::kRestored || variable.num_pins > 0 ||
+        now - variable.last_access < max_idle) {
+      continue;
+    }
+    Var* var = nullptr;
+    if (resource_mgr_->Lookup<Var>(variable.container, variable.shared_name,
+                                   &var)
+            .ok()) {
+      core::ScopedUnref unref(var);
+      tensorflow::mutex_lock var_lock(*var->mu());
+      var->Uninitialize();
+    }
+    variable.state = State::kUnrestored;
+    released_bytes += variable.size_bytes;
+    variable.size_bytes = 0;
+  }
+  if (released_bytes > 0) {
+    LOG(INFO) << "Evicted " << released_bytes
+              << " bytes of idle lazily restored variables.";
+  }
+  return released_bytes;
+}
+
+int LazyVariableRestorer::num_restored_variables() const {
+  tensorflow::mutex_lock lock(mu_);
+  return std::count_if(variables_.begin(), variables_.end(),
+                       [](const Variable& v) {
+                         return v.state == State::kRestored;
+                       });
+}
+
+}  // namespace tfrt_stub
+}  // namespace tensorflow
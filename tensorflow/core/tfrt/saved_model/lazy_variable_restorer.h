@@ -0,0 +1,172 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_TFRT_SAVED_MODEL_LAZY_VARIABLE_RESTORER_H_
+#define TENSORFLOW_CORE_TFRT_SAVED_MODEL_LAZY_VARIABLE_RESTORER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/statusor.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+#include "tsl/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace tfrt_stub {
+
+// Restores the resource variables of a V1 SavedModel on demand instead of
+// running the saver's restore op at load time. The variables reachable from a
+// signature are read from the checkpoint the first time the signature is run,
+// and the variables of signatures that have not been used for a while can be
+// evicted and are restored again on their next use.
+//
+// Only models whose restore op consists of `RestoreV2` feeding
+// `AssignVariableOp` with unpartitioned tensors are supported.
+//
+// Checkpoint reads happen outside of the restorer's lock, so requests only
+// wait for the restore of the variables they use themselves.
+class LazyVariableRestorer {
+ public:
+  // Keeps the variables of a set of signatures from being evicted while a
+  // request that uses them is in flight.
+  class ScopedAccess {
+   public:
+    ScopedAccess() = default;
+    ScopedAccess(ScopedAccess&& other);
+    ScopedAccess& operator=(ScopedAccess&& other);
+    ScopedAccess(const ScopedAccess&) = delete;
+    ScopedAccess& operator=(const ScopedAccess&) = delete;
+    ~ScopedAccess();
+
+   private:
+    friend class LazyVariableRestorer;
+    ScopedAccess(LazyVariableRestorer* restorer, std::vector<int> variables)
+        : restorer_(restorer), variables_(std::move(variables)) {}
+
+    LazyVariableRestorer* restorer_ = nullptr;
+    std::vector<int> variables_;
+  };
+
+  // Builds the per-signature restore plan from `meta_graph_def`, which must
+  // still contain its graph_def. Variables are created in `resource_mgr`.
+  // Returns an error if the restore op of the model is not supported, in which
+  // case the caller should restore eagerly.
+  static StatusOr<std::unique_ptr<LazyVariableRestorer>> Create(
+      const MetaGraphDef& meta_graph_def, absl::string_view saved_model_dir,
+      ResourceMgr* resource_mgr);
+
+  // Returns the exported name of the session initializer that runs the restore
+  // op of `meta_graph_def`, which must be skipped when restoring lazily.
+  static std::string GetRestoreInitializerName(
+      const MetaGraphDef& meta_graph_def);
+
+  // Waits for pending prefetches to finish.
+  ~LazyVariableRestorer();
+
+  LazyVariableRestorer(const LazyVariableRestorer&) = delete;
+  LazyVariableRestorer& operator=(const LazyVariableRestorer&) = delete;
+
+  // Restores the variables used by `signature_names` that are not restored yet
+  // and pins them until the returned object is destroyed. Variables that are
+  // being restored by another caller are waited for rather than read again.
+  StatusOr<ScopedAccess> Acquire(absl::Span<const std::string> signature_names)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Like `Acquire()` but for all variables of the model. This is used when the
+  // subgraph to run is not identified by signatures.
+  StatusOr<ScopedAccess> AcquireAll() TF_LOCKS_EXCLUDED(mu_);
+
+  // Restores the variables used by `signature_names` on a background thread so
+  // that the first request to them does not pay the restore latency.
+  void PrefetchAsync(std::vector<std::string> signature_names)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Blocks until the prefetches started so far have finished.
+  void WaitForPrefetches() TF_LOCKS_EXCLUDED(mu_);
+
+  // Releases the memory of restored variables that are not pinned and have not
+  // been used since `now - max_idle`. Returns the number of bytes released.
+  int64_t EvictIdleVariables(absl::Duration max_idle, absl::Time now)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  int num_variables() const { return variables_.size(); }
+  int num_restored_variables() const TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  enum class State { kUnrestored, kRestoring, kRestored };
+
+  struct Variable {
+    // Fixed after `Create()`, and read without holding `mu_`.
+    std::string container;
+    std::string shared_name;
+    std::string checkpoint_key;
+    DataType dtype = DT_INVALID;
+
+    State state = State::kUnrestored;
+    int num_pins = 0;
+    int64_t size_bytes = 0;
+    absl::Time last_access = absl::InfinitePast();
+  };
+
+  LazyVariableRestorer(std::string checkpoint_prefix,
+                       ResourceMgr* resource_mgr)
+      : checkpoint_prefix_(std::move(checkpoint_prefix)),
+        resource_mgr_(resource_mgr) {}
+
+  StatusOr<ScopedAccess> AcquireVariables(std::vector<int> variable_ids)
+      TF_LOCKS_EXCLUDED(mu_);
+  // Reads the variables in `variable_ids`, which the caller has marked as
+  // restoring, from the checkpoint, and marks them as restored or, on error,
+  // as unrestored again.
+  Status RestoreVariables(absl::Span<const int> variable_ids)
+      TF_LOCKS_EXCLUDED(mu_);
+  // Reads `variable` from `reader` into its resource. Returns the size of the
+  // restored value.
+  StatusOr<int64_t> RestoreVariable(BundleReader& reader,
+                                    const Variable& variable);
+  void Release(absl::Span<const int> variable_ids) TF_LOCKS_EXCLUDED(mu_);
+
+  const std::string checkpoint_prefix_;
+  ResourceMgr* const resource_mgr_;
+
+  // The set of variables is fixed after `Create()`, while their restore state
+  // is guarded by `mu_`.
+  std::vector<Variable> variables_;
+  absl::flat_hash_map<std::string, std::vector<int>> signature_variables_;
+
+  mutable tensorflow::mutex mu_;
+  // Signaled whenever variables stop restoring.
+  tensorflow::condition_variable restore_done_;
+  // A `BundleReader` is not thread-safe, so each concurrent restore takes a
+  // reader of its own. Readers are kept open for subsequent restores.
+  std::vector<std::unique_ptr<BundleReader>> idle_readers_ TF_GUARDED_BY(mu_);
+  int num_pending_prefetches_ TF_GUARDED_BY(mu_) = 0;
+  tensorflow::condition_variable prefetch_done_;
+};
+
+}  // namespace tfrt_stub
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_TFRT_SAVED_MODEL_LAZY_VARIABLE_RESTORER_H_
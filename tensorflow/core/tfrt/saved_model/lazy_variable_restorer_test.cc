@@ -0,0 +1,279 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/tfrt/saved_model/lazy_variable_restorer.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/resource_var.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/threadpool.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow/core/util/tensor_bundle/shared_tensor_store.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+#include "tsl/lib/core/status_test_util.h"
+
+namespace tensorflow {
+namespace tfrt_stub {
+namespace {
+
+void AddConst(const std::string& name, const Tensor& value, GraphDef* graph) {
+  NodeDef* node = graph->add_node();
+  node->set_name(name);
+  node->set_op("Const");
+  (*node->mutable_attr())["dtype"].set_type(value.dtype());
+  value.AsProtoTensorContent((*node->mutable_attr())["value"].mutable_tensor());
+}
+
+void AddVariable(const std::string& name, GraphDef* graph) {
+  NodeDef* node = graph->add_node();
+  node->set_name(name);
+  node->set_op("VarHandleOp");
+  (*node->mutable_attr())["container"].set_s("");
+  (*node->mutable_attr())["shared_name"].set_s(name);
+  (*node->mutable_attr())["dtype"].set_type(DT_FLOAT);
+
+  NodeDef* read = graph->add_node();
+  read->set_name(name + "/read");
+  read->set_op("ReadVariableOp");
+  read->add_input(name);
+}
+
+// Builds a model with variables `a` and `b` where signature `sig_a` only reads
+// `a` and signature `sig_b` only reads `b`.
+MetaGraphDef CreateMetaGraphDef() {
+  MetaGraphDef meta_graph_def;
+  GraphDef* graph = meta_graph_def.mutable_graph_def();
+  AddVariable("a", graph);
+  AddVariable("b", graph);
+
+  AddConst("save/Const", test::AsScalar<tstring>("prefix"), graph);
+  AddConst("save/tensor_names", test::AsTensor<tstring>({"a", "b"}), graph);
+  AddConst("save/shape_and_slices", test::AsTensor<tstring>({"", ""}), graph);
+  NodeDef* restore = graph->add_node();
+  restore->set_name("save/RestoreV2");
+  restore->set_op("RestoreV2");
+  restore->add_input("save/Const");
+  restore->add_input("save/tensor_names");
+  restore->add_input("save/shape_and_slices");
+
+  NodeDef* restore_all = graph->add_node();
+  restore_all->set_name("save/restore_all");
+  restore_all->set_op("NoOp");
+  int index = 0;
+  for (const std::string var : {"a", "b"}) {
+    NodeDef* identity = graph->add_node();
+    identity->set_name("save/Identity_" + var);
+    identity->set_op("Identity");
+    identity->add_input(absl::StrCat("save/RestoreV2:", index++));
+
+    NodeDef* assign = graph->add_node();
+    assign->set_name("save/Assign_" + var);
+    assign->set_op("AssignVariableOp");
+    assign->add_input(var);
+    assign->add_input(identity->name());
+    restore_all->add_input("^" + assign->name());
+  }
+  meta_graph_def.mutable_saver_def()->set_restore_op_name("save/restore_all");
+
+  (*meta_graph_def.mutable_signature_def())["sig_a"]
+      .mutable_outputs()
+      ->operator[]("out")
+      .set_name("a/read:0");
+  (*meta_graph_def.mutable_signature_def())["sig_b"]
+      .mutable_outputs()
+      ->operator[]("out")
+      .set_name("b/read:0");
+  return meta_graph_def;
+}
+
+std::string WriteCheckpoint() {
+  const std::string saved_model_dir =
+      io::JoinPath(testing::TmpDir(), "lazy_variable_restorer_test");
+  const std::string prefix =
+      io::JoinPath(saved_model_dir, kSavedModelVariablesDirectory,
+                   kSavedModelVariablesFilename);
+  BundleWriter writer(Env::Default(), prefix);
+  TF_CHECK_OK(writer.Add("a", test::AsTensor<float>({1, 2})));
+  TF_CHECK_OK(writer.Add("b", test::AsTensor<float>({3, 4, 5})));
+  TF_CHECK_OK(writer.Finish());
+  return saved_model_dir;
+}
+
+void ExpectVariable(ResourceMgr& resource_mgr, const std::string& name,
+                    const Tensor& expected) {
+  Var* var = nullptr;
+  TF_ASSERT_OK(
+      resource_mgr.Lookup<Var>(resource_mgr.default_container(), name, &var));
+  core::ScopedUnref unref(var);
+  ASSERT_TRUE(var->is_initialized);
+  test::ExpectTensorEqual<float>(*var->tensor(), expected);
+}
+
+TEST(LazyVariableRestorerTest, RestoresOnlySignatureVariables) {
+  const std::string saved_model_dir = WriteCheckpoint();
+  ResourceMgr resource_mgr;
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto restorer, LazyVariableRestorer::Create(
+                         CreateMetaGraphDef(), saved_model_dir, &resource_mgr));
+  EXPECT_EQ(restorer->num_variables(), 2);
+  EXPECT_EQ(restorer->num_restored_variables(), 0);
+
+  {
+    TF_ASSERT_OK_AND_ASSIGN(auto access, restorer->Acquire({"sig_a"}));
+    EXPECT_EQ(restorer->num_restored_variables(), 1);
+    ExpectVariable(resource_mgr, "a", test::AsTensor<float>({1, 2}));
+  }
+
+  TF_ASSERT_OK_AND_ASSIGN(auto access, restorer->AcquireAll());
+  EXPECT_EQ(restorer->num_restored_variables(), 2);
+  ExpectVariable(resource_mgr, "b", test::AsTensor<float>({3, 4, 5}));
+}
+
+TEST(LazyVariableRestorerTest, EvictsIdleUnpinnedVariables) {
+  const std::string saved_model_dir = WriteCheckpoint();
+  ResourceMgr resource_mgr;
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto restorer, LazyVariableRestorer::Create(
+                         CreateMetaGraphDef(), saved_model_dir, &resource_mgr));
+
+  TF_ASSERT_OK_AND_ASSIGN(auto access_a, restorer->Acquire({"sig_a"}));
+  { TF_ASSERT_OK_AND_ASSIGN(auto access_b, restorer->Acquire({"sig_b"})); }
+  EXPECT_EQ(restorer->num_restored_variables(), 2);
+
+  // `a` is pinned by `access_a`, so only `b` is evicted.
+  const absl::Time later = absl::Now() + absl::Hours(1);
+  EXPECT_EQ(restorer->EvictIdleVariables(absl::Minutes(1), later),
+            3 * sizeof(float));
+  EXPECT_EQ(restorer->num_restored_variables(), 1);
+
+  // An evicted variable is restored again on its next use.
+  TF_ASSERT_OK_AND_ASSIGN(auto access_b, restorer->Acquire({"sig_b"}));
+  ExpectVariable(resource_mgr, "b", test::AsTensor<float>({3, 4, 5}));
+}
+
+TEST(LazyVariableRestorerTest, ConcurrentAcquires) {
+  const std::string saved_model_dir = WriteCheckpoint();
+  ResourceMgr resource_mgr;
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto restorer, LazyVariableRestorer::Create(
+                         CreateMetaGraphDef(), saved_model_dir, &resource_mgr));
+
+  {
+    thread::ThreadPool pool(Env::Default(), "acquire", 8);
+    for (int i = 0; i < 64; ++i) {
+      pool.Schedule([&, i]() {
+        const std::vector<std::string> signatures =
+            i % 3 == 0 ? std::vector<std::string>{"sig_a"}
+            : i % 3 == 1 ? std::vector<std::string>{"sig_b"}
+                         : std::vector<std::string>{"sig_a", "sig_b"};
+        TF_ASSERT_OK(restorer->Acquire(signatures).status());
+        if (i % 16 == 0) {
+          restorer->EvictIdleVariables(absl::ZeroDuration(), absl::Now());
+        }
+      });
+    }
+  }
+
+  TF_ASSERT_OK_AND_ASSIGN(auto access, restorer->AcquireAll());
+  EXPECT_EQ(restorer->num_restored_variables(), 2);
+  ExpectVariable(resource_mgr, "a", test::AsTensor<float>({1, 2}));
+  ExpectVariable(resource_mgr, "b", test::AsTensor<float>({3, 4, 5}));
+}
+
+TEST(LazyVariableRestorerTest, PrefetchesInBackground) {
+  const std::string saved_model_dir = WriteCheckpoint();
+  ResourceMgr resource_mgr;
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto restorer, LazyVariableRestorer::Create(
+                         CreateMetaGraphDef(), saved_model_dir, &resource_mgr));
+  restorer->PrefetchAsync({"sig_b"});
+  restorer->WaitForPrefetches();
+  EXPECT_EQ(restorer->num_restored_variables(), 1);
+  ExpectVariable(resource_mgr, "b", test::AsTensor<float>({3, 4, 5}));
+}
+
+TEST(LazyVariableRestorerTest, SharesIdenticalVariablesAcrossModels) {
+  const std::string saved_model_dir =
+      io::JoinPath(testing::TmpDir(), "shared_lazy_variable_restorer_test");
+  // Large enough to be shared by the global store.
+  const int64_t num_elements =
+      SharedTensorStore::kDefaultMinTensorBytes / sizeof(float);
+  Tensor value(DT_FLOAT, TensorShape({num_elements}));
+  value.flat<float>().setConstant(1.0f);
+  BundleWriter writer(
+      Env::Default(),
+      io::JoinPath(saved_model_dir, kSavedModelVariablesDirectory,
+                   kSavedModelVariablesFilename));
+  TF_ASSERT_OK(writer.Add("a", value));
+  TF_ASSERT_OK(writer.Add("b", value));
+  TF_ASSERT_OK(writer.Finish());
+
+  SharedTensorStore::SetEnabled(true);
+  ResourceMgr resource_mgr_1;
+  ResourceMgr resource_mgr_2;
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto restorer_1,
+      LazyVariableRestorer::Create(CreateMetaGraphDef(), saved_model_dir,
+                                   &resource_mgr_1));
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto restorer_2,
+      LazyVariableRestorer::Create(CreateMetaGraphDef(), saved_model_dir,
+                                   &resource_mgr_2));
+  TF_ASSERT_OK_AND_ASSIGN(auto access_1, restorer_1->Acquire({"sig_a"}));
+  TF_ASSERT_OK_AND_ASSIGN(auto access_2, restorer_2->Acquire({"sig_a"}));
+  SharedTensorStore::SetEnabled(false);
+
+  Var* var_1 = nullptr;
+  Var* var_2 = nullptr;
+  TF_ASSERT_OK(resource_mgr_1.Lookup<Var>(resource_mgr_1.default_container(),
+                                          "a", &var_1));
+  core::ScopedUnref unref_1(var_1);
+  TF_ASSERT_OK(resource_mgr_2.Lookup<Var>(resource_mgr_2.default_container(),
+                                          "a", &var_2));
+  core::ScopedUnref unref_2(var_2);
+  EXPECT_TRUE(var_1->tensor()->SharesBufferWith(*var_2->tensor()));
+}
+
+TEST(LazyVariableRestorerTest, UnknownSignature) {
+  const std::string saved_model_dir = WriteCheckpoint();
+  ResourceMgr resource_mgr;
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto restorer, LazyVariableRestorer::Create(
+                         CreateMetaGraphDef(), saved_model_dir, &resource_mgr));
+  EXPECT_FALSE(restorer->Acquire({"unknown"}).ok());
+}
+
+TEST(LazyVariableRestorerTest, RestoreInitializerName) {
+  EXPECT_EQ(LazyVariableRestorer::GetRestoreInitializerName(
+                CreateMetaGraphDef()),
+            "__tf_saved_model_session_initializer_save/restore_all");
+}
+
+}  // namespace
+}  // namespace tfrt_stub
+}  // namespace tensorflow
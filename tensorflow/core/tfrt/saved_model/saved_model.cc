@@ -15,7 +15,9 @@ limitations under the License.
 #include "tensorflow/core/tfrt/saved_model/saved_model.h"
 
 #include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <iterator>
 #include <memory>
@@ -76,6 +78,7 @@ limitations under the License.
 #include "tensorflow/core/tfrt/mlrt/kernel/kernel.h"
 #include "tensorflow/core/tfrt/runtime/runtime.h"
 #include "tensorflow/core/tfrt/runtime/work_queue_interface.h"
+#include "tensorflow/core/tfrt/saved_model/lazy_variable_restorer.h"
 #include "tensorflow/core/tfrt/saved_model/saved_model_util.h"
 #include "tensorflow/core/tfrt/saved_model/utils/serialize_utils.h"
 #include "tensorflow/core/tfrt/stubs/model_config_stub.h"
@@ -132,6 +135,17 @@ auto* saved_model_input_spec_validation_failure =
         "/tensorflow/tfrt/saved_model/input_spec_validation_failure",
         "Record the models that failed input spec validation.", "model_name");
 
+auto* saved_model_warmup_time_seconds =
+    tensorflow::monitoring::Gauge<int64_t, 1>::New(
+        "/tensorflow/tfrt/saved_model/warmup_time",
+        "Record the warmup time for the savedmodel.", "model_name");
+
+auto* saved_model_warmup_steady_state =
+    tensorflow::monitoring::Gauge<bool, 1>::New(
+        "/tensorflow/tfrt/saved_model/warmup_steady_state",
+        "Record whether warmup brought the savedmodel to steady state.",
+        "model_name");
+
 tensorflow::Status RunBytecodeInitializers(
     const GraphExecutionOptions& options,
     const InitializersAndSignatures& initializers_and_signatures,
@@ -440,6 +454,69 @@ void UpdateCompileOptions(SavedModel::Options& options) {
       !options.graph_execution_options.enable_mlrt;
 }
 
+// Replays the recorded warmup requests of the model in `saved_model_dir`
+// against `model`.
+tensorflow::Status RunWarmupRequests(
+    saved_model::WarmupOptions warmup_options,
+    absl::string_view saved_model_dir, SavedModel& model) {
+  const auto warmup_start_time = absl::Now();
+  const SessionMetadata& model_metadata = model.model_metadata();
+  // Batch ops look up the warmup state by the model name and version, so an
+  // unnamed model cannot be warmed up at all batch sizes.
+  if (!warmup_options.model_key.has_value() && !model_metadata.name().empty()) {
+    warmup_options.model_key.emplace(model_metadata.name(),
+                                     model_metadata.version());
+  }
+  TF_ASSIGN_OR_RETURN(
+      auto requests,
+      saved_model::ReadWarmupRequests(saved_model_dir, warmup_options));
+  if (requests.empty()) return absl::OkStatus();
+
+  auto run_fn = [&](const saved_model::WarmupRequest& request)
+      -> tensorflow::Status {
+    const auto function_metadata =
+        model.GetFunctionMetadata(request.signature_name);
+    if (!function_metadata.has_value()) {
+      return tensorflow::errors::InvalidArgument(
+          "Warmup request for unknown signature ", request.signature_name);
+    }
+    // Signature inputs are passed in the order of the signature's input names.
+    std::vector<tensorflow::Tensor> inputs;
+    inputs.reserve(function_metadata->GetInputNames().size());
+    for (const auto& input_name : function_metadata->GetInputNames()) {
+      const auto input = std::find_if(
+          request.inputs.begin(), request.inputs.end(),
+          [&](const auto& named_input) {
+            return named_input.first == input_name;
+          });
+      if (input == request.inputs.end()) {
+        return tensorflow::errors::InvalidArgument(
+            "Warmup request for signature ", request.signature_name,
+            " is missing input ", input_name);
+      }
+      inputs.push_back(input->second);
+    }
+    std::vector<tensorflow::Tensor> outputs;
+    return model.Run(SavedModel::RunOptions(), request.signature_name, inputs,
+                     &outputs);
+  };
+  TF_ASSIGN_OR_RETURN(auto report,
+                      saved_model::RunWarmup(warmup_options, requests, run_fn));
+
+  const std::string saved_model_dir_string = std::string(saved_model_dir);
+  const auto warmup_duration = absl::Now() - warmup_start_time;
+  saved_model_warmup_time_seconds->GetCell(saved_model_dir_string)
+      ->Set(absl::ToInt64Seconds(warmup_duration));
+  saved_model_warmup_steady_state->GetCell(saved_model_dir_string)
+      ->Set(report.reached_steady_state);
+  LOG(INFO) << "TFRT finished warming up savedmodel with "
+            << report.num_requests << " requests in " << report.num_rounds
+            << " rounds. Took " << absl::ToInt64Milliseconds(warmup_duration)
+            << " ms. Steady state "
+            << (report.reached_steady_state ? "reached." : "not reached.");
+  return absl::OkStatus();
+}
+
 }  // namespace
 
 tensorflow::StatusOr<std::unique_ptr<SavedModel>>
@@ -551,6 +628,38 @@ SavedModelImpl::LoadSavedModel(Options options,
         GetInitializersAndSignatures(mlir_module.get()));
   }
 
+  // Plan the lazy variable restore before the graph is moved into the graph
+  // executor, and skip the restore initializer if the plan is supported.
+  std::unique_ptr<LazyVariableRestorer> lazy_variable_restorer;
+  if (options.enable_lazy_variable_restore) {
+    if (!options.enable_lazy_loading ||
+        options.graph_execution_options.compile_options.hoist_invariant_ops) {
+      LOG(WARNING) << "Lazy variable restore requires lazy loading without "
+                      "invariant op hoisting. Restoring variables eagerly.";
+    } else {
+      auto restorer = LazyVariableRestorer::Create(
+          meta_graph_def, saved_model_dir,
+          fallback_state->device_manager().HostCPU()->resource_manager());
+      if (restorer.ok()) {
+        lazy_variable_restorer = *std::move(restorer);
+        const std::string restore_initializer_name =
+            LazyVariableRestorer::GetRestoreInitializerName(meta_graph_def);
+        auto& initializers = initializers_and_signatures.initializers;
+        initializers.erase(
+            std::remove_if(initializers.begin(), initializers.end(),
+                           [&](const Initializer& initializer) {
+                             return initializer.name ==
+                                    restore_initializer_name;
+                           }),
+            initializers.end());
+      } else {
+        LOG(WARNING) << "Lazy variable restore is not supported for this "
+                        "model. Restoring variables eagerly: "
+                     << restorer.status();
+      }
+    }
+  }
+
   // If lazy loading is enabled, the user signatures are not exported via MLIR
   // module, so we need to get them from the proto.
   // TODO(b/187228559): Unify the code paths for populating the signature map.
@@ -682,13 +791,21 @@ SavedModelImpl::LoadSavedModel(Options options,
   }
 
   // Finally, create the saved model.
-  return {std::make_unique<SavedModelImpl>(
+  const bool enable_warmup = options.enable_warmup;
+  auto warmup_options = options.warmup_options;
+  auto saved_model = std::make_unique<SavedModelImpl>(
       std::move(options), std::move(symbol_uids), std::move(meta_graph_def),
       std::move(bef), std::move(bef_file), std::move(bytecode),
       std::move(loaded_executable),
       std::move(initializers_and_signatures.signature_map),
       std::move(runner_table), std::move(resource_array),
-      std::move(graph_executor))};
+      std::move(graph_executor), std::move(lazy_variable_restorer));
+
+  if (enable_warmup) {
+    TF_RETURN_IF_ERROR(RunWarmupRequests(std::move(warmup_options),
+                                         saved_model_dir, *saved_model));
+  }
+  return {std::move(saved_model)};
 }
 
 SavedModelImpl::SavedModelImpl(
@@ -698,7 +815,8 @@ SavedModelImpl::SavedModelImpl(
     std::optional<mlrt::LoadedExecutable> loaded_executable,
     SignatureMap signatures, std::unique_ptr<OpKernelRunnerTable> runner_table,
     std::unique_ptr<tfd::FallbackResourceArray> resource_array,
-    std::unique_ptr<GraphExecutor> graph_executor)
+    std::unique_ptr<GraphExecutor> graph_executor,
+    std::unique_ptr<LazyVariableRestorer> lazy_variable_restorer)
     : SavedModel(std::move(options), std::move(graph_executor)),
       symbol_uids_(std::move(symbol_uids)),
       meta_graph_def_(std::move(meta_graph_def)),
@@ -711,7 +829,29 @@ SavedModelImpl::SavedModelImpl(
               ->GetHostContext()),
       signatures_(std::move(signatures)),
       runner_table_(std::move(runner_table)),
-      resource_array_(std::move(resource_array)) {}
+      resource_array_(std::move(resource_array)),
+      lazy_variable_restorer_(std::move(lazy_variable_restorer)) {
+  if (lazy_variable_restorer_ == nullptr) return;
+  if (!options_.lazy_variable_prefetch_signatures.empty()) {
+    lazy_variable_restorer_->PrefetchAsync(
+        options_.lazy_variable_prefetch_signatures);
+  }
+  if (options_.lazy_variable_max_idle != absl::InfiniteDuration()) {
+    eviction_thread_.reset(tensorflow::Env::Default()->StartThread(
+        tensorflow::ThreadOptions(), "tfrt_saved_model_variable_eviction",
+        [this]() { EvictIdleVariablesPeriodically(); }));
+  }
+}
+
+SavedModelImpl::~SavedModelImpl() {
+  {
+    tensorflow::mutex_lock lock(eviction_mu_);
+    stop_eviction_ = true;
+  }
+  eviction_cv_.notify_all();
+  // Joins the eviction thread before the restorer is destroyed.
+  eviction_thread_.reset();
+}
 
 std::vector<std::string> SavedModelImpl::GetFunctionNames() const {
   std::vector<std::string> result;
@@ -745,6 +885,13 @@ tensorflow::Status SavedModelImpl::Run(
   const auto& signature = sig_iter->second;
   const auto& signature_def = meta_graph_def_.signature_def().at(name);
 
+  // Keep the variables used by this signature restored until it finishes.
+  std::optional<LazyVariableRestorer::ScopedAccess> variable_access;
+  if (lazy_variable_restorer_ != nullptr) {
+    TF_ASSIGN_OR_RETURN(variable_access,
+                        lazy_variable_restorer_->Acquire({std::string(name)}));
+  }
+
   if (options_.enable_lazy_loading &&
       options_.lazy_loading_use_graph_executor) {
     std::vector<std::pair<std::string, tensorflow::Tensor>> input_tensors;
@@ -868,6 +1015,12 @@ tensorflow::Status SavedModelImpl::RunMultipleSignatures(
         &visited_feed_tensor_names, flat_inputs, flat_output_names));
   }
 
+  std::optional<LazyVariableRestorer::ScopedAccess> variable_access;
+  if (lazy_variable_restorer_ != nullptr) {
+    TF_ASSIGN_OR_RETURN(variable_access,
+                        lazy_variable_restorer_->Acquire(names));
+  }
+
   std::vector<tensorflow::Tensor> flat_outputs;
 
   TF_RETURN_IF_ERROR(
@@ -924,10 +1077,36 @@ tensorflow::Status SavedModelImpl::RunByTensorNames(
     std::vector<tensorflow::Tensor>* outputs) {
   // TODO(b/192498110): Validate input type.
 
+  // The subgraph is not identified by signatures, so all variables are
+  // restored.
+  std::optional<LazyVariableRestorer::ScopedAccess> variable_access;
+  if (lazy_variable_restorer_ != nullptr) {
+    TF_ASSIGN_OR_RETURN(variable_access, lazy_variable_restorer_->AcquireAll());
+  }
+
   return graph_executor_->Run(run_options, inputs, output_tensor_names,
                               target_node_names, outputs);
 }
 
+int64_t SavedModelImpl::EvictIdleVariables(absl::Duration max_idle) {
+  if (lazy_variable_restorer_ == nullptr) return 0;
+  return lazy_variable_restorer_->EvictIdleVariables(max_idle, absl::Now());
+}
+
+void SavedModelImpl::EvictIdleVariablesPeriodically() {
+  const absl::Duration max_idle = options_.lazy_variable_max_idle;
+  // Checking twice per `max_idle` keeps idle variables for at most 1.5 times
+  // `max_idle`.
+  const auto period = std::chrono::microseconds(
+      std::max<int64_t>(absl::ToInt64Microseconds(max_idle / 2), 1000));
+  tensorflow::mutex_lock lock(eviction_mu_);
+  while (!stop_eviction_) {
+    eviction_cv_.wait_for(lock, period);
+    if (stop_eviction_) break;
+    EvictIdleVariables(max_idle);
+  }
+}
+
 namespace {
 
 using JoinedSignature = SavedModelImpl::JoinedSignature;
@@ -27,9 +27,13 @@ limitations under the License.
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
+#include "tensorflow/cc/saved_model/warmup.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
@@ -37,6 +41,7 @@ limitations under the License.
 #include "tensorflow/core/tfrt/graph_executor/graph_execution_options.h"
 #include "tensorflow/core/tfrt/graph_executor/graph_executor.h"
 #include "tensorflow/core/tfrt/runtime/runtime.h"
+#include "tensorflow/core/tfrt/saved_model/lazy_variable_restorer.h"
 #include "tensorflow/core/tfrt/saved_model/saved_model_util.h"
 #include "tsl/platform/protobuf.h"
 #include "tfrt/host_context/function.h"  // from @tf_runtime
@@ -110,6 +115,31 @@ class SavedModel {
     // True if and only if SavedModel is being loaded to generate AOT results.
     bool aot_generation = false;
 
+    // If true, the restore op is not run at load time. Instead, the variables
+    // reachable from a signature are restored from the checkpoint the first
+    // time the signature is run. This only takes effect when
+    // `enable_lazy_loading` is true and invariant ops are not hoisted, and
+    // models whose restore op is not supported are restored eagerly.
+    bool enable_lazy_variable_restore = false;
+
+    // Only used with `enable_lazy_variable_restore`. The variables of these
+    // signatures, which are expected to be hot, are restored in the background
+    // right after loading rather than by their first request.
+    std::vector<std::string> lazy_variable_prefetch_signatures;
+
+    // Only used with `enable_lazy_variable_restore`. If finite, a background
+    // thread evicts the lazily restored variables that have not been used for
+    // this long. They are restored again on their next use.
+    absl::Duration lazy_variable_max_idle = absl::InfiniteDuration();
+
+    // If true, the PredictLogs recorded in the model's
+    // assets.extra/tf_serving_warmup_requests file are replayed before the
+    // model is returned, so that the first requests do not pay for kernel
+    // creation, allocator growth and lazy signature loading. Batch ops run the
+    // requests at all of their allowed batch sizes.
+    bool enable_warmup = false;
+    saved_model::WarmupOptions warmup_options;
+
     GraphExecutionOptions graph_execution_options;
   };
 
@@ -226,9 +256,10 @@ class SavedModelImpl final : public SavedModel {
       absl::flat_hash_map<std::string, internal::Signature> signatures,
       std::unique_ptr<OpKernelRunnerTable> runner_table,
       std::unique_ptr<tfd::FallbackResourceArray> resource_array,
-      std::unique_ptr<GraphExecutor> graph_executor);
+      std::unique_ptr<GraphExecutor> graph_executor,
+      std::unique_ptr<LazyVariableRestorer> lazy_variable_restorer = nullptr);
 
-  ~SavedModelImpl() override = default;
+  ~SavedModelImpl() override;
 
   SavedModelImpl(const SavedModelImpl&) = delete;
   SavedModelImpl& operator=(const SavedModelImpl&) = delete;
@@ -256,7 +287,16 @@ class SavedModelImpl final : public SavedModel {
       absl::Span<const std::string> target_node_names,
       std::vector<tensorflow::Tensor>* outputs) override;
 
+  // Releases the lazily restored variables that have not been used for
+  // `max_idle`, e.g. when the host is under memory pressure. They are restored
+  // again on their next use. Returns the number of bytes released, which is
+  // zero if lazy variable restore is not enabled.
+  int64_t EvictIdleVariables(absl::Duration max_idle);
+
  private:
+  // Runs on `eviction_thread_` until `stop_eviction_` is set.
+  void EvictIdleVariablesPeriodically() TF_LOCKS_EXCLUDED(eviction_mu_);
+
   // The result of loading signature(s).
   struct LoadingResult {
     std::string name;
@@ -326,6 +366,14 @@ class SavedModelImpl final : public SavedModel {
   absl::flat_hash_map<std::string /*joined_name*/,
                       std::unique_ptr<LoadingResult>>
       loading_result_cache_ TF_GUARDED_BY(loading_result_cache_mu_);
+  // Only set if lazy variable restore is enabled.
+  std::unique_ptr<LazyVariableRestorer> lazy_variable_restorer_;
+  // Only set if lazy variable restore is enabled with a finite
+  // `lazy_variable_max_idle`.
+  std::unique_ptr<tensorflow::Thread> eviction_thread_;
+  tensorflow::mutex eviction_mu_;
+  tensorflow::condition_variable eviction_cv_;
+  bool stop_eviction_ TF_GUARDED_BY(eviction_mu_) = false;
 };
 
 class SavedModelMiraImpl;
@@ -22,6 +22,7 @@ limitations under the License.
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include "absl/time/time.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"  // from @llvm-project
 #include "tensorflow/compiler/mlir/tfrt/backend_compiler.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -800,6 +801,46 @@ TEST(SavedModelTest, ResourceGather) {
           tf_outputs[0].flat<int32_t>().data() + tf_outputs[0].NumElements())));
 }
 
+TEST(SavedModelTest, LazyVariableRestore) {
+  std::string saved_model_dir = tensorflow::GetDataDependencyFilepath(
+      "tensorflow/core/tfrt/saved_model/tests/resource_gather_v1");
+  auto runtime = DefaultTfrtRuntime(/*num_threads=*/1);
+  std::vector<tensorflow::Tensor> inputs;
+  inputs.push_back(CreateTfTensor<int32_t>(/*shape=*/{}, /*data=*/{1}));
+
+  auto eager_options = DefaultSavedModelOptions(runtime.get());
+  eager_options.enable_lazy_loading = true;
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto eager_model,
+      SavedModelImpl::LoadSavedModel(eager_options, saved_model_dir,
+                                     /*tags=*/{"serve"}));
+  std::vector<tensorflow::Tensor> eager_outputs;
+  TF_ASSERT_OK(
+      eager_model->Run({}, "serving_default", inputs, &eager_outputs));
+  ASSERT_EQ(eager_outputs.size(), 1);
+
+  auto lazy_options = DefaultSavedModelOptions(runtime.get());
+  lazy_options.enable_lazy_loading = true;
+  lazy_options.enable_lazy_variable_restore = true;
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto lazy_model,
+      SavedModelImpl::LoadSavedModel(lazy_options, saved_model_dir,
+                                     /*tags=*/{"serve"}));
+  auto* lazy_model_impl = static_cast<SavedModelImpl*>(lazy_model.get());
+  for (int i = 0; i < 2; ++i) {
+    std::vector<tensorflow::Tensor> lazy_outputs;
+    TF_ASSERT_OK(
+        lazy_model->Run({}, "serving_default", inputs, &lazy_outputs));
+    ASSERT_EQ(lazy_outputs.size(), 1);
+    EXPECT_EQ(GetTfTensorData<int32_t>(lazy_outputs[0]),
+              GetTfTensorData<int32_t>(eager_outputs[0]));
+
+    // The variable was restored by the run, and is restored again after it
+    // is evicted.
+    EXPECT_GT(lazy_model_impl->EvictIdleVariables(absl::ZeroDuration()), 0);
+  }
+}
+
 TEST(SavedModelTest, DTypeCoverage) {
   std::string saved_model_dir = tensorflow::GetDataDependencyFilepath(
       "tensorflow/core/tfrt/saved_model/tests/dtype_coverage_v1");
@@ -0,0 +1,140 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/tensor_bundle/shared_tensor_store.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/env_var.h"
+#include "tsl/lib/monitoring/counter.h"
+
+namespace tensorflow {
+namespace {
+
+auto* deduplicated_bytes = tsl::monitoring::Counter<0>::New(
+    "/tensorflow/core/shared_tensor_store/deduplicated_bytes",
+    "The total number of bytes of tensors that were replaced by an identical "
+    "tensor of the shared tensor store.");
+
+std::atomic<bool>& Enabled() {
+  static std::atomic<bool>* enabled = [] {
+    bool value = false;
+    Status status =
+        ReadBoolFromEnvVar("TF_SHARE_RESTORED_TENSORS", false, &value);
+    if (!status.ok()) LOG(ERROR) << status;
+    return new std::atomic<bool>(value);
+  }();
+  return *enabled;
+}
+
+}  // namespace
+
+SharedTensorStore* SharedTensorStore::Global() {
+  static SharedTensorStore* store =
+      new SharedTensorStore(kDefaultMinTensorBytes);
+  return store;
+}
+
+bool SharedTensorStore::IsEnabled() {
+  return Enabled().load(std::memory_order_relaxed);
+}
+
+void SharedTensorStore::SetEnabled(bool enabled) {
+  Enabled().store(enabled, std::memory_order_relaxed);
+}
+
+bool SharedTensorStore::IsEligible(const Tensor& tensor) const {
+  return tensor.IsInitialized() && DataTypeCanUseMemcpy(tensor.dtype()) &&
+         tensor.TotalBytes() > 0 && tensor.TotalBytes() >= min_tensor_bytes_ &&
+         tensor.IsAligned();
+}
+
+Tensor SharedTensorStore::Canonicalize(const Tensor& tensor) {
+  if (!IsEligible(tensor)) return tensor;
+  const absl::string_view data = tensor.tensor_data();
+  return Canonicalize(tensor,
+                      crc32c::Mask(crc32c::Value(data.data(), data.size())));
+}
+
+Tensor SharedTensorStore::Canonicalize(const Tensor& tensor,
+                                       uint32 masked_crc32c) {
+  if (!IsEligible(tensor)) return tensor;
+  Key key{tensor.dtype(), tensor.shape().dim_sizes(), masked_crc32c};
+  const absl::string_view data = tensor.tensor_data();
+
+  mutex_lock lock(mu_);
+  std::vector<Tensor>& candidates = tensors_[key];
+  for (const Tensor& candidate : candidates) {
+    if (candidate.SharesBufferWith(tensor)) return candidate;
+    const absl::string_view candidate_data = candidate.tensor_data();
+    if (std::memcmp(candidate_data.data(), data.data(), data.size()) == 0) {
+      deduplicated_bytes->GetCell()->IncrementBy(data.size());
+      return candidate;
+    }
+  }
+  candidates.push_back(tensor);
+  ++num_entries_;
+  size_bytes_ += data.size();
+  if (num_entries_ > 2 * num_entries_after_sweep_) SweepLocked();
+  return tensor;
+}
+
+int64_t SharedTensorStore::Sweep() {
+  mutex_lock lock(mu_);
+  return SweepLocked();
+}
+
+int64_t SharedTensorStore::SweepLocked() {
+  int64_t released_bytes = 0;
+  for (auto it = tensors_.begin(); it != tensors_.end();) {
+    std::vector<Tensor>& candidates = it->second;
+    for (int i = candidates.size() - 1; i >= 0; --i) {
+      if (!candidates[i].RefCountIsOne()) continue;
+      released_bytes += candidates[i].TotalBytes();
+      candidates[i] = std::move(candidates.back());
+      candidates.pop_back();
+      --num_entries_;
+    }
+    if (candidates.empty()) {
+      tensors_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+  size_bytes_ -= released_bytes;
+  num_entries_after_sweep_ = num_entries_;
+  return released_bytes;
+}
+
+int64_t SharedTensorStore::num_entries() const {
+  mutex_lock lock(mu_);
+  return num_entries_;
+}
+
+int64_t SharedTensorStore::size_bytes() const {
+  mutex_lock lock(mu_);
+  return size_bytes_;
+}
+
+}  // namespace tensorflow
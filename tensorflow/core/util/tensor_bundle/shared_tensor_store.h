@@ -0,0 +1,120 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_SHARED_TENSOR_STORE_H_
+#define TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_SHARED_TENSOR_STORE_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A process-wide, content-addressed store of read-only tensors. Models that
+// restore identical checkpoint entries or hold identical constants, e.g.
+// different versions of a model that share frozen embeddings, get tensors that
+// share a single buffer instead of one copy each.
+//
+// Sharing is safe for resource variables, which copy their buffer before an
+// in-place update when it is referenced elsewhere, and for constants. Ref
+// variables copy the restored value on assignment, so they do not share.
+//
+// Tensors are keyed by dtype, shape and the CRC32C checksum of their content,
+// which for checkpoint entries is read from the BundleEntryProto. Contents are
+// compared on a key match, so checksum collisions never alias tensors. An entry
+// is dropped once the store holds the only reference to its buffer.
+//
+// Thread-safe.
+class SharedTensorStore {
+ public:
+  // Tensors smaller than this are not worth an entry in the global store.
+  static constexpr int64_t kDefaultMinTensorBytes = 64 << 10;
+
+  explicit SharedTensorStore(int64_t min_tensor_bytes)
+      : min_tensor_bytes_(min_tensor_bytes) {}
+
+  SharedTensorStore(const SharedTensorStore&) = delete;
+  SharedTensorStore& operator=(const SharedTensorStore&) = delete;
+
+  // Returns the process-wide store.
+  static SharedTensorStore* Global();
+
+  // Whether restore ops and constants use the global store. Defaults to the
+  // value of the TF_SHARE_RESTORED_TENSORS environment variable, which is
+  // false if unset.
+  static bool IsEnabled();
+  static void SetEnabled(bool enabled);
+
+  // Returns a tensor with the same content as `tensor`, sharing its buffer with
+  // an identical tensor added before if there is one. Otherwise `tensor` is
+  // added to the store and returned. `tensor` must not be modified in place
+  // afterwards. Tensors of dtypes that are not memcpy-able, and tensors below
+  // the size threshold, are returned as is.
+  Tensor Canonicalize(const Tensor& tensor) TF_LOCKS_EXCLUDED(mu_);
+
+  // Like above, but with the masked CRC32C checksum of the content as recorded
+  // in BundleEntryProto::crc32c, to avoid computing it.
+  Tensor Canonicalize(const Tensor& tensor, uint32 masked_crc32c)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Drops the tensors that are no longer referenced outside the store. Returns
+  // the number of bytes released.
+  int64_t Sweep() TF_LOCKS_EXCLUDED(mu_);
+
+  int64_t num_entries() const TF_LOCKS_EXCLUDED(mu_);
+  int64_t size_bytes() const TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Key {
+    DataType dtype;
+    absl::InlinedVector<int64_t, 4> dims;
+    uint32 masked_crc32c;
+
+    template <typename H>
+    friend H AbslHashValue(H h, const Key& key) {
+      return H::combine(std::move(h), key.dtype, key.dims, key.masked_crc32c);
+    }
+    friend bool operator==(const Key& a, const Key& b) {
+      return a.dtype == b.dtype && a.dims == b.dims &&
+             a.masked_crc32c == b.masked_crc32c;
+    }
+  };
+
+  bool IsEligible(const Tensor& tensor) const;
+  int64_t SweepLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const int64_t min_tensor_bytes_;
+
+  mutable mutex mu_;
+  // Tensors with distinct contents may collide on a key, hence the vector.
+  absl::flat_hash_map<Key, std::vector<Tensor>> tensors_ TF_GUARDED_BY(mu_);
+  int64_t num_entries_ TF_GUARDED_BY(mu_) = 0;
+  int64_t size_bytes_ TF_GUARDED_BY(mu_) = 0;
+  // The number of entries after the last sweep. Sweeps are amortized by only
+  // running once the store has doubled since.
+  int64_t num_entries_after_sweep_ TF_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_SHARED_TENSOR_STORE_H_
@@ -0,0 +1,91 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/tensor_bundle/shared_tensor_store.h"
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(SharedTensorStoreTest, SharesIdenticalTensors) {
+  SharedTensorStore store(/*min_tensor_bytes=*/0);
+  Tensor a = test::AsTensor<float>({1, 2, 3});
+  Tensor b = test::AsTensor<float>({1, 2, 3});
+
+  EXPECT_TRUE(store.Canonicalize(a).SharesBufferWith(a));
+  Tensor shared = store.Canonicalize(b);
+  EXPECT_TRUE(shared.SharesBufferWith(a));
+  test::ExpectTensorEqual<float>(shared, b);
+  EXPECT_EQ(store.num_entries(), 1);
+  EXPECT_EQ(store.size_bytes(), 3 * sizeof(float));
+}
+
+TEST(SharedTensorStoreTest, DistinguishesShapesAndTypes) {
+  SharedTensorStore store(/*min_tensor_bytes=*/0);
+  Tensor a = test::AsTensor<int32>({1, 2, 3, 4}, {4});
+  Tensor b = test::AsTensor<int32>({1, 2, 3, 4}, {2, 2});
+  Tensor c = test::AsTensor<uint32>({1, 2, 3, 4}, {4});
+
+  store.Canonicalize(a);
+  EXPECT_TRUE(store.Canonicalize(b).SharesBufferWith(b));
+  EXPECT_TRUE(store.Canonicalize(c).SharesBufferWith(c));
+  EXPECT_EQ(store.num_entries(), 3);
+}
+
+TEST(SharedTensorStoreTest, ComparesContentsOnChecksumCollision) {
+  SharedTensorStore store(/*min_tensor_bytes=*/0);
+  Tensor a = test::AsTensor<float>({1, 2});
+  Tensor b = test::AsTensor<float>({3, 4});
+
+  // Both tensors claim the same checksum but differ in content.
+  store.Canonicalize(a, /*masked_crc32c=*/42);
+  Tensor result = store.Canonicalize(b, /*masked_crc32c=*/42);
+  EXPECT_TRUE(result.SharesBufferWith(b));
+  test::ExpectTensorEqual<float>(result, b);
+  EXPECT_EQ(store.num_entries(), 2);
+}
+
+TEST(SharedTensorStoreTest, SkipsSmallAndNonPodTensors) {
+  SharedTensorStore store(/*min_tensor_bytes=*/64);
+  Tensor small = test::AsTensor<float>({1, 2});
+  Tensor strings = test::AsTensor<tstring>(
+      {"a very long string that is well over the threshold of the store",
+       "another one"});
+
+  store.Canonicalize(small);
+  store.Canonicalize(strings);
+  EXPECT_EQ(store.num_entries(), 0);
+}
+
+TEST(SharedTensorStoreTest, SweepDropsUnreferencedTensors) {
+  SharedTensorStore store(/*min_tensor_bytes=*/0);
+  Tensor kept = test::AsTensor<float>({1, 2});
+  store.Canonicalize(kept);
+  store.Canonicalize(test::AsTensor<float>({3, 4, 5}));
+  EXPECT_EQ(store.num_entries(), 2);
+
+  EXPECT_EQ(store.Sweep(), 3 * sizeof(float));
+  EXPECT_EQ(store.num_entries(), 1);
+  EXPECT_EQ(store.size_bytes(), 2 * sizeof(float));
+  EXPECT_TRUE(store.Canonicalize(test::AsTensor<float>({1, 2}))
+                  .SharesBufferWith(kept));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -1198,6 +1198,17 @@ Status BundleReader::LookupTensorShape(StringPiece key, TensorShape* shape) {
   return LookupDtypeAndShape(key, &ignored, shape);
 }
 
+Status BundleReader::LookupChecksum(StringPiece key, uint32* masked_crc32c) {
+  BundleEntryProto entry;
+  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+  if (entry.slices_size() > 0) {
+    return errors::FailedPrecondition("Tensor ", key,
+                                      " is partitioned and has no checksum.");
+  }
+  *masked_crc32c = entry.crc32c();
+  return OkStatus();
+}
+
 string BundleReader::DebugString() {
   // Format used below emulates that of TensorSliceReader::DebugString().
   string shape_str;
@@ -237,6 +237,14 @@ class BundleReader {
   Status LookupTensorShape(absl::string_view key,
                            TensorShape* shape) TF_MUST_USE_RESULT;
 
+  // Looks up the masked crc32c checksum stored for the tensor keyed by "key",
+  // which identifies its contents without reading them. Returns a
+  // FailedPrecondition error if "key" refers to a partitioned tensor, whose
+  // contents are only checksummed per slice.
+  // REQUIRES: status().ok()
+  Status LookupChecksum(absl::string_view key,
+                        uint32* masked_crc32c) TF_MUST_USE_RESULT;
+
   // Looks up the tensor keyed by "key".  If "key" refers to a partitioned
   // tensor, attempts to look up the full contents using all stored slices.
   //
@@ -1038,6 +1038,33 @@ TEST(TensorBundleTest, Checksum) {
   }
 }
 
+TEST(TensorBundleTest, LookupChecksum) {
+  {
+    BundleWriter writer(Env::Default(), Prefix("lookup_checksum"));
+    TF_EXPECT_OK(writer.Add("a", Constant_2x3(1.f)));
+    TF_EXPECT_OK(writer.Add("b", Constant_2x3(1.f)));
+    TF_EXPECT_OK(writer.Add("c", Constant_2x3(2.f)));
+    TF_EXPECT_OK(writer.AddSlice("partitioned", TensorShape({2}),
+                                 TensorSlice::ParseOrDie("0,1"),
+                                 Constant<float>(0.f, TensorShape({1}))));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader reader(Env::Default(), Prefix("lookup_checksum"));
+  TF_ASSERT_OK(reader.status());
+
+  uint32 a, b, c;
+  TF_ASSERT_OK(reader.LookupChecksum("a", &a));
+  TF_ASSERT_OK(reader.LookupChecksum("b", &b));
+  TF_ASSERT_OK(reader.LookupChecksum("c", &c));
+  EXPECT_EQ(a, b);
+  EXPECT_NE(a, c);
+
+  uint32 ignored;
+  EXPECT_TRUE(errors::IsFailedPrecondition(
+      reader.LookupChecksum("partitioned", &ignored)));
+  EXPECT_TRUE(errors::IsNotFound(reader.LookupChecksum("missing", &ignored)));
+}
+
 TEST(TensorBundleTest, TruncatedTensorContents) {
   Env* env = Env::Default();
   BundleWriter writer(env, Prefix("end"));
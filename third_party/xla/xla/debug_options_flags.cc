@@ -76,6 +76,11 @@ DebugOptions DefaultDebugOptionsIgnoringFlags() {
 #endif
   opts.set_xla_cpu_use_xla_runtime(false);
   opts.set_xla_cpu_sparse_cuda_threads(0);
+  opts.set_xla_cpu_parallel_codegen_split_count(0);
+  opts.set_xla_cpu_parallel_tasks_per_thread(1);
+  opts.set_xla_cpu_use_thunk_runtime(false);
+  opts.set_xla_cpu_microkernel_gemm_max_size(0);
+  opts.set_xla_cpu_fusion_decisions_file("");
 
   opts.set_xla_cpu_enable_fast_math(false);
   // Disable forms of fast math that have caused users problems in the past.
@@ -640,6 +645,39 @@ void MakeDebugOptionsFlags(std::vector<tsl::Flag>* flag_list,
       debug_options->xla_cpu_sparse_cuda_threads(),
       "Sets number fo CUDA threads for sparse GPU acceleration in the CPU "
       "backend (0 = off)."));
+  flag_list->push_back(tsl::Flag(
+      "xla_cpu_parallel_codegen_split_count",
+      int32_setter_for(
+          &DebugOptions::set_xla_cpu_parallel_codegen_split_count),
+      debug_options->xla_cpu_parallel_codegen_split_count(),
+      "Splits the LLVM IR of a module into this many modules, which the CPU "
+      "backend optimizes and compiles in parallel (0 or 1 = off)."));
+  flag_list->push_back(tsl::Flag(
+      "xla_cpu_parallel_tasks_per_thread",
+      int32_setter_for(&DebugOptions::set_xla_cpu_parallel_tasks_per_thread),
+      debug_options->xla_cpu_parallel_tasks_per_thread(),
+      "Number of partitions per thread the CPU backend creates for the ops it "
+      "parallelizes. The threads claim the partitions dynamically, so more "
+      "partitions balance the work better on busy hosts."));
+  flag_list->push_back(tsl::Flag(
+      "xla_cpu_use_thunk_runtime",
+      bool_setter_for(&DebugOptions::set_xla_cpu_use_thunk_runtime),
+      debug_options->xla_cpu_use_thunk_runtime(),
+      "Runs the operations of the entry computation of CPU executables as "
+      "separate thunks, and the independent ones concurrently."));
+  flag_list->push_back(tsl::Flag(
+      "xla_cpu_microkernel_gemm_max_size",
+      int64_setter_for(&DebugOptions::set_xla_cpu_microkernel_gemm_max_size),
+      debug_options->xla_cpu_microkernel_gemm_max_size(),
+      "Emits row major F32 and F64 matrix multiplications with at most this "
+      "many multiply-adds with a cache and register blocked microkernel "
+      "instead of calling into Eigen (0 = off)."));
+  flag_list->push_back(tsl::Flag(
+      "xla_cpu_fusion_decisions_file",
+      string_setter_for(&DebugOptions::set_xla_cpu_fusion_decisions_file),
+      debug_options->xla_cpu_fusion_decisions_file(),
+      "A file with fusion decisions measured by the CPU fusion autotuner. "
+      "The fusions it measured to be slower than not fusing are skipped."));
   flag_list->push_back(tsl::Flag(
       "xla_gpu_crash_on_verification_failures",
       bool_setter_for(
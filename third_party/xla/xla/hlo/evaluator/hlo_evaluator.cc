@@ -30,6 +30,7 @@ limitations under the License.
 #include <optional>
 #include <random>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -4167,10 +4168,9 @@ Status HloEvaluator::HandleStochasticConvert(
   return OkStatus();
 }
 
-static bool IsScalarAdd(HloComputation* computation) {
+static bool IsScalarBinaryOp(HloComputation* computation, HloOpcode opcode) {
   HloInstruction* instruction = computation->root_instruction();
-  if (instruction->opcode() == HloOpcode::kAdd &&
-      computation->num_parameters() == 2) {
+  if (instruction->opcode() == opcode && computation->num_parameters() == 2) {
     const HloInstruction* lhs = instruction->operand(0);
     const HloInstruction* rhs = instruction->operand(1);
     return lhs->opcode() == HloOpcode::kParameter &&
@@ -4181,6 +4181,83 @@ static bool IsScalarAdd(HloComputation* computation) {
   return false;
 }
 
+static bool IsScalarAdd(HloComputation* computation) {
+  return IsScalarBinaryOp(computation, HloOpcode::kAdd);
+}
+
+// If `computation` is the maximum or the minimum of its two parameters, and
+// the input of the reduction has a real element type, reduces the input
+// elements visited with `base`, `counts` and `steps` into the element at
+// `output_index` of `result` with typed comparisons, rather than by
+// evaluating `computation` for each of them, and returns true. The operands
+// of the comparisons are in the same order as in `computation`, and NaNs
+// propagate like in HandleMaximum and HandleMinimum.
+static bool TryReduceWithMaxOrMin(HloComputation* computation,
+                                  absl::Span<const int64_t> output_index,
+                                  const Literal& init_value,
+                                  const Literal& input, Literal& result,
+                                  absl::Span<const int64_t> base,
+                                  absl::Span<const int64_t> counts,
+                                  absl::Span<const int64_t> steps) {
+  const bool is_max = IsScalarBinaryOp(computation, HloOpcode::kMaximum);
+  if (!is_max && !IsScalarBinaryOp(computation, HloOpcode::kMinimum)) {
+    return false;
+  }
+  const PrimitiveType element_type = input.shape().element_type();
+  if (init_value.shape().element_type() != element_type ||
+      result.shape().element_type() != element_type) {
+    return false;
+  }
+  // Whether the accumulator is the left-hand side of the comparisons.
+  const bool accumulator_is_lhs =
+      computation->root_instruction()->operand(0)->parameter_number() == 0;
+  return primitive_util::PrimitiveTypeSwitch<bool>(
+      [&](auto primitive_type_constant) -> bool {
+        if constexpr (primitive_type_constant == F32 ||
+                      primitive_type_constant == F64 ||
+                      primitive_type_constant == S8 ||
+                      primitive_type_constant == S16 ||
+                      primitive_type_constant == S32 ||
+                      primitive_type_constant == S64 ||
+                      primitive_type_constant == U8 ||
+                      primitive_type_constant == U16 ||
+                      primitive_type_constant == U32 ||
+                      primitive_type_constant == U64) {
+          using NativeT = primitive_util::NativeTypeOf<primitive_type_constant>;
+          auto apply = [&](NativeT lhs, NativeT rhs) {
+            if constexpr (std::is_floating_point_v<NativeT>) {
+              if (std::isnan(lhs)) {
+                return lhs;
+              }
+              if (std::isnan(rhs)) {
+                return rhs;
+              }
+            }
+            return is_max ? std::max(lhs, rhs) : std::min(lhs, rhs);
+          };
+          const Shape& shape = input.shape();
+          absl::Span<const int64_t> minor_to_major =
+              LayoutUtil::MinorToMajor(shape);
+          absl::Span<const NativeT> input_data = input.data<NativeT>();
+          NativeT accumulator = init_value.Get<NativeT>({});
+          ShapeUtil::ForEachIndexNoStatus(
+              shape, base, counts, steps,
+              [&](absl::Span<const int64_t> input_index) {
+                NativeT element =
+                    input_data[IndexUtil::MultidimensionalIndexToLinearIndex(
+                        shape, minor_to_major, input_index)];
+                accumulator = accumulator_is_lhs ? apply(accumulator, element)
+                                                 : apply(element, accumulator);
+                return true;
+              });
+          result.Set<NativeT>(output_index, accumulator);
+          return true;
+        }
+        return false;
+      },
+      element_type);
+}
+
 // Run a single step of an inner loop while running reduction, which applies
 // the user-provided computation on the accumulator and the output element
 // (until the reduction is completed, the output element is also used as
@@ -4260,6 +4337,13 @@ static StatusOr<bool> GenerateReduceOutputElement(
     results[i].CopyElementFrom(*init_values[i], {}, output_index);
   }
 
+  if (!is_tuple &&
+      TryReduceWithMaxOrMin(function, output_index, *init_values[0],
+                            *input_args[0], results[0], base, arg_dim_counts,
+                            arg_dim_steps)) {
+    return true;
+  }
+
   if (use_fast_add) {
     double computed_result = *init_values[0]->GetAsDouble({});
     const Literal* input_arg0 = input_args[0];
@@ -18,6 +18,8 @@ limitations under the License.
 
 #define _USE_MATH_DEFINES
 
+#include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <optional>
@@ -443,6 +445,12 @@ class HloEvaluator : public ConstDfsHloVisitorWithDefault {
     TF_RET_CHECK(ShapeUtil::SameDimensions(shape, operand->shape()));
 
     Literal result(shape);
+    absl::Span<const NativeT> operand_data = operand_literal.data<NativeT>();
+    if (TryEvaluateElementwiseOnFlatArrays<ReturnT>(
+            result, {&operand_literal},
+            [&](int64_t i) { return unary_op(operand_data[i]); })) {
+      return std::move(result);
+    }
     TF_RETURN_IF_ERROR(result.PopulateParallel<ReturnT>(
         [&](absl::Span<const int64_t> multi_index, int) {
           return unary_op(operand_literal.Get<NativeT>(multi_index));
@@ -450,6 +458,48 @@ class HloEvaluator : public ConstDfsHloVisitorWithDefault {
     return std::move(result);
   }
 
+  // If `result` and all the `operands` of an elementwise operation have the
+  // same static shape and layout, so that elements with the same linear index
+  // have the same multi-dimensional index, sets each element of `result` to
+  // `elementwise_op` of its linear index and returns true. This avoids
+  // computing the multi-dimensional index of every element. Large arrays are
+  // split into blocks that are evaluated in parallel.
+  template <typename ReturnT, typename ElementwiseOp>
+  static bool TryEvaluateElementwiseOnFlatArrays(
+      Literal& result, absl::Span<const Literal* const> operands,
+      const ElementwiseOp& elementwise_op) {
+    const Shape& shape = result.shape();
+    if (!shape.IsArray() || !shape.is_static() || !shape.has_layout()) {
+      return false;
+    }
+    for (const Literal* operand : operands) {
+      if (!ShapeUtil::EqualIgnoringElementType(operand->shape(), shape)) {
+        return false;
+      }
+    }
+    absl::Span<ReturnT> result_data = result.data<ReturnT>();
+    const int64_t num_elements = result_data.size();
+    constexpr int64_t kBlockSize = 16 * 1024;
+    auto evaluate_block = [&](int64_t block) {
+      const int64_t end = std::min(num_elements, (block + 1) * kBlockSize);
+      for (int64_t i = block * kBlockSize; i < end; ++i) {
+        result_data[i] = elementwise_op(i);
+      }
+    };
+    const int64_t num_blocks = CeilOfRatio(num_elements, kBlockSize);
+    if (num_blocks <= 1) {
+      evaluate_block(0);
+      return true;
+    }
+    ShapeUtil::ForEachIndexParallel(
+        ShapeUtil::MakeShape(S64, {num_blocks}),
+        [&](absl::Span<const int64_t> block, int /*thread_id*/) {
+          evaluate_block(block[0]);
+          return true;
+        });
+    return true;
+  }
+
   // Map from a primitive type to its associated (templated) DfsHloVisitor.
   std::unique_ptr<ConstDfsHloVisitor> typed_visitors_[PrimitiveType_ARRAYSIZE];
 
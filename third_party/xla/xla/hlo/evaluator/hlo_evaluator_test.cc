@@ -15,6 +15,7 @@ limitations under the License.
 #include "xla/hlo/evaluator/hlo_evaluator.h"
 
 #include <array>
+#include <cmath>
 #include <complex>
 #include <cstdint>
 #include <initializer_list>
@@ -2608,6 +2609,87 @@ TEST_F(HloEvaluatorPreciseReduceTest, AddReductionPrecisionTest) {
   LiteralTestUtil::ExpectR0Equal<float>(kNumElements, result);
 }
 
+TEST_F(HloEvaluatorTest, ElementwiseOpsOnLargeArrays) {
+  // Large enough for the elementwise operations to be evaluated in parallel
+  // blocks.
+  constexpr absl::string_view kHloText = R"(
+HloModule m
+
+ENTRY main {
+  p0 = f32[300,200]{1,0} parameter(0)
+  p1 = f32[300,200]{1,0} parameter(1)
+  p2 = f32[300,200]{0,1} parameter(2)
+  negate = f32[300,200]{1,0} negate(p0)
+  add = f32[300,200]{1,0} add(negate, p1)
+  gt = pred[300,200]{1,0} compare(p0, p1), direction=GT
+  select = f32[300,200]{1,0} select(gt, add, p1)
+  ROOT multiply = f32[300,200]{1,0} multiply(select, p2)
+}
+)";
+  Array2D<float> a0(300, 200), a1(300, 200), a2(300, 200);
+  Array2D<float> expected_array(300, 200);
+  for (int64_t i = 0; i < 300; ++i) {
+    for (int64_t j = 0; j < 200; ++j) {
+      a0(i, j) = (i * 7 + j * 3) % 11;
+      a1(i, j) = (i * 5 + j) % 13;
+      a2(i, j) = (i + j) % 3;
+      float select = a0(i, j) > a1(i, j) ? a1(i, j) - a0(i, j) : a1(i, j);
+      expected_array(i, j) = select * a2(i, j);
+    }
+  }
+  Literal arg0 = LiteralUtil::CreateR2FromArray2D(a0);
+  Literal arg1 = LiteralUtil::CreateR2FromArray2D(a1);
+  // Evaluated elementwise by multi-dimensional index, as its layout differs
+  // from that of the result.
+  Literal arg2 = LiteralUtil::CreateR2FromArray2DWithLayout(
+      a2, LayoutUtil::MakeLayout({0, 1}));
+  TF_ASSERT_OK_AND_ASSIGN(m_, ParseAndReturnVerifiedModule(kHloText));
+  TF_ASSERT_OK_AND_ASSIGN(Literal result, Evaluate({&arg0, &arg1, &arg2}));
+  EXPECT_TRUE(LiteralTestUtil::Equal(
+      LiteralUtil::CreateR2FromArray2D(expected_array), result));
+}
+
+TEST_F(HloEvaluatorTest, ReduceMaxAndMinPropagateNaN) {
+  constexpr absl::string_view kHloText = R"(
+HloModule m
+
+max {
+  lhs = f32[] parameter(0)
+  rhs = f32[] parameter(1)
+  ROOT max = f32[] maximum(lhs, rhs)
+}
+
+min {
+  lhs = s32[] parameter(0)
+  rhs = s32[] parameter(1)
+  ROOT min = s32[] minimum(rhs, lhs)
+}
+
+ENTRY main {
+  p0 = f32[3,4] parameter(0)
+  p1 = s32[3,4] parameter(1)
+  neg_inf = f32[] constant(-inf)
+  max_s32 = s32[] constant(2147483647)
+  reduce_max = f32[3] reduce(p0, neg_inf), dimensions={1}, to_apply=max
+  reduce_min = s32[4] reduce(p1, max_s32), dimensions={0}, to_apply=min
+  ROOT tuple = (f32[3], s32[4]) tuple(reduce_max, reduce_min)
+}
+)";
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  Literal arg0 = LiteralUtil::CreateR2<float>(
+      {{1, 5, -2, 3}, {7, nan, 8, 0}, {-1, -5, -3, -2}});
+  Literal arg1 = LiteralUtil::CreateR2<int32_t>(
+      {{4, -6, 2, 9}, {3, 1, 7, 8}, {5, 0, -7, 10}});
+  TF_ASSERT_OK_AND_ASSIGN(m_, ParseAndReturnVerifiedModule(kHloText));
+  TF_ASSERT_OK_AND_ASSIGN(Literal result, Evaluate({&arg0, &arg1}));
+  std::vector<Literal> results = result.DecomposeTuple();
+  EXPECT_EQ(results[0].Get<float>({0}), 5);
+  EXPECT_TRUE(std::isnan(results[0].Get<float>({1})));
+  EXPECT_EQ(results[0].Get<float>({2}), -1);
+  EXPECT_TRUE(LiteralTestUtil::Equal(
+      LiteralUtil::CreateR1<int32_t>({3, -6, -7, 8}), results[1]));
+}
+
 // Reducing many numbers should be fast because it doesn't create
 // intermediate Literals; the microbenchmark should finish in < 1 msec.
 void BM_ReducePrecisely(::testing::benchmark::State& state) {
@@ -2647,6 +2729,35 @@ void BM_ReducePrecisely(::testing::benchmark::State& state) {
 
 BENCHMARK(BM_ReducePrecisely);
 
+// Evaluates elementwise operations on range(0) x range(0) arrays, like the
+// constant folding of large constants does.
+void BM_ElementwiseOps(::testing::benchmark::State& state) {
+  const int64_t size = state.range(0);
+  HloComputation::Builder b("BM_ElementwiseOps");
+  HloModuleConfig config;
+  config.set_debug_options(GetDebugOptionsFromFlags());
+  HloModule module("BM_ElementwiseOps", config);
+
+  Array2D<float> array(size, size);
+  array.FillIota(0.0f);
+  const Shape shape = ShapeUtil::MakeShape(F32, {size, size});
+  HloInstruction* constant = b.AddInstruction(
+      HloInstruction::CreateConstant(LiteralUtil::CreateR2FromArray2D(array)));
+  HloInstruction* sin = b.AddInstruction(
+      HloInstruction::CreateUnary(shape, HloOpcode::kSin, constant));
+  HloInstruction* root = b.AddInstruction(HloInstruction::CreateBinary(
+      shape, HloOpcode::kMultiply, sin, constant));
+  module.AddEntryComputation(b.Build());
+
+  for (auto s : state) {
+    HloEvaluator hlo_eval;
+    hlo_eval.Evaluate(root).value();
+  }
+  state.SetItemsProcessed(state.iterations() * size * size);
+}
+
+BENCHMARK(BM_ElementwiseOps)->Arg(64)->Arg(512)->Arg(2048);
+
 TEST_P(HloEvaluatorBf16Test, ReduceAdd) {
   HloComputation::Builder b(TestName());
 
@@ -1018,8 +1018,10 @@ class HloEvaluatorTypedVisitor : public ConstDfsHloVisitorWithDefault {
     return HandleDotSlowPath(dot);
   }
 
-  template <typename NativeT, typename std::enable_if_t<
-                                  std::is_same_v<NativeT, float>>* = nullptr>
+  template <typename NativeT,
+            typename std::enable_if_t<std::is_same_v<NativeT, float> ||
+                                      std::is_same_v<NativeT, double>>* =
+                nullptr>
   Status HandleDot(const HloInstruction* dot) {
     const HloInstruction* lhs = dot->operand(0);
     const HloInstruction* rhs = dot->operand(1);
@@ -1083,8 +1085,10 @@ class HloEvaluatorTypedVisitor : public ConstDfsHloVisitorWithDefault {
     return OkStatus();
   }
 
-  template <typename NativeT, typename std::enable_if_t<
-                                  !std::is_same_v<NativeT, float>>* = nullptr>
+  template <typename NativeT,
+            typename std::enable_if_t<!std::is_same_v<NativeT, float> &&
+                                      !std::is_same_v<NativeT, double>>* =
+                nullptr>
   Status HandleDot(const HloInstruction* dot) {
     return HandleDotSlowPath(dot);
   }
@@ -1620,12 +1624,21 @@ class HloEvaluatorTypedVisitor : public ConstDfsHloVisitorWithDefault {
     const Literal& rhs_literal = parent_->GetEvaluatedLiteralFor(rhs);
 
     Literal result(shape);
-
+    const std::function<ReturnT(ReturnT, ReturnT)> converted_binary_op =
+        ConvertBinaryFunction(binary_op);
+
+    absl::Span<const ReturnT> lhs_data = lhs_literal.data<ReturnT>();
+    absl::Span<const ReturnT> rhs_data = rhs_literal.data<ReturnT>();
+    if (HloEvaluator::TryEvaluateElementwiseOnFlatArrays<ReturnT>(
+            result, {&lhs_literal, &rhs_literal}, [&](int64_t i) {
+              return converted_binary_op(lhs_data[i], rhs_data[i]);
+            })) {
+      return std::move(result);
+    }
     TF_RETURN_IF_ERROR(result.PopulateParallel<ReturnT>(
         [&](absl::Span<const int64_t> multi_index, int) {
-          return ConvertBinaryFunction(binary_op)(
-              lhs_literal.Get<ReturnT>(multi_index),
-              rhs_literal.Get<ReturnT>(multi_index));
+          return converted_binary_op(lhs_literal.Get<ReturnT>(multi_index),
+                                     rhs_literal.Get<ReturnT>(multi_index));
         }));
     return std::move(result);
   }
@@ -1648,6 +1661,15 @@ class HloEvaluatorTypedVisitor : public ConstDfsHloVisitorWithDefault {
 
     Literal result(shape);
 
+    absl::Span<const LhsType> lhs_data = lhs_literal.data<LhsType>();
+    absl::Span<const RhsType> rhs_data = rhs_literal.data<RhsType>();
+    absl::Span<const EhsType> ehs_data = ehs_literal.data<EhsType>();
+    if (HloEvaluator::TryEvaluateElementwiseOnFlatArrays<ReturnT>(
+            result, {&lhs_literal, &rhs_literal, &ehs_literal}, [&](int64_t i) {
+              return ternary_op(lhs_data[i], rhs_data[i], ehs_data[i]);
+            })) {
+      return std::move(result);
+    }
     TF_RETURN_IF_ERROR(result.PopulateParallel<ReturnT>(
         [&](absl::Span<const int64_t> multi_index, int) {
           return ternary_op(lhs_literal.Get<LhsType>(multi_index),
@@ -170,8 +170,7 @@ HloInstruction* HloComputation::AddInstruction(
 HloInstruction* HloComputation::AddInstructionInternal(
     std::unique_ptr<HloInstruction> instruction) {
   if (parent() != nullptr) {
-    instruction->UniquifyName(&parent()->instruction_name_uniquer());
-    instruction->SetUniqueId(parent()->NewUniqueInstructionId());
+    parent()->UniquifyInstrNameAndId(instruction.get());
   }
   instruction->set_parent(this);
   HloInstruction* pinst = instruction.release();  // Take ownership
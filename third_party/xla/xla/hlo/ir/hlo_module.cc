@@ -32,6 +32,8 @@ limitations under the License.
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "xla/hlo/ir/hlo_computation.h"
 #include "xla/hlo/ir/hlo_frontend_attributes.h"
 #include "xla/hlo/ir/hlo_input_output_alias_config.h"
@@ -117,6 +119,73 @@ HloModule::StackFrame HloModule::get_stack_frame(int id) const {
   return stack_frame;
 }
 
+namespace {
+
+// The module whose instruction names and ids the current thread defers, and
+// where the deferred instructions are recorded.
+thread_local const HloModule* deferred_uniquifying_module = nullptr;
+thread_local HloModule::DeferredInstrs* deferred_instrs = nullptr;
+
+}  // namespace
+
+HloModule::ScopedDeferredUniquifying::ScopedDeferredUniquifying(
+    const HloModule* module, DeferredInstrs* deferred)
+    : previous_module_(deferred_uniquifying_module),
+      previous_deferred_(deferred_instrs) {
+  deferred_uniquifying_module = module;
+  deferred_instrs = deferred;
+}
+
+HloModule::ScopedDeferredUniquifying::~ScopedDeferredUniquifying() {
+  deferred_uniquifying_module = previous_module_;
+  deferred_instrs = previous_deferred_;
+}
+
+void HloModule::UniquifyInstrNameAndId(HloInstruction* instr) {
+  if (deferred_uniquifying_module == this) {
+    // The id is still taken from the module, so that it is unique until the
+    // instruction gets its final id.
+    deferred_instrs->emplace(instr, true);
+    absl::MutexLock lock(&instruction_uniquer_mutex_);
+    instr->SetUniqueId(next_unique_id_++);
+    return;
+  }
+  absl::MutexLock lock(&instruction_uniquer_mutex_);
+  instr->UniquifyName(&instruction_name_uniquer_);
+  instr->SetUniqueId(next_unique_id_++);
+}
+
+void HloModule::SetAndUniquifyInstrName(HloInstruction* instr,
+                                        absl::string_view name) {
+  instr->SetAndSanitizeName(name);
+  if (deferred_uniquifying_module == this) {
+    // Keeps the id provisional if the instruction was added in this scope.
+    deferred_instrs->emplace(instr, false);
+    return;
+  }
+  absl::MutexLock lock(&instruction_uniquer_mutex_);
+  instr->UniquifyName(&instruction_name_uniquer_);
+}
+
+void HloModule::CommitDeferredInstrNamesAndIds(const DeferredInstrs& deferred,
+                                               HloComputation* computation) {
+  if (deferred.empty()) {
+    return;
+  }
+  absl::MutexLock lock(&instruction_uniquer_mutex_);
+  for (HloInstruction* instr : computation->instructions()) {
+    auto it = deferred.find(instr);
+    if (it == deferred.end()) {
+      continue;
+    }
+    instr->UniquifyName(&instruction_name_uniquer_);
+    if (it->second) {
+      instr->ClearUniqueIdInternal();
+      instr->SetUniqueId(next_unique_id_++);
+    }
+  }
+}
+
 HloComputation* HloModule::AddComputationInternal(
     std::unique_ptr<HloComputation> computation, bool is_entry,
     bool uniquify_identifiers, bool preserve_entry_layouts) {
@@ -30,6 +30,7 @@ limitations under the License.
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "xla/hlo/ir/dynamic_parameter_binding.h"
 #include "xla/hlo/ir/hlo_clone_context.h"
@@ -488,15 +489,53 @@ class HloModule {
   uint64_t RandomNew64() const;
 
   // Returns the NameUniquer for uniquing instruction names in this module.
+  // Unlike the methods below, using it is not thread-safe.
   NameUniquer& instruction_name_uniquer() { return instruction_name_uniquer_; }
 
   // Assign a new unique dense id for an instruction
   int NewUniqueInstructionId() {
+    absl::MutexLock lock(&instruction_uniquer_mutex_);
     int result = next_unique_id_;
     next_unique_id_++;
     return result;
   }
 
+  // Uniquifies the name of `instr` and assigns it a new unique id. This is
+  // thread-safe, so that instructions can be added to different computations
+  // of the module in parallel. While a ScopedDeferredUniquifying is active on
+  // the calling thread, the name is left as is and the id is provisional.
+  void UniquifyInstrNameAndId(HloInstruction* instr);
+
+  // The instructions whose names were left as is while a
+  // ScopedDeferredUniquifying was active, mapped to whether their ids are
+  // provisional.
+  using DeferredInstrs = absl::flat_hash_map<const HloInstruction*, bool>;
+
+  // While alive, defers uniquifying the names and ids of the instructions that
+  // the current thread adds to, or renames in, `module`, and records them in
+  // `deferred`. Passes that modify computations in parallel use this so that
+  // the names and ids don't depend on the order the threads ran in.
+  class ScopedDeferredUniquifying {
+   public:
+    ScopedDeferredUniquifying(const HloModule* module, DeferredInstrs* deferred);
+    ~ScopedDeferredUniquifying();
+
+    ScopedDeferredUniquifying(const ScopedDeferredUniquifying&) = delete;
+    ScopedDeferredUniquifying& operator=(const ScopedDeferredUniquifying&) =
+        delete;
+
+   private:
+    const HloModule* previous_module_;
+    DeferredInstrs* previous_deferred_;
+  };
+
+  // Uniquifies the names of the instructions of `computation` in `deferred`
+  // and assigns new ids to those with provisional ones, in instruction order.
+  // Committing the computations in a fixed order makes their names and ids
+  // deterministic.
+  void CommitDeferredInstrNamesAndIds(const DeferredInstrs& deferred,
+                                      HloComputation* computation);
+
   // input_output_alias_config indicates the list of aliased buffers that are
   // expected from the module.
   HloInputOutputAliasConfig& input_output_alias_config() {
@@ -541,10 +580,7 @@ class HloModule {
                                   /*preserve_entry_layouts=*/true);
   }
 
-  void SetAndUniquifyInstrName(HloInstruction* instr, absl::string_view name) {
-    instr->SetAndSanitizeName(name);
-    instr->UniquifyName(&instruction_name_uniquer_);
-  }
+  void SetAndUniquifyInstrName(HloInstruction* instr, absl::string_view name);
 
   Status CheckUniqueNamesAndIdsForComputationsAndInstructions() const;
 
@@ -725,6 +761,9 @@ class HloModule {
   NameUniquer computation_name_uniquer_{/*separator=*/"."};
   NameUniquer instruction_name_uniquer_{/*separator=*/"."};
   int next_unique_id_ = 0;
+  // Guards the instruction name uniquer and the next unique id while passes
+  // add instructions to computations in parallel.
+  absl::Mutex instruction_uniquer_mutex_;
 
   // Used to keep track of the next unique module id that should be assigned.
   static std::atomic<int> next_unique_module_id_;
@@ -357,14 +357,22 @@ StatusOr<std::unique_ptr<PjRtClient>> GetTfrtCpuClient(
     }
   }
 
+  std::unique_ptr<CpuExecutableCache> executable_cache;
+  if (!options.executable_cache_dir.empty()) {
+    executable_cache = std::make_unique<CpuExecutableCache>(
+        options.executable_cache_dir, options.executable_cache_max_bytes);
+  }
+
   return std::unique_ptr<PjRtClient>(std::make_unique<TfrtCpuClient>(
       /*process_index=*/options.node_id, std::move(devices),
-      std::move(options.collectives), num_threads));
+      std::move(options.collectives), num_threads,
+      std::move(executable_cache)));
 }
 
 TfrtCpuClient::TfrtCpuClient(
     int process_index, std::vector<std::unique_ptr<TfrtCpuDevice>> devices,
-    std::shared_ptr<cpu::CollectivesInterface> collectives, size_t num_threads)
+    std::shared_ptr<cpu::CollectivesInterface> collectives, size_t num_threads,
+    std::unique_ptr<CpuExecutableCache> executable_cache)
     : process_index_(process_index),
       owned_devices_(std::move(devices)),
       computation_placer_(std::make_unique<ComputationPlacer>()),
@@ -382,7 +390,8 @@ TfrtCpuClient::TfrtCpuClient(
       transpose_cache_(1024),
       collectives_(std::move(collectives)),
       topology_(TfrtCpuTopologyDescription::Create(
-          platform_id(), platform_name(), platform_version(), owned_devices_)) {
+          platform_id(), platform_name(), platform_version(), owned_devices_)),
+      executable_cache_(std::move(executable_cache)) {
   for (const std::unique_ptr<TfrtCpuDevice>& device : owned_devices_) {
     devices_.push_back(device.get());
     CHECK(id_to_device_.insert({device->id(), device.get()}).second)
@@ -681,6 +690,45 @@ static StatusOr<std::unique_ptr<xla::Executable>> JitCompile(
 
 StatusOr<std::unique_ptr<PjRtLoadedExecutable>> TfrtCpuClient::Compile(
     const XlaComputation& computation, CompileOptions options) {
+  if (executable_cache_ == nullptr) {
+    return CompileUncached(computation, std::move(options));
+  }
+
+  // Options that can't be serialized, e.g. a compile thread pool, can't be
+  // part of the key, so such compilations bypass the cache.
+  StatusOr<std::string> cache_key =
+      CpuExecutableCache::Key(computation, options);
+  if (!cache_key.ok()) {
+    VLOG(1) << "Not caching the executable of " << computation.name() << ": "
+            << cache_key.status();
+    return CompileUncached(computation, std::move(options));
+  }
+  const std::string& key = *cache_key;
+  if (std::optional<std::string> serialized = executable_cache_->Lookup(key)) {
+    StatusOr<std::unique_ptr<PjRtLoadedExecutable>> executable =
+        DeserializeExecutable(*serialized, options);
+    if (executable.ok()) return executable;
+    LOG(WARNING) << "Recompiling " << computation.name()
+                 << " as its cached executable can't be loaded: "
+                 << executable.status();
+    executable_cache_->Erase(key);
+  }
+
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<PjRtLoadedExecutable> executable,
+                      CompileUncached(computation, options));
+  StatusOr<std::string> serialized = executable->SerializeExecutable();
+  Status status = serialized.ok() ? executable_cache_->Store(key, *serialized)
+                                  : serialized.status();
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to cache the executable of " << computation.name()
+                 << " in " << executable_cache_->directory() << ": "
+                 << status;
+  }
+  return executable;
+}
+
+StatusOr<std::unique_ptr<PjRtLoadedExecutable>> TfrtCpuClient::CompileUncached(
+    const XlaComputation& computation, CompileOptions options) {
   tsl::profiler::TraceMe traceme("TfrtCpuClient::Compile");
   auto input_options = options;
   ExecutableBuildOptions& build_options = options.executable_build_options;
@@ -1332,6 +1380,10 @@ StatusOr<PjRtLoadedExecutable::Result> TfrtCpuExecutable::ExecuteHelper(
       Status status = cpu_executable->ExecuteXlaRuntime(
           MakeXLARuntimeDescriptorTable(buffer_table), &run_options);
       if (!status.ok()) return status;
+    } else if (cpu_executable->HasThunks()) {
+      Status status = cpu_executable->ExecuteThunks(
+          &run_options, buffer_pointers.data(), nullptr);
+      if (!status.ok()) return status;
     } else {
       cpu_executable->compute_function()(result_buffer, &run_options, nullptr,
                                          buffer_pointers.data(), &status,
@@ -1390,6 +1442,7 @@ StatusOr<PjRtLoadedExecutable::Result> TfrtCpuExecutable::ExecuteHelper(
 
           // Call generated function.
           std::optional<absl::string_view> error_message;
+          Status thunks_status;
           if (cpu_executable->IsXlaRuntime()) {
             Status s = cpu_executable->ExecuteXlaRuntime(
                 MakeXLARuntimeDescriptorTable(buffer_table), &run_options);
@@ -1397,6 +1450,10 @@ StatusOr<PjRtLoadedExecutable::Result> TfrtCpuExecutable::ExecuteHelper(
               // TODO(kramerb): Propagate custom call error messages.
               error_message = "XLA Runtime execution failed";
             }
+          } else if (cpu_executable->HasThunks()) {
+            thunks_status = cpu_executable->ExecuteThunks(
+                &run_options, buffer_pointers.data(), nullptr);
+            if (!thunks_status.ok()) error_message = thunks_status.message();
           } else {
             XlaCustomCallStatus status;
             cpu_executable->compute_function()(result_buffer, &run_options,
@@ -39,6 +39,7 @@ limitations under the License.
 #include "xla/hlo/ir/hlo_module.h"
 #include "xla/literal.h"
 #include "xla/pjrt/cpu/abstract_tfrt_cpu_buffer.h"
+#include "xla/pjrt/cpu/cpu_executable_cache.h"
 #include "xla/pjrt/cpu/cpu_topology.h"
 #include "xla/pjrt/cpu/tracked_tfrt_cpu_device_buffer.h"
 #include "xla/pjrt/distributed/key_value_store_interface.h"
@@ -251,7 +252,8 @@ class TfrtCpuClient final : public PjRtClient {
   TfrtCpuClient(int process_index,
                 std::vector<std::unique_ptr<TfrtCpuDevice>> devices,
                 std::shared_ptr<cpu::CollectivesInterface> collectives,
-                size_t num_threads);
+                size_t num_threads,
+                std::unique_ptr<CpuExecutableCache> executable_cache = nullptr);
   ~TfrtCpuClient() override;
 
   int process_index() const override { return process_index_; }
@@ -399,9 +401,17 @@ class TfrtCpuClient final : public PjRtClient {
     return &topology_;
   }
 
+  // The persistent cache of compiled executables, or nullptr.
+  CpuExecutableCache* executable_cache() const {
+    return executable_cache_.get();
+  }
+
  private:
   friend class TfrtCpuExecutable;
 
+  StatusOr<std::unique_ptr<PjRtLoadedExecutable>> CompileUncached(
+      const XlaComputation& computation, CompileOptions options);
+
   int process_index_;
   // Includes all devices, including non-addressable devices.
   std::vector<std::unique_ptr<TfrtCpuDevice>> owned_devices_;
@@ -444,6 +454,8 @@ class TfrtCpuClient final : public PjRtClient {
   std::shared_ptr<cpu::CollectivesInterface> collectives_;
 
   xla::TfrtCpuTopologyDescription topology_;
+
+  std::unique_ptr<CpuExecutableCache> executable_cache_;
 };
 
 class TfrtCpuBuffer final : public AbstractTfrtCpuBuffer {
@@ -664,6 +676,14 @@ struct CpuClientOptions {
   // Distributed collectives implementation. Optional. If not provided, an
   // in-process collectives implementation will be used.
   std::shared_ptr<cpu::CollectivesInterface> collectives;
+
+  // Directory of a persistent cache of compiled executables, which can be
+  // shared by several processes. Executables aren't cached if it's empty.
+  std::string executable_cache_dir;
+
+  // Size limit of the executable cache. The least recently written
+  // executables are evicted beyond it.
+  int64_t executable_cache_max_bytes = int64_t{1} << 30;
 };
 StatusOr<std::unique_ptr<PjRtClient>> GetTfrtCpuClient(
     const CpuClientOptions& options);
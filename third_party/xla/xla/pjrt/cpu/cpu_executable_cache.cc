@@ -0,0 +1,252 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/pjrt/cpu/cpu_executable_cache.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <dlfcn.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/TargetParser/Host.h"
+#include "xla/client/xla_computation.h"
+#include "xla/debug_options_flags.h"
+#include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/pjrt/compile_options.pb.h"
+#include "xla/pjrt/pjrt_executable.h"
+#include "xla/service/cpu/cpu_fusion_decisions.h"
+#include "xla/service/cpu/fusion_decisions.pb.h"
+#include "xla/service/hlo_module_config.h"
+#include "xla/xla.pb.h"
+#include "tsl/lib/monitoring/counter.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/errors.h"
+#include "tsl/platform/file_system.h"
+#include "tsl/platform/fingerprint.h"
+#include "tsl/platform/logging.h"
+#include "tsl/platform/path.h"
+#include "tsl/platform/random.h"
+#include "tsl/platform/statusor.h"
+
+namespace xla {
+
+namespace {
+
+// Version of the cache entries. Must be bumped whenever the serialization of
+// CPU executables changes.
+constexpr int kCacheVersion = 1;
+
+constexpr absl::string_view kEntrySuffix = ".executable";
+
+auto* cpu_executable_cache_requests = tsl::monitoring::Counter<1>::New(
+    "/pjrt/cpu/executable_cache_requests",
+    "The number of lookups in the persistent CPU executable cache.", "result");
+
+// Identifies the build of XLA: executables compiled by another build may call
+// runtime functions that don't exist, or have changed, in this one.
+const std::string& BuildId() {
+  static const std::string* build_id = [] {
+    std::string id;
+#if defined(__linux__) || defined(__APPLE__)
+    // The library or binary XLA is linked into.
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void*>(&BuildId), &info) != 0 &&
+        info.dli_fname != nullptr) {
+      tsl::FileStatistics stats;
+      if (tsl::Env::Default()->Stat(info.dli_fname, &stats).ok()) {
+        id = absl::StrCat(info.dli_fname, ":", stats.length, ":",
+                          stats.mtime_nsec);
+      }
+    }
+#endif
+    return new std::string(std::move(id));
+  }();
+  return *build_id;
+}
+
+// The CPU and features the JIT compiles for.
+const std::string& HostTarget() {
+  static const std::string* host_target = [] {
+    std::string target(llvm::sys::getHostCPUName());
+    llvm::StringMap<bool> features;
+    if (llvm::sys::getHostCPUFeatures(features)) {
+      std::vector<std::string> enabled;
+      for (const auto& feature : features) {
+        if (feature.getValue()) enabled.push_back(feature.getKey().str());
+      }
+      std::sort(enabled.begin(), enabled.end());
+      for (const std::string& feature : enabled) {
+        absl::StrAppend(&target, ",", feature);
+      }
+    }
+    return new std::string(std::move(target));
+  }();
+  return *host_target;
+}
+
+}  // namespace
+
+CpuExecutableCache::CpuExecutableCache(std::string directory,
+                                       int64_t max_bytes)
+    : directory_(std::move(directory)), max_bytes_(max_bytes) {}
+
+/*static*/ absl::StatusOr<std::string> CpuExecutableCache::Key(
+    const XlaComputation& computation, const CompileOptions& options) {
+  // The fingerprint of the module ignores the ids of the instructions and
+  // computations, which depend on what else the process built, but unlike
+  // HloPrintOptions::Fingerprint() it includes all the constants, which are
+  // embedded in the executable.
+  TF_ASSIGN_OR_RETURN(HloModuleConfig config,
+                      HloModule::CreateModuleConfigFromProto(
+                          computation.proto(), DebugOptions()));
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<HloModule> module,
+                      HloModule::CreateFromProto(computation.proto(), config));
+  const HloPrintOptions print_options =
+      HloPrintOptions::Fingerprint()
+          .set_print_only_essential_constants(false)
+          .set_print_large_constants(true)
+          .set_print_infeed_outfeed_config(true);
+
+  TF_ASSIGN_OR_RETURN(CompileOptionsProto options_proto, options.ToProto());
+  // Without debug options in the build options, the compiler uses the ones
+  // of the flags.
+  const DebugOptions debug_options =
+      options.executable_build_options.has_debug_options()
+          ? options.executable_build_options.debug_options()
+          : GetDebugOptionsFromFlags();
+
+  // The debug options only name the fusion decisions file, but the fusions
+  // the compiler makes depend on which ones the file rejects.
+  std::string rejected_fusions;
+  const std::string& decisions_file =
+      debug_options.xla_cpu_fusion_decisions_file();
+  if (!decisions_file.empty()) {
+    TF_ASSIGN_OR_RETURN(cpu::FusionDecisionsProto decisions,
+                        cpu::LoadFusionDecisions(decisions_file));
+    const absl::flat_hash_set<uint64_t> rejected =
+        cpu::GetRejectedFusions(decisions);
+    std::vector<uint64_t> sorted(rejected.begin(), rejected.end());
+    std::sort(sorted.begin(), sorted.end());
+    rejected_fusions = absl::StrJoin(sorted, ",");
+  }
+
+  const tsl::Fprint128 fingerprint = tsl::Fingerprint128(absl::StrCat(
+      kCacheVersion, "\n", BuildId(), "\n", HostTarget(), "\n",
+      options_proto.DebugString(), "\n", debug_options.DebugString(), "\n",
+      rejected_fusions, "\n", module->ToString(print_options)));
+  return absl::StrCat(absl::Hex(fingerprint.high64, absl::kZeroPad16),
+                      absl::Hex(fingerprint.low64, absl::kZeroPad16));
+}
+
+std::string CpuExecutableCache::EntryPath(absl::string_view key) const {
+  return tsl::io::JoinPath(directory_, absl::StrCat(key, kEntrySuffix));
+}
+
+std::optional<std::string> CpuExecutableCache::Lookup(absl::string_view key) {
+  std::string serialized;
+  const absl::Status status =
+      tsl::ReadFileToString(tsl::Env::Default(), EntryPath(key), &serialized);
+  if (!status.ok()) {
+    ++misses_;
+    cpu_executable_cache_requests->GetCell("miss")->IncrementBy(1);
+    VLOG(1) << "CPU executable cache miss for " << key;
+    return std::nullopt;
+  }
+  ++hits_;
+  cpu_executable_cache_requests->GetCell("hit")->IncrementBy(1);
+  VLOG(1) << "CPU executable cache hit for " << key;
+  return serialized;
+}
+
+absl::Status CpuExecutableCache::Store(absl::string_view key,
+                                       absl::string_view serialized_executable) {
+  tsl::Env* env = tsl::Env::Default();
+  TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(directory_));
+  // Write to a temporary file first, so that a concurrent lookup never reads
+  // a partially written entry.
+  const std::string path = EntryPath(key);
+  const std::string tmp_path = absl::StrCat(path, ".tmp", tsl::random::New64());
+  std::unique_ptr<tsl::WritableFile> file;
+  TF_RETURN_IF_ERROR(env->NewWritableFile(tmp_path, &file));
+  absl::Status status = file->Append(serialized_executable);
+  if (status.ok()) status = file->Close();
+  if (status.ok()) status = env->RenameFile(tmp_path, path);
+  if (!status.ok()) {
+    env->DeleteFile(tmp_path).IgnoreError();
+    return status;
+  }
+  return Evict(path);
+}
+
+void CpuExecutableCache::Erase(absl::string_view key) {
+  tsl::Env::Default()->DeleteFile(EntryPath(key)).IgnoreError();
+}
+
+absl::Status CpuExecutableCache::Evict(absl::string_view newest_path) {
+  tsl::Env* env = tsl::Env::Default();
+  std::vector<std::string> children;
+  TF_RETURN_IF_ERROR(env->GetChildren(directory_, &children));
+
+  struct Entry {
+    std::string path;
+    int64_t size;
+    int64_t mtime_nsec;
+  };
+  std::vector<Entry> entries;
+  int64_t total_bytes = 0;
+  for (const std::string& child : children) {
+    if (!absl::EndsWith(child, kEntrySuffix)) continue;
+    std::string path = tsl::io::JoinPath(directory_, child);
+    tsl::FileStatistics stats;
+    // Another process may have evicted the entry in the meantime.
+    if (!env->Stat(path, &stats).ok()) continue;
+    total_bytes += stats.length;
+    entries.push_back({std::move(path), stats.length, stats.mtime_nsec});
+  }
+  if (total_bytes <= max_bytes_) return absl::OkStatus();
+
+  // The modification times may be too coarse to order the entry that was
+  // just written after the others.
+  std::sort(entries.begin(), entries.end(),
+            [&](const Entry& a, const Entry& b) {
+              return std::make_pair(a.path == newest_path, a.mtime_nsec) <
+                     std::make_pair(b.path == newest_path, b.mtime_nsec);
+            });
+  for (const Entry& entry : entries) {
+    if (total_bytes <= max_bytes_) break;
+    VLOG(1) << "Evicting " << entry.path << " from the CPU executable cache";
+    env->DeleteFile(entry.path).IgnoreError();
+    total_bytes -= entry.size;
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace xla
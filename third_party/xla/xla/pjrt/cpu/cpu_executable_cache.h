@@ -0,0 +1,83 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_PJRT_CPU_CPU_EXECUTABLE_CACHE_H_
+#define XLA_PJRT_CPU_CPU_EXECUTABLE_CACHE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "xla/client/xla_computation.h"
+#include "xla/pjrt/pjrt_executable.h"
+
+namespace xla {
+
+// A persistent cache of serialized CPU executables, stored as one file per
+// executable in a directory that can be shared by several processes.
+//
+// Executables are keyed by a fingerprint of the HLO module, the compile
+// options, the debug options used by the compiler, the features of the host
+// CPU, and the build of XLA, so that an executable is only reused by a
+// process that would have compiled the same machine code.
+//
+// Entries are written to a temporary file and renamed, so that concurrent
+// readers never see partially written entries. Once the total size of the
+// entries exceeds `max_bytes`, the least recently written entries are evicted.
+class CpuExecutableCache {
+ public:
+  CpuExecutableCache(std::string directory, int64_t max_bytes);
+
+  // Returns the key of `computation` compiled with `options` for the host.
+  static absl::StatusOr<std::string> Key(const XlaComputation& computation,
+                                         const CompileOptions& options);
+
+  // Returns the serialized executable stored under `key`, if any.
+  std::optional<std::string> Lookup(absl::string_view key);
+
+  // Stores `serialized_executable` under `key`, and evicts old entries if the
+  // cache is over its size limit.
+  absl::Status Store(absl::string_view key,
+                     absl::string_view serialized_executable);
+
+  // Removes the entry stored under `key`, e.g. if it can't be loaded.
+  void Erase(absl::string_view key);
+
+  const std::string& directory() const { return directory_; }
+
+  int64_t hits() const { return hits_; }
+  int64_t misses() const { return misses_; }
+
+ private:
+  std::string EntryPath(absl::string_view key) const;
+
+  // Deletes the oldest entries until the cache fits in `max_bytes_`, the
+  // entry at `newest_path` last.
+  absl::Status Evict(absl::string_view newest_path);
+
+  const std::string directory_;
+  const int64_t max_bytes_;
+
+  std::atomic<int64_t> hits_ = 0;
+  std::atomic<int64_t> misses_ = 0;
+};
+
+}  // namespace xla
+
+#endif  // XLA_PJRT_CPU_CPU_EXECUTABLE_CACHE_H_
@@ -0,0 +1,200 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/pjrt/cpu/cpu_executable_cache.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "xla/client/xla_computation.h"
+#include "xla/literal.h"
+#include "xla/literal_util.h"
+#include "xla/pjrt/cpu/cpu_client.h"
+#include "xla/pjrt/pjrt_executable.h"
+#include "xla/service/cpu/cpu_fusion_decisions.h"
+#include "xla/service/cpu/fusion_decisions.pb.h"
+#include "xla/service/hlo_parser.h"
+#include "tsl/lib/core/status_test_util.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/path.h"
+#include "tsl/platform/statusor.h"
+#include "tsl/platform/test.h"
+#include "tsl/platform/threadpool.h"
+
+namespace xla {
+namespace {
+
+constexpr char kProgram[] = R"(
+HloModule add
+ENTRY add {
+  x = f32[4] parameter(0)
+  c = f32[4] constant({1, 2, 3, 4})
+  ROOT add = f32[4] add(x, c)
+})";
+
+std::string CacheDir(const std::string& name) {
+  std::string dir =
+      tsl::io::JoinPath(tsl::testing::TmpDir(), "cpu_executable_cache", name);
+  int64_t undeleted_files, undeleted_dirs;
+  tsl::Env::Default()
+      ->DeleteRecursively(dir, &undeleted_files, &undeleted_dirs)
+      .IgnoreError();
+  return dir;
+}
+
+XlaComputation Parse(const char* program) {
+  auto module = ParseAndReturnUnverifiedModule(program);
+  CHECK_OK(module.status());
+  return XlaComputation((*module)->ToProto());
+}
+
+TEST(CpuExecutableCacheTest, KeysDependOnProgramAndOptions) {
+  XlaComputation computation = Parse(kProgram);
+  TF_ASSERT_OK_AND_ASSIGN(std::string key,
+                          CpuExecutableCache::Key(computation, {}));
+  // The ids of the HLO don't change the key.
+  TF_ASSERT_OK_AND_ASSIGN(std::string same_key,
+                          CpuExecutableCache::Key(Parse(kProgram), {}));
+  EXPECT_EQ(key, same_key);
+
+  TF_ASSERT_OK_AND_ASSIGN(std::string other_constant_key,
+                          CpuExecutableCache::Key(Parse(R"(
+HloModule add
+ENTRY add {
+  x = f32[4] parameter(0)
+  c = f32[4] constant({1, 2, 3, 5})
+  ROOT add = f32[4] add(x, c)
+})"),
+                                                  {}));
+  EXPECT_NE(key, other_constant_key);
+
+  CompileOptions options;
+  options.executable_build_options.mutable_debug_options()
+      ->set_xla_cpu_enable_fast_math(true);
+  TF_ASSERT_OK_AND_ASSIGN(std::string other_options_key,
+                          CpuExecutableCache::Key(computation, options));
+  EXPECT_NE(key, other_options_key);
+}
+
+TEST(CpuExecutableCacheTest, KeysDependOnRejectedFusions) {
+  const std::string decisions_file = tsl::io::JoinPath(
+      tsl::testing::TmpDir(), "cpu_executable_cache_fusion_decisions.pbtxt");
+  XlaComputation computation = Parse(kProgram);
+  CompileOptions options;
+  options.executable_build_options.mutable_debug_options()
+      ->set_xla_cpu_fusion_decisions_file(decisions_file);
+
+  cpu::FusionDecisionsProto decisions;
+  cpu::FusionDecisionProto* decision = decisions.add_decisions();
+  decision->set_fingerprint(1);
+  decision->set_fuse(true);
+  TF_ASSERT_OK(cpu::SaveFusionDecisions(decisions_file, decisions));
+  TF_ASSERT_OK_AND_ASSIGN(std::string key,
+                          CpuExecutableCache::Key(computation, options));
+
+  // Measuring again doesn't change the key if the decisions are the same.
+  decision->set_fused_run_time_ns(100);
+  TF_ASSERT_OK(cpu::SaveFusionDecisions(decisions_file, decisions));
+  TF_ASSERT_OK_AND_ASSIGN(std::string same_key,
+                          CpuExecutableCache::Key(computation, options));
+  EXPECT_EQ(key, same_key);
+
+  decision->set_fuse(false);
+  TF_ASSERT_OK(cpu::SaveFusionDecisions(decisions_file, decisions));
+  TF_ASSERT_OK_AND_ASSIGN(std::string rejected_key,
+                          CpuExecutableCache::Key(computation, options));
+  EXPECT_NE(key, rejected_key);
+}
+
+TEST(CpuExecutableCacheTest, StoresAndEvictsEntries) {
+  CpuExecutableCache cache(CacheDir("evict"), /*max_bytes=*/100);
+  EXPECT_FALSE(cache.Lookup("a").has_value());
+  TF_ASSERT_OK(cache.Store("a", std::string(60, 'a')));
+  EXPECT_EQ(cache.Lookup("a"), std::string(60, 'a'));
+  EXPECT_EQ(cache.hits(), 1);
+  EXPECT_EQ(cache.misses(), 1);
+
+  TF_ASSERT_OK(cache.Store("b", std::string(60, 'b')));
+  EXPECT_FALSE(cache.Lookup("a").has_value());
+  EXPECT_EQ(cache.Lookup("b"), std::string(60, 'b'));
+
+  cache.Erase("b");
+  EXPECT_FALSE(cache.Lookup("b").has_value());
+}
+
+TEST(CpuExecutableCacheTest, ClientReusesCachedExecutables) {
+  CpuClientOptions options;
+  options.cpu_device_count = 1;
+  options.executable_cache_dir = CacheDir("client");
+  XlaComputation computation = Parse(kProgram);
+
+  for (int i = 0; i < 2; ++i) {
+    TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(options));
+    TF_ASSERT_OK_AND_ASSIGN(auto executable,
+                            client->Compile(computation, {}));
+    const CpuExecutableCache* cache =
+        static_cast<TfrtCpuClient*>(client.get())->executable_cache();
+    EXPECT_EQ(cache->hits(), i);
+    EXPECT_EQ(cache->misses(), 1 - i);
+
+    Literal x = LiteralUtil::CreateR1<float>({10, 20, 30, 40});
+    TF_ASSERT_OK_AND_ASSIGN(
+        auto buffer,
+        client->BufferFromHostLiteral(x, client->addressable_devices()[0]));
+    TF_ASSERT_OK_AND_ASSIGN(auto results,
+                            executable->Execute({{buffer.get()}}, {}));
+    TF_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Literal> result,
+                            results[0][0]->ToLiteralSync());
+    EXPECT_EQ(*result, LiteralUtil::CreateR1<float>({11, 22, 33, 44}));
+  }
+}
+
+TEST(CpuExecutableCacheTest, ClientCompilesUncacheableOptions) {
+  CpuClientOptions options;
+  options.cpu_device_count = 1;
+  options.executable_cache_dir = CacheDir("uncacheable");
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(options));
+
+  // A compile thread pool can't be serialized into the cache key.
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), "compile", 2);
+  CompileOptions compile_options;
+  compile_options.executable_build_options.set_compile_thread_pool(
+      &thread_pool);
+  EXPECT_FALSE(
+      CpuExecutableCache::Key(Parse(kProgram), compile_options).ok());
+  TF_ASSERT_OK_AND_ASSIGN(auto executable,
+                          client->Compile(Parse(kProgram), compile_options));
+
+  const CpuExecutableCache* cache =
+      static_cast<TfrtCpuClient*>(client.get())->executable_cache();
+  EXPECT_EQ(cache->hits(), 0);
+  EXPECT_EQ(cache->misses(), 0);
+
+  Literal x = LiteralUtil::CreateR1<float>({10, 20, 30, 40});
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto buffer,
+      client->BufferFromHostLiteral(x, client->addressable_devices()[0]));
+  TF_ASSERT_OK_AND_ASSIGN(auto results,
+                          executable->Execute({{buffer.get()}}, {}));
+  TF_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Literal> result,
+                          results[0][0]->ToLiteralSync());
+  EXPECT_EQ(*result, LiteralUtil::CreateR1<float>({11, 22, 33, 44}));
+}
+
+}  // namespace
+}  // namespace xla
@@ -20,6 +20,7 @@ limitations under the License.
 #include <algorithm>
 #include <cstdint>
 #include <deque>
+#include <functional>
 #include <iterator>
 #include <memory>
 #include <ostream>
@@ -32,8 +33,10 @@ limitations under the License.
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
 #include "absl/memory/memory.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/synchronization/blocking_counter.h"
 #include "xla/hlo/ir/hlo_instruction.h"
 #include "xla/hlo/ir/hlo_op_metadata.h"
 #include "xla/hlo/ir/hlo_opcode.h"
@@ -51,6 +54,7 @@ limitations under the License.
 #include "xla/util.h"
 #include "tsl/platform/errors.h"
 #include "tsl/platform/numbers.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 namespace {
@@ -1083,9 +1087,11 @@ StatusOr<std::unique_ptr<BufferAssignment>> BufferAssigner::Run(
     const PrivateStacks& private_stacks,
     GlobalDecreasingSizeBestFitHeap<HloValue>::BufferIntervalCompare
         heap_buffer_interval_compare,
-    std::optional<BufferAssignment::BufferIsolationOptions> isolation_options) {
+    std::optional<BufferAssignment::BufferIsolationOptions> isolation_options,
+    tsl::thread::ThreadPool* thread_pool) {
   BufferAssigner assigner(allocate_buffers_for_constants, std::move(colorer),
-                          must_not_live_out, std::move(preset_assignments));
+                          must_not_live_out, std::move(preset_assignments),
+                          thread_pool);
   return assigner.CreateAssignment(
       module, std::move(hlo_ordering), std::move(buffer_size),
       std::move(color_alignment), std::move(can_share_buffer), private_stacks,
@@ -1222,6 +1228,17 @@ bool BufferAssigner::MaybeAssignBuffer(BufferAllocation* allocation,
     return false;
   }
 
+  // If the buffer is live out of the computation then it should only be
+  // assigned a buffer which exactly fits the result to avoid wasting memory
+  // (result buffers can have arbitrary lifetimes). This is checked before
+  // the pairwise interference checks below, which are much more expensive.
+  if (assignment->alias_analysis().BufferLivesOut(hlo_buffer) &&
+      allocation->size() != assignment->HloBufferSize(hlo_buffer)) {
+    VLOG(4) << "Can't assign: buffer " << hlo_buffer
+            << "is live out and size not the same as allocation";
+    return false;
+  }
+
   for (const auto& buffer_offset_size : allocation->assigned_buffers()) {
     // Pairwise compare.
     const HloValue& assigned_buffer =
@@ -1260,16 +1277,6 @@ bool BufferAssigner::MaybeAssignBuffer(BufferAllocation* allocation,
     }
   }
 
-  // If the buffer is live out of the computation then it should only be
-  // assigned a buffer which exactly fits the result to avoid wasting memory
-  // (result buffers can have arbitrary lifetimes).
-  if (assignment->alias_analysis().BufferLivesOut(hlo_buffer) &&
-      allocation->size() != assignment->HloBufferSize(hlo_buffer)) {
-    VLOG(4) << "Can't assign: buffer " << hlo_buffer
-            << "is live out and size not the same as allocation";
-    return false;
-  }
-
   assignment->AddAssignment(allocation, hlo_buffer, /*offset=*/0,
                             assignment->HloBufferSize(hlo_buffer));
   return true;
@@ -1651,13 +1658,24 @@ Status BufferAssigner::AssignBuffersWithSequentialOrdering(
         std::move(algorithms));
   };
 
+  // The heap simulations are independent of each other, so they are collected
+  // first and then run, possibly in parallel. Their results are assigned in
+  // the order in which they were collected, which keeps the assignment
+  // deterministic. 'buffer_sets' owns the buffers each simulation assigns.
+  struct Simulation {
+    LogicalBuffer::Color color;
+    std::function<absl::StatusOr<HeapSimulator::Result<HloValue>>()> run;
+  };
+  std::vector<Simulation> simulations;
+  std::deque<flat_hash_set<const HloValue*>> buffer_sets;
+  HloSchedule schedule(&assignment->module());
+
   if (run_whole_module_heap_simulation) {
     // Run the heap simulation over the whole module. This reduces memory
     // usage, since buffers for kCall, kWhile, and kConditional
     // sub-computations are only live for the duration of their calling
     // instructions.
     VLOG(1) << "Running whole-module heap simulation";
-    HloSchedule schedule(&assignment->module());
     flat_hash_set<const HloValue*> all_buffers_to_assign;
     for (const auto& pair : buffers_to_assign_sequentially) {
       const HloComputation* computation = pair.first;
@@ -1678,7 +1696,6 @@ Status BufferAssigner::AssignBuffersWithSequentialOrdering(
     }
     absl::c_sort(sorted_colors);
     for (auto color : sorted_colors) {
-      VLOG(2) << "Simulating heap for color " << color;
       int64_t alignment = assignment->color_alignment_(color);
       HeapSimulator::Options options;
       options.alloc_constants = allocate_buffers_for_constants_;
@@ -1696,33 +1713,36 @@ Status BufferAssigner::AssignBuffersWithSequentialOrdering(
             assignment->alias_analysis().dataflow_analysis().call_graph());
         for (const HloComputation* private_stack_computation :
              private_stacks_it->second) {
-          VLOG(2) << "private stack computation: "
-                  << private_stack_computation->name();
           auto computation_map_it =
               computation_map.find(private_stack_computation);
           CHECK(computation_map_it != computation_map.end());
-          options.buffers_to_assign = &computation_map_it->second;
+          options.buffers_to_assign =
+              &buffer_sets.emplace_back(std::move(computation_map_it->second));
           const HloInstructionSequence* instruction_sequence =
               hlo_ordering.SequentialOrder(*private_stack_computation);
-          TF_ASSIGN_OR_RETURN(
-              HeapSimulator::Result<HloValue> result,
-              HeapSimulator::Run(
-                  get_heap_algorithm(alignment), *private_stack_computation,
-                  *instruction_sequence, assignment->alias_analysis(),
-                  assignment->buffer_size_, &schedule, options));
-          AssignBuffersFromHeapSimulator(result, assignment, color,
-                                         isolation_options);
+          simulations.push_back(
+              {color, [&, alignment, options, private_stack_computation,
+                       instruction_sequence, color] {
+                 VLOG(2) << "Simulating heap for color " << color
+                         << " in private stack computation "
+                         << private_stack_computation->name();
+                 return HeapSimulator::Run(
+                     get_heap_algorithm(alignment), *private_stack_computation,
+                     *instruction_sequence, assignment->alias_analysis(),
+                     assignment->buffer_size_, &schedule, options);
+               }});
         }
       } else {
-        options.buffers_to_assign = &color_map[color];
-        TF_ASSIGN_OR_RETURN(
-            HeapSimulator::Result<HloValue> result,
-            HeapSimulator::Run(get_heap_algorithm(alignment),
-                               assignment->module(), schedule,
-                               assignment->alias_analysis(),
-                               assignment->buffer_size_, options));
-        AssignBuffersFromHeapSimulator(result, assignment, color,
-                                       isolation_options);
+        options.buffers_to_assign =
+            &buffer_sets.emplace_back(std::move(color_map[color]));
+        auto run = [&, alignment, options, color] {
+          VLOG(2) << "Simulating heap for color " << color;
+          return HeapSimulator::Run(get_heap_algorithm(alignment),
+                                    assignment->module(), schedule,
+                                    assignment->alias_analysis(),
+                                    assignment->buffer_size_, options);
+        };
+        simulations.push_back({color, std::move(run)});
       }
     }
   } else {
@@ -1745,21 +1765,55 @@ Status BufferAssigner::AssignBuffersWithSequentialOrdering(
       }
       absl::c_sort(sorted_colors);
       for (auto color : sorted_colors) {
-        VLOG(2) << "Simulating heap for color " << color;
         int64_t alignment = assignment->color_alignment_(color);
         HeapSimulator::Options options;
-        options.buffers_to_assign = &color_map[color];
-        TF_ASSIGN_OR_RETURN(
-            HeapSimulator::Result<HloValue> result,
-            HeapSimulator::Run(get_heap_algorithm(alignment), *computation,
-                               *instruction_sequence,
-                               assignment->alias_analysis(),
-                               assignment->buffer_size_, options));
-        AssignBuffersFromHeapSimulator(result, assignment, color,
-                                       isolation_options);
+        options.buffers_to_assign =
+            &buffer_sets.emplace_back(std::move(color_map[color]));
+        simulations.push_back(
+            {color, [&, alignment, options, computation, instruction_sequence,
+                     color] {
+               VLOG(2) << "Simulating heap for color " << color << " in "
+                       << computation->name();
+               return HeapSimulator::Run(
+                   get_heap_algorithm(alignment), *computation,
+                   *instruction_sequence, assignment->alias_analysis(),
+                   assignment->buffer_size_, options);
+             }});
       }
     }
   }
+
+  // Waiting for the pool from one of its own threads could deadlock, so the
+  // simulations run on the calling thread in that case.
+  if (thread_pool_ == nullptr || thread_pool_->CurrentThreadId() != -1 ||
+      simulations.size() < 2) {
+    for (Simulation& simulation : simulations) {
+      TF_ASSIGN_OR_RETURN(HeapSimulator::Result<HloValue> result,
+                          simulation.run());
+      AssignBuffersFromHeapSimulator(result, assignment, simulation.color,
+                                     isolation_options);
+    }
+    return OkStatus();
+  }
+
+  VLOG(1) << "Running " << simulations.size()
+          << " heap simulations in parallel";
+  std::vector<absl::StatusOr<HeapSimulator::Result<HloValue>>> results(
+      simulations.size());
+  absl::BlockingCounter counter(simulations.size());
+  for (int64_t i = 0; i < simulations.size(); ++i) {
+    thread_pool_->Schedule([&, i] {
+      results[i] = simulations[i].run();
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  for (int64_t i = 0; i < simulations.size(); ++i) {
+    TF_ASSIGN_OR_RETURN(HeapSimulator::Result<HloValue> result,
+                        std::move(results[i]));
+    AssignBuffersFromHeapSimulator(result, assignment, simulations[i].color,
+                                   isolation_options);
+  }
   return OkStatus();
 }
 
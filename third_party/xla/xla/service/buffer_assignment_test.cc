@@ -48,7 +48,9 @@ limitations under the License.
 #include "xla/types.h"
 #include "xla/xla_data.pb.h"
 #include "tsl/lib/core/status_test_util.h"
+#include "tsl/platform/env.h"
 #include "tsl/platform/statusor.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 namespace {
@@ -2212,6 +2214,60 @@ ENTRY main {
   }
 }
 
+TEST_F(BufferAssignmentTest, ParallelHeapSimulationsMatchSequential) {
+  const char* hlo_text = R"(
+HloModule Module, is_scheduled=true
+
+ENTRY main {
+  p0 = f32[100] parameter(0)
+  p1 = f32[100] parameter(1)
+  a0 = f32[100] add(p0, p1)
+  m0 = f32[100] multiply(a0, p1)
+  a1 = f32[100] add(m0, a0)
+  m1 = f32[100] multiply(a1, p0)
+  a2 = f32[100] add(m1, a1)
+  m2 = f32[100] multiply(a2, m0)
+  a3 = f32[100] add(m2, a2)
+  m3 = f32[100] multiply(a3, m1)
+  ROOT a4 = f32[100] add(m3, a3)
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(hlo_text));
+
+  // Spreads the buffers over three colors, which are simulated separately.
+  auto colorer = [](HloAliasAnalysis* alias_analysis, const HloOrdering&) {
+    for (const HloBuffer& buffer : alias_analysis->buffers()) {
+      for (const HloValue* value : buffer.values()) {
+        alias_analysis->dataflow_analysis().GetValue(value->id()).set_color(
+            LogicalBuffer::Color(buffer.id() % 3));
+      }
+    }
+    return OkStatus();
+  };
+  auto run = [&](tsl::thread::ThreadPool* thread_pool) {
+    return BufferAssigner::Run(
+               module.get(),
+               std::make_unique<SequentialHloOrdering>(module->schedule()),
+               backend().compiler()->BufferSizeBytesFunction(),
+               [](LogicalBuffer::Color) { return 1; },
+               /*allocate_buffers_for_constants=*/true, colorer,
+               /*must_not_live_out=*/std::nullopt,
+               /*can_share_buffer=*/nullptr, /*preset_assignments=*/{},
+               /*private_stacks=*/{},
+               /*heap_buffer_interval_compare=*/nullptr,
+               /*isolation_options=*/std::nullopt, thread_pool)
+        .value();
+  };
+
+  std::unique_ptr<BufferAssignment> sequential = run(nullptr);
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), "buffer_assignment",
+                                      4);
+  for (int i = 0; i < 10; ++i) {
+    std::unique_ptr<BufferAssignment> parallel = run(&thread_pool);
+    EXPECT_EQ(parallel->ToString(), sequential->ToString());
+  }
+}
+
 class WhileBufferAssignmentTest : public HloTestBase {
  protected:
   std::unique_ptr<HloComputation> BuildWhileConditionComputation(
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "xla/service/cpu/cpu_compiler.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
@@ -41,6 +42,7 @@ limitations under the License.
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/STLExtras.h"
@@ -57,6 +59,7 @@ limitations under the License.
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/CodeGen.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
@@ -140,12 +143,14 @@ limitations under the License.
 #include "xla/service/cpu/compiler_functor.h"
 #include "xla/service/cpu/conv_canonicalization.h"
 #include "xla/service/cpu/cpu_executable.h"
+#include "xla/service/cpu/cpu_fusion_decisions.h"
 #include "xla/service/cpu/cpu_instruction_fusion.h"
 #include "xla/service/cpu/cpu_layout_assignment.h"
 #include "xla/service/cpu/cpu_options.h"
 #include "xla/service/cpu/dot_op_emitter.h"
 #include "xla/service/cpu/hlo_xla_runtime_pipeline.h"
 #include "xla/service/cpu/ir_emitter.h"
+#include "xla/service/cpu/parallel_codegen.h"
 #include "xla/service/cpu/parallel_task_assignment.h"
 #include "xla/service/cpu/runtime/collectives.h"
 #include "xla/service/cpu/runtime/convolution_call.h"
@@ -155,6 +160,8 @@ limitations under the License.
 #include "xla/service/cpu/runtime/xfeed.h"
 #include "xla/service/cpu/simple_orc_jit.h"
 #include "xla/service/cpu/target_machine_features.h"
+#include "xla/service/cpu/thunk_executor.h"
+#include "xla/service/cpu/thunk_outliner.h"
 #include "xla/service/cpu/xla_framework.h"
 #include "xla/service/cpu_gpu_shape_verifier.h"
 #include "xla/service/dot_decomposer.h"
@@ -237,6 +244,7 @@ limitations under the License.
 #include "tsl/platform/logging.h"  // IWYU pragma: keep
 #include "tsl/platform/status.h"
 #include "tsl/platform/statusor.h"
+#include "tsl/platform/threadpool.h"
 
 #if defined(INTEL_MKL) && defined(ENABLE_ONEDNN_V3)
 #include "xla/service/cpu/cpu_float_support.h"
@@ -647,7 +655,8 @@ void AddHloVerifier(HloPassPipeline* pipeline, bool allow_sparse_shapes,
 
 Status CpuCompiler::RunHloPassesThroughLayoutAssn(
     HloModule* module, bool is_aot_compile,
-    LLVMTargetMachineFeatures* target_machine_features, bool is_mlir_compile) {
+    LLVMTargetMachineFeatures* target_machine_features, bool is_mlir_compile,
+    tsl::thread::ThreadPool* thread_pool) {
   const int64_t num_partitions = module->config().num_partitions();
   if (num_partitions > 1) {
     if (!module->config().use_spmd_partitioning()) {
@@ -689,6 +698,7 @@ Status CpuCompiler::RunHloPassesThroughLayoutAssn(
   }
 
   HloPassPipeline pipeline("HLO passes through layout assignment");
+  pipeline.set_thread_pool(thread_pool);
   AddHloVerifier(&pipeline, allow_sparse_shapes_);
 
   pipeline.AddPass<OperandUpcaster>();
@@ -904,8 +914,10 @@ Status CpuCompiler::RunHloPassesThroughLayoutAssn(
 
 Status CpuCompiler::RunHloPassesAfterLayoutAssn(
     HloModule* module, bool is_aot_compile,
-    LLVMTargetMachineFeatures* target_machine_features, bool is_mlir_compile) {
+    LLVMTargetMachineFeatures* target_machine_features, bool is_mlir_compile,
+    tsl::thread::ThreadPool* thread_pool) {
   HloPassPipeline pipeline("HLO passes after layout assignment");
+  pipeline.set_thread_pool(thread_pool);
 
   // CopyInsertion is still needed by BufferAssignment. MLIR passes will handle
   // everything else done by XLA, but CopyInsertion is needed to interface with
@@ -945,8 +957,17 @@ Status CpuCompiler::RunHloPassesAfterLayoutAssn(
   }
 #endif  // INTEL_MKL && ENABLE_ONEDNN_V3
 
-  // Add a fusion pass now that layout assignment is done.
-  pipeline.AddPass<CpuInstructionFusion>();
+  // Add a fusion pass now that layout assignment is done. It skips the fusions
+  // the fusion autotuner measured to be slower than leaving them unfused.
+  absl::flat_hash_set<uint64_t> rejected_fusions;
+  const std::string& fusion_decisions_file =
+      module->config().debug_options().xla_cpu_fusion_decisions_file();
+  if (!fusion_decisions_file.empty()) {
+    TF_ASSIGN_OR_RETURN(FusionDecisionsProto fusion_decisions,
+                        LoadFusionDecisions(fusion_decisions_file));
+    rejected_fusions = GetRejectedFusions(fusion_decisions);
+  }
+  pipeline.AddPass<CpuInstructionFusion>(std::move(rejected_fusions));
 
   // The LayoutAssignment pass may leave behind kCopy instructions which are
   // duplicate or NOPs, so remove them with algebraic simplification and CSE.
@@ -983,7 +1004,8 @@ Status CpuCompiler::RunHloPassesAfterLayoutAssn(
     // binary size (and most AOT applications are single-threaded).
     // TODO(b/29630486) Support multi-threaded AOT.
     pipeline.AddPass<ParallelTaskAssigner>(
-        max_parallelism, ShapeSizeBytesFunction(), target_machine_features);
+        max_parallelism, ShapeSizeBytesFunction(), target_machine_features,
+        module->config().debug_options().xla_cpu_parallel_tasks_per_thread());
   }
   // Copy insertion should be performed immediately before IR emission to
   // avoid inserting unnecessary copies (later pass adds an instruction which
@@ -1000,13 +1022,16 @@ Status CpuCompiler::RunHloPassesAfterLayoutAssn(
 
 Status CpuCompiler::RunHloPasses(HloModule* module, bool is_aot_compile,
                                  llvm::TargetMachine* target_machine,
-                                 bool is_mlir_compile) {
+                                 bool is_mlir_compile,
+                                 tsl::thread::ThreadPool* thread_pool) {
   LLVMTargetMachineFeatures target_machine_features(target_machine);
   TF_RETURN_IF_ERROR(RunHloPassesThroughLayoutAssn(
-      module, is_aot_compile, &target_machine_features, is_mlir_compile));
+      module, is_aot_compile, &target_machine_features, is_mlir_compile,
+      thread_pool));
 
   return RunHloPassesAfterLayoutAssn(module, is_aot_compile,
-                                     &target_machine_features, is_mlir_compile);
+                                     &target_machine_features, is_mlir_compile,
+                                     thread_pool);
 }
 
 namespace {
@@ -1121,7 +1146,7 @@ Status CreateHloProfilingArtifacts(
 
 StatusOr<std::unique_ptr<HloModule>> CpuCompiler::RunHloPasses(
     std::unique_ptr<HloModule> module, se::StreamExecutor* /*stream_exec*/,
-    const CompileOptions& /*options*/) {
+    const CompileOptions& options) {
   std::unique_ptr<llvm::TargetMachine> jit_target_machine =
       SimpleOrcJIT::InferTargetMachineForJIT(
           CompilerTargetOptions(module->config()),
@@ -1130,7 +1155,8 @@ StatusOr<std::unique_ptr<HloModule>> CpuCompiler::RunHloPasses(
   TF_RETURN_IF_ERROR(RunHloPasses(
       module.get(), /*is_aot_compile=*/false, jit_target_machine.get(),
       /*is_mlir_compile=*/
-      module->config().debug_options().xla_cpu_use_xla_runtime()));
+      module->config().debug_options().xla_cpu_use_xla_runtime(),
+      options.thread_pool));
   return std::move(module);
 }
 
@@ -1158,6 +1184,19 @@ StatusOr<std::unique_ptr<BufferAssignment>> CpuCompiler::AssignBuffers(
 
 namespace {
 
+// Collects the machine code of `module` in `obj_files`, and dumps it if
+// dumping is enabled for the module.
+void RecordObjFile(const HloModule& module, llvm::StringRef obj_file,
+                   absl::string_view file_suffix,
+                   std::vector<std::string>* obj_files) {
+  if (obj_files) obj_files->push_back(obj_file.str());
+
+  if (DumpingEnabledForHloModule(module)) {
+    DumpToFileInDir(module, /*file_prefix=*/"", file_suffix,
+                    absl::string_view(obj_file.data(), obj_file.size()));
+  }
+}
+
 // Post-compilation callback functor for use by SimpleOrcJIT.
 //
 // Dumps machine code if dumping is enabled for the module.
@@ -1165,14 +1204,76 @@ static absl::AnyInvocable<void(const llvm::object::ObjectFile& obj_file)>
 CreateOrcJITPostCompilationHook(const HloModule* module,
                                 std::vector<std::string>* obj_files) {
   return [=](const llvm::object::ObjectFile& obj_file) {
-    if (obj_files) obj_files->push_back(obj_file.getData().str());
+    RecordObjFile(*module, obj_file.getData(), /*file_suffix=*/"o",
+                  obj_files);
+  };
+}
 
-    if (DumpingEnabledForHloModule(*module)) {
-      DumpToFileInDir(*module, /*file_prefix=*/"", /*file_suffix=*/"o",
-                      absl::string_view(obj_file.getData().data(),
-                                        obj_file.getData().size()));
+// Splits `llvm_module` into up to one module per thread of `thread_pool`,
+// compiles them in parallel, and adds the object files to `jit`.
+//
+// This is equivalent to `jit->AddModule(llvm_module)`, but the IR hooks are
+// called on the whole module before optimizations, and on each of the split
+// modules after optimizations, and the IR and machine code dumps of the split
+// modules are numbered.
+Status CompileModuleInParallel(
+    const HloModule& hlo_module, std::unique_ptr<llvm::Module> llvm_module,
+    const LLVMCompiler::ModuleHook& pre_optimization_hook,
+    const LLVMCompiler::ModuleHook& user_post_optimization_hook,
+    tsl::thread::ThreadPool* thread_pool, SimpleOrcJIT* jit,
+    std::vector<std::string>* obj_files) {
+  XLA_SCOPED_LOGGING_TIMER("CpuCompiler - Compiling LLVM IR in parallel");
+  pre_optimization_hook(*llvm_module);
+  std::vector<std::unique_ptr<llvm::Module>> llvm_modules =
+      SplitModuleForParallelCodegen(std::move(llvm_module),
+                                    thread_pool->NumThreads());
+  VLOG(1) << "Compiling " << hlo_module.name() << " as "
+          << llvm_modules.size() << " LLVM modules";
+
+  const HloModuleConfig& config = hlo_module.config();
+  // The user hook isn't required to be thread safe.
+  absl::Mutex hook_mu;
+  auto compile = [&](int part, llvm::Module& module)
+      -> absl::StatusOr<std::unique_ptr<llvm::MemoryBuffer>> {
+    std::unique_ptr<llvm::TargetMachine> target_machine =
+        SimpleOrcJIT::InferTargetMachineForJIT(CompilerTargetOptions(config),
+                                               CodeGenOptLevel(config));
+    auto post_optimization_hook = [&](const llvm::Module& optimized_module) {
+      absl::MutexLock lock(&hook_mu);
+      if (user_post_optimization_hook) {
+        user_post_optimization_hook(optimized_module);
+      }
+      llvm_ir::DumpIrIfEnabled(hlo_module, optimized_module,
+                               /*optimized=*/true, absl::StrCat(part));
+    };
+    CompilerFunctor compiler(
+        target_machine.get(), static_cast<int>(CodeGenOptLevel(config)),
+        options::OptimizeForSizeRequested(config),
+        config.debug_options().xla_llvm_disable_expensive_passes(),
+        options::SlpVectorizerDisabled(config),
+        llvm_ir::GetCpuFastMathFlags(config),
+        /*pre_optimization_hook=*/nullptr, post_optimization_hook);
+    llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> obj_file =
+        compiler(module);
+    if (!obj_file) {
+      return Internal("Compiling part %d of %s failed: %s", part,
+                      hlo_module.name(), llvm::toString(obj_file.takeError()));
     }
+    return std::move(*obj_file);
   };
+  TF_ASSIGN_OR_RETURN(
+      std::vector<std::unique_ptr<llvm::MemoryBuffer>> part_obj_files,
+      CompileModulesInParallel(std::move(llvm_modules), thread_pool, compile));
+
+  for (int part = 0; part < part_obj_files.size(); ++part) {
+    RecordObjFile(hlo_module, part_obj_files[part]->getBuffer(),
+                  /*file_suffix=*/absl::StrCat(part, ".o"), obj_files);
+    if (llvm::Error error = jit->AddObjFile(std::move(part_obj_files[part]))) {
+      return Internal("Adding part %d of %s to the JIT failed: %s", part,
+                      hlo_module.name(), llvm::toString(std::move(error)));
+    }
+  }
+  return absl::OkStatus();
 }
 
 void InitializeLLVMCommandLineOptions(const HloModuleConfig& config) {
@@ -1368,7 +1469,8 @@ std::vector<ComputationToEmit> SubcomputationEmissionOrder(
 }  // namespace
 
 StatusOr<std::unique_ptr<CpuExecutable>>
-CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
+CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module,
+                                        const CompileOptions& options) {
   ModuleHook pre_optimization_ir_hook;
   ModuleHook post_optimization_ir_hook;
   std::tie(pre_optimization_ir_hook, post_optimization_ir_hook) =
@@ -1419,6 +1521,15 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
   // ownership is std::moved.
   const bool embed_ir_in_executable =
       module->config().debug_options().xla_embed_ir_in_executable();
+  const bool use_thunk_runtime =
+      module->config().debug_options().xla_cpu_use_thunk_runtime();
+
+  // With the thunk runtime, each operation of the entry computation is
+  // compiled to a function of its own, and run as soon as its operands are
+  // ready.
+  if (use_thunk_runtime) {
+    TF_RETURN_IF_ERROR(ThunkOutliner().Run(module.get()).status());
+  }
 
   // Select an order for emitting the HLO instructions for each
   // computation. Using this sequence enables tighter buffer liveness analysis
@@ -1428,13 +1539,27 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
                                      ComputationSchedulerToModuleScheduler(
                                          DFSMemoryScheduler)));
 
+  // The thunks run concurrently, so their buffers can only be shared when
+  // they depend on each other.
+  std::unique_ptr<HloOrdering> hlo_ordering;
+  if (use_thunk_runtime) {
+    hlo_ordering = std::make_unique<DependencyHloOrdering>(module.get());
+  } else {
+    hlo_ordering = std::make_unique<SequentialHloOrdering>(schedule);
+  }
+
   // Run buffer allocation on the HLO graph.
   TF_ASSIGN_OR_RETURN(
       std::unique_ptr<BufferAssignment> assignment,
-      BufferAssigner::Run(module.get(),
-                          std::make_unique<SequentialHloOrdering>(schedule),
-                          BufferSizeBytesFunction(), memory_alignment,
-                          /*allocate_buffers_for_constants=*/true));
+      BufferAssigner::Run(
+          module.get(), std::move(hlo_ordering), BufferSizeBytesFunction(),
+          memory_alignment,
+          /*allocate_buffers_for_constants=*/true,
+          BufferAssigner::DefaultColorer(),
+          /*must_not_live_out=*/std::nullopt, /*can_share_buffer=*/nullptr,
+          /*preset_assignments=*/{}, /*private_stacks=*/{},
+          /*heap_buffer_interval_compare=*/nullptr,
+          /*isolation_options=*/std::nullopt, options.thread_pool));
   DumpHloModuleIfEnabled(*module, *assignment,
                          absl::StrCat("cpu_", kAfterOptimizationsDumpName));
 
@@ -1459,37 +1584,64 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
 
   TF_RETURN_IF_ERROR(ir_emitter.EmitConstantGlobals());
 
+  auto mangle = [&](llvm::Function* function) {
+    llvm::SmallVector<char, 40> function_name_vector;
+    llvm::Mangler::getNameWithPrefix(
+        function_name_vector, function->getName(), (*jit)->data_layout());
+    return std::string(function_name_vector.begin(),
+                       function_name_vector.end());
+  };
+
+  // The computations called by the thunks of the entry computation, which
+  // are compiled to functions with external linkage.
+  std::vector<ThunkInstruction> thunk_instructions;
+  absl::flat_hash_map<const HloComputation*, llvm::Function*> thunk_functions;
+  if (use_thunk_runtime) {
+    thunk_instructions = GetThunkInstructions(
+        schedule.sequence(entry_computation).instructions());
+    for (const ThunkInstruction& thunk : thunk_instructions) {
+      thunk_functions[thunk.call->to_apply()] = nullptr;
+    }
+  }
+
   for (ComputationToEmit subcomputation :
        SubcomputationEmissionOrder(entry_computation)) {
     if (subcomputation.computation->IsFusionComputation()) {
       continue;
     }
-    TF_RETURN_IF_ERROR(
-        ir_emitter
-            .EmitComputation(
-                subcomputation.computation, subcomputation.computation->name(),
-                /*is_top_level_computation=*/false,
-                schedule.sequence(subcomputation.computation).instructions(),
-                subcomputation.allow_reassociation)
-            .status());
+    auto thunk_function = thunk_functions.find(subcomputation.computation);
+    const bool is_thunk = thunk_function != thunk_functions.end();
+    TF_ASSIGN_OR_RETURN(
+        llvm::Function * function,
+        ir_emitter.EmitComputation(
+            subcomputation.computation, subcomputation.computation->name(),
+            /*is_top_level_computation=*/is_thunk,
+            schedule.sequence(subcomputation.computation).instructions(),
+            subcomputation.allow_reassociation));
+    if (is_thunk) {
+      thunk_function->second = function;
+    }
+  }
+
+  std::vector<ThunkExecutor::Thunk> thunks;
+  if (use_thunk_runtime) {
+    for (ThunkInstruction& thunk : thunk_instructions) {
+      thunks.push_back(ThunkExecutor::Thunk{
+          mangle(thunk_functions.at(thunk.call->to_apply())),
+          /*function=*/nullptr, std::move(thunk.dependencies)});
+    }
+  } else {
+    absl::string_view function_name_prefix =
+        entry_computation->name().empty() ? "__compute"
+                                          : entry_computation->name();
+    TF_ASSIGN_OR_RETURN(llvm::Function * entry_function,
+                        ir_emitter.EmitComputation(
+                            entry_computation, function_name_prefix,
+                            /*is_top_level_computation=*/true,
+                            schedule.sequence(entry_computation).instructions(),
+                            /*allow_reassociation=*/false));
+    function_name = mangle(entry_function);
   }
-  absl::string_view function_name_prefix = entry_computation->name().empty()
-                                               ? "__compute"
-                                               : entry_computation->name();
-  TF_ASSIGN_OR_RETURN(llvm::Function * entry_function,
-                      ir_emitter.EmitComputation(
-                          entry_computation, function_name_prefix,
-                          /*is_top_level_computation=*/true,
-                          schedule.sequence(entry_computation).instructions(),
-                          /*allow_reassociation=*/false));
-
-  function_name = [&]() {
-    llvm::SmallVector<char, 40> function_name_vector;
-    llvm::Mangler::getNameWithPrefix(
-        function_name_vector, entry_function->getName(), (*jit)->data_layout());
-    return std::string(function_name_vector.begin(),
-                       function_name_vector.end());
-  }();
 
   std::string ir_module_string;
   if (embed_ir_in_executable) {
@@ -1498,17 +1650,42 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
 
   TF_RETURN_IF_ERROR(VerifyLlvmModule(*llvm_module));
 
-  // JIT compile the LLVM IR module to in-memory machine code.
-  llvm::orc::ThreadSafeModule thread_safe_module(std::move(llvm_module),
-                                                 std::move(llvm_context));
-  cantFail((*jit)->AddModule(std::move(thread_safe_module)));
+  // JIT compile the LLVM IR module to in-memory machine code, in parallel if
+  // requested. Splitting the module changes the generated code, so it is
+  // only done when asked for explicitly, not whenever a thread pool is given.
+  const int split_count =
+      module->config().debug_options().xla_cpu_parallel_codegen_split_count();
+  MaybeOwningThreadPool thread_pool = MaybeOwningThreadPool::GetOrCreate(
+      /*parallelism=*/std::max(1, split_count),
+      /*default_thread_pool=*/nullptr,
+      /*default_parallelism=*/1);
+  if (thread_pool && thread_pool->NumThreads() > 1) {
+    TF_RETURN_IF_ERROR(CompileModuleInParallel(
+        *module, std::move(llvm_module), pre_optimization_ir_hook,
+        user_post_optimization_hook_, thread_pool.get(), jit->get(),
+        &obj_files));
+  } else {
+    llvm::orc::ThreadSafeModule thread_safe_module(std::move(llvm_module),
+                                                   std::move(llvm_context));
+    cantFail((*jit)->AddModule(std::move(thread_safe_module)));
+  }
 
-  TF_ASSIGN_OR_RETURN(
-      auto cpu_executable,
-      CpuExecutable::Create(std::move(*jit), std::move(assignment),
-                            std::move(module), function_name,
-                            std::move(hlo_profile_printer_data),
-                            std::move(hlo_profile_index_map)));
+  std::unique_ptr<CpuExecutable> cpu_executable;
+  if (use_thunk_runtime) {
+    TF_ASSIGN_OR_RETURN(
+        cpu_executable,
+        CpuExecutable::Create(std::move(*jit), std::move(assignment),
+                              std::move(module), std::move(thunks),
+                              std::move(hlo_profile_printer_data),
+                              std::move(hlo_profile_index_map)));
+  } else {
+    TF_ASSIGN_OR_RETURN(
+        cpu_executable,
+        CpuExecutable::Create(std::move(*jit), std::move(assignment),
+                              std::move(module), function_name,
+                              std::move(hlo_profile_printer_data),
+                              std::move(hlo_profile_index_map)));
+  }
 
   cpu_executable->set_obj_files(std::move(obj_files));
 
@@ -1632,7 +1809,7 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
                         CompileXlaRuntimeCpuExecutable(std::move(module)));
   } else {
     TF_ASSIGN_OR_RETURN(cpu_executable,
-                        CompileLegacyCpuExecutable(std::move(module)));
+                        CompileLegacyCpuExecutable(std::move(module), options));
   }
 
   cpu_executable->set_debug_info(
@@ -2035,6 +2212,10 @@ StatusOr<std::unique_ptr<AotCompilationResult>> CpuCompiler::Export(
   if (!cpu_executable)
     return Internal("Could not downcast Executable to CpuExecutable");
 
+  if (cpu_executable->HasThunks()) {
+    return Unimplemented("Can't export CPU executables using thunks");
+  }
+
   if (cpu_executable->obj_files().size() != 1) {
     return absl::InternalError(
         absl::StrCat("Can't export CPU execuable, expected exactly one object "
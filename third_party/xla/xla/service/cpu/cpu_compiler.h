@@ -39,6 +39,7 @@ limitations under the License.
 #include "xla/statusor.h"
 #include "xla/stream_executor/stream_executor.h"
 #include "xla/util.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 namespace cpu {
@@ -216,24 +217,28 @@ class CpuCompiler : public LLVMCompiler {
   static void InitializeLLVMTarget();
 
   // Runs the HLO passes which are necessary for both optimizations and
-  // correctness.
+  // correctness. If `thread_pool` is not null, the passes transforming each
+  // computation independently run on the computations in parallel on it.
   Status RunHloPasses(HloModule* module, bool is_aot_compile,
                       llvm::TargetMachine* target_machine,
-                      bool is_mlir_compile = false);
+                      bool is_mlir_compile = false,
+                      tsl::thread::ThreadPool* thread_pool = nullptr);
 
   // Runs HLO passes up to and including layout assignment.
   Status RunHloPassesThroughLayoutAssn(
       HloModule* module, bool /*is_aot_compile*/,
       LLVMTargetMachineFeatures* target_machine_features,
-      bool is_mlir_compile = false);
+      bool is_mlir_compile = false,
+      tsl::thread::ThreadPool* thread_pool = nullptr);
 
   // Runs HLO passes after layout assignment.
   Status RunHloPassesAfterLayoutAssn(
       HloModule* module, bool is_aot_compile,
-      LLVMTargetMachineFeatures* target_machine_features, bool is_mlir_compile);
+      LLVMTargetMachineFeatures* target_machine_features, bool is_mlir_compile,
+      tsl::thread::ThreadPool* thread_pool = nullptr);
 
   StatusOr<std::unique_ptr<CpuExecutable>> CompileLegacyCpuExecutable(
-      std::unique_ptr<HloModule> module);
+      std::unique_ptr<HloModule> module, const CompileOptions& options);
 
   CpuCompiler(const CpuCompiler&) = delete;
   CpuCompiler& operator=(const CpuCompiler&) = delete;
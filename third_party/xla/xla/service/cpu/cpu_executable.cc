@@ -58,6 +58,26 @@ namespace cpu {
 
 namespace runtime = ::xla::runtime;
 
+// Returns the compiled function 'function_name' of 'jit'.
+static StatusOr<CpuExecutable::ComputeFunctionType> FindComputeFunction(
+    SimpleOrcJIT* jit, const std::string& function_name) {
+  llvm::Expected<llvm::orc::ExecutorSymbolDef> sym =
+      jit->FindCompiledSymbol(function_name);
+  // We expect to find the symbol provided with function_name; otherwise
+  // this is an internal error.
+  if (!sym) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Symbol ", function_name, " not found."));
+  }
+  // getAddress can do work under the hood in the jit, so it needs to be
+  // guarded by the mutex.
+  auto compute_function = reinterpret_cast<CpuExecutable::ComputeFunctionType>(
+      sym->getAddress().getValue());
+  VLOG(1) << function_name << " at address "
+          << reinterpret_cast<void*>(compute_function);
+  return compute_function;
+}
+
 StatusOr<std::unique_ptr<CpuExecutable>> CpuExecutable::Create(
     std::unique_ptr<SimpleOrcJIT> jit,
     std::unique_ptr<const BufferAssignment> assignment,
@@ -73,20 +93,33 @@ StatusOr<std::unique_ptr<CpuExecutable>> CpuExecutable::Create(
 
   // Resolve symbols in the constructor rather than at execution time to avoid
   // races because FindSymbol is not thread safe.
-  llvm::Expected<llvm::orc::ExecutorSymbolDef> sym =
-      executable->jit_->FindCompiledSymbol(entry_function_name);
-  // We expect to find the symbol provided with entry_function_name; otherwise
-  // this is an internal error.
-  if (!sym) {
-    return absl::InvalidArgumentError(
-        absl::StrCat("Symbol ", entry_function_name, " not found."));
+  TF_ASSIGN_OR_RETURN(
+      executable->compute_function_,
+      FindComputeFunction(executable->jit_.get(), entry_function_name));
+  executable->jit_->DoneCompiling();
+  return executable;
+}
+
+StatusOr<std::unique_ptr<CpuExecutable>> CpuExecutable::Create(
+    std::unique_ptr<SimpleOrcJIT> jit,
+    std::unique_ptr<const BufferAssignment> assignment,
+    std::unique_ptr<HloModule> hlo_module,
+    std::vector<ThunkExecutor::Thunk> thunks,
+    std::unique_ptr<HloProfilePrinterData> hlo_profile_printer_data,
+    std::unique_ptr<HloProfileIndexMap> hlo_profile_index_map) {
+  std::unique_ptr<CpuExecutable> executable(new CpuExecutable(
+      std::move(hlo_module), std::move(hlo_profile_printer_data),
+      std::move(hlo_profile_index_map), std::move(assignment)));
+  executable->jit_ = std::move(jit);
+  executable->module_name_ = executable->module().entry_computation()->name();
+
+  // As above, resolve the symbols of all thunks before running any.
+  for (ThunkExecutor::Thunk& thunk : thunks) {
+    TF_ASSIGN_OR_RETURN(thunk.function, FindComputeFunction(
+                                            executable->jit_.get(), thunk.name));
   }
-  // getAddress can do work under the hood in the jit, so it needs to be
-  // guarded by the mutex.
-  executable->compute_function_ =
-      reinterpret_cast<ComputeFunctionType>(sym->getAddress().getValue());
-  VLOG(1) << "compute_function_ at address "
-          << reinterpret_cast<void*>(executable->compute_function_);
+  executable->thunk_executor_ =
+      std::make_unique<ThunkExecutor>(std::move(thunks));
   executable->jit_->DoneCompiling();
   return executable;
 }
@@ -250,6 +283,13 @@ Status CpuExecutable::ExecuteComputeFunction(
     if (!status.ok()) {
       return status;
     }
+  } else if (HasThunks()) {
+    Status status = ExecuteThunks(run_options, buffer_pointers.data(),
+                                  profile_counters);
+    record_profile();
+    if (!status.ok()) {
+      return status;
+    }
   } else {
     XlaCustomCallStatus status;
     // For the entry computation (like all global computations), all inputs and
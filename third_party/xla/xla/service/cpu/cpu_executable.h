@@ -32,6 +32,7 @@ limitations under the License.
 #include "xla/service/buffer_assignment.h"
 #include "xla/service/cpu/buffer_desc.h"
 #include "xla/service/cpu/simple_orc_jit.h"
+#include "xla/service/cpu/thunk_executor.h"
 #include "xla/service/cpu/xla_framework.h"
 #include "xla/service/custom_call_status_internal.h"
 #include "xla/service/executable.h"
@@ -138,6 +139,15 @@ class CpuExecutable : public Executable {
       std::unique_ptr<HloProfileIndexMap> hlo_profile_index_map,
       std::unique_ptr<const BufferAssignment> assignment,
       std::unique_ptr<XlaRuntimeCpuExecutable> xla_runtime_executable);
+  // Thunk runtime factory method. The names of 'thunks' are the symbols of
+  // their functions in 'jit'.
+  static StatusOr<std::unique_ptr<CpuExecutable>> Create(
+      std::unique_ptr<SimpleOrcJIT> jit,
+      std::unique_ptr<const BufferAssignment> assignment,
+      std::unique_ptr<HloModule> hlo_module,
+      std::vector<ThunkExecutor::Thunk> thunks,
+      std::unique_ptr<HloProfilePrinterData> hlo_profile_printer_data,
+      std::unique_ptr<HloProfileIndexMap> hlo_profile_index_map);
 
   ~CpuExecutable() override;
 
@@ -149,6 +159,14 @@ class CpuExecutable : public Executable {
     return xla_runtime_executable_->Execute(descriptor_table, run_options);
   }
 
+  bool HasThunks() const { return thunk_executor_ != nullptr; }
+
+  Status ExecuteThunks(const ExecutableRunOptions* run_options,
+                       void** buffer_table, int64_t* profile_counters) const {
+    return thunk_executor_->Execute(run_options, buffer_table,
+                                    profile_counters);
+  }
+
   StatusOr<ExecutionOutput> ExecuteAsyncOnStream(
       const ServiceExecutableRunOptions* run_options,
       std::vector<ExecutionInput> arguments,
@@ -279,6 +297,10 @@ class CpuExecutable : public Executable {
   // If not null, XLA Runtime is enabled.
   std::unique_ptr<XlaRuntimeCpuExecutable> xla_runtime_executable_;
 
+  // If not null, the thunk runtime is enabled, and runs the thunks of the
+  // entry computation instead of the compute function.
+  std::unique_ptr<ThunkExecutor> thunk_executor_;
+
   CpuExecutable(std::unique_ptr<HloModule> hlo_module,
                 std::unique_ptr<HloProfilePrinterData> hlo_profile_printer_data,
                 std::unique_ptr<HloProfileIndexMap> hlo_profile_index_map,
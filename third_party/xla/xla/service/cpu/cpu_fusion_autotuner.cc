@@ -0,0 +1,122 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/cpu_fusion_autotuner.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/cleanup/cleanup.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/time/time.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/service/cpu/cpu_fusion_decisions.h"
+#include "xla/service/cpu/fusion_decisions.pb.h"
+#include "xla/service/hlo_module_config.h"
+#include "xla/statusor.h"
+#include "xla/util.h"
+#include "xla/xla.pb.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/errors.h"
+#include "tsl/platform/logging.h"
+#include "tsl/platform/statusor.h"
+
+namespace xla {
+namespace cpu {
+
+StatusOr<FusionAutotuner::Measurement> FusionAutotuner::Measure(
+    const HloModule& module, const FusionDecisionsProto& decisions,
+    const std::string& trial_file) {
+  TF_RETURN_IF_ERROR(SaveFusionDecisions(trial_file, decisions));
+  HloModuleConfig config = module.config();
+  DebugOptions debug_options = config.debug_options();
+  debug_options.set_xla_cpu_fusion_decisions_file(trial_file);
+  config.set_debug_options(debug_options);
+  return measure_(module.Clone(config));
+}
+
+StatusOr<FusionDecisionsProto> FusionAutotuner::Tune(
+    const HloModule& module, FusionDecisionsProto decisions) {
+  if (options_.decisions_file.empty()) {
+    return InvalidArgument("The fusion autotuner needs a decisions file.");
+  }
+
+  // The decisions to try are written to a file of their own, so that the
+  // decisions file never holds unverified decisions, even if tuning fails.
+  tsl::Env* env = tsl::Env::Default();
+  std::string trial_file;
+  if (!env->LocalTempFilename(&trial_file)) {
+    return Internal("Failed to create a temporary fusion decisions file.");
+  }
+  absl::Cleanup delete_trial_file = [&] {
+    env->DeleteFile(trial_file).IgnoreError();
+  };
+
+  TF_ASSIGN_OR_RETURN(Measurement baseline,
+                      Measure(module, decisions, trial_file));
+
+  absl::flat_hash_set<uint64_t> measured;
+  for (const FusionDecisionProto& decision : decisions.decisions()) {
+    measured.insert(decision.fingerprint());
+  }
+
+  // Tries to leave each fusion of the baseline unfused on top of the decisions
+  // made so far, and keeps the ones that make the module faster.
+  int64_t num_measured = 0;
+  for (const FusedProducer& candidate :
+       GetFusedProducers(*baseline.optimized_module)) {
+    if (num_measured >= options_.max_measured_fusions) {
+      break;
+    }
+    if (!measured.insert(candidate.fingerprint).second) {
+      continue;
+    }
+    ++num_measured;
+
+    FusionDecisionsProto trial = decisions;
+    FusionDecisionProto* decision = trial.add_decisions();
+    decision->set_fingerprint(candidate.fingerprint);
+    decision->set_producer(candidate.producer->ToString());
+    decision->set_fusion_root(
+        candidate.fusion->fused_expression_root()->ToString());
+    decision->set_fuse(false);
+    TF_ASSIGN_OR_RETURN(Measurement unfused,
+                        Measure(module, trial, trial_file));
+
+    decision->set_fused_run_time_ns(
+        absl::ToInt64Nanoseconds(baseline.run_time));
+    decision->set_unfused_run_time_ns(
+        absl::ToInt64Nanoseconds(unfused.run_time));
+    bool reject = unfused.run_time <
+                  baseline.run_time * (1.0 - options_.min_relative_gain);
+    VLOG(1) << (reject ? "Rejecting" : "Keeping") << " fusion of "
+            << decision->producer() << " into " << decision->fusion_root()
+            << ": fused " << baseline.run_time << ", unfused "
+            << unfused.run_time;
+    decision->set_fuse(!reject);
+    if (reject) {
+      baseline.run_time = unfused.run_time;
+    }
+    decisions = std::move(trial);
+  }
+
+  TF_RETURN_IF_ERROR(SaveFusionDecisions(options_.decisions_file, decisions));
+  return decisions;
+}
+
+}  // namespace cpu
+}  // namespace xla
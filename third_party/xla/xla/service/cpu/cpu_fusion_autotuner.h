@@ -0,0 +1,90 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_SERVICE_CPU_CPU_FUSION_AUTOTUNER_H_
+#define XLA_SERVICE_CPU_CPU_FUSION_AUTOTUNER_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/time/time.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/service/cpu/fusion_decisions.pb.h"
+#include "xla/statusor.h"
+
+namespace xla {
+namespace cpu {
+
+// Decides which of the fusions made by CpuInstructionFusion pay off by
+// compiling and running a module with and without each of them.
+//
+// The decisions are keyed by FusionCandidateFingerprint, so they also apply to
+// other modules with the same fusions. Passing the file they are saved to as
+// --xla_cpu_fusion_decisions_file makes the CPU compiler skip the rejected
+// fusions. The autotuner can only reject fusions the heuristics would make;
+// it never fuses something the heuristics consider illegal or unprofitable.
+//
+// The cpu_fusion_autotuner tool in xla/tools tunes a dumped module by running
+// it on the host.
+class FusionAutotuner {
+ public:
+  struct Measurement {
+    absl::Duration run_time;
+    // The module after the HLO passes, which holds the fusions that were made.
+    std::unique_ptr<HloModule> optimized_module;
+  };
+
+  // Compiles the module with its debug options and measures its run time.
+  using MeasureFn =
+      std::function<StatusOr<Measurement>(std::unique_ptr<HloModule>)>;
+
+  struct Options {
+    // Where the decisions are written to once tuning succeeds. The decisions
+    // to try are measured through a temporary file of their own.
+    std::string decisions_file;
+
+    // The number of fusions to measure at most.
+    int64_t max_measured_fusions = 64;
+
+    // Rejects a fusion only if not fusing makes the module at least this much
+    // faster, to not flip decisions because of noise.
+    double min_relative_gain = 0.02;
+  };
+
+  FusionAutotuner(Options options, MeasureFn measure)
+      : options_(std::move(options)), measure_(std::move(measure)) {}
+
+  // Measures the fusions of `module` that aren't in `decisions` yet, one at a
+  // time, and returns `decisions` with their results added.
+  StatusOr<FusionDecisionsProto> Tune(const HloModule& module,
+                                      FusionDecisionsProto decisions);
+
+ private:
+  // Compiles `module` with `decisions`, which are written to `trial_file`.
+  StatusOr<Measurement> Measure(const HloModule& module,
+                                const FusionDecisionsProto& decisions,
+                                const std::string& trial_file);
+
+  Options options_;
+  MeasureFn measure_;
+};
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // XLA_SERVICE_CPU_CPU_FUSION_AUTOTUNER_H_
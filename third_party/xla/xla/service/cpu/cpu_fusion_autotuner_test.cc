@@ -0,0 +1,181 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/cpu_fusion_autotuner.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "xla/hlo/ir/hlo_computation.h"
+#include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/hlo/ir/hlo_opcode.h"
+#include "xla/service/cpu/cpu_fusion_decisions.h"
+#include "xla/service/cpu/cpu_instruction_fusion.h"
+#include "xla/service/cpu/fusion_decisions.pb.h"
+#include "xla/tests/hlo_test_base.h"
+#include "tsl/lib/core/status_test_util.h"
+#include "tsl/platform/path.h"
+#include "tsl/platform/statusor.h"
+#include "tsl/platform/test.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+constexpr absl::string_view kModule = R"(
+HloModule module
+
+ENTRY main {
+  a = f32[1024] parameter(0)
+  b = f32[1024] parameter(1)
+  add = f32[1024] add(a, b)
+  exp = f32[1024] exponential(add)
+  ROOT neg = f32[1024] negate(exp)
+}
+)";
+
+// Returns whether a fusion of the module computes both an exponential and a
+// negate.
+bool FusesExpIntoNegate(const HloModule& module) {
+  for (const HloInstruction* instruction :
+       module.entry_computation()->instructions()) {
+    if (instruction->opcode() != HloOpcode::kFusion) {
+      continue;
+    }
+    bool has_exp = false;
+    bool has_negate = false;
+    for (const HloInstruction* fused : instruction->fused_instructions()) {
+      has_exp |= fused->opcode() == HloOpcode::kExp;
+      has_negate |= fused->opcode() == HloOpcode::kNegate;
+    }
+    if (has_exp && has_negate) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Runs the fusion pass with the decisions the compiler would load and
+// pretends that fusing the exponential into the negate is slow.
+StatusOr<FusionAutotuner::Measurement> FakeMeasure(
+    std::unique_ptr<HloModule> module) {
+  TF_ASSIGN_OR_RETURN(
+      FusionDecisionsProto decisions,
+      LoadFusionDecisions(
+          module->config().debug_options().xla_cpu_fusion_decisions_file()));
+  TF_RETURN_IF_ERROR(CpuInstructionFusion(GetRejectedFusions(decisions))
+                         .Run(module.get())
+                         .status());
+  absl::Duration run_time = FusesExpIntoNegate(*module)
+                                ? absl::Microseconds(200)
+                                : absl::Microseconds(100);
+  return FusionAutotuner::Measurement{run_time, std::move(module)};
+}
+
+class FusionAutotunerTest : public HloTestBase {
+ protected:
+  FusionAutotuner::Options GetOptions() {
+    FusionAutotuner::Options options;
+    options.decisions_file =
+        tsl::io::JoinPath(::testing::TempDir(), "fusion_decisions.pbtxt");
+    return options;
+  }
+};
+
+TEST_F(FusionAutotunerTest, RejectsSlowFusion) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kModule));
+  FusionAutotuner::Options options = GetOptions();
+  FusionAutotuner autotuner(options, &FakeMeasure);
+  TF_ASSERT_OK_AND_ASSIGN(FusionDecisionsProto decisions,
+                          autotuner.Tune(*module, FusionDecisionsProto()));
+
+  // Fusing the add into the negate and the exponential into the negate were
+  // both measured, and only the latter was rejected.
+  ASSERT_EQ(decisions.decisions_size(), 2);
+  const HloInstruction* neg = module->entry_computation()->root_instruction();
+  const HloInstruction* exp = neg->operand(0);
+  absl::flat_hash_set<uint64_t> rejected = GetRejectedFusions(decisions);
+  EXPECT_TRUE(rejected.contains(FusionCandidateFingerprint(*exp, *neg)));
+  EXPECT_FALSE(
+      rejected.contains(FusionCandidateFingerprint(*exp->operand(0), *neg)));
+
+  // The decisions file holds the final decisions, which leave the exponential
+  // out of the fusion with the negate.
+  TF_ASSERT_OK_AND_ASSIGN(FusionDecisionsProto saved,
+                          LoadFusionDecisions(options.decisions_file));
+  EXPECT_EQ(saved.SerializeAsString(), decisions.SerializeAsString());
+  TF_ASSERT_OK_AND_ASSIGN(bool fused_something,
+                          CpuInstructionFusion(GetRejectedFusions(saved))
+                              .Run(module.get()));
+  EXPECT_TRUE(fused_something);
+  EXPECT_FALSE(FusesExpIntoNegate(*module));
+  EXPECT_NE(FusionDecisionsReport(saved).find("reject"), std::string::npos);
+}
+
+TEST_F(FusionAutotunerTest, SkipsMeasuredFusions) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kModule));
+  FusionAutotuner autotuner(GetOptions(), &FakeMeasure);
+  TF_ASSERT_OK_AND_ASSIGN(FusionDecisionsProto decisions,
+                          autotuner.Tune(*module, FusionDecisionsProto()));
+  TF_ASSERT_OK_AND_ASSIGN(FusionDecisionsProto retuned,
+                          autotuner.Tune(*module, decisions));
+  EXPECT_EQ(retuned.decisions_size(), decisions.decisions_size());
+}
+
+TEST_F(FusionAutotunerTest, KeepsDecisionsFileIfTuningFails) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kModule));
+  FusionAutotuner::Options options = GetOptions();
+  FusionDecisionsProto previous;
+  previous.add_decisions()->set_fingerprint(42);
+  TF_ASSERT_OK(SaveFusionDecisions(options.decisions_file, previous));
+
+  // The baseline is measured, and the first trial fails.
+  int num_measurements = 0;
+  FusionAutotuner autotuner(
+      options,
+      [&](std::unique_ptr<HloModule> module)
+          -> StatusOr<FusionAutotuner::Measurement> {
+        EXPECT_NE(
+            module->config().debug_options().xla_cpu_fusion_decisions_file(),
+            options.decisions_file);
+        if (++num_measurements > 1) {
+          return absl::InternalError("Measurement failed.");
+        }
+        return FakeMeasure(std::move(module));
+      });
+  EXPECT_FALSE(autotuner.Tune(*module, FusionDecisionsProto()).ok());
+  EXPECT_EQ(num_measurements, 2);
+
+  TF_ASSERT_OK_AND_ASSIGN(FusionDecisionsProto saved,
+                          LoadFusionDecisions(options.decisions_file));
+  EXPECT_EQ(saved.SerializeAsString(), previous.SerializeAsString());
+}
+
+TEST_F(FusionAutotunerTest, NeedsDecisionsFile) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kModule));
+  FusionAutotuner autotuner(FusionAutotuner::Options(), &FakeMeasure);
+  EXPECT_FALSE(autotuner.Tune(*module, FusionDecisionsProto()).ok());
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
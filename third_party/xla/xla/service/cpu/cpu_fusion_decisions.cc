@@ -0,0 +1,160 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/cpu_fusion_decisions.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_append.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/time.h"
+#include "xla/hlo/ir/hlo_computation.h"
+#include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/hlo/ir/hlo_opcode.h"
+#include "xla/service/cpu/fusion_decisions.pb.h"
+#include "xla/status.h"
+#include "xla/statusor.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/errors.h"
+#include "tsl/platform/fingerprint.h"
+#include "tsl/platform/random.h"
+
+namespace xla {
+namespace cpu {
+
+namespace {
+
+const HloInstruction& FusionRoot(const HloInstruction& consumer) {
+  return consumer.opcode() == HloOpcode::kFusion
+             ? *consumer.fused_expression_root()
+             : consumer;
+}
+
+std::string FingerprintString(const HloInstruction& instruction) {
+  return instruction.ToString(HloPrintOptions::Fingerprint());
+}
+
+}  // namespace
+
+uint64_t FusionCandidateFingerprint(const HloInstruction& producer,
+                                    const HloInstruction& consumer) {
+  return tsl::Fingerprint64(
+      absl::StrCat(FingerprintString(producer), " -> ",
+                   FingerprintString(FusionRoot(consumer))));
+}
+
+std::vector<FusedProducer> GetFusedProducers(const HloModule& module) {
+  std::vector<FusedProducer> producers;
+  for (const HloComputation* computation : module.MakeNonfusionComputations()) {
+    for (const HloInstruction* fusion :
+         computation->MakeInstructionPostOrder()) {
+      if (fusion->opcode() != HloOpcode::kFusion) {
+        continue;
+      }
+      for (const HloInstruction* producer :
+           fusion->fused_instructions_computation()
+               ->MakeInstructionPostOrder()) {
+        if (producer == fusion->fused_expression_root() ||
+            producer->opcode() == HloOpcode::kParameter) {
+          continue;
+        }
+        producers.push_back(
+            {FusionCandidateFingerprint(*producer, *fusion), producer, fusion});
+      }
+    }
+  }
+  return producers;
+}
+
+absl::flat_hash_set<uint64_t> GetRejectedFusions(
+    const FusionDecisionsProto& decisions) {
+  absl::flat_hash_set<uint64_t> rejected_fusions;
+  for (const FusionDecisionProto& decision : decisions.decisions()) {
+    if (!decision.fuse()) {
+      rejected_fusions.insert(decision.fingerprint());
+    }
+  }
+  return rejected_fusions;
+}
+
+StatusOr<FusionDecisionsProto> LoadFusionDecisions(const std::string& path) {
+  FusionDecisionsProto decisions;
+  TF_RETURN_IF_ERROR(
+      tsl::ReadTextOrBinaryProto(tsl::Env::Default(), path, &decisions));
+  return decisions;
+}
+
+Status SaveFusionDecisions(const std::string& path,
+                           const FusionDecisionsProto& decisions) {
+  // Writes to a temporary file first, so that a compilation reading `path`
+  // never sees partially written decisions.
+  tsl::Env* env = tsl::Env::Default();
+  const std::string tmp_path = absl::StrCat(path, ".tmp", tsl::random::New64());
+  Status status = tsl::WriteTextProto(env, tmp_path, decisions);
+  if (status.ok()) status = env->RenameFile(tmp_path, path);
+  if (!status.ok()) {
+    env->DeleteFile(tmp_path).IgnoreError();
+  }
+  return status;
+}
+
+std::string FusionDecisionsReport(const FusionDecisionsProto& decisions) {
+  std::vector<const FusionDecisionProto*> sorted;
+  for (const FusionDecisionProto& decision : decisions.decisions()) {
+    sorted.push_back(&decision);
+  }
+  // Sorts by the time saved by not fusing, which is negative for the fusions
+  // that pay off.
+  auto gain = [](const FusionDecisionProto* decision) {
+    return decision->fused_run_time_ns() - decision->unfused_run_time_ns();
+  };
+  absl::c_stable_sort(sorted, [&](const FusionDecisionProto* a,
+                                  const FusionDecisionProto* b) {
+    return gain(a) > gain(b);
+  });
+
+  std::string report = absl::StrFormat(
+      "%d measured fusions, %d rejected\n", sorted.size(),
+      absl::c_count_if(sorted, [](const FusionDecisionProto* decision) {
+        return !decision->fuse();
+      }));
+  for (const FusionDecisionProto* decision : sorted) {
+    absl::StrAppend(
+        &report,
+        absl::StrFormat(
+            "%-6s fused: %s unfused: %s (%+.1f%% saved by not fusing)\n"
+            "  producer: %s\n"
+            "  fusion root: %s\n",
+            decision->fuse() ? "fuse" : "reject",
+            absl::FormatDuration(
+                absl::Nanoseconds(decision->fused_run_time_ns())),
+            absl::FormatDuration(
+                absl::Nanoseconds(decision->unfused_run_time_ns())),
+            decision->fused_run_time_ns() == 0
+                ? 0.0
+                : 100.0 * gain(decision) / decision->fused_run_time_ns(),
+            decision->producer(), decision->fusion_root()));
+  }
+  return report;
+}
+
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,70 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_SERVICE_CPU_CPU_FUSION_DECISIONS_H_
+#define XLA_SERVICE_CPU_CPU_FUSION_DECISIONS_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/service/cpu/fusion_decisions.pb.h"
+#include "xla/status.h"
+#include "xla/statusor.h"
+
+namespace xla {
+namespace cpu {
+
+// Returns the fingerprint of fusing `producer` into `consumer`, which is either
+// the instruction the fusion is rooted at or a fusion rooted at it. It only
+// depends on the producer, the fusion root and the shapes of their operands, so
+// that the same fusion has the same fingerprint when it is considered by
+// CpuInstructionFusion, in the optimized module and in later compilations.
+uint64_t FusionCandidateFingerprint(const HloInstruction& producer,
+                                    const HloInstruction& consumer);
+
+// A producer that was fused into a fusion of an optimized module.
+struct FusedProducer {
+  uint64_t fingerprint;
+  const HloInstruction* producer;
+  const HloInstruction* fusion;
+};
+
+// Returns the producers of the fusions in `module`, in post order.
+std::vector<FusedProducer> GetFusedProducers(const HloModule& module);
+
+// Returns the fingerprints of the fusions that `decisions` rule out.
+absl::flat_hash_set<uint64_t> GetRejectedFusions(
+    const FusionDecisionsProto& decisions);
+
+// Reads the fusion decisions in the text or binary proto at `path`.
+StatusOr<FusionDecisionsProto> LoadFusionDecisions(const std::string& path);
+
+// Writes `decisions` to `path` as a text proto. The file is replaced
+// atomically, so readers see either the old or the new decisions.
+Status SaveFusionDecisions(const std::string& path,
+                           const FusionDecisionsProto& decisions);
+
+// Returns a human-readable report of the measured fusions, with the ones that
+// gain the most from not fusing first.
+std::string FusionDecisionsReport(const FusionDecisionsProto& decisions);
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // XLA_SERVICE_CPU_CPU_FUSION_DECISIONS_H_
@@ -15,10 +15,14 @@ limitations under the License.
 
 #include "xla/service/cpu/cpu_instruction_fusion.h"
 
+#include "xla/hlo/ir/hlo_module.h"
 #include "xla/hlo/ir/hlo_opcode.h"
+#include "xla/service/cpu/cpu_fusion_decisions.h"
+#include "xla/service/cpu/ir_emission_utils.h"
 #include "xla/service/fusion_node_indexing_evaluation.h"
 #include "xla/service/instruction_fusion.h"
 #include "xla/service/llvm_ir/fused_ir_emitter.h"
+#include "xla/shape_util.h"
 
 namespace xla {
 namespace cpu {
@@ -50,6 +54,20 @@ bool IsNonComplexNonBatchedMatrixVectorDot(const HloInstruction* hlo) {
          hlo->dot_dimension_numbers().lhs_batch_dimensions_size() == 0;
 }
 
+// Returns true if `hlo` is a dot emitted with the GEMM microkernel, which can
+// add `addend` to its result for free.
+bool IsMicrokernelGemmDotWithAddend(const HloInstruction* hlo,
+                                    const HloInstruction* addend) {
+  // The microkernel writes the result in the layout of the dot, and reads the
+  // addend in the same layout.
+  return hlo->opcode() == HloOpcode::kDot &&
+         ShapeUtil::Equal(hlo->shape(), addend->shape()) &&
+         CanEmitMicrokernelGemm(hlo->GetModule()->config(),
+                                hlo->operand(0)->shape(),
+                                hlo->operand(1)->shape(), hlo->shape(),
+                                hlo->dot_dimension_numbers());
+}
+
 bool HasExactlyOneUse(const HloInstruction& hlo_instr) {
   return hlo_instr.user_count() == 1 &&
          absl::c_count(hlo_instr.users().front()->operands(), &hlo_instr) == 1;
@@ -57,9 +75,14 @@ bool HasExactlyOneUse(const HloInstruction& hlo_instr) {
 
 bool CanBeOutputFused(const HloInstruction* producer,
                       const HloInstruction* consumer) {
-  return consumer->opcode() == HloOpcode::kAdd &&
-         IsNonComplexNonBatchedMatrixVectorDot(producer) &&
-         HasExactlyOneUse(*producer) == 1;
+  if (consumer->opcode() != HloOpcode::kAdd || !HasExactlyOneUse(*producer)) {
+    return false;
+  }
+  const HloInstruction* addend =
+      consumer->operand(consumer->operand(0) == producer ? 1 : 0);
+  return IsNonComplexNonBatchedMatrixVectorDot(producer) ||
+         (ShapeUtil::Equal(consumer->shape(), producer->shape()) &&
+          IsMicrokernelGemmDotWithAddend(producer, addend));
 }
 
 bool CanBeOutputFusedIntoSomeOperand(const HloInstruction* consumer) {
@@ -71,6 +94,17 @@ bool CanBeOutputFusedIntoSomeOperand(const HloInstruction* consumer) {
 
 FusionDecision CpuInstructionFusion::ShouldFuse(HloInstruction* consumer,
                                                 int64_t operand_index) {
+  FusionDecision decision = ShouldFuseByHeuristics(consumer, operand_index);
+  if (decision.CanFuse() && !rejected_fusions_.empty() &&
+      rejected_fusions_.contains(FusionCandidateFingerprint(
+          *consumer->operand(operand_index), *consumer))) {
+    return "Not fusing: measured to be slower than not fusing.";
+  }
+  return decision;
+}
+
+FusionDecision CpuInstructionFusion::ShouldFuseByHeuristics(
+    HloInstruction* consumer, int64_t operand_index) {
   HloInstruction* producer = consumer->mutable_operand(operand_index);
   VLOG(2) << "Considering for fusion: operand " << operand_index << " of "
           << consumer->ToString();
@@ -16,7 +16,11 @@ limitations under the License.
 #ifndef XLA_SERVICE_CPU_CPU_INSTRUCTION_FUSION_H_
 #define XLA_SERVICE_CPU_CPU_INSTRUCTION_FUSION_H_
 
+#include <cstdint>
+#include <utility>
+
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "xla/hlo/ir/hlo_instruction.h"
 #include "xla/service/fusion_node_indexing_evaluation.h"
 #include "xla/service/instruction_fusion.h"
@@ -26,8 +30,14 @@ namespace cpu {
 
 class CpuInstructionFusion : public InstructionFusion {
  public:
-  CpuInstructionFusion()
-      : InstructionFusion(CpuInstructionFusion::IsExpensive) {}
+  // `rejected_fusions` holds the fingerprints, as computed by
+  // FusionCandidateFingerprint, of the fusions that were measured to be slower
+  // than leaving the producer unfused. They are not fused even if the
+  // heuristics below would fuse them.
+  explicit CpuInstructionFusion(
+      absl::flat_hash_set<uint64_t> rejected_fusions = {})
+      : InstructionFusion(CpuInstructionFusion::IsExpensive),
+        rejected_fusions_(std::move(rejected_fusions)) {}
   ~CpuInstructionFusion() override = default;
 
   using HloPassInterface::Run;
@@ -45,6 +55,9 @@ class CpuInstructionFusion : public InstructionFusion {
       const HloInstruction* producer, const HloInstruction* consumer) override;
 
  private:
+  FusionDecision ShouldFuseByHeuristics(HloInstruction* consumer,
+                                        int64_t operand_index);
+
   HloInstruction* FuseInstruction(HloInstruction* fusion_instruction,
                                   HloInstruction* producer) override;
 
@@ -52,6 +65,8 @@ class CpuInstructionFusion : public InstructionFusion {
   // indexed with different index vectors.
   absl::flat_hash_map<const HloInstruction*, FusionNodeIndexingEvaluation>
       fusion_node_evaluations_;
+
+  absl::flat_hash_set<uint64_t> rejected_fusions_;
 };
 
 }  // namespace cpu
@@ -22,6 +22,7 @@ limitations under the License.
 #include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "xla/hlo/utils/hlo_matchers.h"
+#include "xla/service/cpu/cpu_fusion_decisions.h"
 #include "xla/service/transpose_folding.h"
 #include "xla/shape.h"
 #include "xla/tests/hlo_test_base.h"
@@ -688,6 +689,36 @@ TEST_F(OpcodeFusionTest, DotAddOutputFusion_19x50x19) {
               Not(op::Fusion()));
 }
 
+TEST_F(OpcodeFusionTest, DotAddOutputFusion_19x50x19_Microkernel) {
+  auto module = CreateNewVerifiedModule();
+  DebugOptions debug_options = module->config().debug_options();
+  debug_options.set_xla_cpu_microkernel_gemm_max_size(19 * 50 * 19);
+  module->mutable_config().set_debug_options(debug_options);
+  CreateComputationForDotAddOutputFusionTest(TestName(), module.get(), /*m=*/19,
+                                             /*k=*/50, /*n=*/19,
+                                             /*add_extra_use_for_dot=*/false);
+
+  RunFusionAndCheckOpcodesWereFused(
+      module.get(),
+      {HloOpcode::kDot, HloOpcode::kAdd, HloOpcode::kParameter,
+       HloOpcode::kParameter, HloOpcode::kParameter},
+      HloInstruction::FusionKind::kOutput);
+}
+
+TEST_F(OpcodeFusionTest, DotAddOutputFusion_19x50x19_TooLargeForMicrokernel) {
+  auto module = CreateNewVerifiedModule();
+  DebugOptions debug_options = module->config().debug_options();
+  debug_options.set_xla_cpu_microkernel_gemm_max_size(19 * 50 * 19 - 1);
+  module->mutable_config().set_debug_options(debug_options);
+  CreateComputationForDotAddOutputFusionTest(TestName(), module.get(), /*m=*/19,
+                                             /*k=*/50, /*n=*/19,
+                                             /*add_extra_use_for_dot=*/false);
+
+  TF_ASSERT_OK_AND_ASSIGN(bool fused_something,
+                          CpuInstructionFusion().Run(module.get()));
+  EXPECT_FALSE(fused_something);
+}
+
 TEST_F(OpcodeFusionTest, DotAddOutputFusion_19x50x1_multi_use) {
   auto module = CreateNewVerifiedModule();
   CreateComputationForDotAddOutputFusionTest(TestName(), module.get(), /*m=*/19,
@@ -927,6 +958,32 @@ ENTRY main {
   EXPECT_TRUE(fused_something);
   EXPECT_THAT(module->entry_computation()->root_instruction(), op::Fusion());
 }
+
+TEST_F(InstructionFusionTest, SkipsRejectedFusions) {
+  absl::string_view module_string = R"(
+HloModule module
+
+ENTRY main {
+  a = f32[1024] parameter(0)
+  b = f32[1024] parameter(1)
+  add = f32[1024] add(a, b)
+  exp = f32[1024] exponential(add)
+  ROOT neg = f32[1024] negate(exp)
+}
+)";
+
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(module_string));
+  HloInstruction* neg = module->entry_computation()->root_instruction();
+  CpuInstructionFusion fusion(
+      {FusionCandidateFingerprint(*neg->operand(0), *neg)});
+  TF_ASSERT_OK_AND_ASSIGN(bool fused_something, fusion.Run(module.get()));
+  EXPECT_TRUE(fused_something);
+  // The exponential is fused with the add it consumes, but not into the
+  // negate.
+  EXPECT_THAT(module->entry_computation()->root_instruction(),
+              op::Negate(op::Fusion(op::Parameter(0), op::Parameter(1))));
+}
 }  // namespace
 }  // namespace cpu
 }  // namespace xla
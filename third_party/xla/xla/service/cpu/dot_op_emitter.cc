@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "xla/service/cpu/dot_op_emitter.h"
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -103,6 +104,13 @@ enum class DotImplementationStrategy {
   // and the output have to be row major.
   kTiledLlvmIrGemm,
 
+  // The dot operation is lowered into LLVM IR that implements a Matrix*Matrix
+  // operation tiled for the caches, with a register-blocked microkernel
+  // specialized for the target as the innermost loop.  This strategy also
+  // allows fusing in a bias add into the dot.  The two inputs and the output
+  // have to be row major.
+  kMicrokernelLlvmIrGemm,
+
   // The dot operation is lowered into linalg.matmul op and lowered to LLVM IR.
   kLinalgMatmul,
 
@@ -191,6 +199,10 @@ class DotOpEmitter {
   // Lowers the dot operation as a tiled Matrix*Matrix loop.
   void EmitTiledLlvmIrGemm();
 
+  // Lowers the dot operation as a Matrix*Matrix loop tiled for the caches and
+  // the vector registers.
+  void EmitMicrokernelLlvmIrGemm();
+
   // Lowers the dot operation through MLIR's linalg.matmul.
   Status EmitLinalgMatmul();
 
@@ -415,6 +427,79 @@ void DotOpEmitter::EmitTiledLlvmIrGemm() {
       /*rhs=*/rhs, /*result=*/target, b_, hlo_module_config_);
 }
 
+void DotOpEmitter::EmitMicrokernelLlvmIrGemm() {
+  PrimitiveType primitive_type = dot_info_.result_shape.element_type();
+  MatMultDims mat_mult_dims = GetMatMultDims();
+  CHECK(mat_mult_dims.lhs_canonical && mat_mult_dims.rhs_canonical);
+  CHECK(!mat_mult_dims.lhs_column_major && !mat_mult_dims.rhs_column_major);
+  CHECK(LayoutUtil::IsMonotonicWithDim0Major(
+      target_array_.GetShape().layout()));
+
+  llvm::Value* target = target_array_.GetBasePointer();
+  int64_t m = mat_mult_dims.m;
+  int64_t k = mat_mult_dims.k;
+  int64_t n = mat_mult_dims.n;
+
+  // The kernel accumulates onto the target, so a fused bias add is free.  The
+  // addend may share its buffer with the target.
+  int64_t element_size = ShapeUtil::ByteSizeOfPrimitiveType(primitive_type);
+  int64_t size_bytes = m * n * element_size;
+  if (addend_array_) {
+    b_->CreateMemMove(target, /*DstAlign=*/llvm::MaybeAlign(1),
+                      addend_array_->GetBasePointer(),
+                      /*SrcAlign=*/llvm::MaybeAlign(1), size_bytes);
+  } else {
+    b_->CreateMemSet(target, b_->getInt8(0), /*Size=*/size_bytes,
+                     /*Align=*/llvm::MaybeAlign(1));
+  }
+
+  const llvm::Function& function = *b_->GetInsertBlock()->getParent();
+  int64_t vector_width =
+      target_machine_features_.vector_register_num_elements(function,
+                                                            primitive_type);
+  int64_t num_registers =
+      target_machine_features_.vector_register_count(function);
+  // We may not know the vector registers of the target we're compiling for.
+  if (vector_width == 0 || num_registers == 0) {
+    vector_width = 4;
+    num_registers = 16;
+  }
+
+  // The microkernel keeps a [tile_size_m, tile_size_n] tile of the result in
+  // vector registers, and needs one more register per vector of a row of the
+  // RHS and one for a broadcast element of the LHS.
+  int64_t tile_size_n_in_vector_width = num_registers >= 32 ? 3 : 2;
+  int64_t tile_size_m = std::max<int64_t>(
+      1, (num_registers - tile_size_n_in_vector_width - 1) /
+             tile_size_n_in_vector_width);
+  int64_t tile_size_n = tile_size_n_in_vector_width * vector_width;
+
+  // A [block_size_k, block_size_n] block of the RHS is multiplied with every
+  // row tile of the LHS, so it should stay in the L2 cache.  The
+  // [tile_size_m, block_size_k] row tile of the LHS should stay in the L1
+  // cache while it is multiplied with the block.
+  constexpr int64_t kMaxBlockSizeK = 256;
+  constexpr int64_t kRhsBlockBytes = 256 * 1024;
+  int64_t block_size_k = std::min(k, kMaxBlockSizeK);
+  int64_t block_size_n = std::min(
+      n, std::max(tile_size_n, kRhsBlockBytes / (block_size_k * element_size) /
+                                   tile_size_n * tile_size_n));
+
+  VLOG(2) << "Emitting microkernel GEMM " << m << "x" << k << "x" << n
+          << " with register tile " << tile_size_m << "x" << tile_size_n
+          << " and cache block " << block_size_k << "x" << block_size_n;
+  EmitBlockedGemm(
+      /*scalar_type=*/primitive_type,
+      /*m=*/m, /*k=*/k, /*n=*/n,
+      /*max_vectorization_width=*/vector_width,
+      /*max_vector_count=*/tile_size_n_in_vector_width,
+      /*min_vectorization_width=*/std::min<int64_t>(4, vector_width),
+      /*tile_size_m=*/tile_size_m, /*tile_size_k=*/1,
+      /*block_size_k=*/block_size_k, /*block_size_n=*/block_size_n,
+      /*lhs=*/lhs_array_.GetBasePointer(), /*rhs=*/rhs_array_.GetBasePointer(),
+      /*result=*/target, b_, hlo_module_config_);
+}
+
 void DotOpEmitter::EmitTiledLlvmIrGemv() {
   PrimitiveType primitive_type = dot_info_.result_shape.element_type();
 
@@ -576,6 +661,10 @@ Status DotOpEmitter::Emit() {
       EmitTiledLlvmIrGemm();
       return OkStatus();
 
+    case DotImplementationStrategy::kMicrokernelLlvmIrGemm:
+      EmitMicrokernelLlvmIrGemm();
+      return OkStatus();
+
     case DotImplementationStrategy::kLinalgMatmul:
       return EmitLinalgMatmul();
 
@@ -1209,6 +1298,10 @@ DotImplementationStrategy GetDotImplementationStrategy(
   }
 
   if (IsAlignedGemm(dot_info, target_machine_features)) {
+    if (CanEmitMicrokernelGemm(config, dot_info.lhs_shape, dot_info.rhs_shape,
+                               dot_info.result_shape, dot_info.dim_nums)) {
+      return DotImplementationStrategy::kMicrokernelLlvmIrGemm;
+    }
     if (CanEmitTiledLlvmIrGemm(config, dot_info, target_machine_features)) {
       return DotImplementationStrategy::kTiledLlvmIrGemm;
     }
@@ -1478,6 +1571,7 @@ bool DotOperandsAndResultMustHaveRowMajorLayout(
                                    DotInfo(dot_instr), target_machine_features);
 
   return impl_strategy == DotImplementationStrategy::kTiledLlvmIrGemm ||
+         impl_strategy == DotImplementationStrategy::kMicrokernelLlvmIrGemm ||
          impl_strategy == DotImplementationStrategy::kEigen;
 }
 
@@ -110,5 +110,43 @@ bool PotentiallyImplementedAsEigenConvolution(
              kernel_shape.dimensions_size() - 1;
 }
 
+bool CanEmitMicrokernelGemm(const HloModuleConfig& config,
+                            const Shape& lhs_shape, const Shape& rhs_shape,
+                            const Shape& result_shape,
+                            const DotDimensionNumbers& dim_nums) {
+  int64_t max_size =
+      config.debug_options().xla_cpu_microkernel_gemm_max_size();
+  if (max_size <= 0) {
+    return false;
+  }
+
+  PrimitiveType primitive_type = result_shape.element_type();
+  if ((primitive_type != F32 && primitive_type != F64) ||
+      lhs_shape.element_type() != primitive_type ||
+      rhs_shape.element_type() != primitive_type) {
+    return false;
+  }
+
+  // Only canonical matrix-matrix products, which have no batch dimensions.
+  if (lhs_shape.rank() != 2 || rhs_shape.rank() != 2 ||
+      result_shape.rank() != 2 ||
+      dim_nums.lhs_contracting_dimensions_size() != 1 ||
+      dim_nums.lhs_contracting_dimensions(0) != 1 ||
+      dim_nums.rhs_contracting_dimensions_size() != 1 ||
+      dim_nums.rhs_contracting_dimensions(0) != 0) {
+    return false;
+  }
+
+  // Smaller products are emitted as matrix-vector products or naive loops.
+  constexpr int64_t kMinDimension = 4;
+  int64_t m = result_shape.dimensions(0);
+  int64_t k = lhs_shape.dimensions(1);
+  int64_t n = result_shape.dimensions(1);
+  if (m < kMinDimension || k < kMinDimension || n < kMinDimension) {
+    return false;
+  }
+  return m * k * n <= max_size;
+}
+
 }  // namespace cpu
 }  // namespace xla
@@ -19,6 +19,9 @@ limitations under the License.
 #include "llvm/IR/Value.h"
 #include "xla/hlo/ir/hlo_instruction.h"
 #include "xla/service/cpu/target_machine_features.h"
+#include "xla/service/hlo_module_config.h"
+#include "xla/shape.h"
+#include "xla/xla_data.pb.h"
 
 namespace xla {
 namespace cpu {
@@ -27,6 +30,14 @@ bool PotentiallyImplementedAsEigenConvolution(
     const HloInstruction& convolution,
     const TargetMachineFeatures& target_machine_features);
 
+// Returns true if a dot with the given shapes and dimension numbers is emitted
+// with the register-blocked GEMM microkernel under `config`.  The microkernel
+// accumulates onto its output, so a bias add can be output fused into it.
+bool CanEmitMicrokernelGemm(const HloModuleConfig& config,
+                            const Shape& lhs_shape, const Shape& rhs_shape,
+                            const Shape& result_shape,
+                            const DotDimensionNumbers& dim_nums);
+
 // Computes the minimum alignment guaranteed for a tensor of shape `shape` on
 // the target machine.
 int64_t GetMinimumAlignmentForArray(
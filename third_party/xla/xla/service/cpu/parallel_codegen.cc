@@ -0,0 +1,166 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/parallel_codegen.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/Attributes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalValue.h"
+#include "llvm/IR/InstrTypes.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
+#include "xla/util.h"
+#include "tsl/platform/blocking_counter.h"
+#include "tsl/platform/logging.h"
+#include "tsl/platform/threadpool.h"
+
+namespace xla {
+namespace cpu {
+
+namespace {
+
+// Returns true if the inliner never inlines `function`, whatever its linkage.
+bool IsNeverInlined(const llvm::Function& function) {
+  if (function.hasFnAttribute(llvm::Attribute::AlwaysInline)) return false;
+  if (function.hasFnAttribute(llvm::Attribute::NoInline)) return true;
+  int num_calls = 0;
+  for (const llvm::Use& use : function.uses()) {
+    const auto* call = llvm::dyn_cast<llvm::CallBase>(use.getUser());
+    if (call != nullptr && call->isCallee(&use)) ++num_calls;
+  }
+  // A local function with a single call is inlined whatever its size, as the
+  // function can be deleted afterwards.
+  return num_calls == 0 ||
+         (num_calls > 1 &&
+          function.getInstructionCount() >= kMinInstructionsToSplitFunction);
+}
+
+}  // namespace
+
+std::vector<std::unique_ptr<llvm::Module>> SplitModuleForParallelCodegen(
+    std::unique_ptr<llvm::Module> module, int max_parts) {
+  int num_functions = 0;
+  for (llvm::Function& function : module->functions()) {
+    if (function.isDeclaration()) continue;
+    if (function.hasLocalLinkage() && !function.use_empty() &&
+        IsNeverInlined(function)) {
+      function.setLinkage(llvm::GlobalValue::ExternalLinkage);
+      function.setVisibility(llvm::GlobalValue::HiddenVisibility);
+    }
+    if (!function.hasLocalLinkage()) ++num_functions;
+  }
+
+  const int num_parts = std::min(max_parts, num_functions);
+  std::vector<std::unique_ptr<llvm::Module>> parts;
+  if (num_parts <= 1) {
+    parts.push_back(std::move(module));
+    return parts;
+  }
+
+  // Locals are kept in the module of their users, so that the splitting
+  // doesn't prevent inlining or constant folding.
+  llvm::SplitModule(
+      *module, num_parts,
+      [&](std::unique_ptr<llvm::Module> part) {
+        if (llvm::all_of(part->global_values(),
+                         [](const llvm::GlobalValue& value) {
+                           return value.isDeclaration();
+                         })) {
+          return;
+        }
+        parts.push_back(std::move(part));
+      },
+      /*PreserveLocals=*/true);
+  VLOG(2) << "Split " << module->getName().str() << " with " << num_functions
+          << " splittable functions into " << parts.size() << " modules";
+  return parts;
+}
+
+absl::StatusOr<std::vector<std::unique_ptr<llvm::MemoryBuffer>>>
+CompileModulesInParallel(
+    std::vector<std::unique_ptr<llvm::Module>> modules,
+    tsl::thread::ThreadPool* thread_pool,
+    absl::FunctionRef<absl::StatusOr<std::unique_ptr<llvm::MemoryBuffer>>(
+        int, llvm::Module&)>
+        compile) {
+  // The modules share an LLVM context, which isn't thread safe, so they are
+  // moved to contexts of their own through bitcode. The serialization is
+  // sequential, and the parsing is done by the compiling threads.
+  //
+  // We are setting llvm::SmallString's InternalLen to 0, because we want to
+  // allocate its buffer on the heap.
+  std::vector<llvm::SmallString<0>> bitcodes(modules.size());
+  for (int i = 0; i < modules.size(); ++i) {
+    llvm::raw_svector_ostream bitcode_ostream(bitcodes[i]);
+    llvm::WriteBitcodeToFile(*modules[i], bitcode_ostream);
+  }
+  modules.clear();
+
+  std::vector<absl::StatusOr<std::unique_ptr<llvm::MemoryBuffer>>> results(
+      bitcodes.size());
+  auto compile_part = [&](int i) {
+    llvm::LLVMContext context;
+    llvm::Expected<std::unique_ptr<llvm::Module>> module =
+        llvm::parseBitcodeFile(
+            llvm::MemoryBufferRef(
+                llvm::StringRef(bitcodes[i].data(), bitcodes[i].size()),
+                "split_module"),
+            context);
+    if (!module) {
+      results[i] = Internal("Failed to parse split module %d: %s", i,
+                            llvm::toString(module.takeError()));
+      return;
+    }
+    results[i] = compile(i, **module);
+  };
+
+  if (thread_pool == nullptr) {
+    for (int i = 0; i < bitcodes.size(); ++i) compile_part(i);
+  } else {
+    tsl::BlockingCounter counter(bitcodes.size());
+    for (int i = 0; i < bitcodes.size(); ++i) {
+      thread_pool->Schedule([&, i] {
+        compile_part(i);
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+  }
+
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> obj_files;
+  obj_files.reserve(results.size());
+  for (auto& result : results) {
+    if (!result.ok()) return result.status();
+    obj_files.push_back(std::move(result).value());
+  }
+  return obj_files;
+}
+
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,71 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_SERVICE_CPU_PARALLEL_CODEGEN_H_
+#define XLA_SERVICE_CPU_PARALLEL_CODEGEN_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/functional/function_ref.h"
+#include "absl/status/statusor.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "tsl/platform/threadpool.h"
+
+namespace xla {
+namespace cpu {
+
+// Functions with local linkage and at least this many instructions are never
+// inlined into more than one caller, so moving them to a module of their own
+// doesn't change the generated code.
+inline constexpr int64_t kMinInstructionsToSplitFunction = 1000;
+
+// Splits `module` into at most `max_parts` modules, which can be optimized
+// and compiled independently and then linked together by the JIT.
+//
+// The IR emitter gives every computation but the entry computation local
+// linkage, so that LLVM can inline it into its callers. Splitting must not
+// change what gets inlined, so only the local functions that would never be
+// inlined anyway are given (hidden) external linkage and can be moved to
+// another module: the functions that are only called through a pointer, like
+// the parallel tasks passed to the fork-join runtime, and the large functions
+// with several callers. All the other local functions and globals stay in the
+// same module as their users.
+//
+// The returned modules live in the LLVM context of `module`, and are
+// non-empty. The original module is consumed.
+std::vector<std::unique_ptr<llvm::Module>> SplitModuleForParallelCodegen(
+    std::unique_ptr<llvm::Module> module, int max_parts);
+
+// Compiles `modules` to object files in parallel on `thread_pool`, and returns
+// the object files in the order of `modules`.
+//
+// Each module is moved to an LLVM context of its own before it's passed to
+// `compile`, which runs concurrently on the threads of the pool, and must be
+// thread safe. `compile` also gets the index of the module, for naming dumps.
+absl::StatusOr<std::vector<std::unique_ptr<llvm::MemoryBuffer>>>
+CompileModulesInParallel(
+    std::vector<std::unique_ptr<llvm::Module>> modules,
+    tsl::thread::ThreadPool* thread_pool,
+    absl::FunctionRef<absl::StatusOr<std::unique_ptr<llvm::MemoryBuffer>>(
+        int, llvm::Module&)>
+        compile);
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // XLA_SERVICE_CPU_PARALLEL_CODEGEN_H_
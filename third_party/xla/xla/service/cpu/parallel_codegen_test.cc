@@ -0,0 +1,199 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/parallel_codegen.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/statusor.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "xla/test.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/statusor.h"
+#include "tsl/platform/threadpool.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+// An entry function with a reducer called once, and two parallel tasks only
+// passed to the fork-join runtime, like the IR emitter generates them.
+constexpr char kModuleIr[] = R"(
+@constant = private constant [4 x i32] [i32 1, i32 2, i32 3, i32 4]
+
+declare void @fork_join(ptr)
+
+define internal void @reducer(ptr %p) {
+  store i32 1, ptr %p
+  ret void
+}
+
+define internal void @task0(ptr %p) {
+  %v = load i32, ptr @constant
+  store i32 %v, ptr %p
+  ret void
+}
+
+define internal void @task1(ptr %p) {
+  store i32 2, ptr %p
+  ret void
+}
+
+define void @entry(ptr %out) {
+  call void @reducer(ptr %out)
+  call void @fork_join(ptr @task0)
+  call void @fork_join(ptr @task1)
+  ret void
+}
+)";
+
+std::unique_ptr<llvm::Module> ParseModule(llvm::LLVMContext& context,
+                                          const char* ir) {
+  llvm::SMDiagnostic error;
+  std::unique_ptr<llvm::Module> module =
+      llvm::parseAssemblyString(ir, error, context);
+  CHECK(module != nullptr) << error.getMessage().str();
+  return module;
+}
+
+// Returns the names of the functions defined in `module`, in order.
+std::string DefinedFunctions(const llvm::Module& module) {
+  std::string names;
+  for (const llvm::Function& function : module.functions()) {
+    if (function.isDeclaration()) continue;
+    names += function.getName().str() + ";";
+  }
+  return names;
+}
+
+const llvm::Module* FindDefinition(
+    const std::vector<std::unique_ptr<llvm::Module>>& modules,
+    const std::string& name) {
+  const llvm::Module* result = nullptr;
+  for (const auto& module : modules) {
+    const llvm::Function* function = module->getFunction(name);
+    if (function == nullptr || function->isDeclaration()) continue;
+    EXPECT_EQ(result, nullptr) << name << " is defined twice";
+    result = module.get();
+  }
+  return result;
+}
+
+TEST(ParallelCodegenTest, SplitsTasksAndKeepsInlinableFunctions) {
+  llvm::LLVMContext context;
+  std::vector<std::unique_ptr<llvm::Module>> modules =
+      SplitModuleForParallelCodegen(ParseModule(context, kModuleIr),
+                                    /*max_parts=*/3);
+  ASSERT_GT(modules.size(), 1);
+  ASSERT_LE(modules.size(), 3);
+
+  const llvm::Module* entry_module = FindDefinition(modules, "entry");
+  ASSERT_NE(entry_module, nullptr);
+  // The reducer is inlined into the entry function, so it has to stay in the
+  // same module, with local linkage.
+  EXPECT_EQ(FindDefinition(modules, "reducer"), entry_module);
+  EXPECT_TRUE(entry_module->getFunction("reducer")->hasLocalLinkage());
+
+  absl::flat_hash_set<const llvm::Module*> task_modules;
+  for (const char* task : {"task0", "task1"}) {
+    const llvm::Module* task_module = FindDefinition(modules, task);
+    ASSERT_NE(task_module, nullptr) << task;
+    const llvm::Function* function = task_module->getFunction(task);
+    EXPECT_FALSE(function->hasLocalLinkage()) << task;
+    EXPECT_TRUE(function->hasHiddenVisibility()) << task;
+    task_modules.insert(task_module);
+  }
+  task_modules.insert(entry_module);
+  EXPECT_GT(task_modules.size(), 1);
+}
+
+TEST(ParallelCodegenTest, DoesNotSplitInlinableFunctions) {
+  llvm::LLVMContext context;
+  std::vector<std::unique_ptr<llvm::Module>> modules =
+      SplitModuleForParallelCodegen(ParseModule(context, R"(
+define internal void @reducer(ptr %p) {
+  store i32 1, ptr %p
+  ret void
+}
+
+define void @entry(ptr %out) {
+  call void @reducer(ptr %out)
+  ret void
+}
+)"),
+                                    /*max_parts=*/4);
+  ASSERT_EQ(modules.size(), 1);
+  EXPECT_EQ(DefinedFunctions(*modules[0]), "reducer;entry;");
+  EXPECT_TRUE(modules[0]->getFunction("reducer")->hasLocalLinkage());
+}
+
+TEST(ParallelCodegenTest, CompilesModulesInOrder) {
+  llvm::LLVMContext context;
+  std::vector<std::unique_ptr<llvm::Module>> modules =
+      SplitModuleForParallelCodegen(ParseModule(context, kModuleIr),
+                                    /*max_parts=*/3);
+  std::vector<std::string> expected;
+  for (const auto& module : modules) {
+    expected.push_back(DefinedFunctions(*module));
+  }
+
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), "test", 3);
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::vector<std::unique_ptr<llvm::MemoryBuffer>> obj_files,
+      CompileModulesInParallel(
+          std::move(modules), &thread_pool,
+          [&](int part, llvm::Module& module)
+              -> absl::StatusOr<std::unique_ptr<llvm::MemoryBuffer>> {
+            EXPECT_NE(&module.getContext(), &context);
+            return llvm::MemoryBuffer::getMemBufferCopy(
+                DefinedFunctions(module));
+          }));
+  ASSERT_EQ(obj_files.size(), expected.size());
+  for (int i = 0; i < obj_files.size(); ++i) {
+    EXPECT_EQ(obj_files[i]->getBuffer().str(), expected[i]);
+  }
+}
+
+TEST(ParallelCodegenTest, ReturnsCompilationErrors) {
+  llvm::LLVMContext context;
+  std::vector<std::unique_ptr<llvm::Module>> modules =
+      SplitModuleForParallelCodegen(ParseModule(context, kModuleIr),
+                                    /*max_parts=*/3);
+  ASSERT_GT(modules.size(), 1);
+
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), "test", 3);
+  absl::StatusOr<std::vector<std::unique_ptr<llvm::MemoryBuffer>>> obj_files =
+      CompileModulesInParallel(
+          std::move(modules), &thread_pool,
+          [](int part, llvm::Module& module)
+              -> absl::StatusOr<std::unique_ptr<llvm::MemoryBuffer>> {
+            if (part == 1) return absl::InternalError("part 1 failed");
+            return llvm::MemoryBuffer::getMemBuffer("");
+          });
+  EXPECT_FALSE(obj_files.ok());
+  EXPECT_EQ(obj_files.status().message(), "part 1 failed");
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
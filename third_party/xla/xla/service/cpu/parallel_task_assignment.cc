@@ -283,8 +283,12 @@ void ParallelTaskAssigner::ComputeTargetParallelTasks(
       const int64_t target_parallel_task_count =
           parallel_task_assignment.GetTargetParallelTaskCount(instruction);
       if (target_parallel_task_count > 1) {
+        // The runtime claims the tasks dynamically, so splitting the work of
+        // each thread balances it when some threads are slower or busy.
+        const int64_t tasks_per_thread =
+            std::max(int64_t{1}, tasks_per_thread_);
         hlo_to_parallel_tasks->insert(
-            {instruction, target_parallel_task_count});
+            {instruction, target_parallel_task_count * tasks_per_thread});
       }
     }
   }
@@ -75,10 +75,15 @@ class ParallelTaskAssigner : public HloModulePass {
   // 'max_parallelism': the maximum parallel task count per instruction.
   // 'shape_size': shape size function used by HloCostAnalysis during parallel
   //               task assignment.
+  // 'tasks_per_thread': the number of tasks each parallelized instruction is
+  //                     split into per thread it's assigned, so that the
+  //                     runtime can balance the tasks across threads.
   ParallelTaskAssigner(const int64_t max_parallelism,
                        const HloCostAnalysis::ShapeSizeFunction& shape_size,
-                       const TargetMachineFeatures* target_machine_features)
+                       const TargetMachineFeatures* target_machine_features,
+                       const int64_t tasks_per_thread = 1)
       : max_parallelism_(max_parallelism),
+        tasks_per_thread_(tasks_per_thread),
         shape_size_function_(shape_size),
         target_machine_features_(*target_machine_features) {}
   ~ParallelTaskAssigner() override {}
@@ -114,6 +119,7 @@ class ParallelTaskAssigner : public HloModulePass {
                                   HloToParallelTasks* hlo_to_parallel_tasks);
 
   int64_t max_parallelism_;
+  int64_t tasks_per_thread_;
   HloCostAnalysis::ShapeSizeFunction shape_size_function_;
   const TargetMachineFeatures& target_machine_features_;
 };
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "xla/service/cpu/parallel_task_assignment.h"
 
+#include "xla/service/cpu/backend_config.pb.h"
 #include "xla/service/cpu/cpu_executable.h"
 #include "xla/service/cpu/target_machine_features_fake.h"
 #include "xla/test.h"
@@ -40,11 +41,30 @@ class ParallelTaskAssignmentTest : public HloTestBase {
           return cpu::TargetMachineFeatures::kEigenExpectedTensorAlignment;
         }) {}
 
-  StatusOr<bool> RunParallelTaskAssigner(HloModule* module) {
+  StatusOr<bool> RunParallelTaskAssigner(HloModule* module,
+                                         int64_t tasks_per_thread = 1) {
     return cpu::ParallelTaskAssigner(max_parallelism_, shape_size_func_,
-                                     &target_machine_features_)
+                                     &target_machine_features_,
+                                     tasks_per_thread)
         .Run(module);
   }
+
+  // Returns the number of partitions assigned to the instruction outlined
+  // into the computation called by the root of the entry computation.
+  int64_t GetRootPartitionCount(HloModule* module) {
+    const HloInstruction* root =
+        module->entry_computation()->root_instruction();
+    EXPECT_EQ(root->opcode(), HloOpcode::kCall);
+    auto backend_config = root->to_apply()
+                              ->root_instruction()
+                              ->backend_config<cpu::BackendConfig>();
+    EXPECT_TRUE(backend_config.ok());
+    int64_t partition_count = 1;
+    for (int64_t count : backend_config->outer_dimension_partitions()) {
+      partition_count *= count;
+    }
+    return partition_count;
+  }
 };
 
 TEST_F(ParallelTaskAssignmentTest, DotOperationNotParallelized) {
@@ -206,5 +226,49 @@ TEST_F(ParallelTaskAssignmentTest, ConstantNotParallelized) {
   EXPECT_FALSE(changed);
 }
 
+TEST_F(ParallelTaskAssignmentTest, TasksPerThreadSplitsParallelTasks) {
+  // A compute bound fusion, which is split into 'max_parallelism_' tasks.
+  constexpr char hlo_string[] = R"(
+  HloModule TestTaskParallel_tasks_per_thread
+    fused_computation {
+      p = f32[1024,1024] parameter(0)
+      m0 = f32[1024,1024] multiply(p, p)
+      m1 = f32[1024,1024] multiply(m0, p)
+      m2 = f32[1024,1024] multiply(m1, p)
+      m3 = f32[1024,1024] multiply(m2, p)
+      m4 = f32[1024,1024] multiply(m3, p)
+      m5 = f32[1024,1024] multiply(m4, p)
+      m6 = f32[1024,1024] multiply(m5, p)
+      m7 = f32[1024,1024] multiply(m6, p)
+      m8 = f32[1024,1024] multiply(m7, p)
+      m9 = f32[1024,1024] multiply(m8, p)
+      m10 = f32[1024,1024] multiply(m9, p)
+      m11 = f32[1024,1024] multiply(m10, p)
+      m12 = f32[1024,1024] multiply(m11, p)
+      m13 = f32[1024,1024] multiply(m12, p)
+      m14 = f32[1024,1024] multiply(m13, p)
+      ROOT m15 = f32[1024,1024] multiply(m14, p)
+    }
+
+    ENTRY e {
+      p = f32[1024,1024] parameter(0)
+      ROOT fusion = f32[1024,1024] fusion(p), kind=kLoop,
+        calls=fused_computation
+    }
+  )";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> m,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunParallelTaskAssigner(m.get()));
+  EXPECT_TRUE(changed);
+  EXPECT_EQ(GetRootPartitionCount(m.get()), max_parallelism_);
+
+  TF_ASSERT_OK_AND_ASSIGN(m, ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(changed, RunParallelTaskAssigner(
+                                       m.get(), /*tasks_per_thread=*/4));
+  EXPECT_TRUE(changed);
+  EXPECT_EQ(GetRootPartitionCount(m.get()), 4 * max_parallelism_);
+}
+
 }  // namespace
 }  // namespace xla
@@ -17,6 +17,15 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "absl/base/dynamic_annotations.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
@@ -29,9 +38,65 @@ limitations under the License.
 using ComputeFunctionType = void (*)(void*, const void*, const void**, void**,
                                      void*, int64_t*, uint64_t*);
 
-// Dispatches 'num_partitions - 1' calls to 'function_ptr' in parallel.
-// Calls 'function_ptr' for first partition inline.
-// Uses blocking counter to synchronize threads after parallel calls complete.
+namespace {
+
+// The state of a parallel loop, shared by the caller and the workers it
+// dispatched. Partitions are claimed dynamically, so that idle threads pick up
+// the partitions of busy ones, and the caller runs all of them if the thread
+// pool is saturated. Workers which start after all partitions were claimed
+// only touch this state, so the caller doesn't wait for them to be scheduled.
+struct ParallelLoop {
+  ParallelLoop(ComputeFunctionType function, void* result_ptr,
+               const void* run_options_ptr, void** buffer_table,
+               uint64_t* prof_counters, int32_t num_partitions,
+               int64_t* partitions, int64_t stride)
+      : function(function),
+        result_ptr(result_ptr),
+        run_options_ptr(run_options_ptr),
+        buffer_table(buffer_table),
+        prof_counters(prof_counters),
+        num_partitions(num_partitions),
+        partitions(partitions),
+        stride(stride),
+        statuses(num_partitions),
+        pending_partitions(num_partitions) {}
+
+  // Runs partitions until all of them were claimed.
+  void RunPartitions() {
+    for (int32_t i = next_partition.fetch_add(1, std::memory_order_relaxed);
+         i < num_partitions;
+         i = next_partition.fetch_add(1, std::memory_order_relaxed)) {
+      function(result_ptr, run_options_ptr, nullptr, buffer_table,
+               &statuses[i], &partitions[i * stride], prof_counters);
+      VLOG(3) << "ParallelForkJoin partition " << i << " done.";
+      pending_partitions.DecrementCount();
+    }
+  }
+
+  const ComputeFunctionType function;
+  void* const result_ptr;
+  const void* const run_options_ptr;
+  void** const buffer_table;
+  uint64_t* const prof_counters;
+  const int32_t num_partitions;
+  int64_t* const partitions;
+  const int64_t stride;
+
+  std::atomic<int32_t> next_partition{0};
+  std::vector<XlaCustomCallStatus> statuses;
+  tsl::BlockingCounter pending_partitions;
+};
+
+}  // namespace
+
+// Runs 'num_partitions' calls to 'function_ptr' in parallel, and returns when
+// all of them are done.
+//
+// The calling thread and up to 'num_partitions - 1' threads of the intra-op
+// thread pool claim partitions one at a time until none is left, so the
+// partitions are balanced across the threads that are actually available.
+// The ParallelTaskAssigner can create more partitions than threads to make
+// the balancing finer (see 'xla_cpu_parallel_tasks_per_thread').
 //
 // The 'partitions' array has a total number of elements equal to
 // 'num_partitions * num_partitioned_dims * 2' (the '2' is necessary to specify
@@ -80,27 +145,22 @@ ABSL_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_ParallelForkJoin(
   // Compute partition stride in 'partitions' array.
   const int64_t stride = 2 * num_partitioned_dims;
 
-  std::vector<XlaCustomCallStatus> statuses(num_partitions);
-
-  // Dispatch 'num_partitions - 1' compute functions to run in parallel.
-  tsl::BlockingCounter bc(num_partitions - 1);
-  for (int32_t i = 1; i < num_partitions; ++i) {
-    const int64_t offset = i * stride;
-    run_options->intra_op_thread_pool()->enqueueNoNotification(
-        [i, function, result_ptr, run_options_ptr, buffer_table, prof_counters,
-         partitions, offset, &bc, &statuses]() {
-          function(result_ptr, run_options_ptr, nullptr, buffer_table,
-                   &statuses[i], &partitions[offset], prof_counters);
-          bc.DecrementCount();
-          VLOG(3) << "ParallelForkJoin partition " << i << " done.";
-        });
-  }
+  auto loop = std::make_shared<ParallelLoop>(
+      function, result_ptr, run_options_ptr, buffer_table, prof_counters,
+      num_partitions, partitions, stride);
 
-  // Call first compute function inline.
-  function(result_ptr, run_options_ptr, params, buffer_table, &statuses[0],
-           &partitions[0], prof_counters);
-  VLOG(3) << "ParallelForkJoin partition 0 done.";
-  bc.Wait();
+  // Dispatch workers to the intra-op thread pool, and run partitions inline
+  // until none is left.
+  const Eigen::ThreadPoolDevice* thread_pool =
+      run_options->intra_op_thread_pool();
+  const int32_t num_workers =
+      std::min<int32_t>(num_partitions - 1, thread_pool->numThreads());
+  for (int32_t i = 0; i < num_workers; ++i) {
+    thread_pool->enqueueNoNotification([loop] { loop->RunPartitions(); });
+  }
+  loop->RunPartitions();
+  loop->pending_partitions.Wait();
+  const std::vector<XlaCustomCallStatus>& statuses = loop->statuses;
 
   // Collect all error messages (if any).
   std::vector<std::pair<int32_t, absl::string_view>> error_messages;
@@ -0,0 +1,157 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/runtime_fork_join.h"
+
+#define EIGEN_USE_THREADS
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/notification.h"
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+#include "xla/executable_run_options.h"
+#include "xla/service/custom_call_status.h"
+#include "xla/service/custom_call_status_internal.h"
+#include "tsl/platform/test.h"
+#include "tsl/platform/test_benchmark.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+// The state of a test loop, passed to the partitions in the buffer table.
+struct Loop {
+  std::vector<std::atomic<int32_t>> runs;
+  std::optional<int64_t> failing_partition;
+  int64_t work_per_partition = 0;
+};
+
+// A parallel loop body over a single partitioned dimension, which records the
+// partitions it runs.
+void LoopBody(void* /*result*/, const void* /*run_options*/,
+              const void** /*params*/, void** buffer_table, void* status,
+              int64_t* partition, uint64_t* /*prof_counters*/) {
+  auto* loop = static_cast<Loop*>(buffer_table[0]);
+  const int64_t start = partition[0];
+  CHECK_EQ(partition[1], start + 1);
+  float sum = 0;
+  for (int64_t i = 0; i < loop->work_per_partition; ++i) {
+    sum += static_cast<float>(i) * 0.5f;
+  }
+  tsl::testing::DoNotOptimize(sum);
+  loop->runs[start].fetch_add(1);
+  if (loop->failing_partition == start) {
+    std::string message = absl::StrCat("failed ", start);
+    XlaCustomCallStatusSetFailure(static_cast<XlaCustomCallStatus*>(status),
+                                  message.data(), message.size());
+  }
+}
+
+// Returns the 'partitions' array of a loop over a dimension of size
+// 'num_partitions', with one partition per index.
+std::vector<int64_t> Partitions(int32_t num_partitions) {
+  std::vector<int64_t> partitions;
+  for (int64_t i = 0; i < num_partitions; ++i) {
+    partitions.push_back(i);
+    partitions.push_back(i + 1);
+  }
+  return partitions;
+}
+
+std::optional<std::string> RunLoop(const Eigen::ThreadPoolDevice& device,
+                                   Loop& loop, int32_t num_partitions) {
+  ExecutableRunOptions run_options;
+  run_options.set_intra_op_thread_pool(&device);
+  std::vector<int64_t> partitions = Partitions(num_partitions);
+  void* buffer_table[] = {&loop};
+  XlaCustomCallStatus status;
+  __xla_cpu_runtime_ParallelForkJoin(
+      /*result_ptr=*/nullptr, &run_options, /*params=*/nullptr, buffer_table,
+      &status, /*prof_counters=*/nullptr, num_partitions, partitions.data(),
+      /*num_partitioned_dims=*/1, reinterpret_cast<void*>(&LoopBody));
+  std::optional<absl::string_view> message =
+      CustomCallStatusGetMessage(&status);
+  if (!message) return std::nullopt;
+  return std::string(*message);
+}
+
+TEST(RuntimeForkJoinTest, RunsEachPartitionOnce) {
+  Eigen::ThreadPool pool(4);
+  Eigen::ThreadPoolDevice device(&pool, pool.NumThreads());
+  Loop loop{std::vector<std::atomic<int32_t>>(100)};
+  loop.work_per_partition = 1000;
+
+  EXPECT_EQ(RunLoop(device, loop, 100), std::nullopt);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(loop.runs[i].load(), 1) << i;
+  }
+}
+
+TEST(RuntimeForkJoinTest, RunsPartitionsInlineWhenThreadPoolIsBusy) {
+  Eigen::ThreadPool pool(2);
+  Eigen::ThreadPoolDevice device(&pool, pool.NumThreads());
+  absl::Notification release;
+  for (int i = 0; i < pool.NumThreads(); ++i) {
+    pool.Schedule([&] { release.WaitForNotification(); });
+  }
+
+  // The loop must not wait for the blocked threads.
+  Loop loop{std::vector<std::atomic<int32_t>>(8)};
+  EXPECT_EQ(RunLoop(device, loop, 8), std::nullopt);
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_EQ(loop.runs[i].load(), 1) << i;
+  }
+  release.Notify();
+}
+
+TEST(RuntimeForkJoinTest, ReturnsErrorsOfPartitions) {
+  Eigen::ThreadPool pool(4);
+  Eigen::ThreadPoolDevice device(&pool, pool.NumThreads());
+  Loop loop{std::vector<std::atomic<int32_t>>(16)};
+  loop.failing_partition = 5;
+
+  EXPECT_EQ(RunLoop(device, loop, 16), "Partition 5 error: failed 5");
+}
+
+// Runs a loop with as many partitions as the first argument, where each
+// partition does as much work as the second argument.
+void BM_ParallelForkJoin(::testing::benchmark::State& state) {
+  const int32_t num_partitions = state.range(0);
+  Eigen::ThreadPool pool(8);
+  Eigen::ThreadPoolDevice device(&pool, pool.NumThreads());
+  Loop loop{std::vector<std::atomic<int32_t>>(num_partitions)};
+  loop.work_per_partition = state.range(1);
+
+  for (auto s : state) {
+    RunLoop(device, loop, num_partitions);
+  }
+}
+
+BENCHMARK(BM_ParallelForkJoin)
+    ->ArgPair(8, 100000)
+    ->ArgPair(32, 25000)
+    ->ArgPair(128, 6250)
+    ->ArgPair(8, 1000)
+    ->ArgPair(32, 250);
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,185 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Tests that the GEMM microkernel computes the same results as Eigen.
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_replace.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "xla/debug_options_flags.h"
+#include "xla/literal.h"
+#include "xla/primitive_util.h"
+#include "xla/service/cpu/tests/cpu_codegen_test.h"
+#include "xla/service/hlo_module_config.h"
+#include "xla/service/hlo_parser.h"
+#include "xla/service/hlo_runner.h"
+#include "xla/service/platform_util.h"
+#include "xla/tests/literal_test_util.h"
+#include "xla/tests/test_utils.h"
+#include "xla/xla_data.pb.h"
+#include "tsl/platform/logging.h"
+#include "tsl/platform/test.h"
+#include "tsl/platform/test_benchmark.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+// A dense layer: a matrix multiplication followed by a bias add, which is
+// output fused into the microkernel, and a ReLU.
+constexpr absl::string_view kDenseLayer = R"(
+HloModule dense_layer
+
+ENTRY dense_layer {
+  x = $type[$m,$k] parameter(0)
+  w = $type[$k,$n] parameter(1)
+  b = $type[$n] parameter(2)
+  dot = $type[$m,$n] dot(x, w), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+  bias = $type[$m,$n] broadcast(b), dimensions={1}
+  add = $type[$m,$n] add(dot, bias)
+  zero = $type[] constant(0)
+  zeros = $type[$m,$n] broadcast(zero), dimensions={}
+  ROOT relu = $type[$m,$n] maximum(add, zeros)
+}
+)";
+
+std::string GetDenseLayer(PrimitiveType type, int64_t m, int64_t k,
+                          int64_t n) {
+  return absl::StrReplaceAll(
+      kDenseLayer,
+      {{"$type", primitive_util::LowercasePrimitiveTypeName(type)},
+       {"$m", absl::StrCat(m)},
+       {"$k", absl::StrCat(k)},
+       {"$n", absl::StrCat(n)}});
+}
+
+HloModuleConfig GetConfig(HloModuleConfig config, bool use_microkernel) {
+  DebugOptions debug_options = config.debug_options();
+  debug_options.set_xla_cpu_microkernel_gemm_max_size(
+      use_microkernel ? int64_t{1} << 40 : 0);
+  config.set_debug_options(debug_options);
+  return config;
+}
+
+struct GemmTestSpec {
+  PrimitiveType type;
+  int64_t m;
+  int64_t k;
+  int64_t n;
+};
+
+std::string GemmTestSpecToString(
+    const ::testing::TestParamInfo<GemmTestSpec>& info) {
+  return absl::StrCat(PrimitiveType_Name(info.param.type), "_", info.param.m,
+                      "x", info.param.k, "x", info.param.n);
+}
+
+class CpuMicrokernelGemmTest
+    : public CpuCodegenTest,
+      public ::testing::WithParamInterface<GemmTestSpec> {
+ protected:
+  Literal Run(absl::string_view hlo, bool use_microkernel,
+              absl::Span<Literal* const> arguments) {
+    auto module = ParseAndReturnVerifiedModule(
+        hlo, GetConfig(GetModuleConfigForTest(), use_microkernel));
+    CHECK_OK(module.status());
+    return ExecuteAndTransfer(*std::move(module), arguments);
+  }
+};
+
+TEST_P(CpuMicrokernelGemmTest, MatchesEigen) {
+  GemmTestSpec spec = GetParam();
+  std::string hlo = GetDenseLayer(spec.type, spec.m, spec.k, spec.n);
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(hlo));
+  TF_ASSERT_OK_AND_ASSIGN(std::vector<Literal> arguments,
+                          MakeFakeArguments(module.get()));
+  std::vector<Literal*> argument_ptrs;
+  for (Literal& argument : arguments) {
+    argument_ptrs.push_back(&argument);
+  }
+  Literal expected = Run(hlo, /*use_microkernel=*/false, argument_ptrs);
+  Literal actual = Run(hlo, /*use_microkernel=*/true, argument_ptrs);
+  EXPECT_TRUE(LiteralTestUtil::Near(expected, actual, ErrorSpec{1e-3, 1e-3}));
+}
+
+TEST_P(CpuMicrokernelGemmTest, DoesNotCallEigen) {
+  GemmTestSpec spec = GetParam();
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto module,
+      ParseAndReturnVerifiedModule(
+          GetDenseLayer(spec.type, spec.m, spec.k, spec.n),
+          GetConfig(GetModuleConfigForTest(), /*use_microkernel=*/true)));
+  CompileAndVerifyIr(std::move(module), "CHECK-NOT: EigenMatMul",
+                     /*match_optimized_ir=*/true);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    CpuMicrokernelGemmTestInstantiation, CpuMicrokernelGemmTest,
+    ::testing::ValuesIn(std::vector<GemmTestSpec>{
+        // A single register tile.
+        {F32, 8, 8, 16},
+        // Residues in all dimensions.
+        {F32, 37, 129, 71},
+        {F64, 37, 129, 71},
+        // Several blocks in K.
+        {F32, 64, 512, 256},
+        // Several blocks in K and N, with a remainder in both.
+        {F32, 32, 300, 1100},
+        {F64, 32, 300, 1100},
+    }),
+    GemmTestSpecToString);
+
+// Runs a dense layer of the given shape with the microkernel if the last
+// benchmark argument is 1, and with Eigen otherwise.
+void BM_DenseLayer(::testing::benchmark::State& state) {
+  HloRunner runner(PlatformUtil::GetPlatform("cpu").value());
+  HloModuleConfig config;
+  config.set_debug_options(GetDebugOptionsFromFlags());
+  std::unique_ptr<HloModule> module =
+      ParseAndReturnUnverifiedModule(
+          GetDenseLayer(F32, state.range(0), state.range(1), state.range(2)),
+          GetConfig(config, /*use_microkernel=*/state.range(3) == 1))
+          .value();
+  std::vector<Literal> arguments = MakeFakeArguments(module.get()).value();
+  std::vector<const Literal*> argument_ptrs;
+  for (const Literal& argument : arguments) {
+    argument_ptrs.push_back(&argument);
+  }
+  std::unique_ptr<Executable> executable =
+      runner.CreateExecutable(std::move(module), /*run_hlo_passes=*/true)
+          .value();
+
+  for (auto s : state) {
+    CHECK_OK(
+        runner.ExecuteWithExecutable(executable.get(), argument_ptrs).status());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) *
+                          state.range(1) * state.range(2));
+}
+
+BENCHMARK(BM_DenseLayer)
+    ->ArgsProduct({{8, 32, 64, 128, 256}, {64, 256, 512}, {64, 256, 1024},
+                   {0, 1}});
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,86 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <string>
+
+#include "xla/literal_util.h"
+#include "xla/service/cpu/tests/cpu_codegen_test.h"
+#include "xla/tests/literal_test_util.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+class CpuParallelCodegenTest : public CpuCodegenTest {
+ private:
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = CpuCodegenTest::GetDebugOptionsForTest();
+    debug_options.set_xla_cpu_parallel_codegen_split_count(4);
+    return debug_options;
+  }
+};
+
+TEST_F(CpuParallelCodegenTest, WhileWithCallsAndReductions) {
+  const std::string hlo_text = R"(
+HloModule module
+
+add {
+  add.lhs = s32[] parameter(0)
+  add.rhs = s32[] parameter(1)
+  ROOT add.sum = s32[] add(add.lhs, add.rhs)
+}
+
+double {
+  double.p0 = s32[1024] parameter(0)
+  ROOT double.sum = s32[1024] add(double.p0, double.p0)
+}
+
+body {
+  body.p0 = (s32[], s32[1024]) parameter(0)
+  body.i = s32[] get-tuple-element(body.p0), index=0
+  body.one = s32[] constant(1)
+  body.next = s32[] add(body.i, body.one)
+  body.data = s32[1024] get-tuple-element(body.p0), index=1
+  body.doubled = s32[1024] call(body.data), to_apply=double
+  ROOT body.root = (s32[], s32[1024]) tuple(body.next, body.doubled)
+}
+
+cond {
+  cond.p0 = (s32[], s32[1024]) parameter(0)
+  cond.i = s32[] get-tuple-element(cond.p0), index=0
+  cond.n = s32[] constant(3)
+  ROOT cond.root = pred[] compare(cond.i, cond.n), direction=LT
+}
+
+ENTRY entry {
+  entry.zero = s32[] constant(0)
+  entry.data = s32[1024] iota(), iota_dimension=0
+  entry.init = (s32[], s32[1024]) tuple(entry.zero, entry.data)
+  entry.loop = (s32[], s32[1024]) while(entry.init), condition=cond, body=body
+  entry.result = s32[1024] get-tuple-element(entry.loop), index=1
+  ROOT entry.root = s32[] reduce(entry.result, entry.zero), dimensions={0},
+    to_apply=add
+}
+)";
+
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(hlo_text));
+  auto result = ExecuteAndTransfer(std::move(module), {});
+  // 8 * (0 + 1 + ... + 1023).
+  LiteralTestUtil::ExpectR0Equal(8 * 1023 * 1024 / 2, result);
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,205 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "xla/debug_options_flags.h"
+#include "xla/literal.h"
+#include "xla/service/cpu/tests/cpu_codegen_test.h"
+#include "xla/service/hlo_module_config.h"
+#include "xla/service/hlo_parser.h"
+#include "xla/service/hlo_runner.h"
+#include "xla/service/platform_util.h"
+#include "xla/tests/literal_test_util.h"
+#include "xla/tests/test_utils.h"
+#include "tsl/platform/logging.h"
+#include "tsl/platform/test.h"
+#include "tsl/platform/test_benchmark.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+// Two dense layers, with the bias additions and activations parallelized.
+constexpr absl::string_view kMlp = R"(
+HloModule mlp
+
+ENTRY mlp {
+  x = f32[256,1024] parameter(0)
+  w0 = f32[1024,1024] parameter(1)
+  b0 = f32[1024] parameter(2)
+  w1 = f32[1024,1024] parameter(3)
+  b1 = f32[1024] parameter(4)
+  zero = f32[] constant(0)
+  zeros = f32[256,1024] broadcast(zero), dimensions={}
+
+  d0 = f32[256,1024] dot(x, w0), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+  bias0 = f32[256,1024] broadcast(b0), dimensions={1}
+  a0 = f32[256,1024] add(d0, bias0)
+  h0 = f32[256,1024] maximum(a0, zeros)
+
+  d1 = f32[256,1024] dot(h0, w1), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+  bias1 = f32[256,1024] broadcast(b1), dimensions={1}
+  a1 = f32[256,1024] add(d1, bias1)
+  ROOT h1 = f32[256,1024] tanh(a1)
+}
+)";
+
+// A single head self-attention followed by a residual connection and a layer
+// normalization, with the softmax and normalization reductions parallelized.
+constexpr absl::string_view kTransformerBlock = R"(
+HloModule transformer_block
+
+max {
+  max.lhs = f32[] parameter(0)
+  max.rhs = f32[] parameter(1)
+  ROOT max.result = f32[] maximum(max.lhs, max.rhs)
+}
+
+add {
+  add.lhs = f32[] parameter(0)
+  add.rhs = f32[] parameter(1)
+  ROOT add.result = f32[] add(add.lhs, add.rhs)
+}
+
+ENTRY transformer_block {
+  x = f32[512,256] parameter(0)
+  wq = f32[256,256] parameter(1)
+  wk = f32[256,256] parameter(2)
+  wv = f32[256,256] parameter(3)
+  zero = f32[] constant(0)
+  min = f32[] constant(-inf)
+
+  q = f32[512,256] dot(x, wq), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+  k = f32[512,256] dot(x, wk), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+  v = f32[512,256] dot(x, wv), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+  s = f32[512,512] dot(q, k), lhs_contracting_dims={1},
+    rhs_contracting_dims={1}
+  scale = f32[] constant(0.0625)
+  scales = f32[512,512] broadcast(scale), dimensions={}
+  scaled = f32[512,512] multiply(s, scales)
+
+  row_max = f32[512] reduce(scaled, min), dimensions={1}, to_apply=max
+  row_maxes = f32[512,512] broadcast(row_max), dimensions={0}
+  shifted = f32[512,512] subtract(scaled, row_maxes)
+  e = f32[512,512] exponential(shifted)
+  row_sum = f32[512] reduce(e, zero), dimensions={1}, to_apply=add
+  row_sums = f32[512,512] broadcast(row_sum), dimensions={0}
+  p = f32[512,512] divide(e, row_sums)
+  o = f32[512,256] dot(p, v), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+  r = f32[512,256] add(o, x)
+
+  n = f32[] constant(256)
+  ns = f32[512] broadcast(n), dimensions={}
+  sum = f32[512] reduce(r, zero), dimensions={1}, to_apply=add
+  mean = f32[512] divide(sum, ns)
+  means = f32[512,256] broadcast(mean), dimensions={0}
+  centered = f32[512,256] subtract(r, means)
+  squares = f32[512,256] multiply(centered, centered)
+  square_sum = f32[512] reduce(squares, zero), dimensions={1}, to_apply=add
+  variance = f32[512] divide(square_sum, ns)
+  epsilon = f32[] constant(1e-5)
+  epsilons = f32[512] broadcast(epsilon), dimensions={}
+  shifted_variance = f32[512] add(variance, epsilons)
+  rstd = f32[512] rsqrt(shifted_variance)
+  rstds = f32[512,256] broadcast(rstd), dimensions={0}
+  ROOT y = f32[512,256] multiply(centered, rstds)
+}
+)";
+
+class CpuParallelTasksTest : public CpuCodegenTest {
+ protected:
+  // Runs 'hlo' with 'tasks_per_thread' partitions per thread for each
+  // parallelized op.
+  Literal Run(absl::string_view hlo, int tasks_per_thread,
+              absl::Span<Literal* const> arguments) {
+    HloModuleConfig config = GetModuleConfigForTest();
+    DebugOptions debug_options = config.debug_options();
+    debug_options.set_xla_cpu_parallel_tasks_per_thread(tasks_per_thread);
+    config.set_debug_options(debug_options);
+    auto module = ParseAndReturnVerifiedModule(hlo, config);
+    CHECK_OK(module.status());
+    return ExecuteAndTransfer(*std::move(module), arguments);
+  }
+
+  // Checks that splitting the parallelized ops in more tasks doesn't change
+  // the results of 'hlo'.
+  void RunAndCompareTasksPerThread(absl::string_view hlo) {
+    TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(hlo));
+    TF_ASSERT_OK_AND_ASSIGN(std::vector<Literal> arguments,
+                            MakeFakeArguments(module.get()));
+    std::vector<Literal*> argument_ptrs;
+    for (Literal& argument : arguments) {
+      argument_ptrs.push_back(&argument);
+    }
+    Literal expected = Run(hlo, /*tasks_per_thread=*/1, argument_ptrs);
+    Literal actual = Run(hlo, /*tasks_per_thread=*/4, argument_ptrs);
+    EXPECT_TRUE(LiteralTestUtil::Near(expected, actual, ErrorSpec{1e-5}));
+  }
+};
+
+TEST_F(CpuParallelTasksTest, Mlp) { RunAndCompareTasksPerThread(kMlp); }
+
+TEST_F(CpuParallelTasksTest, TransformerBlock) {
+  RunAndCompareTasksPerThread(kTransformerBlock);
+}
+
+// Runs 'hlo' with as many partitions per thread as the benchmark argument.
+void BM_ParallelTasks(::testing::benchmark::State& state,
+                      absl::string_view hlo) {
+  HloRunner runner(PlatformUtil::GetPlatform("cpu").value());
+  HloModuleConfig config;
+  DebugOptions debug_options = GetDebugOptionsFromFlags();
+  debug_options.set_xla_cpu_parallel_tasks_per_thread(state.range(0));
+  config.set_debug_options(debug_options);
+  std::unique_ptr<HloModule> module =
+      ParseAndReturnUnverifiedModule(hlo, config).value();
+  std::vector<Literal> arguments = MakeFakeArguments(module.get()).value();
+  std::vector<const Literal*> argument_ptrs;
+  for (const Literal& argument : arguments) {
+    argument_ptrs.push_back(&argument);
+  }
+  std::unique_ptr<Executable> executable =
+      runner.CreateExecutable(std::move(module), /*run_hlo_passes=*/true)
+          .value();
+
+  for (auto s : state) {
+    CHECK_OK(
+        runner.ExecuteWithExecutable(executable.get(), argument_ptrs).status());
+  }
+}
+
+void BM_Mlp(::testing::benchmark::State& state) {
+  BM_ParallelTasks(state, kMlp);
+}
+
+void BM_TransformerBlock(::testing::benchmark::State& state) {
+  BM_ParallelTasks(state, kTransformerBlock);
+}
+
+BENCHMARK(BM_Mlp)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+BENCHMARK(BM_TransformerBlock)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
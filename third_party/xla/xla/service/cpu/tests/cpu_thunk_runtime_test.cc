@@ -0,0 +1,180 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "xla/debug_options_flags.h"
+#include "xla/literal.h"
+#include "xla/service/cpu/tests/cpu_codegen_test.h"
+#include "xla/service/hlo_module_config.h"
+#include "xla/service/hlo_parser.h"
+#include "xla/service/hlo_runner.h"
+#include "xla/service/platform_util.h"
+#include "xla/tests/literal_test_util.h"
+#include "xla/tests/test_utils.h"
+#include "tsl/platform/logging.h"
+#include "tsl/platform/test.h"
+#include "tsl/platform/test_benchmark.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+// Four independent towers of two dense layers, concatenated at the end.
+constexpr absl::string_view kMultiTower = R"(
+HloModule multi_tower
+
+ENTRY multi_tower {
+  x = f32[128,512] parameter(0)
+  w = f32[4,512,512] parameter(1)
+  zero = f32[] constant(0)
+  zeros = f32[128,512] broadcast(zero), dimensions={}
+
+  s0 = f32[1,512,512] slice(w), slice={[0:1], [0:512], [0:512]}
+  w0 = f32[512,512] reshape(s0)
+  d0 = f32[128,512] dot(x, w0), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+  h0 = f32[128,512] maximum(d0, zeros)
+  t0 = f32[128,512] dot(h0, w0), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+
+  s1 = f32[1,512,512] slice(w), slice={[1:2], [0:512], [0:512]}
+  w1 = f32[512,512] reshape(s1)
+  d1 = f32[128,512] dot(x, w1), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+  h1 = f32[128,512] maximum(d1, zeros)
+  t1 = f32[128,512] dot(h1, w1), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+
+  s2 = f32[1,512,512] slice(w), slice={[2:3], [0:512], [0:512]}
+  w2 = f32[512,512] reshape(s2)
+  d2 = f32[128,512] dot(x, w2), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+  h2 = f32[128,512] maximum(d2, zeros)
+  t2 = f32[128,512] dot(h2, w2), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+
+  s3 = f32[1,512,512] slice(w), slice={[3:4], [0:512], [0:512]}
+  w3 = f32[512,512] reshape(s3)
+  d3 = f32[128,512] dot(x, w3), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+  h3 = f32[128,512] maximum(d3, zeros)
+  t3 = f32[128,512] dot(h3, w3), lhs_contracting_dims={1},
+    rhs_contracting_dims={0}
+
+  ROOT c = f32[128,2048] concatenate(t0, t1, t2, t3), dimensions={1}
+}
+)";
+
+// A loop next to an independent elementwise operation, returning a tuple.
+constexpr absl::string_view kWhileLoop = R"(
+HloModule while_loop
+
+cond {
+  cond.state = (s32[], f32[64]) parameter(0)
+  cond.i = s32[] get-tuple-element(cond.state), index=0
+  cond.n = s32[] constant(10)
+  ROOT cond.result = pred[] compare(cond.i, cond.n), direction=LT
+}
+
+body {
+  body.state = (s32[], f32[64]) parameter(0)
+  body.i = s32[] get-tuple-element(body.state), index=0
+  body.x = f32[64] get-tuple-element(body.state), index=1
+  body.one = s32[] constant(1)
+  body.next_i = s32[] add(body.i, body.one)
+  body.next_x = f32[64] sine(body.x)
+  ROOT body.result = (s32[], f32[64]) tuple(body.next_i, body.next_x)
+}
+
+ENTRY while_loop {
+  x = f32[64] parameter(0)
+  y = f32[64] parameter(1)
+  zero = s32[] constant(0)
+  init = (s32[], f32[64]) tuple(zero, x)
+  loop = (s32[], f32[64]) while(init), condition=cond, body=body
+  loop.x = f32[64] get-tuple-element(loop), index=1
+  exp = f32[64] exponential(y)
+  ROOT result = (f32[64], f32[64]) tuple(loop.x, exp)
+}
+)";
+
+class CpuThunkRuntimeTest : public CpuCodegenTest {
+ protected:
+  Literal Run(absl::string_view hlo, bool use_thunk_runtime,
+              absl::Span<Literal* const> arguments) {
+    HloModuleConfig config = GetModuleConfigForTest();
+    DebugOptions debug_options = config.debug_options();
+    debug_options.set_xla_cpu_use_thunk_runtime(use_thunk_runtime);
+    config.set_debug_options(debug_options);
+    auto module = ParseAndReturnVerifiedModule(hlo, config);
+    CHECK_OK(module.status());
+    return ExecuteAndTransfer(*std::move(module), arguments);
+  }
+
+  // Checks that running the operations of 'hlo' as thunks doesn't change its
+  // results.
+  void RunAndCompareWithThunks(absl::string_view hlo) {
+    TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(hlo));
+    TF_ASSERT_OK_AND_ASSIGN(std::vector<Literal> arguments,
+                            MakeFakeArguments(module.get()));
+    std::vector<Literal*> argument_ptrs;
+    for (Literal& argument : arguments) {
+      argument_ptrs.push_back(&argument);
+    }
+    Literal expected = Run(hlo, /*use_thunk_runtime=*/false, argument_ptrs);
+    Literal actual = Run(hlo, /*use_thunk_runtime=*/true, argument_ptrs);
+    EXPECT_TRUE(LiteralTestUtil::Near(expected, actual, ErrorSpec{1e-5}));
+  }
+};
+
+TEST_F(CpuThunkRuntimeTest, MultiTower) {
+  RunAndCompareWithThunks(kMultiTower);
+}
+
+TEST_F(CpuThunkRuntimeTest, WhileLoop) { RunAndCompareWithThunks(kWhileLoop); }
+
+// Runs the towers with the thunk runtime if the benchmark argument is 1.
+void BM_MultiTower(::testing::benchmark::State& state) {
+  HloRunner runner(PlatformUtil::GetPlatform("cpu").value());
+  HloModuleConfig config;
+  DebugOptions debug_options = GetDebugOptionsFromFlags();
+  debug_options.set_xla_cpu_use_thunk_runtime(state.range(0) == 1);
+  config.set_debug_options(debug_options);
+  std::unique_ptr<HloModule> module =
+      ParseAndReturnUnverifiedModule(kMultiTower, config).value();
+  std::vector<Literal> arguments = MakeFakeArguments(module.get()).value();
+  std::vector<const Literal*> argument_ptrs;
+  for (const Literal& argument : arguments) {
+    argument_ptrs.push_back(&argument);
+  }
+  std::unique_ptr<Executable> executable =
+      runner.CreateExecutable(std::move(module), /*run_hlo_passes=*/true)
+          .value();
+
+  for (auto s : state) {
+    CHECK_OK(
+        runner.ExecuteWithExecutable(executable.get(), argument_ptrs).status());
+  }
+}
+
+BENCHMARK(BM_MultiTower)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,206 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/thunk_executor.h"
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "xla/executable_run_options.h"
+#include "xla/service/custom_call_status_internal.h"
+#include "xla/status.h"
+#include "xla/util.h"
+#include "tsl/concurrency/async_value.h"
+#include "tsl/concurrency/async_value_ref.h"
+#include "tsl/concurrency/chain.h"
+#include "tsl/platform/cpu_info.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/logging.h"
+#include "tsl/platform/threadpool.h"
+
+namespace xla {
+namespace cpu {
+
+namespace {
+
+// The process-wide thread pool of the helpers running ready thunks.
+tsl::thread::ThreadPool* GetHelperThreadPool() {
+  static tsl::thread::ThreadPool* pool = new tsl::thread::ThreadPool(
+      tsl::Env::Default(), "xla_cpu_thunk_executor",
+      tsl::port::MaxParallelism());
+  return pool;
+}
+
+// The state of an execution of the thunks. It is shared with the helpers and
+// the callbacks of the done events, which may outlive the execution.
+class Execution : public std::enable_shared_from_this<Execution> {
+ public:
+  Execution(absl::Span<const ThunkExecutor::Thunk> thunks,
+            const ExecutableRunOptions* run_options, void** buffer_table,
+            int64_t* profile_counters)
+      : thunks_(thunks),
+        run_options_(run_options),
+        buffer_table_(buffer_table),
+        profile_counters_(profile_counters) {
+    done_.reserve(thunks_.size());
+    for (int64_t i = 0; i < thunks_.size(); ++i) {
+      done_.push_back(tsl::MakeConstructedAsyncValueRef<tsl::Chain>());
+    }
+  }
+
+  // Runs the thunks on the calling thread, and on helpers while more than one
+  // thunk is ready, until all thunks are done.
+  void Run() {
+    for (int64_t i = 0; i < thunks_.size(); ++i) {
+      std::vector<tsl::AsyncValue*> dependencies;
+      for (int64_t dependency : thunks_[i].dependencies) {
+        CHECK_LT(dependency, i);
+        dependencies.push_back(done_[dependency].GetAsyncValue());
+      }
+      tsl::RunWhenReady(dependencies,
+                        [execution = shared_from_this(), i] {
+                          execution->Push(i);
+                        });
+    }
+    // The calling thread always makes progress, even when the helper thread
+    // pool is busy, so that replicas running collectives don't deadlock.
+    while (std::optional<int64_t> index = Pop(/*wait=*/true)) {
+      RunThunk(*index);
+    }
+  }
+
+  // The events of the thunks, which are errors for the failed thunks.
+  absl::Span<const tsl::AsyncValueRef<tsl::Chain>> done() const {
+    return done_;
+  }
+
+ private:
+  // Queues the thunk 'index', whose dependencies are done, and schedules a
+  // helper if the threads running thunks already have work.
+  void Push(int64_t index) {
+    tsl::thread::ThreadPool* pool = GetHelperThreadPool();
+    bool schedule_helper;
+    {
+      absl::MutexLock lock(&mu_);
+      ready_.push_back(index);
+      schedule_helper =
+          ready_.size() > 1 && num_helpers_ < pool->NumThreads();
+      if (schedule_helper) ++num_helpers_;
+    }
+    if (schedule_helper) {
+      pool->Schedule([execution = shared_from_this()] {
+        execution->RunHelper();
+      });
+    }
+  }
+
+  // Returns the next ready thunk. If 'wait', waits for a thunk to be ready,
+  // and returns nullopt once all thunks are done. Otherwise, returns nullopt
+  // if no thunk is ready.
+  std::optional<int64_t> Pop(bool wait) {
+    absl::MutexLock lock(&mu_);
+    if (wait) mu_.Await(absl::Condition(this, &Execution::HasReadyOrDone));
+    if (ready_.empty()) return std::nullopt;
+    int64_t index = ready_.front();
+    ready_.pop_front();
+    return index;
+  }
+
+  bool HasReadyOrDone() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return !ready_.empty() || num_done_ == thunks_.size();
+  }
+
+  void RunHelper() {
+    while (std::optional<int64_t> index = Pop(/*wait=*/false)) {
+      RunThunk(*index);
+    }
+    absl::MutexLock lock(&mu_);
+    --num_helpers_;
+  }
+
+  // Runs the thunk 'index', or fails it with the error of a failed
+  // dependency.
+  void RunThunk(int64_t index) {
+    const ThunkExecutor::Thunk& thunk = thunks_[index];
+    const tsl::AsyncValueRef<tsl::Chain>& done = done_[index];
+    const Status* dependency_error = nullptr;
+    for (int64_t dependency : thunk.dependencies) {
+      if (done_[dependency].IsError()) {
+        dependency_error = &done_[dependency].GetError();
+        break;
+      }
+    }
+
+    if (dependency_error != nullptr) {
+      done.SetError(*dependency_error);
+    } else {
+      VLOG(3) << "Running thunk " << index << ": " << thunk.name;
+      XlaCustomCallStatus status;
+      thunk.function(nullptr, run_options_, nullptr, buffer_table_, &status,
+                     profile_counters_);
+      std::optional<absl::string_view> error_message =
+          CustomCallStatusGetMessage(&status);
+      if (error_message) {
+        done.SetError(Internal("CustomCall failed: %s", *error_message));
+      } else {
+        done.SetStateConcrete();
+      }
+    }
+
+    absl::MutexLock lock(&mu_);
+    ++num_done_;
+  }
+
+  const absl::Span<const ThunkExecutor::Thunk> thunks_;
+  const ExecutableRunOptions* const run_options_;
+  void** const buffer_table_;
+  int64_t* const profile_counters_;
+  std::vector<tsl::AsyncValueRef<tsl::Chain>> done_;
+
+  absl::Mutex mu_;
+  std::deque<int64_t> ready_ ABSL_GUARDED_BY(mu_);
+  int64_t num_done_ ABSL_GUARDED_BY(mu_) = 0;
+  int num_helpers_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace
+
+ThunkExecutor::ThunkExecutor(std::vector<Thunk> thunks)
+    : thunks_(std::move(thunks)) {}
+
+Status ThunkExecutor::Execute(const ExecutableRunOptions* run_options,
+                              void** buffer_table,
+                              int64_t* profile_counters) const {
+  auto execution = std::make_shared<Execution>(thunks_, run_options,
+                                               buffer_table, profile_counters);
+  execution->Run();
+  // The dependencies of a thunk come before it, so the first error is the
+  // error of a thunk which failed on its own.
+  for (const tsl::AsyncValueRef<tsl::Chain>& done : execution->done()) {
+    if (done.IsError()) return done.GetError();
+  }
+  return OkStatus();
+}
+
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,73 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_SERVICE_CPU_THUNK_EXECUTOR_H_
+#define XLA_SERVICE_CPU_THUNK_EXECUTOR_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "xla/executable_run_options.h"
+#include "xla/service/custom_call_status_internal.h"
+#include "xla/status.h"
+
+namespace xla {
+namespace cpu {
+
+// Runs the thunks of an executable compiled with the thunk runtime, each as
+// soon as the thunks it depends on are done. Independent thunks run
+// concurrently: the calling thread runs the thunks which are ready, and
+// helper threads of a process-wide thread pool join it while more than one
+// thunk is ready.
+//
+// The thunks run on their own thread pool rather than on the intra-op thread
+// pool, as they block on the intra-op thread pool themselves when they run
+// Eigen operations or parallel loops.
+class ThunkExecutor {
+ public:
+  // The type of a thunk, which follows the calling convention of the global
+  // computations: all inputs and outputs are in the buffer table.
+  using ComputeFunctionType =
+      void (*)(void* /*result*/, const ExecutableRunOptions* /*run_options*/,
+               const void** /*args*/, void** /*buffer_table*/,
+               XlaCustomCallStatus* /*status*/, int64_t* /*profile_counters*/);
+
+  struct Thunk {
+    std::string name;
+    ComputeFunctionType function;
+    // Indices of the thunks which must be done before this one starts. They
+    // must be smaller than the index of this thunk.
+    std::vector<int64_t> dependencies;
+  };
+
+  explicit ThunkExecutor(std::vector<Thunk> thunks);
+
+  // Runs all thunks, and returns the error of the first failed thunk if any.
+  // The thunks depending on a failed thunk don't run.
+  Status Execute(const ExecutableRunOptions* run_options, void** buffer_table,
+                 int64_t* profile_counters) const;
+
+  absl::Span<const Thunk> thunks() const { return thunks_; }
+
+ private:
+  std::vector<Thunk> thunks_;
+};
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // XLA_SERVICE_CPU_THUNK_EXECUTOR_H_
@@ -0,0 +1,137 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/thunk_executor.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+#include "xla/executable_run_options.h"
+#include "xla/service/custom_call_status.h"
+#include "xla/service/custom_call_status_internal.h"
+#include "tsl/lib/core/status_test_util.h"
+#include "tsl/platform/test.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+using ::testing::IsEmpty;
+using ::testing::UnorderedElementsAre;
+
+// The state of a test execution, passed to the thunks in the buffer table.
+struct State {
+  absl::Mutex mu;
+  std::vector<std::string> runs ABSL_GUARDED_BY(mu);
+  absl::Notification started[2];
+  bool overlapped[2] = {false, false};
+};
+
+State* GetState(void** buffer_table) {
+  return static_cast<State*>(buffer_table[0]);
+}
+
+void Record(void** buffer_table, const std::string& name) {
+  State* state = GetState(buffer_table);
+  absl::MutexLock lock(&state->mu);
+  state->runs.push_back(name);
+}
+
+template <int kIndex>
+void Wait(void* /*result*/, const ExecutableRunOptions* /*run_options*/,
+          const void** /*args*/, void** buffer_table,
+          XlaCustomCallStatus* /*status*/, int64_t* /*profile_counters*/) {
+  State* state = GetState(buffer_table);
+  state->started[kIndex].Notify();
+  // Only returns quickly if the other thunk runs at the same time.
+  state->overlapped[kIndex] =
+      state->started[1 - kIndex].WaitForNotificationWithTimeout(
+          absl::Seconds(10));
+}
+
+template <char kName>
+void Run(void* /*result*/, const ExecutableRunOptions* /*run_options*/,
+         const void** /*args*/, void** buffer_table,
+         XlaCustomCallStatus* /*status*/, int64_t* /*profile_counters*/) {
+  Record(buffer_table, std::string(1, kName));
+}
+
+void Fail(void* /*result*/, const ExecutableRunOptions* /*run_options*/,
+          const void** /*args*/, void** buffer_table,
+          XlaCustomCallStatus* status, int64_t* /*profile_counters*/) {
+  Record(buffer_table, "fail");
+  XlaCustomCallStatusSetFailure(status, "failed", 6);
+}
+
+Status Execute(const ThunkExecutor& executor, State& state) {
+  void* buffer_table[] = {&state};
+  ExecutableRunOptions run_options;
+  return executor.Execute(&run_options, buffer_table,
+                          /*profile_counters=*/nullptr);
+}
+
+TEST(ThunkExecutorTest, RunsIndependentThunksConcurrently) {
+  ThunkExecutor executor({{"wait0", &Wait<0>, {}}, {"wait1", &Wait<1>, {}}});
+  State state;
+  TF_ASSERT_OK(Execute(executor, state));
+  EXPECT_TRUE(state.overlapped[0]);
+  EXPECT_TRUE(state.overlapped[1]);
+}
+
+TEST(ThunkExecutorTest, RunsThunksAfterTheirDependencies) {
+  ThunkExecutor executor({{"a", &Run<'a'>, {}},
+                          {"b", &Run<'b'>, {0}},
+                          {"c", &Run<'c'>, {0}},
+                          {"d", &Run<'d'>, {1, 2}}});
+  for (int i = 0; i < 100; ++i) {
+    State state;
+    TF_ASSERT_OK(Execute(executor, state));
+    absl::MutexLock lock(&state.mu);
+    ASSERT_EQ(state.runs.size(), 4);
+    EXPECT_EQ(state.runs.front(), "a");
+    EXPECT_EQ(state.runs.back(), "d");
+  }
+}
+
+TEST(ThunkExecutorTest, SkipsThunksDependingOnFailedThunks) {
+  ThunkExecutor executor({{"fail", &Fail, {}},
+                          {"a", &Run<'a'>, {0}},
+                          {"b", &Run<'b'>, {1}},
+                          {"c", &Run<'c'>, {}}});
+  State state;
+  Status status = Execute(executor, state);
+  EXPECT_EQ(status.message(), "CustomCall failed: failed");
+  absl::MutexLock lock(&state.mu);
+  EXPECT_THAT(state.runs, UnorderedElementsAre("fail", "c"));
+}
+
+TEST(ThunkExecutorTest, RunsNoThunks) {
+  ThunkExecutor executor(std::vector<ThunkExecutor::Thunk>{});
+  State state;
+  TF_EXPECT_OK(Execute(executor, state));
+  absl::MutexLock lock(&state.mu);
+  EXPECT_THAT(state.runs, IsEmpty());
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,153 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/thunk_outliner.h"
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/container/btree_set.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "xla/hlo/ir/hlo_computation.h"
+#include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/hlo/ir/hlo_opcode.h"
+#include "xla/hlo/utils/hlo_query.h"
+#include "xla/map_util.h"
+#include "xla/statusor.h"
+#include "tsl/platform/errors.h"
+#include "tsl/platform/logging.h"
+
+namespace xla {
+namespace cpu {
+
+namespace {
+
+// Returns true if 'instruction' doesn't emit code in the entry computation.
+bool EmitsNoCode(const HloInstruction& instruction) {
+  switch (instruction.opcode()) {
+    case HloOpcode::kAddDependency:
+    case HloOpcode::kAfterAll:
+    case HloOpcode::kBitcast:
+    case HloOpcode::kConstant:
+    case HloOpcode::kGetTupleElement:
+    case HloOpcode::kParameter:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns true if 'call', or a computation it transitively calls, has side
+// effects or communicates with other devices.
+bool HasOrderedEffects(const HloInstruction& call) {
+  std::vector<HloComputation*> computations =
+      call.to_apply()->MakeEmbeddedComputationsList();
+  computations.push_back(call.to_apply());
+  for (const HloComputation* computation : computations) {
+    for (const HloInstruction* instruction : computation->instructions()) {
+      if (instruction->HasSideEffectNoRecurse() ||
+          hlo_query::IsCollectiveCommunicationOp(instruction->opcode())) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+StatusOr<bool> ThunkOutliner::Run(
+    HloModule* module,
+    const absl::flat_hash_set<absl::string_view>& execution_threads) {
+  HloComputation* entry_computation = module->entry_computation();
+  bool changed = false;
+  for (HloInstruction* instruction :
+       entry_computation->MakeInstructionPostOrder()) {
+    if (EmitsNoCode(*instruction)) continue;
+
+    // The control dependencies of the outlined instruction move to its call.
+    std::vector<HloInstruction*> predecessors =
+        instruction->control_predecessors();
+    std::vector<HloInstruction*> successors = instruction->control_successors();
+    TF_RETURN_IF_ERROR(instruction->DropAllControlDeps());
+
+    HloInstruction* call = module->OutlineExpressionFromComputation(
+        {instruction}, absl::StrCat("thunk_", instruction->name()),
+        entry_computation);
+    for (HloInstruction* predecessor : predecessors) {
+      TF_RETURN_IF_ERROR(predecessor->AddControlDependencyTo(call));
+    }
+    for (HloInstruction* successor : successors) {
+      TF_RETURN_IF_ERROR(call->AddControlDependencyTo(successor));
+    }
+    changed = true;
+  }
+  return changed;
+}
+
+std::vector<ThunkInstruction> GetThunkInstructions(
+    absl::Span<HloInstruction* const> sequence) {
+  std::vector<ThunkInstruction> thunks;
+  // The thunks which must be done before each instruction can be used. For
+  // thunks, only the thunk itself.
+  absl::flat_hash_map<const HloInstruction*, absl::btree_set<int64_t>>
+      thunks_before;
+  std::optional<int64_t> last_ordered_thunk;
+  for (const HloInstruction* instruction : sequence) {
+    absl::btree_set<int64_t> dependencies;
+    auto add_dependencies = [&](const HloInstruction* producer) {
+      const absl::btree_set<int64_t>& producer_thunks =
+          FindOrDie(thunks_before, producer);
+      dependencies.insert(producer_thunks.begin(), producer_thunks.end());
+    };
+    for (const HloInstruction* operand : instruction->operands()) {
+      add_dependencies(operand);
+    }
+    for (const HloInstruction* predecessor :
+         instruction->control_predecessors()) {
+      add_dependencies(predecessor);
+    }
+
+    if (instruction->opcode() != HloOpcode::kCall) {
+      thunks_before[instruction] = std::move(dependencies);
+      continue;
+    }
+
+    const int64_t thunk = thunks.size();
+    if (HasOrderedEffects(*instruction)) {
+      if (last_ordered_thunk.has_value()) {
+        dependencies.insert(*last_ordered_thunk);
+      }
+      last_ordered_thunk = thunk;
+    }
+    thunks_before[instruction] = {thunk};
+    thunks.push_back(ThunkInstruction{
+        instruction, std::vector<int64_t>(dependencies.begin(),
+                                          dependencies.end())});
+    VLOG(2) << "Thunk " << thunk << ": " << instruction->name() << " after "
+            << thunks.back().dependencies.size() << " thunks";
+  }
+  return thunks;
+}
+
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,69 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_SERVICE_CPU_THUNK_OUTLINER_H_
+#define XLA_SERVICE_CPU_THUNK_OUTLINER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/service/hlo_pass_interface.h"
+#include "xla/statusor.h"
+
+namespace xla {
+namespace cpu {
+
+// Outlines each operation of the entry computation which emits code into a
+// computation of its own, called by a kCall. Each of these calls is compiled
+// to a separate function, a thunk, which the thunk runtime runs once the
+// thunks it depends on are done.
+//
+// Parameters, constants, get-tuple-elements, bitcasts, after-alls and
+// add-dependencies don't emit code, and stay in the entry computation.
+class ThunkOutliner : public HloModulePass {
+ public:
+  absl::string_view name() const override { return "cpu-thunk-outliner"; }
+
+  using HloPassInterface::Run;
+  StatusOr<bool> Run(
+      HloModule* module,
+      const absl::flat_hash_set<absl::string_view>& execution_threads) override;
+};
+
+// A thunk of the entry computation, and the thunks it depends on.
+struct ThunkInstruction {
+  const HloInstruction* call;
+  // Indices of the thunks which must be done before this one starts.
+  std::vector<int64_t> dependencies;
+};
+
+// Returns the thunks in 'sequence', a schedule of an entry computation
+// outlined by the ThunkOutliner, in the same order. A thunk depends on:
+// *) the thunks producing its operands, through the operations which aren't
+//    thunks, and the thunks of its control predecessors;
+// *) if it has side effects or communicates with other devices, the previous
+//    thunk which does, so that they run in the order of the schedule.
+std::vector<ThunkInstruction> GetThunkInstructions(
+    absl::Span<HloInstruction* const> sequence);
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // XLA_SERVICE_CPU_THUNK_OUTLINER_H_
@@ -0,0 +1,181 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/thunk_outliner.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "xla/hlo/ir/hlo_computation.h"
+#include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/hlo/ir/hlo_opcode.h"
+#include "xla/hlo/utils/hlo_matchers.h"
+#include "xla/tests/hlo_test_base.h"
+#include "tsl/platform/statusor.h"
+#include "tsl/platform/test.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+namespace op = xla::testing::opcode_matchers;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+class ThunkOutlinerTest : public HloTestBase {
+ protected:
+  // Returns the dependencies of the thunks of 'module', keyed and named by
+  // the custom call targets or the opcodes of the outlined instructions.
+  std::map<std::string, std::vector<std::string>> GetDependencies(
+      HloModule* module) {
+    std::vector<ThunkInstruction> thunks = GetThunkInstructions(
+        module->entry_computation()->MakeInstructionPostOrder());
+    auto name = [&](int64_t thunk) -> std::string {
+      const HloInstruction* outlined =
+          thunks[thunk].call->to_apply()->root_instruction();
+      if (outlined->opcode() == HloOpcode::kCustomCall) {
+        return outlined->custom_call_target();
+      }
+      return std::string(HloOpcodeString(outlined->opcode()));
+    };
+    std::map<std::string, std::vector<std::string>> dependencies;
+    for (int64_t i = 0; i < thunks.size(); ++i) {
+      std::vector<std::string>& thunk_dependencies = dependencies[name(i)];
+      for (int64_t dependency : thunks[i].dependencies) {
+        EXPECT_LT(dependency, i);
+        thunk_dependencies.push_back(name(dependency));
+      }
+    }
+    return dependencies;
+  }
+};
+
+TEST_F(ThunkOutlinerTest, OutlinesOperationsEmittingCode) {
+  constexpr char kHlo[] = R"(
+    HloModule m
+    ENTRY e {
+      p0 = (f32[4], f32[4]) parameter(0)
+      gte0 = f32[4] get-tuple-element(p0), index=0
+      gte1 = f32[4] get-tuple-element(p0), index=1
+      exp = f32[4] exponential(gte0)
+      c = f32[4] constant({1, 2, 3, 4})
+      add = f32[4] add(exp, c)
+      ROOT bitcast = f32[2,2] bitcast(add)
+    }
+  )";
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHlo));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, ThunkOutliner().Run(module.get()));
+  EXPECT_TRUE(changed);
+
+  const HloInstruction* root = module->entry_computation()->root_instruction();
+  EXPECT_THAT(root, op::Bitcast(op::Call(op::Call(op::GetTupleElement()),
+                                         op::Constant())));
+  EXPECT_THAT(root->operand(0)->to_apply()->root_instruction(),
+              op::Add(op::Parameter(0), op::Parameter(1)));
+  EXPECT_THAT(root->operand(0)->operand(0)->to_apply()->root_instruction(),
+              op::Exp(op::Parameter(0)));
+}
+
+TEST_F(ThunkOutlinerTest, IndependentBranchesDontDependOnEachOther) {
+  constexpr char kHlo[] = R"(
+    HloModule m
+    ENTRY e {
+      p0 = f32[4] parameter(0)
+      p1 = f32[4] parameter(1)
+      exp = f32[4] exponential(p0)
+      log = f32[4] log(p1)
+      add = f32[4] add(exp, log)
+      ROOT tuple = (f32[4], f32[4]) tuple(add, exp)
+    }
+  )";
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHlo));
+  TF_ASSERT_OK(ThunkOutliner().Run(module.get()).status());
+
+  auto dependencies = GetDependencies(module.get());
+  EXPECT_THAT(dependencies["exponential"], IsEmpty());
+  EXPECT_THAT(dependencies["log"], IsEmpty());
+  EXPECT_THAT(dependencies["add"], ElementsAre("exponential", "log"));
+  EXPECT_THAT(dependencies["tuple"], ElementsAre("exponential", "add"));
+}
+
+TEST_F(ThunkOutlinerTest, DependenciesGoThroughOperationsEmittingNoCode) {
+  constexpr char kHlo[] = R"(
+    HloModule m
+    ENTRY e {
+      p0 = f32[4] parameter(0)
+      exp = f32[4] exponential(p0)
+      bitcast = f32[2,2] bitcast(exp)
+      ROOT negate = f32[2,2] negate(bitcast)
+    }
+  )";
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHlo));
+  TF_ASSERT_OK(ThunkOutliner().Run(module.get()).status());
+
+  auto dependencies = GetDependencies(module.get());
+  EXPECT_THAT(dependencies["negate"], ElementsAre("exponential"));
+}
+
+TEST_F(ThunkOutlinerTest, KeepsControlDependencies) {
+  constexpr char kHlo[] = R"(
+    HloModule m
+    ENTRY e {
+      p0 = f32[4] parameter(0)
+      exp = f32[4] exponential(p0)
+      log = f32[4] log(p0), control-predecessors={exp}
+      ROOT tuple = (f32[4], f32[4]) tuple(exp, log)
+    }
+  )";
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHlo));
+  TF_ASSERT_OK(ThunkOutliner().Run(module.get()).status());
+
+  auto dependencies = GetDependencies(module.get());
+  EXPECT_THAT(dependencies["log"], ElementsAre("exponential"));
+}
+
+TEST_F(ThunkOutlinerTest, OrdersOperationsWithSideEffects) {
+  constexpr char kHlo[] = R"(
+    HloModule m
+    ENTRY e {
+      p0 = f32[4] parameter(0)
+      p1 = f32[4] parameter(1)
+      first = f32[4] custom-call(p0), custom_call_target="first",
+        custom_call_has_side_effect=true
+      pure = f32[4] custom-call(p1), custom_call_target="pure"
+      second = f32[4] custom-call(p1), custom_call_target="second",
+        custom_call_has_side_effect=true
+      ROOT tuple = (f32[4], f32[4], f32[4]) tuple(first, pure, second)
+    }
+  )";
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHlo));
+  TF_ASSERT_OK(ThunkOutliner().Run(module.get()).status());
+
+  auto dependencies = GetDependencies(module.get());
+  EXPECT_THAT(dependencies["pure"], IsEmpty());
+  // The side effects run in the order of the post order.
+  if (dependencies["first"].empty()) {
+    EXPECT_THAT(dependencies["second"], ElementsAre("first"));
+  } else {
+    EXPECT_THAT(dependencies["first"], ElementsAre("second"));
+    EXPECT_THAT(dependencies["second"], IsEmpty());
+  }
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
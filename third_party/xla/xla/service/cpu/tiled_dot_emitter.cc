@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "xla/service/cpu/tiled_dot_emitter.h"
 
+#include "absl/functional/function_ref.h"
+#include "absl/strings/string_view.h"
 #include "xla/hlo/ir/hlo_module.h"
 #include "xla/service/cpu/vector_support_library.h"
 #include "xla/service/llvm_ir/kernel_support_library.h"
@@ -607,13 +609,14 @@ void RowMajorMatrixVectorProductEmitter::EmitInnerLoopEpilogue(
   }
 }
 
-// This class implements a tiled matrix multiplication algorithm, intended for
-// multiplying small matrices that don't need cache tiling.
+// This class implements a tiled matrix multiplication algorithm.  By default
+// it is intended for multiplying small matrices that don't need cache tiling.
 //
-// In the future this can be used as the innermost GEBP loop in a GEMM kernel as
-// described in "Goto, Kazushige, and Robert A. Geijn. "Anatomy of
-// high-performance matrix multiplication." ACM Transactions on Mathematical
-// Software (TOMS) 34.3 (2008): 12.".
+// With `block_size_k` and `block_size_n` smaller than the matrix dimensions it
+// also tiles for the caches, and the tiled GEMM kernel becomes the innermost
+// GEBP loop of a GEMM kernel as described in "Goto, Kazushige, and Robert A.
+// Geijn. "Anatomy of high-performance matrix multiplication." ACM Transactions
+// on Mathematical Software (TOMS) 34.3 (2008): 12.".
 //
 // This only supports canonical dot operations (i.e. where the lhs contraction
 // dimension is 1 and the rhs contraction dimension is 0) over row major
@@ -660,25 +663,35 @@ class TiledSmallGemmEmitter {
   // The innermost reduction loop executes the matrix multiply in tiles of size
   // [`tile_size_m`, `tile_size_k`] from the LHS and [`tile_size_k`,
   // <vectorization width>] in the RHS.
+  //
+  // The outermost loops step through the RHS in blocks of size
+  // [`block_size_k`, `block_size_n`], which are multiplied with the
+  // corresponding [m, `block_size_k`] panel of the LHS.  Each RHS block is
+  // reused across all of the tiles in M, so it should fit in the L2 cache.
   class Config {
    public:
     explicit Config(PrimitiveType scalar_type, Dimensions dims,
                     int64_t max_vectorization_width, int64_t max_vector_count,
                     int64_t min_vectorization_width, int64_t tile_size_m,
-                    int64_t tile_size_k)
+                    int64_t tile_size_k, int64_t block_size_k,
+                    int64_t block_size_n)
         : scalar_type_(scalar_type),
           dims_(dims),
           max_vectorization_width_(max_vectorization_width),
           max_vector_count_(max_vector_count),
           min_vectorization_width_(min_vectorization_width),
           tile_size_m_(tile_size_m),
-          tile_size_k_(tile_size_k) {}
+          tile_size_k_(tile_size_k),
+          block_size_k_(block_size_k),
+          block_size_n_(block_size_n) {}
 
     std::string GetCacheKey() const {
       return absl::StrCat("gemm_", PrimitiveType_Name(scalar_type()), "_",
                           dims().ToString(), "_", max_vectorization_width(),
-                          "_", min_vectorization_width(), "_", tile_size_m(),
-                          "_", tile_size_k());
+                          "_", max_vector_count(), "_",
+                          min_vectorization_width(), "_", tile_size_m(), "_",
+                          tile_size_k(), "_", block_size_k(), "_",
+                          block_size_n());
     }
 
     PrimitiveType scalar_type() const { return scalar_type_; }
@@ -689,6 +702,8 @@ class TiledSmallGemmEmitter {
 
     int64_t tile_size_m() const { return tile_size_m_; }
     int64_t tile_size_k() const { return tile_size_k_; }
+    int64_t block_size_k() const { return block_size_k_; }
+    int64_t block_size_n() const { return block_size_n_; }
 
    private:
     PrimitiveType scalar_type_;
@@ -698,6 +713,8 @@ class TiledSmallGemmEmitter {
     int64_t min_vectorization_width_;
     int64_t tile_size_m_;
     int64_t tile_size_k_;
+    int64_t block_size_k_;
+    int64_t block_size_n_;
   };
 
   // Creates an instance of TiledSmallGemmEmitter that matrix-multiplies
@@ -720,6 +737,8 @@ class TiledSmallGemmEmitter {
         absl::has_single_bit(static_cast<uint64_t>(min_vectorization_width())));
     CHECK_GE(max_vectorization_width(), min_vectorization_width());
     CHECK_GT(tile_size_k(), 0);
+    CHECK_GT(block_size_k(), 0);
+    CHECK_GT(block_size_n(), 0);
   }
 
   void Emit();
@@ -728,10 +747,13 @@ class TiledSmallGemmEmitter {
   // The HandleResiduesOnX helpers split the iteration space for dimension X
   // into a multiple of the tile size on dimension X and an epilogue.  These
   // helpers ultimately call into `EmitTiledGemm` for emitting the
-  // tiled GEMM kernel.
+  // tiled GEMM kernel.  They work on the cache block of the RHS starting at
+  // [`k_offset`, `n_offset`] and of size [`k_extent`, `n_extent`].
 
-  void HandleResiduesOnN();
-  void HandleResiduesOnK(VectorSupportLibrary* vsl, llvm::Value* n_start,
+  void HandleResiduesOnN(llvm::Value* k_offset, int64_t k_extent,
+                         llvm::Value* n_offset, int64_t n_extent);
+  void HandleResiduesOnK(VectorSupportLibrary* vsl, llvm::Value* k_offset,
+                         int64_t k_extent, llvm::Value* n_start,
                          llvm::Value* n_end);
   void HandleResiduesOnM(VectorSupportLibrary* vsl, int64_t tile_size_k,
                          llvm::Value* k_start, llvm::Value* k_end,
@@ -745,6 +767,11 @@ class TiledSmallGemmEmitter {
                      int64_t tile_size_m, llvm::Value* m_start,
                      llvm::Value* m_end);
 
+  // Calls `emit_block` with the offset and the extent of each block of size
+  // `block_size` in [0, `size`), and then with the remainder, if any.
+  void EmitBlocks(absl::string_view name, int64_t size, int64_t block_size,
+                  absl::FunctionRef<void(llvm::Value*, int64_t)> emit_block);
+
   llvm::Value* GetInt64(int64_t value) { return b_->getInt64(value); }
 
   Config config() const { return config_; }
@@ -759,6 +786,8 @@ class TiledSmallGemmEmitter {
   }
   int64_t tile_size_m() const { return config().tile_size_m(); }
   int64_t tile_size_k() const { return config().tile_size_k(); }
+  int64_t block_size_k() const { return config().block_size_k(); }
+  int64_t block_size_n() const { return config().block_size_n(); }
   PrimitiveType scalar_type() const { return config().scalar_type(); }
 
   llvm::Value* lhs_;
@@ -770,9 +799,39 @@ class TiledSmallGemmEmitter {
   KernelSupportLibrary ksl_;
 };
 
-void TiledSmallGemmEmitter::Emit() { HandleResiduesOnN(); }
+void TiledSmallGemmEmitter::Emit() {
+  // The K blocks are the inner loop so that the result tiles of an N block
+  // stay in cache while they are accumulated into.
+  EmitBlocks("dot.block.n", dims().n(), block_size_n(),
+             [&](llvm::Value* n_offset, int64_t n_extent) {
+               EmitBlocks("dot.block.k", dims().k(), block_size_k(),
+                          [&](llvm::Value* k_offset, int64_t k_extent) {
+                            HandleResiduesOnN(k_offset, k_extent, n_offset,
+                                              n_extent);
+                          });
+             });
+}
+
+void TiledSmallGemmEmitter::EmitBlocks(
+    absl::string_view name, int64_t size, int64_t block_size,
+    absl::FunctionRef<void(llvm::Value*, int64_t)> emit_block) {
+  int64_t blocked_end = size - size % block_size;
+  if (blocked_end == block_size) {
+    emit_block(GetInt64(0), block_size);
+  } else if (blocked_end != 0) {
+    ksl_.For(name, 0, blocked_end, block_size,
+             [&](llvm::Value* offset) { emit_block(offset, block_size); });
+  }
+
+  if (blocked_end != size) {
+    emit_block(GetInt64(blocked_end), size - blocked_end);
+  }
+}
 
-void TiledSmallGemmEmitter::HandleResiduesOnN() {
+void TiledSmallGemmEmitter::HandleResiduesOnN(llvm::Value* k_offset,
+                                              int64_t k_extent,
+                                              llvm::Value* n_offset,
+                                              int64_t n_extent) {
   // We can only iterate the `n` dimension for an extent that is divisible by
   // the vectorization width.  So we emit an outer loop that first processes the
   // largest extent in `n` that is divisible by max_vectorization_width, then
@@ -783,14 +842,17 @@ void TiledSmallGemmEmitter::HandleResiduesOnN() {
       max_vector_count() * max_vectorization_width();
   int64_t current_vector_count = max_vector_count();
 
+  auto get_n = [&](int64_t n) { return b_->CreateAdd(n_offset, GetInt64(n)); };
+
   int64_t n_start = 0;
-  while (n_start != dims().n() &&
+  while (n_start != n_extent &&
          current_vectorization_width >= min_vectorization_width()) {
-    int64_t n_end = dims().n() - (dims().n() % current_vectorization_width);
+    int64_t n_end = n_extent - (n_extent % current_vectorization_width);
     if (n_start != n_end) {
       VectorSupportLibrary vsl(scalar_type(), current_vectorization_width, b_,
                                "gemm");
-      HandleResiduesOnK(&vsl, GetInt64(n_start), GetInt64(n_end));
+      HandleResiduesOnK(&vsl, k_offset, k_extent, get_n(n_start),
+                        get_n(n_end));
       n_start = n_end;
     }
     if (current_vector_count == 1) {
@@ -802,29 +864,34 @@ void TiledSmallGemmEmitter::HandleResiduesOnN() {
     }
   }
 
-  if (n_start != dims().n()) {
+  if (n_start != n_extent) {
     VectorSupportLibrary vsl(scalar_type(), 1, b_, "gemm");
-    ksl_.For("epi.n", n_start, dims().n(), 1, [&](llvm::Value* n_i) {
-      llvm::Value* n_i_next = b_->CreateAdd(n_i, b_->getInt64(1));
-      HandleResiduesOnK(&vsl, n_i, n_i_next);
-    });
+    ksl_.For("epi.n", get_n(n_start), get_n(n_extent), 1,
+             [&](llvm::Value* n_i) {
+               llvm::Value* n_i_next = b_->CreateAdd(n_i, b_->getInt64(1));
+               HandleResiduesOnK(&vsl, k_offset, k_extent, n_i, n_i_next);
+             });
   }
 }
 
 void TiledSmallGemmEmitter::HandleResiduesOnK(VectorSupportLibrary* vsl,
+                                              llvm::Value* k_offset,
+                                              int64_t k_extent,
                                               llvm::Value* n_start,
                                               llvm::Value* n_end) {
+  auto get_k = [&](int64_t k) { return b_->CreateAdd(k_offset, GetInt64(k)); };
+
   int64_t k_start = 0;
-  int64_t k_end = dims().k() - (dims().k() % tile_size_k());
+  int64_t k_end = k_extent - (k_extent % tile_size_k());
   if (k_end != k_start) {
-    HandleResiduesOnM(vsl, tile_size_k(), GetInt64(k_start), GetInt64(k_end),
+    HandleResiduesOnM(vsl, tile_size_k(), get_k(k_start), get_k(k_end),
                       n_start, n_end);
     k_start = k_end;
   }
 
-  if (k_start != dims().k()) {
-    HandleResiduesOnM(vsl, dims().k() - k_start, GetInt64(k_start),
-                      GetInt64(dims().k()), n_start, n_end);
+  if (k_start != k_extent) {
+    HandleResiduesOnM(vsl, k_extent - k_start, get_k(k_start),
+                      get_k(k_extent), n_start, n_end);
   }
 }
 
@@ -998,13 +1065,28 @@ void EmitSmallGemm(PrimitiveType scalar_type, int64_t m, int64_t k, int64_t n,
                    int64_t tile_size_k, llvm::Value* lhs, llvm::Value* rhs,
                    llvm::Value* result, llvm::IRBuilder<>* b,
                    const HloModuleConfig& module_config) {
+  EmitBlockedGemm(scalar_type, m, k, n, max_vectorization_width,
+                  max_vector_count, min_vectorization_width, tile_size_m,
+                  tile_size_k, /*block_size_k=*/k, /*block_size_n=*/n, lhs, rhs,
+                  result, b, module_config);
+}
+
+void EmitBlockedGemm(PrimitiveType scalar_type, int64_t m, int64_t k,
+                     int64_t n, int64_t max_vectorization_width,
+                     int64_t max_vector_count,
+                     int64_t min_vectorization_width, int64_t tile_size_m,
+                     int64_t tile_size_k, int64_t block_size_k,
+                     int64_t block_size_n, llvm::Value* lhs, llvm::Value* rhs,
+                     llvm::Value* result, llvm::IRBuilder<>* b,
+                     const HloModuleConfig& module_config) {
   TiledSmallGemmEmitter::Config config(
       /*scalar_type=*/scalar_type,
       TiledSmallGemmEmitter::Dimensions{/*m=*/m, /*k=*/k, /*n=*/n},
       /*max_vectorization_width=*/max_vectorization_width,
       /*max_vector_count=*/max_vector_count,
       /*min_vectorization_width=*/min_vectorization_width,
-      /*tile_size_m=*/tile_size_m, /*tile_size_k=*/tile_size_k);
+      /*tile_size_m=*/tile_size_m, /*tile_size_k=*/tile_size_k,
+      /*block_size_k=*/block_size_k, /*block_size_n=*/block_size_n);
 
   KernelSupportLibrary::EmitAndCallOutlinedKernel(
       module_config, b, config.GetCacheKey(), lhs, rhs, result,
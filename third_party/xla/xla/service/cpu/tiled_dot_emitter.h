@@ -45,6 +45,17 @@ void EmitSmallGemm(PrimitiveType scalar_type, int64_t m, int64_t k, int64_t n,
                    llvm::Value* result, llvm::IRBuilder<>* b,
                    const HloModuleConfig& module_config);
 
+// Like EmitSmallGemm, but also tiles the matrix multiplication for the caches
+// by stepping through the RHS in blocks of size [block_size_k, block_size_n].
+void EmitBlockedGemm(PrimitiveType scalar_type, int64_t m, int64_t k,
+                     int64_t n, int64_t max_vectorization_width,
+                     int64_t max_vector_count,
+                     int64_t min_vectorization_width, int64_t tile_size_m,
+                     int64_t tile_size_k, int64_t block_size_k,
+                     int64_t block_size_n, llvm::Value* lhs, llvm::Value* rhs,
+                     llvm::Value* result, llvm::IRBuilder<>* b,
+                     const HloModuleConfig& module_config);
+
 }  // namespace cpu
 }  // namespace xla
 
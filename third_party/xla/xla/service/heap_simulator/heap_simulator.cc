@@ -686,160 +686,142 @@ void GlobalDecreasingSizeBestFitHeap<BufferType>::Free(const BufferType* buffer,
 
 using Chunk = HeapSimulator::Chunk;
 
+namespace {
+
+// Returns the key by which the nodes of a BufferIntervalTree are ordered.
+std::tuple<int64_t, int64_t, int64_t> IntervalTreeKey(
+    int64_t start, int64_t end, const Chunk& chunk) {
+  return std::make_tuple(start, end, chunk.offset);
+}
+
+std::tuple<int64_t, int64_t, int64_t> IntervalTreeKey(
+    const BufferIntervalTreeNode& node) {
+  return IntervalTreeKey(node.start, node.end, node.chunk);
+}
+
+// Returns the priority of the `index`th node added to a BufferIntervalTree.
+// The priorities are pseudo-random but deterministic (SplitMix64), so that the
+// shape of a tree only depends on the intervals added to it.
+uint64_t IntervalTreeNodePriority(uint64_t index) {
+  uint64_t z = index + 0x9e3779b97f4a7c15;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+void UpdateSubtreeEnd(BufferIntervalTreeNode* node) {
+  node->subtree_end = node->end;
+  if (node->left) {
+    node->subtree_end = std::max(node->subtree_end, node->left->subtree_end);
+  }
+  if (node->right) {
+    node->subtree_end = std::max(node->subtree_end, node->right->subtree_end);
+  }
+}
+
+}  // namespace
+
+void BufferIntervalTree::RotateUp(BufferIntervalTreeNode* node) {
+  BufferIntervalTreeNode* parent = node->parent;
+  BufferIntervalTreeNode* grandparent = parent->parent;
+  if (parent->left == node) {
+    parent->left = node->right;
+    if (node->right) {
+      node->right->parent = parent;
+    }
+    node->right = parent;
+  } else {
+    parent->right = node->left;
+    if (node->left) {
+      node->left->parent = parent;
+    }
+    node->left = parent;
+  }
+  parent->parent = node;
+  node->parent = grandparent;
+  if (grandparent == nullptr) {
+    root_ = node;
+  } else if (grandparent->left == parent) {
+    grandparent->left = node;
+  } else {
+    grandparent->right = node;
+  }
+  UpdateSubtreeEnd(parent);
+  UpdateSubtreeEnd(node);
+}
+
 void BufferIntervalTree::Add(int64_t start, int64_t end, const Chunk& chunk) {
   node_storage_.emplace_back(BufferIntervalTreeNode{
       start, end, end, chunk,
-      /*left=*/nullptr, /*right=*/nullptr, /*parent=*/nullptr});
+      /*left=*/nullptr, /*right=*/nullptr, /*parent=*/nullptr,
+      /*priority=*/IntervalTreeNodePriority(node_storage_.size())});
+  BufferIntervalTreeNode* node = &node_storage_.back();
   if (root_ == nullptr) {
-    root_ = &node_storage_.back();
+    root_ = node;
     // This is root.
     return;
   }
 
+  // Insert the node as a leaf, ...
+  const auto key = IntervalTreeKey(*node);
   BufferIntervalTreeNode* parent = root_;
   while (true) {
     parent->subtree_end = std::max(parent->subtree_end, end);
-    if (parent->start > start) {
-      if (parent->left == nullptr) {
-        parent->left = &node_storage_.back();
-        node_storage_.back().parent = parent;
-        return;
-      }
-      parent = parent->left;
-    } else {
-      if (parent->right == nullptr) {
-        parent->right = &node_storage_.back();
-        node_storage_.back().parent = parent;
-        return;
-      }
-      parent = parent->right;
+    BufferIntervalTreeNode*& child =
+        key < IntervalTreeKey(*parent) ? parent->left : parent->right;
+    if (child == nullptr) {
+      child = node;
+      node->parent = parent;
+      break;
     }
+    parent = child;
+  }
+  // ... and move it up until its parent has a higher priority.
+  while (node->parent != nullptr && node->parent->priority < node->priority) {
+    RotateUp(node);
   }
 }
 
 bool BufferIntervalTree::Remove(int64_t start, int64_t end,
                                 const Chunk& chunk) {
+  const auto key = IntervalTreeKey(start, end, chunk);
   BufferIntervalTreeNode* to_delete = root_;
   while (to_delete != nullptr) {
-    if (to_delete->start == start && to_delete->end == end &&
-        to_delete->chunk.offset == chunk.offset) {
+    const auto node_key = IntervalTreeKey(*to_delete);
+    if (key == node_key) {
       break;
     }
-    if (start < to_delete->start) {
-      to_delete = to_delete->left;
-    } else {
-      to_delete = to_delete->right;
-    }
+    to_delete = key < node_key ? to_delete->left : to_delete->right;
   }
   if (to_delete == nullptr) {
     // Nothing to delete.
     return false;
   }
-  // Found the node to be deleted, enter deletion sequence.
 
-  // Recursively traverse the parents of node and fix up the `subtree_end`
-  // invariant of a node. Recursive lambda need an explicit
-  // std::function declaration.
-  std::function<void(BufferIntervalTreeNode*)> fix_up =
-      [&](BufferIntervalTreeNode* node) {
-        if (node == nullptr) {
-          return;
-        }
-        node->subtree_end = node->end;
-        if (node->left) {
-          node->subtree_end =
-              std::max(node->subtree_end, node->left->subtree_end);
-        }
-        if (node->right) {
-          node->subtree_end =
-              std::max(node->subtree_end, node->right->subtree_end);
-        }
-        // Recursively go up.
-        fix_up(node->parent);
-      };
-
-  if (to_delete->right == nullptr) {
-    // to_delete has no right child, simply move up left child of to_delete if
-    // any.
-    //
-    // Turn:
-    //      parent
-    //       /
-    // to_delete
-    //  /      \
-    // left    nullptr
-    //
-    // Into:
-    //      parent
-    //      /
-    //    left
-    if (root_ == to_delete) {
-      // Deleting root is simply resetting root;
-      root_ = to_delete->left;
-      return true;
-    }
-
-    if (to_delete == to_delete->parent->left) {
-      // to_delete is left child of parent.
-      to_delete->parent->left = to_delete->left;
-    }
-    if (to_delete == to_delete->parent->right) {
-      // to_delete is right child of parent.
-      to_delete->parent->right = to_delete->left;
-    }
-    // Rewire parent to the node being moved up.
-    if (to_delete->left) {
-      to_delete->left->parent = to_delete->parent;
-    }
-    // Fix up starting from subroot.
-    fix_up(to_delete);
+  // Move the node down until it has at most one child, by rotating its child
+  // with the higher priority above it, ...
+  while (to_delete->left != nullptr && to_delete->right != nullptr) {
+    RotateUp(to_delete->left->priority > to_delete->right->priority
+                 ? to_delete->left
+                 : to_delete->right);
+  }
+  // ... replace it with that child, ...
+  BufferIntervalTreeNode* child =
+      to_delete->left != nullptr ? to_delete->left : to_delete->right;
+  BufferIntervalTreeNode* parent = to_delete->parent;
+  if (child != nullptr) {
+    child->parent = parent;
+  }
+  if (parent == nullptr) {
+    root_ = child;
+  } else if (parent->left == to_delete) {
+    parent->left = child;
   } else {
-    // 1. Find left-most node of the right subtree, promote it to the position
-    // of to_delete.
-    BufferIntervalTreeNode* to_promote = to_delete->right;
-    while (to_promote->left != nullptr) {
-      // Go to left-most subtree.
-      to_promote = to_promote->left;
-    }
-
-    // 2. Copy the content of `to_promote` to `to_delete`.
-    to_delete->start = to_promote->start;
-    to_delete->end = to_promote->end;
-    // This is incorrect but we will fix this up later in the `fix_up`
-    // procedure.
-    to_delete->subtree_end = to_promote->subtree_end;
-    to_delete->chunk = to_promote->chunk;
-    auto to_promote_parent = to_promote->parent;
-    // 3. Move the right child of `to_promote` up if there is any.
-    //
-    // Turn
-    //
-    // to_delete
-    //         \
-    //        to_promote_parent
-    //         /
-    //    to_promote
-    //          \
-    //          right
-    // into
-    //
-    // to_promote
-    //         \
-    //         to_promote_parent
-    //         /
-    //      right
-    if (to_promote_parent->left == to_promote) {
-      to_promote_parent->left = to_promote->right;
-    } else {
-      to_promote_parent->right = to_promote->right;
-    }
-    if (to_promote->right) {
-      // Set correct parent.
-      to_promote->right->parent = to_promote_parent;
-    }
-    // 4. Recursive fix up the `subtree_end` starting from
-    // `to_promote_parent`.
-    fix_up(to_promote_parent);
+    parent->right = child;
+  }
+  // ... and fix up the `subtree_end` of its ancestors.
+  for (; parent != nullptr; parent = parent->parent) {
+    UpdateSubtreeEnd(parent);
   }
   // Don't free the entry in node_storage_ until we free the entire tree.
   return true;
@@ -2177,8 +2159,14 @@ GlobalDecreasingSizeBestFitHeap<BufferType>::MakeFreeChunks(
   FreeChunks free_chunks{
       {0, INT64_MAX}};  // Initialize with "infinite" free memory.
 
-  // Subtract chunks that are in use from the free chunks.
-  auto subtract_used_chunks = [&](const std::vector<Chunk>& used_chunks) {
+  // Subtract chunks that are in use from the free chunks. They are subtracted
+  // in order of offset, so that the free chunks don't depend on the order in
+  // which the interval tree finds them.
+  auto subtract_used_chunks = [&](std::vector<Chunk> used_chunks) {
+    absl::c_sort(used_chunks, [](const Chunk& a, const Chunk& b) {
+      return std::make_pair(a.offset, a.size) <
+             std::make_pair(b.offset, b.size);
+    });
     for (const Chunk& used_chunk : used_chunks) {
       // Find the free chunks containing the start and end of the used chunk.
       auto it_end = free_chunks.lower_bound(used_chunk.chunk_end());
@@ -364,9 +364,14 @@ struct BufferIntervalTreeNode {
   BufferIntervalTreeNode* right;
   // parent
   BufferIntervalTreeNode* parent;
+  // Priority of the node, which is no smaller than those of its children.
+  uint64_t priority;
 };
 
-// An interval tree that can query buffers overlapping in time.
+// An interval tree that can query buffers overlapping in time. It is a treap
+// ordered by alloc time, free time and offset, whose nodes get pseudo-random
+// priorities, so that its depth is logarithmic in expectation whatever the
+// order in which buffers are added.
 class BufferIntervalTree {
  public:
   using Chunk = HeapSimulator::Chunk;
@@ -384,6 +389,9 @@ class BufferIntervalTree {
   BufferIntervalTreeNode* GetRoot() { return root_; }
 
  private:
+  // Rotates `node` above its parent.
+  void RotateUp(BufferIntervalTreeNode* node);
+
   BufferIntervalTreeNode* root_ = nullptr;
   std::list<BufferIntervalTreeNode> node_storage_;
 };
@@ -20,6 +20,7 @@ limitations under the License.
 #include <limits>
 #include <memory>
 #include <optional>
+#include <random>
 #include <string>
 #include <tuple>
 #include <utility>
@@ -43,6 +44,7 @@ limitations under the License.
 #include "tsl/lib/core/status_test_util.h"
 #include "tsl/platform/logging.h"
 #include "tsl/platform/test.h"
+#include "tsl/platform/test_benchmark.h"
 
 namespace xla {
 namespace {
@@ -2019,6 +2021,52 @@ TEST_F(IntervalTreeTest, ThreeLevelsRightLeftChunkDifferent) {
   ASSERT_EQ(tree.GetRoot(), nullptr);
 }
 
+TEST_F(IntervalTreeTest, RandomAddAndRemoveMatchesBruteForce) {
+  struct Interval {
+    int64_t start;
+    int64_t end;
+    HeapSimulator::Chunk chunk;
+  };
+  std::minstd_rand0 rng(42);
+  std::uniform_int_distribution<int64_t> time_dist(0, 200);
+  std::uniform_int_distribution<int64_t> offset_dist(0, 20);
+  BufferIntervalTree tree;
+  std::vector<Interval> intervals;
+  for (int i = 0; i < 2000; ++i) {
+    if (intervals.empty() || rng() % 3 != 0) {
+      int64_t start = time_dist(rng);
+      int64_t end = start + time_dist(rng) / 4;
+      // Duplicate intervals are allowed in the tree.
+      auto chunk = HeapSimulator::Chunk::FromOffsetSize(offset_dist(rng), 4);
+      tree.Add(start, end, chunk);
+      intervals.push_back({start, end, chunk});
+    } else {
+      int64_t index = rng() % intervals.size();
+      const Interval& interval = intervals[index];
+      ASSERT_TRUE(tree.Remove(interval.start, interval.end, interval.chunk));
+      intervals.erase(intervals.begin() + index);
+    }
+    int64_t start = time_dist(rng);
+    int64_t end = start + time_dist(rng) / 4;
+    std::vector<int64_t> expected;
+    for (const Interval& interval : intervals) {
+      if (interval.start <= end && start <= interval.end) {
+        expected.push_back(interval.chunk.offset);
+      }
+    }
+    std::vector<int64_t> actual;
+    for (const HeapSimulator::Chunk& chunk :
+         tree.ChunksOverlappingInTime(start, end)) {
+      actual.push_back(chunk.offset);
+    }
+    ASSERT_THAT(actual, ::testing::UnorderedElementsAreArray(expected));
+  }
+  for (const Interval& interval : intervals) {
+    ASSERT_TRUE(tree.Remove(interval.start, interval.end, interval.chunk));
+  }
+  EXPECT_EQ(tree.GetRoot(), nullptr);
+}
+
 class SlicedBufferIntervalTest : public ::testing::Test {
  public:
   using HeapTy = GlobalDecreasingSizeBestFitHeap<HloValue>;
@@ -3693,5 +3741,38 @@ TEST_F(SliceTimePermutationIteratorTest, Repacks) {
   }
 }
 
+// Allocates buffers of a few sizes, each live for a few hundred time steps, in
+// a heap with range(0) buffers. This mimics the heap simulations of large
+// modules, where many buffers of the same size are live at overlapping times.
+void BM_GlobalDecreasingSizeBestFitHeap(::testing::benchmark::State& state) {
+  const int64_t num_buffers = state.range(0);
+  constexpr int64_t kLiveTime = 256;
+  HloComputation::Builder builder("BM_GlobalDecreasingSizeBestFitHeap");
+  std::vector<std::unique_ptr<HloValue>> values;
+  values.reserve(num_buffers);
+  for (int64_t i = 0; i < num_buffers; ++i) {
+    HloInstruction* constant = builder.AddInstruction(
+        HloInstruction::CreateConstant(LiteralUtil::CreateR0<float>(1.0)));
+    values.push_back(std::make_unique<HloValue>(i, constant, ShapeIndex{}));
+  }
+  auto size = [](int64_t i) { return 64 << (i % 4); };
+
+  for (auto s : state) {
+    GlobalDecreasingSizeBestFitHeap<HloValue> heap(/*alignment=*/64);
+    for (int64_t i = 0; i < num_buffers + kLiveTime; ++i) {
+      if (i < num_buffers) {
+        heap.Alloc(values[i].get(), size(i));
+      }
+      if (i >= kLiveTime) {
+        heap.Free(values[i - kLiveTime].get(), size(i - kLiveTime));
+      }
+    }
+    CHECK_OK(heap.Finish().status());
+  }
+  state.SetItemsProcessed(state.iterations() * num_buffers);
+}
+
+BENCHMARK(BM_GlobalDecreasingSizeBestFitHeap)->Range(1 << 10, 1 << 16);
+
 }  // namespace
 }  // namespace xla
@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef XLA_SERVICE_HLO_CSE_H_
 #define XLA_SERVICE_HLO_CSE_H_
 
+#include <vector>
+
+#include "xla/hlo/ir/hlo_computation.h"
 #include "xla/hlo/ir/hlo_module.h"
 #include "xla/service/hlo_pass_interface.h"
 
@@ -25,7 +28,7 @@ namespace xla {
 // and identical instructions with the same operands are commoned. The pass
 // iterates over the instructions in topological order which enables the pass to
 // find arbitrarily large common expressions.
-class HloCSE : public HloModulePass {
+class HloCSE : public HloComputationPass {
  public:
   // If is_layout_sensitive is true, then the simplifier preserves layout during
   // transformation. Otherwise, layout is ignored.
@@ -40,10 +43,11 @@ class HloCSE : public HloModulePass {
   ~HloCSE() override = default;
   absl::string_view name() const override { return "cse"; }
 
-  // Run CSE on the given module. Returns whether the module was changed (common
-  // subexpressions were found and eliminated).
-  using HloPassInterface::Run;
-  StatusOr<bool> Run(
+  // Run CSE on the given computation. Returns whether the computation was
+  // changed (common subexpressions were found and eliminated).
+  StatusOr<bool> RunOnComputation(HloComputation* computation) override;
+
+  std::vector<HloComputation*> GetComputations(
       HloModule* module,
       const absl::flat_hash_set<absl::string_view>& execution_threads) override;
 
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "xla/service/hlo_lexer.h"
 
+#include <cstdint>
 #include <cstring>
 #include <limits>
 #include <optional>
@@ -43,6 +44,67 @@ bool IsIdentifierChar(char c) {
          c == '.' || c == '_';
 }
 
+// Returns the length of the decimal or integer at the start of `s`, or 0 if
+// there is none or if it is followed by a character which could make it part
+// of a longer pattern or identifier. Sets `is_decimal` to whether the number
+// has a fraction or an exponent.
+int64_t LengthOfDelimitedNumber(string_view s, bool* is_decimal) {
+  int64_t i = 0;
+  auto consume_digits = [&] {
+    int64_t start = i;
+    while (i < s.size() &&
+           absl::ascii_isdigit(static_cast<unsigned char>(s[i]))) {
+      ++i;
+    }
+    return i > start;
+  };
+  if (i < s.size() && s[i] == '-') {
+    ++i;
+  }
+  const bool has_integer_part = consume_digits();
+  *is_decimal = false;
+  if (i < s.size() && s[i] == '.') {
+    ++i;
+    if (!consume_digits() && !has_integer_part) {
+      return 0;
+    }
+    *is_decimal = true;
+  } else if (!has_integer_part) {
+    return 0;
+  }
+  if (i < s.size() && (s[i] == 'e' || s[i] == 'E')) {
+    int64_t exponent_start = i + 1;
+    if (exponent_start < s.size() &&
+        (s[exponent_start] == '+' || s[exponent_start] == '-')) {
+      ++exponent_start;
+    }
+    if (exponent_start < s.size() &&
+        absl::ascii_isdigit(static_cast<unsigned char>(s[exponent_start]))) {
+      i = exponent_start;
+      consume_digits();
+      *is_decimal = true;
+    }
+  }
+  if (i < s.size() && (IsIdentifierChar(s[i]) || s[i] == '?')) {
+    return 0;
+  }
+  return i;
+}
+
+// Parses an integer token, which may also be an unsigned 64-bit integer too
+// large for an int64_t.
+bool ParseIntToken(string_view s, int64_t* value) {
+  if (absl::SimpleAtoi(s, value)) {
+    return true;
+  }
+  uint64_t uint64_val;
+  if (absl::SimpleAtoi(s, &uint64_val)) {
+    *value = absl::bit_cast<int64_t>(uint64_val);
+    return true;
+  }
+  return false;
+}
+
 }  // namespace
 
 int HloLexer::GetNextChar() {
@@ -383,12 +445,31 @@ TokKind HloLexer::LexPercent() {
 TokKind HloLexer::LexNumberOrPattern() {
   absl::string_view consumable = StringViewFromPointers(
       token_state_.token_start, buf_.data() + buf_.size());
+
+  // Fast path for the plain numbers which make up the elements of large
+  // literals, which avoids matching them against the patterns below.
+  bool is_decimal;
+  if (int64_t length = LengthOfDelimitedNumber(consumable, &is_decimal)) {
+    current_ptr_ = token_state_.token_start + length;
+    auto slice = StringViewFromPointers(token_state_.token_start, current_ptr_);
+    if (is_decimal) {
+      CHECK(absl::SimpleAtod(slice, &token_state_.decimal_val));
+      return TokKind::kDecimal;
+    }
+    if (ParseIntToken(slice, &token_state_.int64_val)) {
+      return TokKind::kInt;
+    }
+    LOG(ERROR) << "Failed to parse int literal: " << slice;
+    return TokKind::kError;
+  }
+
   static LazyRE2 float_pattern = {
       R"([-]?((\d+|\d+[.]\d*|\d*[.]\d+)([eE][+-]?\d+))|[-]?(\d+[.]\d*|\d*[.]\d+))"};
   if (RE2::Consume(&consumable, *float_pattern)) {
     current_ptr_ = consumable.data();
-    CHECK(absl::SimpleAtod(std::string(token_state_.token_start, current_ptr_),
-                           &token_state_.decimal_val));
+    CHECK(absl::SimpleAtod(
+        StringViewFromPointers(token_state_.token_start, current_ptr_),
+        &token_state_.decimal_val));
     return TokKind::kDecimal;
   }
 
@@ -420,12 +501,7 @@ TokKind HloLexer::LexNumberOrPattern() {
   if (RE2::Consume(&consumable, *int_pattern)) {
     current_ptr_ = consumable.data();
     auto slice = StringViewFromPointers(token_state_.token_start, current_ptr_);
-    if (absl::SimpleAtoi(slice, &token_state_.int64_val)) {
-      return TokKind::kInt;
-    }
-    uint64_t uint64_val;
-    if (absl::SimpleAtoi(slice, &uint64_val)) {
-      token_state_.int64_val = absl::bit_cast<int64_t>(uint64_val);
+    if (ParseIntToken(slice, &token_state_.int64_val)) {
       return TokKind::kInt;
     }
     LOG(ERROR) << "Failed to parse int literal: " << slice;
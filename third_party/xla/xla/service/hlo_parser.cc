@@ -4130,9 +4130,10 @@ bool HloParserImpl::ParseDenseLiteral(Literal* literal, const Shape& shape) {
   // implementation-defined behavior.
   const int rank = static_cast<int>(shape.rank());
 
-  // Create a literal with the given shape in default layout.
-  *literal = LiteralUtil::CreateFromDimensions(shape.element_type(),
-                                               shape.dimensions());
+  // Create a literal with the given shape in default layout. Its elements are
+  // left uninitialized since parsing either sets all of them or fails.
+  *literal =
+      Literal(ShapeUtil::MakeShape(shape.element_type(), shape.dimensions()));
   int64_t nest_level = 0;
   int64_t linear_index = 0;
   // elems_seen_per_dim[i] is how many elements or sub-arrays we have seen for
@@ -4255,8 +4256,9 @@ bool HloParserImpl::ParseDenseLiteral(Literal* literal, const Shape& shape) {
         }
         uint8_t* raw_data_int8 = static_cast<uint8_t*>(literal->untyped_data());
         static uint8_t data_int8 = 0;
+        const int64_t tail_start = literal->size_bytes() / 4 * 4;
         for (int64_t i = 0; i < literal->size_bytes() % 4; ++i) {
-          raw_data_int8[literal->size_bytes() / 4 + i] = data_int8++ & mask;
+          raw_data_int8[tail_start + i] = data_int8++ & mask;
         }
         break;
       }
@@ -4310,7 +4312,10 @@ bool HloParserImpl::ParseDenseLiteral(Literal* literal, const Shape& shape) {
     }  // end of switch
   } while (nest_level > 0);
 
-  *literal = literal->Relayout(shape.layout());
+  // Only copy the literal if it is not in the requested layout already.
+  if (!LayoutUtil::Equal(literal->shape().layout(), shape.layout())) {
+    *literal = literal->Relayout(shape.layout());
+  }
   return true;
 }
 
@@ -15,12 +15,15 @@ limitations under the License.
 
 #include "xla/service/hlo_parser.h"
 
+#include <cstdint>
+#include <limits>
 #include <memory>
 #include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
 
+#include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include "absl/strings/ascii.h"
 #include "absl/strings/match.h"
@@ -2904,6 +2907,39 @@ ENTRY %ConstantWithExp.v4 () -> f32[] {
   // printed as "300".
 }
 
+TEST_F(HloParserTest, ConstantNumberFormats) {
+  const std::string original = R"(HloModule ConstantNumberFormats_module
+
+ENTRY %ConstantNumberFormats () -> (f32[7], u64[3], f32[2,3]{0,1}) {
+  %f32 = f32[7] constant({1, -2.5, 3e2, -4.5E-1, .5, 6., -7e+1})
+  %u64 = u64[3] constant({0, 42, 18446744073709551615})
+  %column_major = f32[2,3]{0,1} constant({{1,2,3},{4,5,6}})
+  ROOT %tuple = (f32[7], u64[3], f32[2,3]{0,1}) tuple(%f32, %u64, %column_major)
+}
+
+)";
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(original));
+  const HloInstruction* root = module->entry_computation()->root_instruction();
+
+  const Literal& f32 = root->operand(0)->literal();
+  const float expected_f32[] = {1, -2.5, 300, -0.45, 0.5, 6, -70};
+  for (int64_t i = 0; i < 7; ++i) {
+    EXPECT_EQ(f32.Get<float>({i}), expected_f32[i]) << i;
+  }
+
+  const Literal& u64 = root->operand(1)->literal();
+  EXPECT_EQ(u64.Get<uint64_t>({0}), 0);
+  EXPECT_EQ(u64.Get<uint64_t>({1}), 42);
+  EXPECT_EQ(u64.Get<uint64_t>({2}), std::numeric_limits<uint64_t>::max());
+
+  const Literal& column_major = root->operand(2)->literal();
+  EXPECT_THAT(column_major.shape().layout().minor_to_major(),
+              ElementsAre(0, 1));
+  EXPECT_EQ(column_major.Get<float>({0, 2}), 3);
+  EXPECT_EQ(column_major.Get<float>({1, 0}), 4);
+  EXPECT_EQ(column_major.data<float>()[1], 4);
+}
+
 TEST_F(HloParserTest, ShortConstant) {
   const std::string original =
       R"(HloModule ShortConstant_module, entry_computation_layout={()->f32[67,89]{1,0}}
@@ -2918,6 +2954,40 @@ ENTRY %ShortConstant.v4 () -> f32[67,89] {
   EXPECT_EQ(result.value()->ToString(HloPrintOptions()), original);
 }
 
+// Checks that the filler of a short constant also sets the bytes after the
+// last whole word, which are consecutive values of its byte counter.
+TEST_F(HloParserTest, ShortConstantWithPartialWord) {
+  const std::string hlo_string = R"(HloModule module
+
+ENTRY %entry () -> (pred[7], s8[5], s8[7]) {
+  %pred = pred[7]{0} constant({...})
+  %s8_5 = s8[5]{0} constant({...})
+  %s8_7 = s8[7]{0} constant({...})
+  ROOT %tuple = (pred[7]{0}, s8[5]{0}, s8[7]{0}) tuple(%pred, %s8_5, %s8_7)
+}
+
+)";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  const HloInstruction* root = module->entry_computation()->root_instruction();
+
+  const Literal& pred = root->operand(0)->literal();
+  const uint8_t* pred_bytes =
+      static_cast<const uint8_t*>(pred.untyped_data());
+  for (int64_t i = 0; i < pred.size_bytes(); ++i) {
+    EXPECT_LE(pred_bytes[i], 1) << "byte " << i;
+  }
+  EXPECT_NE(pred_bytes[5], pred_bytes[4]);
+  EXPECT_EQ(pred_bytes[6], pred_bytes[4]);
+
+  EXPECT_EQ(root->operand(1)->literal().size_bytes(), 5);
+
+  const uint8_t* s8_bytes =
+      static_cast<const uint8_t*>(root->operand(2)->literal().untyped_data());
+  EXPECT_EQ(s8_bytes[5], static_cast<uint8_t>(s8_bytes[4] + 1));
+  EXPECT_EQ(s8_bytes[6], static_cast<uint8_t>(s8_bytes[5] + 1));
+}
+
 TEST_F(HloParserTest, NegativeNan) {
   const std::string original =
       R"(HloModule NegativeNan_module, entry_computation_layout={()->bf16[2]{0}}
@@ -16,8 +16,11 @@ limitations under the License.
 #ifndef XLA_SERVICE_HLO_PASS_INTERFACE_H_
 #define XLA_SERVICE_HLO_PASS_INTERFACE_H_
 
+#include <vector>
+
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/string_view.h"
+#include "xla/hlo/ir/hlo_computation.h"
 #include "xla/hlo/ir/hlo_module.h"
 #include "xla/hlo/ir/hlo_module_group.h"
 #include "xla/status_macros.h"
@@ -167,6 +170,42 @@ class HloModulePass : public HloPassInterface {
   virtual void UpdateLayout(Shape* shape) {}
 };
 
+// Base class for passes which transform each computation of a module
+// independently of the others. HloPassPipeline can run such passes on the
+// computations of a module in parallel, see HloPassPipeline::set_thread_pool.
+class HloComputationPass : public HloModulePass {
+ public:
+  // Runs the pass on `computation` and returns whether it changed it. The pass
+  // may only modify `computation` and its instructions, and must not add or
+  // remove computations. It may read the computations called by
+  // `computation`, which are done before it when running in parallel, but not
+  // the computations calling it.
+  virtual StatusOr<bool> RunOnComputation(HloComputation* computation) = 0;
+
+  // Returns the computations of `module` the pass runs on.
+  virtual std::vector<HloComputation*> GetComputations(
+      HloModule* module,
+      const absl::flat_hash_set<absl::string_view>& execution_threads) {
+    return module->MakeNonfusionComputations(execution_threads);
+  }
+
+  // Runs the pass on the computations of `module` one after the other. This
+  // is final since HloPassPipeline may call RunOnComputation directly instead.
+  using HloPassInterface::Run;
+  StatusOr<bool> Run(HloModule* module,
+                     const absl::flat_hash_set<absl::string_view>&
+                         execution_threads) final {
+    bool changed = false;
+    for (HloComputation* computation :
+         GetComputations(module, execution_threads)) {
+      TF_ASSIGN_OR_RETURN(bool computation_changed,
+                          RunOnComputation(computation));
+      changed |= computation_changed;
+    }
+    return changed;
+  }
+};
+
 // Base class for passes which are module-group scoped. These passes cannot run
 // on an HLO module.
 class HloModuleGroupPass : public HloPassInterface {
@@ -15,13 +15,19 @@ limitations under the License.
 
 #include "xla/service/hlo_pass_pipeline.h"
 
+#include <cstdint>
 #include <functional>
 #include <string>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/mutex.h"
+#include "xla/hlo/ir/hlo_computation.h"
+#include "xla/hlo/ir/hlo_instruction.h"
 #include "xla/service/dump.h"
 #include "xla/service/hlo_graph_dumper.h"
 #include "xla/service/hlo_proto_util.h"
@@ -31,6 +37,7 @@ limitations under the License.
 #include "tsl/platform/errors.h"
 #include "tsl/platform/logging.h"
 #include "tsl/platform/status.h"
+#include "tsl/platform/threadpool.h"
 #include "tsl/profiler/lib/scoped_annotation.h"
 
 namespace xla {
@@ -122,8 +129,138 @@ void SetInstructionMetadata(HloModuleGroup& module_group) {
   }
 }
 
+// Runs `pass` on its computations of `module` in parallel on `thread_pool`. A
+// computation starts once the computations it calls are done, directly or
+// through computations the pass doesn't run on, so that the pass never reads
+// a computation which another thread modifies. The names and ids of the
+// instructions the pass adds are uniquified once all computations are done, in
+// the order of the computations, so that they don't depend on the order the
+// threads ran in.
+StatusOr<bool> RunComputationPassInParallel(
+    HloComputationPass* pass, HloModule* module,
+    const absl::flat_hash_set<absl::string_view>& execution_threads,
+    tsl::thread::ThreadPool* thread_pool) {
+  // Waiting for the pool from one of its own threads could deadlock, and a
+  // schedule refers to instructions by the ids that would be reassigned, so
+  // the pass runs on the calling thread in those cases.
+  if (thread_pool->CurrentThreadId() != -1 || module->has_schedule()) {
+    return pass->Run(module, execution_threads);
+  }
+  std::vector<HloComputation*> computations =
+      pass->GetComputations(module, execution_threads);
+  if (computations.size() <= 1) {
+    return pass->Run(module, execution_threads);
+  }
+
+  absl::flat_hash_map<const HloComputation*, int64_t> indices;
+  for (int64_t i = 0; i < computations.size(); ++i) {
+    indices[computations[i]] = i;
+  }
+
+  // The computations waiting for each computation, and the number of
+  // computations each computation waits for.
+  std::vector<std::vector<int64_t>> callers(computations.size());
+  std::vector<int64_t> num_pending_callees(computations.size(), 0);
+  for (int64_t i = 0; i < computations.size(); ++i) {
+    absl::flat_hash_set<const HloComputation*> visited;
+    std::vector<const HloComputation*> stack = {computations[i]};
+    while (!stack.empty()) {
+      const HloComputation* computation = stack.back();
+      stack.pop_back();
+      for (const HloInstruction* instruction : computation->instructions()) {
+        for (const HloComputation* callee :
+             instruction->called_computations()) {
+          if (!visited.insert(callee).second) {
+            continue;
+          }
+          auto it = indices.find(callee);
+          if (it == indices.end()) {
+            stack.push_back(callee);
+          } else if (it->second != i) {
+            callers[it->second].push_back(i);
+            ++num_pending_callees[i];
+          }
+        }
+      }
+    }
+  }
+
+  std::vector<HloModule::DeferredInstrs> deferred(computations.size());
+  absl::Mutex mu;
+  Status status;
+  bool changed = false;
+  absl::BlockingCounter done(computations.size());
+  std::function<void(int64_t)> run = [&](int64_t index) {
+    bool failed;
+    {
+      absl::MutexLock lock(&mu);
+      failed = !status.ok();
+    }
+    // Once a computation failed, the remaining ones are skipped.
+    StatusOr<bool> computation_changed = false;
+    if (!failed) {
+      HloModule::ScopedDeferredUniquifying deferred_uniquifying(
+          module, &deferred[index]);
+      computation_changed = pass->RunOnComputation(computations[index]);
+    }
+
+    std::vector<int64_t> ready;
+    {
+      absl::MutexLock lock(&mu);
+      if (computation_changed.ok()) {
+        changed |= *computation_changed;
+      } else {
+        status.Update(computation_changed.status());
+      }
+      for (int64_t caller : callers[index]) {
+        if (--num_pending_callees[caller] == 0) {
+          ready.push_back(caller);
+        }
+      }
+    }
+    for (int64_t caller : ready) {
+      thread_pool->Schedule([&run, caller] { run(caller); });
+    }
+    done.DecrementCount();
+  };
+
+  for (int64_t i = 0; i < computations.size(); ++i) {
+    if (num_pending_callees[i] == 0) {
+      thread_pool->Schedule([&run, i] { run(i); });
+    }
+  }
+  done.Wait();
+  for (int64_t i = 0; i < computations.size(); ++i) {
+    module->CommitDeferredInstrNamesAndIds(deferred[i], computations[i]);
+  }
+  TF_RETURN_IF_ERROR(status);
+  return changed;
+}
+
 }  // namespace
 
+StatusOr<bool> HloPassPipeline::RunHelper(
+    HloPassInterface* pass, HloModule* module,
+    const absl::flat_hash_set<absl::string_view>& execution_threads) {
+  bool changed;
+  auto* computation_pass = dynamic_cast<HloComputationPass*>(pass);
+  if (thread_pool_ != nullptr && computation_pass != nullptr) {
+    TF_ASSIGN_OR_RETURN(
+        changed, RunComputationPassInParallel(computation_pass, module,
+                                              execution_threads, thread_pool_));
+  } else {
+    if (thread_pool_ != nullptr && pass->IsPassPipeline()) {
+      auto* pipeline = static_cast<HloPassPipeline*>(pass);
+      if (pipeline->thread_pool_ == nullptr) {
+        pipeline->set_thread_pool(thread_pool_);
+      }
+    }
+    TF_ASSIGN_OR_RETURN(changed, pass->Run(module, execution_threads));
+  }
+  module->Cleanup();
+  return changed;
+}
+
 template <typename HloT>
 Status HloPassPipeline::RunInvariantCheckers(
     HloT* hlo, absl::string_view after_pass_name,
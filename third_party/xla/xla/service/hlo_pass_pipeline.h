@@ -27,6 +27,7 @@ limitations under the License.
 #include "xla/service/hlo_pass_interface.h"
 #include "xla/statusor.h"
 #include "xla/types.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 
@@ -89,6 +90,17 @@ class HloPassPipeline : public HloPassInterface {
 
   bool IsPassPipeline() override { return true; }
 
+  // Runs the HloComputationPasses of the pipeline, and of the pipelines nested
+  // in it, on the computations of a module in parallel on `thread_pool`. The
+  // thread pool must outlive the runs of the pipeline. The names and ids of
+  // the instructions the passes add are deterministic, but may differ from
+  // the ones of a run without a thread pool. Passes run sequentially when the
+  // pipeline runs on one of the threads of the pool, or on a scheduled
+  // module.
+  void set_thread_pool(tsl::thread::ThreadPool* thread_pool) {
+    thread_pool_ = thread_pool;
+  }
+
   // Return size of passes_.
   int PassesSize() { return passes_.size(); }
   // Return reference to pass specified by index.
@@ -134,13 +146,9 @@ class HloPassPipeline : public HloPassInterface {
   // empty thread list means all `execution_threads` are considered. These
   // helpers enable templating of the core of the pipeline logic by providing
   // HloModule and HloModuleGroup specific methods with the same name.
-  static StatusOr<bool> RunHelper(
+  StatusOr<bool> RunHelper(
       HloPassInterface* pass, HloModule* module,
-      const absl::flat_hash_set<absl::string_view>& execution_threads) {
-    TF_ASSIGN_OR_RETURN(bool changed, pass->Run(module, execution_threads));
-    module->Cleanup();
-    return changed;
-  }
+      const absl::flat_hash_set<absl::string_view>& execution_threads);
   static StatusOr<bool> RunHelper(
       HloPassInterface* pass, HloModuleGroup* module_group,
       const absl::flat_hash_set<absl::string_view>& execution_threads) {
@@ -154,6 +162,7 @@ class HloPassPipeline : public HloPassInterface {
   std::vector<std::unique_ptr<HloPassInterface>> passes_;
   std::vector<std::unique_ptr<HloPassInterface>> invariant_checkers_;
   bool run_called_ = false;
+  tsl::thread::ThreadPool* thread_pool_ = nullptr;
 
   CompilationStats* compilation_stats_;
   // Default stats instance for when one is not passed in the constructor.
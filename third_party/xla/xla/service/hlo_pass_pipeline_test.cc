@@ -15,13 +15,31 @@ limitations under the License.
 
 #include "xla/service/hlo_pass_pipeline.h"
 
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "xla/hlo/ir/hlo_computation.h"
 #include "xla/hlo/ir/hlo_instruction.h"
 #include "xla/hlo/ir/hlo_module.h"
+#include "xla/literal_util.h"
+#include "xla/service/hlo_cse.h"
 #include "xla/service/hlo_parser.h"
 #include "xla/tests/hlo_test_base.h"
 #include "xla/util.h"
 #include "tsl/lib/core/status_test_util.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/logging.h"
+#include "tsl/platform/test_benchmark.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 namespace {
@@ -133,6 +151,67 @@ class BarBlowerUpper : public HloModulePass {
   }
 };
 
+// A computation pass which adds a dead constant to each computation, and
+// records whether the computations it calls were done before it.
+class AddConstantComputationPass : public HloComputationPass {
+ public:
+  explicit AddConstantComputationPass(
+      tsl::thread::ThreadPool* thread_pool = nullptr,
+      absl::string_view failing_computation = "")
+      : thread_pool_(thread_pool), failing_computation_(failing_computation) {}
+
+  absl::string_view name() const override { return "add-constant"; }
+
+  StatusOr<bool> RunOnComputation(HloComputation* computation) override {
+    bool callees_done = true;
+    {
+      absl::MutexLock lock(&mu_);
+      for (const HloInstruction* instruction : computation->instructions()) {
+        for (const HloComputation* callee :
+             instruction->called_computations()) {
+          callees_done &=
+              callee->IsFusionComputation() || done_.contains(callee);
+        }
+      }
+    }
+    if (computation->name() == failing_computation_) {
+      return Internal("Failed on %s", computation->name());
+    }
+    computation->AddInstruction(
+        HloInstruction::CreateConstant(LiteralUtil::CreateR0<float>(0)));
+
+    absl::MutexLock lock(&mu_);
+    callees_done_ &= callees_done;
+    on_pool_thread_ |=
+        thread_pool_ != nullptr && thread_pool_->CurrentThreadId() != -1;
+    done_.insert(computation);
+    return true;
+  }
+
+  bool callees_done() {
+    absl::MutexLock lock(&mu_);
+    return callees_done_;
+  }
+  bool on_pool_thread() {
+    absl::MutexLock lock(&mu_);
+    return on_pool_thread_;
+  }
+  bool done(absl::string_view computation_name) {
+    absl::MutexLock lock(&mu_);
+    return absl::c_any_of(done_, [&](const HloComputation* computation) {
+      return computation->name() == computation_name;
+    });
+  }
+
+ private:
+  tsl::thread::ThreadPool* thread_pool_;
+  std::string failing_computation_;
+  absl::Mutex mu_;
+  absl::flat_hash_set<const HloComputation*> done_ ABSL_GUARDED_BY(mu_);
+  bool callees_done_ ABSL_GUARDED_BY(mu_) = true;
+  bool on_pool_thread_ ABSL_GUARDED_BY(mu_) = false;
+};
+
 TEST_F(HloPassPipelineTest, ModulePassChanged) {
   // Test an HLO module pass which changes a module.
   const std::string module_str = R"(
@@ -400,5 +479,205 @@ TEST_F(HloPassPipelineTest, SetHloModuleMetadata) {
   }
 }
 
+// A module whose computations call each other directly and through a fusion.
+constexpr char kCallGraphModule[] = R"(
+HloModule CallGraph
+
+sum {
+  a = f32[] parameter(0)
+  b = f32[] parameter(1)
+  ROOT add = f32[] add(a, b)
+}
+
+fused_reduce {
+  p = f32[8] parameter(0)
+  zero = f32[] constant(0)
+  ROOT reduce = f32[] reduce(p, zero), dimensions={0}, to_apply=sum
+}
+
+leaf {
+  p = f32[] parameter(0)
+  ROOT negate = f32[] negate(p)
+}
+
+left {
+  p = f32[] parameter(0)
+  ROOT call = f32[] call(p), to_apply=leaf
+}
+
+right {
+  p = f32[] parameter(0)
+  ROOT call = f32[] call(p), to_apply=leaf
+}
+
+ENTRY main {
+  p = f32[8] parameter(0)
+  fusion = f32[] fusion(p), kind=kLoop, calls=fused_reduce
+  left = f32[] call(fusion), to_apply=left
+  right = f32[] call(fusion), to_apply=right
+  ROOT add = f32[] add(left, right)
+}
+)";
+
+TEST_F(HloPassPipelineTest, ComputationPassRunsCalleesFirstInParallel) {
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> module,
+                          ParseAndReturnVerifiedModule(kCallGraphModule));
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), TestName(), 4);
+  HloPassPipeline pipeline(TestName());
+  pipeline.set_thread_pool(&thread_pool);
+  auto* pass = pipeline.AddPass<AddConstantComputationPass>(&thread_pool);
+
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, pipeline.Run(module.get()));
+  EXPECT_TRUE(changed);
+  EXPECT_TRUE(pass->callees_done());
+  EXPECT_TRUE(pass->on_pool_thread());
+  for (absl::string_view name : {"sum", "leaf", "left", "right", "main"}) {
+    EXPECT_TRUE(pass->done(name)) << name;
+  }
+
+  // The instructions added concurrently got unique names and ids.
+  absl::flat_hash_set<std::string> names;
+  absl::flat_hash_set<int> ids;
+  int64_t num_instructions = 0;
+  for (const HloComputation* computation : module->computations()) {
+    for (const HloInstruction* instruction : computation->instructions()) {
+      names.insert(instruction->name());
+      ids.insert(instruction->unique_id());
+      ++num_instructions;
+    }
+  }
+  EXPECT_EQ(names.size(), num_instructions);
+  EXPECT_EQ(ids.size(), num_instructions);
+}
+
+TEST_F(HloPassPipelineTest, ComputationPassFailsInParallel) {
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> module,
+                          ParseAndReturnVerifiedModule(kCallGraphModule));
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), TestName(), 4);
+  HloPassPipeline pipeline(TestName());
+  pipeline.set_thread_pool(&thread_pool);
+  auto* pass = pipeline.AddPass<AddConstantComputationPass>(
+      &thread_pool, /*failing_computation=*/"leaf");
+
+  Status status = pipeline.Run(module.get()).status();
+  EXPECT_THAT(status.message(), ::testing::HasSubstr("Failed on leaf"));
+  // The callers of the failed computation were skipped.
+  EXPECT_FALSE(pass->done("left"));
+  EXPECT_FALSE(pass->done("right"));
+  EXPECT_FALSE(pass->done("main"));
+}
+
+TEST_F(HloPassPipelineTest, NestedPipelineRunsComputationPassInParallel) {
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> module,
+                          ParseAndReturnVerifiedModule(kCallGraphModule));
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), TestName(), 4);
+  HloPassPipeline pipeline(TestName());
+  pipeline.set_thread_pool(&thread_pool);
+  auto& nested = pipeline.AddPass<HloPassPipeline>("nested");
+  auto* pass = nested.AddPass<AddConstantComputationPass>(&thread_pool);
+
+  TF_ASSERT_OK(pipeline.Run(module.get()).status());
+  EXPECT_TRUE(pass->callees_done());
+  EXPECT_TRUE(pass->on_pool_thread());
+}
+
+TEST_F(HloPassPipelineTest, ComputationPassRunsSequentiallyWithoutThreadPool) {
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> module,
+                          ParseAndReturnVerifiedModule(kCallGraphModule));
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), TestName(), 4);
+  HloPassPipeline pipeline(TestName());
+  auto* pass = pipeline.AddPass<AddConstantComputationPass>(&thread_pool);
+
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, pipeline.Run(module.get()));
+  EXPECT_TRUE(changed);
+  EXPECT_TRUE(pass->callees_done());
+  EXPECT_FALSE(pass->on_pool_thread());
+}
+
+TEST_F(HloPassPipelineTest, ComputationPassInParallelIsDeterministic) {
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), TestName(), 4);
+  // Returns the names and ids of the instructions after running the pass.
+  auto run = [&]() -> StatusOr<std::string> {
+    TF_ASSIGN_OR_RETURN(std::unique_ptr<VerifiedHloModule> module,
+                        ParseAndReturnVerifiedModule(kCallGraphModule));
+    HloPassPipeline pipeline(TestName());
+    pipeline.set_thread_pool(&thread_pool);
+    pipeline.AddPass<AddConstantComputationPass>(&thread_pool);
+    TF_RETURN_IF_ERROR(pipeline.Run(module.get()).status());
+    std::string instructions;
+    for (const HloComputation* computation : module->computations()) {
+      for (const HloInstruction* instruction :
+           computation->MakeInstructionPostOrder()) {
+        absl::StrAppend(&instructions, instruction->name(), ":",
+                        instruction->unique_id(), " ");
+      }
+    }
+    return instructions;
+  };
+
+  TF_ASSERT_OK_AND_ASSIGN(std::string expected, run());
+  for (int i = 0; i < 10; ++i) {
+    TF_ASSERT_OK_AND_ASSIGN(std::string instructions, run());
+    EXPECT_EQ(instructions, expected);
+  }
+}
+
+// Returns a module with `num_computations` computations called by the entry
+// computation, each with many common subexpressions.
+std::string GetManyComputationsModule(int64_t num_computations) {
+  std::string hlo = "HloModule many_computations\n";
+  std::string entry = "ENTRY main {\n  p = f32[16] parameter(0)\n";
+  std::vector<std::string> calls;
+  std::vector<std::string> shapes;
+  for (int64_t i = 0; i < num_computations; ++i) {
+    absl::StrAppend(&hlo, "\ncomputation", i, " {\n",
+                    "  p = f32[16] parameter(0)\n");
+    std::string previous = "p";
+    for (int64_t j = 0; j < 64; ++j) {
+      absl::StrAppend(&hlo, "  a", j, " = f32[16] add(", previous, ", p)\n",
+                      "  b", j, " = f32[16] add(", previous, ", p)\n",
+                      "  m", j, " = f32[16] multiply(a", j, ", b", j, ")\n");
+      previous = absl::StrCat("m", j);
+    }
+    absl::StrAppend(&hlo, "  ROOT r = f32[16] negate(", previous, ")\n}\n");
+    absl::StrAppend(&entry, "  c", i, " = f32[16] call(p), to_apply=",
+                    "computation", i, "\n");
+    calls.push_back(absl::StrCat("c", i));
+    shapes.push_back("f32[16]");
+  }
+  absl::StrAppend(&entry, "  ROOT t = (", absl::StrJoin(shapes, ", "),
+                  ") tuple(", absl::StrJoin(calls, ", "), ")\n}\n");
+  return absl::StrCat(hlo, "\n", entry);
+}
+
+// Runs CSE on a module with many computations, on as many threads as the
+// benchmark argument, or sequentially if it is 0.
+void BM_ComputationPassOnManyComputations(
+    ::testing::benchmark::State& state) {
+  const int num_threads = state.range(0);
+  std::string hlo = GetManyComputationsModule(/*num_computations=*/256);
+  std::unique_ptr<tsl::thread::ThreadPool> thread_pool;
+  if (num_threads > 0) {
+    thread_pool = std::make_unique<tsl::thread::ThreadPool>(
+        tsl::Env::Default(), "cse", num_threads);
+  }
+  for (auto s : state) {
+    state.PauseTiming();
+    std::unique_ptr<HloModule> module =
+        ParseAndReturnUnverifiedModule(hlo).value();
+    HloPassPipeline pipeline("cse");
+    pipeline.set_thread_pool(thread_pool.get());
+    pipeline.AddPass<HloCSE>(/*is_layout_sensitive=*/false);
+    state.ResumeTiming();
+    CHECK(pipeline.Run(module.get()).value());
+  }
+}
+
+BENCHMARK(BM_ComputationPassOnManyComputations)
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(4)
+    ->Arg(16);
+
 }  // namespace
 }  // namespace xla
@@ -0,0 +1,164 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Tunes the fusions of a dumped HLO module on the host CPU and prints which of
+// them pay off.
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/literal.h"
+#include "xla/service/cpu/cpu_fusion_autotuner.h"
+#include "xla/service/cpu/cpu_fusion_decisions.h"
+#include "xla/service/cpu/fusion_decisions.pb.h"
+#include "xla/service/executable.h"
+#include "xla/service/hlo_runner.h"
+#include "xla/service/platform_util.h"
+#include "xla/statusor.h"
+#include "xla/tests/test_utils.h"
+#include "xla/tools/hlo_module_loader.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/errors.h"
+#include "tsl/platform/init_main.h"
+#include "tsl/platform/statusor.h"
+#include "tsl/util/command_line_flags.h"
+
+namespace {
+
+const char* const kUsage = R"(
+This tool measures the fusions the CPU compiler makes in an HLO module, and
+writes the ones that are faster left unfused to a decisions file that can be
+passed to the compiler with --xla_cpu_fusion_decisions_file.
+
+The decisions already in the file are kept, and only new fusions are measured,
+so the same file can be used to tune several modules.
+
+Usage:
+
+  cpu_fusion_autotuner --decisions_file=path/to/decisions.pbtxt \
+    [--input_format=[hlo|pb|pbtxt]] [--optional_flags] path/to/hlo_module
+)";
+
+}  // namespace
+
+namespace xla {
+namespace cpu {
+namespace {
+
+// Compiles the module for the host and takes the fastest of `num_runs` runs
+// with fake arguments.
+FusionAutotuner::MeasureFn MeasureOnHost(int num_runs) {
+  return [num_runs](std::unique_ptr<HloModule> module)
+             -> StatusOr<FusionAutotuner::Measurement> {
+    TF_ASSIGN_OR_RETURN(se::Platform * platform,
+                        PlatformUtil::GetPlatform("cpu"));
+    HloRunner runner(platform);
+    TF_ASSIGN_OR_RETURN(std::vector<Literal> arguments,
+                        MakeFakeArguments(module.get()));
+    std::vector<const Literal*> argument_ptrs;
+    for (const Literal& argument : arguments) {
+      argument_ptrs.push_back(&argument);
+    }
+    TF_ASSIGN_OR_RETURN(
+        std::unique_ptr<Executable> executable,
+        runner.CreateExecutable(std::move(module), /*run_hlo_passes=*/true));
+
+    // Warms up caches and thread pools before taking the fastest run.
+    TF_RETURN_IF_ERROR(
+        runner.ExecuteWithExecutable(executable.get(), argument_ptrs)
+            .status());
+    absl::Duration run_time = absl::InfiniteDuration();
+    for (int i = 0; i < num_runs; ++i) {
+      absl::Time start = absl::Now();
+      TF_RETURN_IF_ERROR(
+          runner.ExecuteWithExecutable(executable.get(), argument_ptrs)
+              .status());
+      run_time = std::min(run_time, absl::Now() - start);
+    }
+    return FusionAutotuner::Measurement{run_time,
+                                        executable->module().Clone()};
+  };
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
+
+int main(int argc, char** argv) {
+  std::string input_format;
+  int32_t num_runs = 5;
+  xla::cpu::FusionAutotuner::Options options;
+  float min_relative_gain = options.min_relative_gain;
+  std::vector<tsl::Flag> flag_list = {
+      tsl::Flag("input_format", &input_format,
+                "The format of the module: hlo, pb or pbtxt. Inferred from the "
+                "file extension if empty."),
+      tsl::Flag("decisions_file", &options.decisions_file,
+                "The file the fusion decisions are read from, if it exists, "
+                "and written to."),
+      tsl::Flag("max_measured_fusions", &options.max_measured_fusions,
+                "The number of fusions to measure at most."),
+      tsl::Flag("min_relative_gain", &min_relative_gain,
+                "How much faster a module has to be without a fusion for the "
+                "fusion to be rejected."),
+      tsl::Flag("num_runs", &num_runs,
+                "The number of timed runs, of which the fastest is kept."),
+  };
+  const std::string usage =
+      absl::StrCat(kUsage, "\n", tsl::Flags::Usage(argv[0], flag_list));
+  bool parse_ok = tsl::Flags::Parse(&argc, argv, flag_list);
+  tsl::port::InitMain(usage.c_str(), &argc, &argv);
+  if (!parse_ok || argc != 2 || options.decisions_file.empty()) {
+    std::cerr << usage;
+    return 1;
+  }
+  options.min_relative_gain = min_relative_gain;
+
+  auto module = xla::LoadModuleFromFile(
+      argv[1], xla::hlo_module_loader_details::Config(), input_format);
+  if (!module.ok()) {
+    std::cerr << module.status() << "\n";
+    return 1;
+  }
+
+  xla::cpu::FusionDecisionsProto decisions;
+  if (tsl::Env::Default()->FileExists(options.decisions_file).ok()) {
+    auto loaded = xla::cpu::LoadFusionDecisions(options.decisions_file);
+    if (!loaded.ok()) {
+      std::cerr << loaded.status() << "\n";
+      return 1;
+    }
+    decisions = *std::move(loaded);
+  }
+
+  xla::cpu::FusionAutotuner autotuner(options,
+                                      xla::cpu::MeasureOnHost(num_runs));
+  auto tuned = autotuner.Tune(**module, std::move(decisions));
+  if (!tuned.ok()) {
+    std::cerr << tuned.status() << "\n";
+    return 1;
+  }
+  std::cout << xla::cpu::FusionDecisionsReport(*tuned);
+  return 0;
+}